@@ -84,6 +84,132 @@ femm::ParserResult ElectrostaticsPostProcessor::parseSolution(std::istream &inpu
         input >> circuit->q;
     }
 
+    // optional capacitance matrix
+    std::string token;
+    CapacitanceConductors.clear();
+    Capacitance.clear();
+    if (input >> token && token == "[Capacitance]")
+    {
+        k = -1;
+        input >> k;
+        if (k<0 || k>(int)circproplist.size())
+        {
+            err << "Invalid number of conductors in the capacitance matrix: " << k << "\n";
+            return femm::F_FILE_MALFORMED;
+        }
+        CapacitanceConductors.resize(k);
+        Capacitance.resize(k*k);
+        for(int i=0;i<k;i++)
+        {
+            input >> CapacitanceConductors[i];
+            if (CapacitanceConductors[i]<0 || CapacitanceConductors[i]>=(int)circproplist.size())
+            {
+                err << "Invalid conductor in the capacitance matrix: " << CapacitanceConductors[i] << "\n";
+                return femm::F_FILE_MALFORMED;
+            }
+            for(int j=0;j<k;j++)
+                input >> Capacitance[i*k+j];
+        }
+        if (!input)
+        {
+            err << "The capacitance matrix is incomplete.\n";
+            return femm::F_FILE_MALFORMED;
+        }
+    }
+
+    return femm::F_FILE_OK;
+}
+
+femm::ParserResult ElectrostaticsPostProcessor::parseBinarySolution(const femm::CSolutionFile &solution, std::ostream &err)
+{
+    using femmsolver::CSMeshNode;
+    using femmsolver::CHSElement;
+
+    size_t numNodes, numElements, n;
+    // mesh nodes
+    const femm::SolutionNode *nodes = solution.section<femm::SolutionNode>(femm::SolutionSection::Nodes, numNodes);
+    const double *potentials = solution.section<double>(femm::SolutionSection::Potentials, n);
+    if (!nodes || !potentials || n!=numNodes)
+    {
+        err << "The binary solution contains no mesh nodes or no voltages.\n";
+        return femm::F_FILE_MALFORMED;
+    }
+    meshnodes.reserve(numNodes);
+    for(size_t i=0;i<numNodes;i++)
+    {
+        std::unique_ptr<CSMeshNode> node = MAKE_UNIQUE<CSMeshNode>();
+        node->x = nodes[i].x;
+        node->y = nodes[i].y;
+        node->V = potentials[i];
+        node->Q = nodes[i].marker;
+        meshnodes.push_back(std::move(node));
+    }
+
+    // elements
+    const femm::SolutionElement *elements = solution.section<femm::SolutionElement>(femm::SolutionSection::Elements, numElements);
+    if (!elements)
+    {
+        err << "The binary solution contains no mesh elements.\n";
+        return femm::F_FILE_MALFORMED;
+    }
+    meshelems.reserve(numElements);
+    auto &labellist = problem->labellist;
+    for(size_t i=0;i<numElements;i++)
+    {
+        CHSElement elm;
+        for (int j=0; j<3; j++)
+            elm.p[j] = elements[i].p[j];
+        elm.lbl = elements[i].lbl;
+        if (elm.p[0]<0 || elm.p[1]<0 || elm.p[2]<0
+                || elm.p[0]>=(int)numNodes || elm.p[1]>=(int)numNodes || elm.p[2]>=(int)numNodes)
+        {
+            err << "The binary solution contains an element with an invalid node.\n";
+            return femm::F_FILE_MALFORMED;
+        }
+        if (elm.lbl<0 || elm.lbl>=(int)labellist.size())
+        {
+            err << "The binary solution contains an element with an invalid block label.\n";
+            return femm::F_FILE_MALFORMED;
+        }
+        elm.blk = labellist[elm.lbl]->BlockType;
+        meshelems.push_back(MAKE_UNIQUE<CHSElement>(elm));
+    }
+
+    // circuit data
+    auto &circproplist = problem->circproplist;
+    const femm::SolutionCircuit *circuits = solution.section<femm::SolutionCircuit>(femm::SolutionSection::Circuits, n);
+    for(size_t i=0;i<n && i<circproplist.size();i++)
+    {
+        auto circuit = reinterpret_cast<CSCircuit*>(circproplist[i].get());
+        // partially overwrite circuit data:
+        circuit->V = circuits[i].value[0];
+        circuit->q = circuits[i].value[1];
+    }
+
+    // optional capacitance matrix
+    CapacitanceConductors.clear();
+    Capacitance.clear();
+    const int32_t *conductors = solution.section<int32_t>(femm::SolutionSection::CapacitanceConductors, n);
+    if (conductors)
+    {
+        size_t entries;
+        const double *capacitance = solution.section<double>(femm::SolutionSection::Capacitance, entries);
+        if (!capacitance || entries!=n*n)
+        {
+            err << "The capacitance matrix of the binary solution is incomplete.\n";
+            return femm::F_FILE_MALFORMED;
+        }
+        for(size_t i=0;i<n;i++)
+        {
+            if (conductors[i]<0 || conductors[i]>=(int)circproplist.size())
+            {
+                err << "The binary solution contains an invalid conductor in the capacitance matrix.\n";
+                return femm::F_FILE_MALFORMED;
+            }
+        }
+        CapacitanceConductors.assign(conductors, conductors+n);
+        Capacitance.assign(capacitance, capacitance+entries);
+    }
     return femm::F_FILE_OK;
 }
 
@@ -723,6 +849,23 @@ void ElectrostaticsPostProcessor::lineIntegral(int intType, double (&results)[2]
     }
 }
 
+bool ElectrostaticsPostProcessor::getCapacitance(int i, int j, double &c) const
+{
+    const int nc = static_cast<int>(CapacitanceConductors.size());
+    int row=-1, col=-1;
+    for (int k=0; k<nc; k++)
+    {
+        if (CapacitanceConductors[k]==i)
+            row=k;
+        if (CapacitanceConductors[k]==j)
+            col=k;
+    }
+    if (row<0 || col<0)
+        return false;
+    c = Capacitance[row*nc+col];
+    return true;
+}
+
 CComplex ElectrostaticsPostProcessor::E(const CHSElement *elem) const
 {
     const CSMaterialProp *mat = dynamic_cast<CSMaterialProp*>(problem->blockproplist[elem->blk].get());
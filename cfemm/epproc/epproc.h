@@ -30,6 +30,7 @@ public:
     ElectrostaticsPostProcessor();
     virtual ~ElectrostaticsPostProcessor();
     femm::ParserResult parseSolution( std::istream &input, std::ostream &err = std::cerr ) override;
+    femm::ParserResult parseBinarySolution( const femm::CSolutionFile &solution, std::ostream &err = std::cerr ) override;
     bool OpenDocument( std::string solutionFile ) override;
 
     /**
@@ -75,6 +76,15 @@ public:
      * @param results
      */
     void lineIntegral(int intType, double (&results)[2]) const;
+
+    /**
+     * @brief Get an entry of the capacitance matrix, if the solver computed it (see ESolver::ComputeCapacitance).
+     * @param i index of a conductor
+     * @param j index of a conductor
+     * @param c is set to the charge on conductor \p i for 1 V on conductor \p j, and 0 V on all other conductors
+     * @return \c false, if the solution has no capacitance matrix, or if \p i or \p j is not a fixed-voltage conductor.
+     */
+    bool getCapacitance(int i, int j, double &c) const;
 private:
     /**
      * @brief Calculate the average electric field density for the given element.
@@ -100,6 +110,9 @@ private:
     double A_Low;
     double A_lb;
     double A_ub;
+
+    std::vector<int> CapacitanceConductors; ///< conductors of the capacitance matrix, in the order of its rows
+    std::vector<double> Capacitance; ///< capacitance matrix by rows
 };
 
 #endif
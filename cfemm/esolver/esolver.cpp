@@ -35,8 +35,13 @@
 #include "femmcomplex.h"
 #include "femmconstants.h"
 #include "spars.h"
+#include "coloring.h"
+#include "triangleshapes.h"
 //#include "fparse.h"
 #include "esolver.h"
+#include "meshdata.h"
+#include "solutionfile.h"
+#include "textwriter.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -79,6 +84,7 @@ using namespace femm;
 ESolver::ESolver()
 {
 	meshnode=NULL;
+	ComputeCapacitance=false;
 
     // initialise the warning message box function pointer to
     // point to the PrintWarningMsg function
@@ -128,26 +134,29 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 {
     int i,j,k,q,n0,n1,n;
     char infile[256];
-    FILE *fp;
-    char s[1024];
 
-    //read meshnodes;
-    sprintf(infile,"%s.node",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL){
-        return BADELEMENTFILE;
+    // use the triangulation handed over by the mesher, or read the mesh files
+    femm::CMeshData fileMesh;
+    const femm::CMeshData *mesh = meshData.get();
+    if (!mesh)
+    {
+        LoadMeshErr err = fileMesh.readFiles(PathName);
+        if (err != NOERROR)
+            return err;
+        mesh = &fileMesh;
     }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
+
+    //read meshnodes;
+    k = (int) mesh->nodes.size();
     NumNodes=k;
 
     meshnode = new CNode[k];
     CNode node;
     for (i=0; i<k; i++)
     {
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%lf",&node.x);
-        fscanf(fp,"%lf",&node.y);
-        fscanf(fp,"%i",&n);
+        node.x = mesh->nodes[i].x;
+        node.y = mesh->nodes[i].y;
+        n = mesh->nodes[i].marker;
 
         if (n > 1)
         {
@@ -177,36 +186,14 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 
         meshnode[i] = node;
     }
-    fclose(fp);
 
     //read in periodic boundary conditions;
-    sprintf(infile,"%s.pbc",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL){
-        return BADPBCFILE;
-    }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
-    NumPBCs=k;
-
-    if (k!=0)
-        pbclist.reserve(k);
-    CCommonPoint pbc;
-    for(i=0;i<k;i++){
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%i",&pbc.x);
-        fscanf(fp,"%i",&pbc.y);
-        fscanf(fp,"%i",&pbc.t);
-        pbclist.push_back(pbc);
-    }
-    fclose(fp);
+    NumPBCs = (int) mesh->pbcs.size();
+    pbclist = mesh->pbcs;
 
     // read in elements;
-    sprintf(infile,"%s.ele",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL){
-        return BADELEMENTFILE;
-    }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k); NumEls=k;
+    k = (int) mesh->elements.size();
+    NumEls = k;
 
     meshele.reserve(k);
     femmsolver::CElement elm;
@@ -216,11 +203,10 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
         if (labellist[i].IsDefault) defaultLabel=i;
 
     for(i=0;i<k;i++){
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%i",&elm.p[0]);
-        fscanf(fp,"%i",&elm.p[1]);
-        fscanf(fp,"%i",&elm.p[2]);
-        fscanf(fp,"%i",&elm.lbl);
+        elm.p[0] = mesh->elements[i].p[0];
+        elm.p[1] = mesh->elements[i].p[1];
+        elm.p[2] = mesh->elements[i].p[2];
+        elm.lbl = mesh->elements[i].label;
         elm.lbl--;
         if(elm.lbl<0) elm.lbl=defaultLabel;
         if(elm.lbl<0){
@@ -229,7 +215,6 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
             msg +="button to highlight the problem regions.";
             WarnMessage(msg.c_str());
 
-            fclose(fp);
             if (deleteFiles)
             {
                 sprintf(infile,"%s.ele",PathName.c_str());
@@ -250,7 +235,6 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 
         meshele.push_back(elm);
     }
-    fclose(fp);
 
     // initialize edge bc's and element permeabilities;
     for(i=0;i<NumEls;i++)
@@ -289,20 +273,12 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
             nmbr[k]++;
         }
 
-    sprintf(infile,"%s.edge",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
-    {
-        return BADEDGEFILE;
-    }
-    fscanf(fp,"%i",&k);	// read in number of lines
-
-    fscanf(fp,"%i",&j);	// read in boundarymarker flag;
+    k = (int) mesh->edges.size();
     for(i=0;i<k;i++)
     {
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%i",&n0);
-        fscanf(fp,"%i",&n1);
-        fscanf(fp,"%i",&n);
+        n0 = mesh->edges[i].n0;
+        n1 = mesh->edges[i].n1;
+        n = mesh->edges[i].marker;
 
         // BC number;
         if (n<0)
@@ -347,7 +323,6 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
         }
 
     }
-    fclose(fp);
 
     // free up the connectivity information
     free(nmbr);
@@ -386,21 +361,37 @@ LoadMeshErr ESolver::LoadMesh(bool deleteFiles)
 int ESolver::AnalyzeProblem(CBigLinProb &L)
 {
     int i,j,k;
-	double Me[3][3],be[3];		// element matrices;
-	double l[3],p[3],q[3];		// element shape parameters;
-	int n[3],ne[3];				// numbers of nodes for a particular element;
-	double a,K,r,z,kludge;
-    femmsolver::CElement *El;
+	double K;
 
 	double c = (1.e-6)/eo;
+
+	// load cases of the capacitance sweep: one right hand side per conductor with a prescribed voltage
+	std::vector<int> sweepColumn(NumCircProps,-1);
+	std::vector< std::vector<double> > sweepRHS;
+	CapacitanceConductors.clear();
+	Capacitance.clear();
+	if (ComputeCapacitance)
+	{
+		for(i=0;i<NumCircProps;i++)
+			if(circproplist[i].CircType==1)
+			{
+				sweepColumn[i]=static_cast<int>(CapacitanceConductors.size());
+				CapacitanceConductors.push_back(i);
+			}
+		sweepRHS.assign(CapacitanceConductors.size(), std::vector<double>(L.n,0.));
+	}
+
 	Depth*=units[LengthUnits];
 	extRo*=units[LengthUnits];
 	extRi*=units[LengthUnits];
 	extZo*=units[LengthUnits];
-	kludge=1;
 
     //TheView->SetDlgItemText(IDC_FRAME1,"Matrix Construction");
 
+	// shape parameters of all elements
+	CTriangleShapes shapes;
+	shapes.Create(meshnode,NumNodes,meshele);
+
 	// do some book-keeping related to fixed boundary conditions;
 	// The P vector denotes which nodes have an assigned value
 	// The V vector denotes the assigned value
@@ -440,10 +431,34 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 		}
 	}
 
+	// elements of the same color do not share nodes, so that they can add to the matrix concurrently.
+	// Elements with a node in a conductor of unknown voltage also add to the conductor's row,
+	// so they are assembled serially.
+	CElementColoring coloring;
+	coloring.Create(NumNodes);
+	for(i=0;i<NumEls;i++)
+	{
+		bool serial=false;
+		for(j=0;j<3;j++)
+		{
+			k=meshnode[meshele[i].p[j]].InConductor;
+			if((k>=0) && (circproplist[k].CircType==0)) serial=true;
+		}
+		coloring.Add(i,meshele[i].p,serial);
+	}
+	coloring.Finish();
 
 	// build element matrices using the matrices derived in Allaire's book.
-	for(i=0;i<NumEls;i++)
+	coloring.ForEach([&](int i)
 	{
+		double Me[3][3],be[3];		// element matrices;
+		double l[3],p[3],q[3];		// element shape parameters;
+		int n[3],ne[3];				// numbers of nodes for a particular element;
+		double a,K,r,z,kludge=1;
+		double depth=Depth;
+		double ue[3][3];
+		int uq[3];
+		int j,k;
 
 		// zero out Me, be;
 		for(j=0;j<3;j++){
@@ -455,25 +470,15 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 		// l's are element side lengths;
 		// p's corresponds to the `b' parameter in Allaire
 		// q's corresponds to the `c' parameter in Allaire
-		El=&meshele[i];
+		femmsolver::CElement *El=&meshele[i];
 
 		for(k=0;k<3;k++) n[k]=El->p[k];
-		p[0]=meshnode[n[1]].y - meshnode[n[2]].y;
-		p[1]=meshnode[n[2]].y - meshnode[n[0]].y;
-		p[2]=meshnode[n[0]].y - meshnode[n[1]].y;
-		q[0]=meshnode[n[2]].x - meshnode[n[1]].x;
-		q[1]=meshnode[n[0]].x - meshnode[n[2]].x;
-		q[2]=meshnode[n[1]].x - meshnode[n[0]].x;
-		for(j=0,k=1;j<3;k++,j++){
-			if (k==3) k=0;
-			l[j]=sqrt( sqr(meshnode[n[k]].x-meshnode[n[j]].x) +
-					   sqr(meshnode[n[k]].y-meshnode[n[j]].y) );
-		}
-		a=(p[0]*q[1]-p[1]*q[0])/2.;
+		shapes.Get(i,p,q,a);
+		shapes.GetSides(i,l);
 		r=(meshnode[n[0]].x+meshnode[n[1]].x+meshnode[n[2]].x)/3.;
 
 		if (ProblemType==AXISYMMETRIC){
-			Depth=2.*PI*r;
+			depth=2.*PI*r;
 
 			// "Warp" the permeability of this element is part of
 			// the conformally mapped external region
@@ -482,12 +487,11 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 				z=(meshnode[n[0]].y+meshnode[n[1]].y+meshnode[n[2]].y)/3. - extZo;
 				kludge=(r*r+z*z)/(extRi*extRo);
 			}
-			else kludge=1;
 		}
 
 
 		// x-contribution;
-		K = -Depth*blockproplist[El->blk].ex/(4.*a)/kludge;
+		K = -depth*blockproplist[El->blk].ex/(4.*a)/kludge;
 		for(j=0;j<3;j++)
 			for(k=j;k<3;k++)
 			{
@@ -496,7 +500,7 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 			}
 
 		// y-contribution;
-		K = -Depth*blockproplist[El->blk].ey/(4.*a)/kludge;
+		K = -depth*blockproplist[El->blk].ey/(4.*a)/kludge;
 		for(j=0;j<3;j++)
 			for(k=j;k<3;k++)
 			{
@@ -506,7 +510,7 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 
 		// contribution to be[] from volume charge density
 		for(j = 0;j<3;j++){
-			K = -Depth*c*(blockproplist[El->blk].qv)*a/3.;
+			K = -depth*c*(blockproplist[El->blk].qv)*a/3.;
 			be[j]+=K;
 		}
 
@@ -518,18 +522,18 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 				k=j+1; if(k==3) k=0;
 
 				if (ProblemType==AXISYMMETRIC)
-					Depth=PI*(meshnode[n[j]].x + meshnode[n[k]].x);
+					depth=PI*(meshnode[n[j]].x + meshnode[n[k]].x);
 
 				// contributions to Me, be from derivative boundary conditions;
 				if (lineproplist[El->e[j]].BdryFormat==1)
 				{
-					K =-1000.*Depth*c*lineproplist[El->e[j]].c0*l[j]/6.;
+					K =-1000.*depth*c*lineproplist[El->e[j]].c0*l[j]/6.;
 					Me[j][j]+=K*2.;
 					Me[k][k]+=K*2.;
 					Me[j][k]+=K;
 					Me[k][j]+=K;
 
-					K = 1000.*Depth*c*lineproplist[El->e[j]].c1*l[j]/2.;
+					K = 1000.*depth*c*lineproplist[El->e[j]].c1*l[j]/2.;
 					be[j]+=K;
 					be[k]+=K;
 				}
@@ -537,13 +541,29 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 				// contribution to be[] from surface charge density;
 				if (lineproplist[El->e[j]].BdryFormat==2)
 				{
-					K =-1000.*Depth*c*lineproplist[El->e[j]].qs*l[j]/2.;
+					K =-1000.*depth*c*lineproplist[El->e[j]].qs*l[j]/2.;
 					be[j]+=K;
 					be[k]+=K;
 				}
 			}
 		}
 
+		// contribution of 1 V on a conductor, as it results from the elimination of the prescribed values below
+		for(j=0;j<3;j++)
+		{
+			uq[j]=-1;
+			if(ComputeCapacitance && L.Q[n[j]]>=0)
+			{
+				uq[j]=sweepColumn[L.Q[n[j]]];
+				for(k=0;k<3;k++)
+				{
+					if(k==j) ue[j][k]=Me[j][j];
+					else if(L.Q[n[k]]==-2) ue[j][k]=-Me[k][j];
+					else ue[j][k]=0;
+				}
+			}
+		}
+
 		// process any prescribed nodal values;
 		for(j=0;j<3;j++)
 		{
@@ -571,17 +591,21 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 		}
 		for (j=0;j<3;j++){
 			for (k=j;k<3;k++)
-				L.Put(L.Get(ne[j],ne[k])-Me[j][k],ne[j],ne[k]);
+				L.AddTo(-Me[j][k],ne[j],ne[k]);
 			L.b[ne[j]]-=be[j];
 
 			if(ne[j]!=n[j])
 			{
-				L.Put(L.Get(n[j],n[j])-Me[j][j],n[j],n[j]);
-				L.Put(L.Get(n[j],ne[j])+Me[j][j],n[j],ne[j]);
+				L.AddTo(-Me[j][j],n[j],n[j]);
+				L.AddTo(Me[j][j],n[j],ne[j]);
 			}
 		}
+		for (j=0;j<3;j++)
+			if(uq[j]>=0)
+				for (k=0;k<3;k++)
+					sweepRHS[uq[j]][ne[k]]-=ue[j][k];
 
-	} // end of loop that builds element matrices
+	}); // end of loop that builds element matrices
 
 	// add in contribution from point charge density;
 	for(i=0;i<NumNodes;i++)
@@ -602,6 +626,23 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 	{
 		if (pbclist[k].t==0) L.Periodicity(pbclist[k].x,pbclist[k].y);
 		if (pbclist[k].t==1) L.AntiPeriodicity(pbclist[k].x,pbclist[k].y);
+
+		// same treatment of the right hand side as in CBigLinProb::(Anti)Periodicity
+		for (auto &rhs : sweepRHS)
+		{
+			double v1=rhs[pbclist[k].x];
+			double v2=rhs[pbclist[k].y];
+			if (pbclist[k].t==0)
+			{
+				rhs[pbclist[k].x]=0.5*(v1+v2);
+				rhs[pbclist[k].y]=0.5*(v1+v2);
+			}
+			if (pbclist[k].t==1)
+			{
+				rhs[pbclist[k].x]=0.5*(v1-v2);
+				rhs[pbclist[k].y]=-0.5*(v1-v2);
+			}
+		}
 	}
 
 	// Finish building the equations that assign conductor voltage;
@@ -615,6 +656,7 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 			K=L.Get(0,0);
 			L.Put(K,k,k);
 			L.b[k]=K*circproplist[i].V;
+			if (sweepColumn[i]>=0) sweepRHS[sweepColumn[i]][k]=K;
 		}
 
 		if(circproplist[i].CircType==0)
@@ -631,7 +673,35 @@ int ESolver::AnalyzeProblem(CBigLinProb &L)
 	}
 
 	// solve the problem;
-    if (! L.PCGSolve(false)) return false;
+	if (sweepRHS.empty())
+	{
+		if (! L.Solve(false)) return false;
+	}
+	else
+	{
+		// solve the problem and all load cases of the capacitance sweep together
+		int nc=static_cast<int>(sweepRHS.size());
+		std::vector< std::vector<double> > sweepV(nc, std::vector<double>(L.n,0.));
+		std::vector<double *> B(1,L.b);
+		std::vector<double *> X(1,L.V);
+		for(k=0;k<nc;k++)
+		{
+			B.push_back(sweepRHS[k].data());
+			X.push_back(sweepV[k].data());
+		}
+		if (! L.SolveBlock(nc+1,B.data(),X.data(),false)) return false;
+
+		// charge on each conductor for 1 V on conductor k
+		double *V0=L.V;
+		Capacitance.assign(nc*nc,0.);
+		for(k=0;k<nc;k++)
+		{
+			L.V=sweepV[k].data();
+			for(j=0;j<nc;j++)
+				Capacitance[j*nc+k]=ChargeOnConductor(CapacitanceConductors[j],L);
+		}
+		L.V=V0;
+	}
 
 	// compute total charge on conductors
 	// with a specified voltage
@@ -672,15 +742,30 @@ bool ESolver::runSolver(bool verbose)
         PrintMessage(stats.c_str());
     }
 
-    CBigLinProb L;
+    std::unique_ptr<CBigLinProb> Lp = createLinProb();
+    if (!Lp)
+        return false;
+    CBigLinProb &L = *Lp;
 
-    L.Precision = Precision;
     if (!L.Create(NumNodes+NumCircProps,BandWidth))
     {
         WarnMessage("couldn't allocate enough space for matrices\n");
         return false;
     }
 
+    // fix the sparsity pattern once, so that assembly only fills in values.
+    // Nodes in a conductor with a prescribed charge are assembled into the conductor's unknown.
+    std::vector<int> dofmap(NumNodes);
+    for (int i=0; i<NumNodes; i++)
+    {
+        dofmap[i] = i;
+        if (meshnode[i].InConductor>=0 && circproplist[meshnode[i].InConductor].CircType==0)
+            dofmap[i] = meshnode[i].InConductor+NumNodes;
+    }
+    CSparsityPattern pattern(NumNodes+NumCircProps);
+    BuildSparsityPattern(pattern, dofmap);
+    L.SetPattern(pattern);
+
     if (!AnalyzeProblem(L))
     {
         WarnMessage("Couldn't solve the problem\n");
@@ -716,6 +801,9 @@ bool ESolver::runSolver(bool verbose)
  */
 int ESolver::WriteResults(CBigLinProb &L)
 {
+	if (binarySolutionFile)
+		return WriteBinaryResults(L);
+
 	// write solution to disk;
 
 	char c[1024];
@@ -737,45 +825,95 @@ int ESolver::WriteResults(CBigLinProb &L)
 	if(fp==NULL)
     {
 		printf("Couldn't write to %s.res",PathName.c_str());
+		fclose(fz);
         return false;
 	}
 
-	while(fgets(c,1024,fz)!=NULL)
-    {
-        fputs(c,fp);
-    }
+	femm::CTextWriter out(fp);
+	out.copyFrom(fz);
 	fclose(fz);
 
 	// then print out node, line, and element information
-	fprintf(fp,"[Solution]\n");
+	out << "[Solution]\n";
     // get conversion factor for conversion from internal working units of
     // mm to the specified length units
 	cf = units[LengthUnits];
-	fprintf(fp,"%i\n",NumNodes);
-	for(i=0;i<NumNodes;i++)
-    {
-		fprintf(fp,"%.17g	%.17g	%.17g	%i\n",meshnode[i].x/cf,meshnode[i].y/cf,L.V[i],L.Q[i]);
-    }
+	out << NumNodes << '\n';
+	out.writeRecords(NumNodes, [&](femm::CTextWriter &w, int i) {
+		w << meshnode[i].x/cf << '\t' << meshnode[i].y/cf << '\t' << L.V[i] << '\t' << L.Q[i] << '\n';
+	});
 
-	fprintf(fp,"%i\n",NumEls);
+	out << NumEls << '\n';
 
-	for(i=0;i<NumEls;i++)
-    {
-		fprintf(fp,"%i	%i	%i	%i\n",
-			meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl);
-    }
+	out.writeRecords(NumEls, [&](femm::CTextWriter &w, int i) {
+		w << meshele[i].p[0] << '\t' << meshele[i].p[1] << '\t' << meshele[i].p[2] << '\t' << meshele[i].lbl << '\n';
+	});
 
 	// print out circuit info
-	fprintf(fp,"%i\n",NumCircProps);
+	out << NumCircProps << '\n';
 	for(i=0;i<NumCircProps;i++)
     {
-		fprintf(fp,"%.17g	%.17g\n",L.V[NumNodes+i],circproplist[i].q);
+		out << L.V[NumNodes+i] << '\t' << circproplist[i].q << '\n';
     }
 
-	fclose(fp);
+	// the capacitance matrix follows the circuits, so that other readers can ignore it:
+	// number of conductors, then one row per conductor, starting with its index in the conductor list
+	if (!CapacitanceConductors.empty())
+	{
+		int nc = static_cast<int>(CapacitanceConductors.size());
+		out << "[Capacitance]\n" << nc << '\n';
+		for(i=0;i<nc;i++)
+		{
+			out << CapacitanceConductors[i];
+			for(int j=0;j<nc;j++)
+				out << '\t' << Capacitance[i*nc+j];
+			out << '\n';
+		}
+	}
+
+	bool written = out.flush();
+	if (fclose(fp)!=0 || !written)
+	{
+		printf("Couldn't write to %s.res",PathName.c_str());
+		return false;
+	}
     return true;
 }
 
+bool ESolver::WriteBinaryResults(CBigLinProb &L)
+{
+    using namespace femm;
+    CSolutionFileWriter writer;
+
+    // get conversion factor for conversion from internal working units of
+    // mm to the specified length units
+    double cf = units[LengthUnits];
+    std::vector<SolutionNode> nodes(NumNodes);
+    for (int i=0; i<NumNodes; i++)
+        nodes[i] = SolutionNode{meshnode[i].x/cf, meshnode[i].y/cf, L.Q[i], 0};
+    writer.addSection(SolutionSection::Nodes, nodes);
+    writer.addSection(SolutionSection::Potentials, L.V, NumNodes, sizeof(double));
+
+    std::vector<SolutionElement> elements(NumEls);
+    for (int i=0; i<NumEls; i++)
+        elements[i] = SolutionElement{{meshele[i].p[0], meshele[i].p[1], meshele[i].p[2]}, meshele[i].lbl};
+    writer.addSection(SolutionSection::Elements, elements);
+
+    std::vector<SolutionCircuit> circuits(NumCircProps);
+    for (int i=0; i<NumCircProps; i++)
+        circuits[i] = SolutionCircuit{0, 0, {L.V[NumNodes+i], circproplist[i].q}};
+    writer.addSection(SolutionSection::Circuits, circuits);
+
+    if (!CapacitanceConductors.empty())
+    {
+        std::vector<int32_t> conductors(CapacitanceConductors.begin(), CapacitanceConductors.end());
+        writer.addSection(SolutionSection::CapacitanceConductors, conductors);
+        writer.addSection(SolutionSection::Capacitance, Capacitance);
+    }
+
+    return writer.write(PathName+".res", PathName+".fee");
+}
+
 //=========================================================================
 //=========================================================================
 
@@ -856,7 +994,13 @@ void ESolver::SortNodes (int* newnum)
     }
 }
 
-bool ESolver::handleToken(const string &, istream &, ostream &)
+bool ESolver::handleToken(const string &token, istream &input, ostream &err)
 {
+    if( token == "[computecapacitance]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, ComputeCapacitance, err);
+        return true;
+    }
     return false;
 }
@@ -45,6 +45,7 @@
 #include "CPointProp.h"
 
 #include <string>
+#include <vector>
 
 class ESolver : public FEASolver<
         femm::CSPointProp
@@ -66,6 +67,19 @@ public:
     // mesh information
     femm::CNode *meshnode;
 
+    /**
+     * @brief If set, AnalyzeProblem() also computes the capacitance matrix of the conductors with a prescribed voltage.
+     *
+     * For each of these conductors, a load case with 1 V on that conductor, 0 V on all other conductors
+     * and fixed-voltage boundaries, and no charge sources is set up during the (single) assembly of the matrix.
+     * All load cases are solved together with the regular problem, see CBigLinProb::SolveBlock().
+     * Set by \c [ComputeCapacitance] in the problem file.
+     * The matrix is written to the solution file after the conductors (section \c [Capacitance]).
+     */
+    bool ComputeCapacitance;
+    std::vector<int> CapacitanceConductors; ///< conductors (index into circproplist) in the order of the rows of \c Capacitance
+    std::vector<double> Capacitance; ///< capacitance matrix by rows: entry (i,j) is the charge on conductor i for 1 V on conductor j
+
 // Operations
 public:
 
@@ -73,6 +87,11 @@ public:
     bool LoadProblemFile();
     double ChargeOnConductor(int conductor, CBigLinProb &L);
     int WriteResults(CBigLinProb &L);
+    /**
+     * @brief Write the results to a binary solution file, see femm::CSolutionFileWriter.
+     * WriteResults() calls this if binarySolutionFile is set.
+     */
+    bool WriteBinaryResults(CBigLinProb &L);
     int AnalyzeProblem(CBigLinProb &L);
     int (*WarnMessage)(const char*, ...);
 
@@ -85,7 +104,7 @@ private:
     // override parent class virtual method
     void SortNodes (int* newnum) override;
 
-    virtual bool handleToken(const std::string &, std::istream &, std::ostream &) override;
+    virtual bool handleToken(const std::string &token, std::istream &input, std::ostream &err) override;
 
 };
 
@@ -72,6 +72,8 @@ void femmcli::FemmState::close()
     current.document.reset();
     current.mesher.reset();
     current.postProcessor.reset();
+    current.solutionProblemFile.clear();
+    current.solution.reset();
 }
 
 void femmcli::FemmState::deactivateProblemSet()
@@ -104,3 +106,46 @@ bool femmcli::FemmState::isValid() const
 {
     return (nullptr != current.document.get());
 }
+
+bool femmcli::FemmState::inMemoryAnalysis() const
+{
+    return inMemory;
+}
+
+void femmcli::FemmState::setInMemoryAnalysis(bool value)
+{
+    inMemory = value;
+}
+
+bool femmcli::FemmState::binarySolutionFiles() const
+{
+    return binarySolution;
+}
+
+void femmcli::FemmState::setBinarySolutionFiles(bool value)
+{
+    binarySolution = value;
+}
+
+std::shared_ptr<femm::CMeshCache> femmcli::FemmState::meshCache() const
+{
+    return cache;
+}
+
+void femmcli::FemmState::setMeshCache(std::shared_ptr<femm::CMeshCache> cache)
+{
+    this->cache = cache;
+}
+
+void femmcli::FemmState::storeSolution(const std::string &problemFile, std::shared_ptr<const femm::CMSolution> solution)
+{
+    current.solutionProblemFile = solution ? problemFile : std::string();
+    current.solution = solution;
+}
+
+std::shared_ptr<const femm::CMSolution> femmcli::FemmState::storedSolution(const std::string &problemFile) const
+{
+    if (!current.solution || current.solutionProblemFile != problemFile)
+        return nullptr;
+    return current.solution;
+}
@@ -22,10 +22,12 @@
 
 #include "FemmProblem.h"
 #include "fmesher.h"
+#include "meshcache.h"
 #include "fsolver.h"
 #include "PostProcessor.h"
 
 #include <memory>
+#include <string>
 
 namespace femmcli
 {
@@ -51,6 +53,7 @@ namespace femmcli
  *    but stores mesh data internally and saves it to disk.
  *  * The solver reads and writes data from/to disk.
  *  * The post processor reads and writes data from/to disk.
+ *  * For magnetics problems, the mesh and the solution can be handed over in memory instead (see below).
  *
  * Data flow
  * ---------
@@ -69,6 +72,16 @@ namespace femmcli
  *    The solution data is available for lua commands (mo_*).<br/>
  *    → the data is in memory in postProcessor
  *
+ * The analyze commands of all problem types hand the mesh to the solver in memory (FEASolver::meshData),
+ * so that no mesh files are written in step 3.
+ * For magnetics problems, if inMemoryAnalysis() is set, the solver also keeps its solution in memory (FSolver::keepSolution) instead of
+ * writing the \c .ans file in step 4, and step 5 takes the solution from storedSolution().
+ * Heat flow and electrostatics solutions always go through the solution file.
+ * The \c .fem file is still written in step 2, because the post processor reads the problem description from it.
+ *
+ * If a meshCache() is set, the analyze commands look up the triangulation in the cache before step 3,
+ * and skip the mesher on a hit.
+ *
  * Multiple documents
  * ------------------
  *
@@ -142,15 +155,53 @@ public:
      * @return \c true, if a problem set is active, \c false otherwise.
      */
     bool isValid() const;
+
+    /**
+     * @brief If set, magnetics solutions are kept in memory instead of being written to \c .ans files.
+     * @see storedSolution()
+     */
+    bool inMemoryAnalysis() const;
+    void setInMemoryAnalysis(bool value);
+
+    /**
+     * @brief If set, the solvers write binary solution files (FEASolver::binarySolutionFile).
+     */
+    bool binarySolutionFiles() const;
+    void setBinarySolutionFiles(bool value);
+
+    /**
+     * @brief The cache for the triangulations of the analyze commands, or null if meshes are not cached.
+     * @see fmesher::FMesher::meshCacheKey()
+     */
+    std::shared_ptr<femm::CMeshCache> meshCache() const;
+    void setMeshCache(std::shared_ptr<femm::CMeshCache> cache);
+
+    /**
+     * @brief Remember the solution of the current problem set.
+     * @param problemFile the \c .fem file that was solved
+     * @param solution the solution, or null to discard the stored solution
+     */
+    void storeSolution(const std::string &problemFile, std::shared_ptr<const femm::CMSolution> solution);
+    /**
+     * @brief The stored solution of the current problem set.
+     * @param problemFile the \c .fem file of the problem
+     * @return the solution, or null if no solution is stored for \p problemFile
+     */
+    std::shared_ptr<const femm::CMSolution> storedSolution(const std::string &problemFile) const;
 private:
     struct ProblemSet {
         std::shared_ptr<femm::FemmProblem> document;
         std::shared_ptr<fmesher::FMesher> mesher;
         std::shared_ptr<femm::PProcIface> postProcessor;
+        std::string solutionProblemFile; ///< the problem file of \c solution
+        std::shared_ptr<const femm::CMSolution> solution;
     };
 
     ProblemSet current;
     std::vector<ProblemSet> inactiveProblems;
+    bool inMemory = false;
+    bool binarySolution = false;
+    std::shared_ptr<femm::CMeshCache> cache;
 
 
 };
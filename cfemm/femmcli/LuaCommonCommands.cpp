@@ -21,9 +21,11 @@
 #include "femmconstants.h"
 #include "femmenums.h"
 #include "FemmState.h"
+#include "fpproc.h"
 #include "locationTools.h"
 #include "LuaInstance.h"
 #include "MatlibReader.h"
+#include "solverbackend.h"
 #include "stringTools.h"
 
 #include <lua.h>
@@ -1688,6 +1690,15 @@ int femmcli::LuaCommonCommands::luaLoadSolution(lua_State *L)
         lua_error(L,"No output in focus!");
         return 0;
     }
+    // a solution that was kept in memory by the analysis replaces the solution file
+    std::shared_ptr<const femm::CMSolution> solution = femmState->storedSolution(doc->pathName);
+    std::shared_ptr<FPProc> fpproc = std::dynamic_pointer_cast<FPProc>(pproc);
+    if (solution && fpproc)
+    {
+        if (!fpproc->LoadSolution(doc->pathName, *solution))
+            lua_error(L, "loadsolution(): error while loading the solution\n");
+        return 0;
+    }
     if (!pproc->OpenDocument(solutionFile))
     {
         std::string msg = "loadsolution(): error while loading solution file:\n";
@@ -2013,11 +2024,15 @@ int femmcli::LuaCommonCommands::luaCreateMesh(lua_State *L)
         lua_error(L,"A data file must be loaded,\nor the current data must saved.");
         return 0;
     }
+    // any stored solution is outdated now
+    femmState->storeSolution(pathName, nullptr);
     if (!doc->saveFEMFile(pathName))
     {
         lua_error(L, "createmesh(): Could not save fem file!\n");
         return 0;
     }
+    // mesher->LoadMesh() reads the mesh files
+    mesher->writeMeshFiles = true;
     if (!doc->consistencyCheckOK())
     {
         lua_error(L,"createmesh(): consistency check failed before meshing!\n");
@@ -2183,6 +2198,8 @@ int femmcli::LuaCommonCommands::luaSaveDocument(lua_State *L)
     if (!lua_isnil(L,1))
     {
         doc->pathName = lua_tostring(L,1);
+        // any stored solution is outdated now
+        femmState->storeSolution(doc->pathName, nullptr);
         doc->saveFEMFile(doc->pathName);
     } else {
         lua_error(L, "saveas(): no pathname given!");
@@ -3173,4 +3190,51 @@ int femmcli::LuaCommonCommands::luaSetSmoothing(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Select the linear solver backend used by the solver.
+ * @param L
+ * @return 0
+ * \ingroup LuaCommon
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{mi_setsolver("name")}
+ * - \lua{ei_setsolver("name")}
+ * - \lua{hi_setsolver("name")}
+ *
+ * Selects one of the backends registered in solverbackend.h, e.g. "csr" (default) or "legacy".
+ * The name is stored in the problem file as \c [SolverBackend].
+ * An empty name selects the default backend.
+ *
+ * ### FEMM source:
+ * - (not in FEMM; introduced by xfemm)
+ * \endinternal
+ */
+int femmcli::LuaCommonCommands::luaSetSolverBackend(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    if (!luaExpectParameterCount(L, 1))
+        return 0;
+    if (!lua_isstring(L,1))
+    {
+        lua_error(L, "setsolver(): expected the name of a solver backend");
+        return 0;
+    }
+    std::string name (lua_tostring(L,1));
+    to_lower(name);
+    if (!femm::findLinearSolverBackend(name))
+    {
+        std::string msg = "Unknown solver backend \"" + name + "\". Available backends:";
+        for (const auto &backend: femm::linearSolverBackendNames())
+            msg += " " + backend;
+        lua_error(L, msg.c_str());
+        return 0;
+    }
+    doc->SolverBackend = name;
+    return 0;
+}
+
 // vi:expandtab:tabstop=4 shiftwidth=4:
@@ -140,6 +140,7 @@ int luaSetGroup(lua_State *L);
 int luaSetNodeProperty(lua_State *L);
 int luaSetSegmentProperty(lua_State *L);
 int luaSetSmoothing(lua_State *L);
+int luaSetSolverBackend(lua_State *L);
 }
 
 } /* namespace femmcli*/
@@ -73,6 +73,8 @@ void femmcli::LuaElectrostaticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("ei_clear_selected", LuaCommonCommands::luaClearSelected);
     li.addFunction("ei_clearselected", LuaCommonCommands::luaClearSelected);
     li.addFunction("ei_close", LuaCommonCommands::luaExitPre);
+    li.addFunction("ei_compute_capacitance", luaComputeCapacitance);
+    li.addFunction("ei_computecapacitance", luaComputeCapacitance);
     li.addFunction("ei_copy_rotate", LuaCommonCommands::luaCopyRotate);
     li.addFunction("ei_copyrotate", LuaCommonCommands::luaCopyRotate);
     li.addFunction("ei_copy_translate", LuaCommonCommands::luaCopyTranslate);
@@ -183,6 +185,8 @@ void femmcli::LuaElectrostaticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("ei_setnodeprop", LuaCommonCommands::luaSetNodeProperty);
     li.addFunction("ei_set_segment_prop", LuaCommonCommands::luaSetSegmentProperty);
     li.addFunction("ei_setsegmentprop", LuaCommonCommands::luaSetSegmentProperty);
+    li.addFunction("ei_set_solver", LuaCommonCommands::luaSetSolverBackend);
+    li.addFunction("ei_setsolver", LuaCommonCommands::luaSetSolverBackend);
     li.addFunction("ei_show_grid", LuaInstance::luaNOP);
     li.addFunction("ei_showgrid", LuaInstance::luaNOP);
     li.addFunction("ei_show_mesh", LuaInstance::luaNOP);
@@ -207,6 +211,8 @@ void femmcli::LuaElectrostaticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("eo_clear_contour", LuaCommonCommands::luaClearContourPoint);
     li.addFunction("eo_clearcontour", LuaCommonCommands::luaClearContourPoint);
     li.addFunction("eo_close", LuaCommonCommands::luaExitPost);
+    li.addFunction("eo_get_capacitance", luaGetCapacitance);
+    li.addFunction("eo_getcapacitance", luaGetCapacitance);
     li.addFunction("eo_get_conductor_properties", LuaCommonCommands::luaGetConductorProperties);
     li.addFunction("eo_getconductorproperties", LuaCommonCommands::luaGetConductorProperties);
     li.addFunction("eo_get_element", LuaCommonCommands::luaGetElement);
@@ -571,21 +577,44 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
     // allow setting verbosity from lua:
     const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
     mesherDoc->Verbose = verbose;
-    if (mesherDoc->HasPeriodicBC()){
-        if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            mesherDoc->problem->unselectAll();
-            lua_error(L, "ei_analyze(): Periodic BC triangulation failed!\n");
-            return 0;
-        }
+    // the mesh is handed to the solver in memory
+    mesherDoc->writeMeshFiles = false;
+    // look up the mesh in the cache, or mesh the problem
+    std::shared_ptr<femm::CMeshCache> meshCache = femmState->meshCache();
+    std::string meshKey;
+    mesherDoc->meshData.reset();
+    if (meshCache)
+    {
+        meshKey = mesherDoc->meshCacheKey();
+        mesherDoc->meshData = meshCache->load(meshKey);
+        if (mesherDoc->meshData && verbose)
+            PrintWarningMsg("ei_analyze(): using cached mesh\n");
     }
-    else{
-        if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
+    if (!mesherDoc->meshData)
+    {
+        if (mesherDoc->HasPeriodicBC()){
+            if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                mesherDoc->problem->unselectAll();
+                lua_error(L, "ei_analyze(): Periodic BC triangulation failed!\n");
+                return 0;
+            }
+        }
+        else{
+            if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                lua_error(L, "ei_analyze(): Nonperiodic BC triangulation failed!\n");
+                return 0;
+            }
+        }
+        if (meshCache)
         {
-            //EndWaitCursor();
-            lua_error(L, "ei_analyze(): Nonperiodic BC triangulation failed!\n");
-            return 0;
+            // keep the node numbering with the mesh, so that a cache hit also skips the renumbering in the solver
+            mesherDoc->meshData->computeNumbering();
+            if (!meshCache->store(meshKey, *mesherDoc->meshData))
+                PrintWarningMsg("ei_analyze(): could not store the mesh in %s\n", meshCache->directory().c_str());
         }
     }
     //EndWaitCursor();
@@ -601,6 +630,8 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
     theSolver.PathName = doc->pathName.substr(0,dotpos);
     theSolver.WarnMessage = &PrintWarningMsg;
     theSolver.PrintMessage = &PrintWarningMsg;
+    theSolver.meshData = mesherDoc->meshData;
+    theSolver.binarySolutionFile = femmState->binarySolutionFiles();
     if (!theSolver.LoadProblemFile())
     {
         lua_error(L, "ei_analyze(): problem initializing solver!");
@@ -621,6 +652,36 @@ int femmcli::LuaElectrostaticsCommands::luaAnalyze(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Enable or disable the computation of the capacitance matrix.
+ * @param L
+ * @return 0
+ * \ingroup LuaES
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{ei_computecapacitance(flag)}
+ *
+ * With flag set to 1, the solver also computes the capacitance matrix of all fixed-voltage conductors
+ * (see ESolver::ComputeCapacitance), which can be queried with \lua{eo_getcapacitance("cond_i","cond_j")}.
+ * The flag is stored in the problem file as \c [ComputeCapacitance].
+ *
+ * ### FEMM sources:
+ * - (not in FEMM; introduced by xfemm)
+ * \endinternal
+ */
+int femmcli::LuaElectrostaticsCommands::luaComputeCapacitance(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<FemmProblem> doc = femmState->femmDocument();
+
+    if (!luaExpectParameterCount(L, 1))
+        return 0;
+    doc->ComputeCapacitance = (lua_todouble(L,1) != 0);
+    return 0;
+}
+
 /**
  * @brief Calculate a block integral for the selected blocks.
  * @param L
@@ -687,6 +748,68 @@ int femmcli::LuaElectrostaticsCommands::luaBlockIntegral(lua_State *L)
     return 2;
 }
 
+/**
+ * @brief Get an entry of the capacitance matrix.
+ * @param L
+ * @return 1 on success, 0 otherwise
+ * \ingroup LuaES
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{eo_getcapacitance("cond_i","cond_j")}
+ *
+ * Returns the charge on conductor cond_i for 1 V on conductor cond_j and 0 V on all other fixed-voltage conductors.
+ * The solution has to be computed with \lua{ei_computecapacitance(1)}.
+ *
+ * ### FEMM sources:
+ * - (not in FEMM; introduced by xfemm)
+ * \endinternal
+ */
+int femmcli::LuaElectrostaticsCommands::luaGetCapacitance(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+
+    auto femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<ElectrostaticsPostProcessor> pproc = std::dynamic_pointer_cast<ElectrostaticsPostProcessor>(femmState->getPostProcessor());
+    if (!pproc)
+    {
+        lua_error(L,"No electrostatics output in focus");
+        return 0;
+    }
+
+    if (!luaExpectParameterCount(L, 2))
+        return 0;
+    const auto doc = pproc->getProblem();
+    int idx[2];
+    for (int k=0; k<2; k++)
+    {
+        if (!lua_isstring(L,k+1))
+        {
+            lua_error(L,"eo_getcapacitance(): expected two conductor names");
+            return 0;
+        }
+        std::string name = lua_tostring(L,k+1);
+        auto searchResult = doc->circuitMap.find(name);
+        if (searchResult == doc->circuitMap.end())
+        {
+            std::string msg = "eo_getcapacitance(): No conductor of name " + name;
+            lua_error(L,msg.c_str());
+            return 0;
+        }
+        idx[k] = searchResult->second;
+    }
+
+    double c;
+    if (!pproc->getCapacitance(idx[0], idx[1], c))
+    {
+        lua_error(L,"eo_getcapacitance(): The solution contains no capacitance for these conductors."
+                  " Only fixed-voltage conductors are included, and only if the problem was analyzed after ei_computecapacitance(1).");
+        return 0;
+    }
+    lua_pushnumber(L,c);
+    return 1;
+}
+
 /**
  * @brief Get the solution values for a point.
  * @param L
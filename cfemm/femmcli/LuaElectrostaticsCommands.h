@@ -46,7 +46,9 @@ int luaAddMaterialProperty(lua_State *L);
 int luaAddPointProperty(lua_State *L);
 int luaAnalyze(lua_State *L);
 int luaBlockIntegral(lua_State *L);
+int luaComputeCapacitance(lua_State *L);
 int luaExitPost(lua_State *L);
+int luaGetCapacitance(lua_State *L);
 int luaGetPointValues(lua_State *L);
 int luaLineIntegral(lua_State *L);
 int luaModifyBoundaryProperty(lua_State *L);
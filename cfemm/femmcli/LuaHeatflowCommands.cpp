@@ -185,6 +185,10 @@ void femmcli::LuaHeatflowCommands::registerCommands(LuaInstance &li)
     li.addFunction("hi_setnodeprop", LuaCommonCommands::luaSetNodeProperty);
     li.addFunction("hi_set_segment_prop", LuaCommonCommands::luaSetSegmentProperty);
     li.addFunction("hi_setsegmentprop", LuaCommonCommands::luaSetSegmentProperty);
+    li.addFunction("hi_set_solver", LuaCommonCommands::luaSetSolverBackend);
+    li.addFunction("hi_setsolver", LuaCommonCommands::luaSetSolverBackend);
+    li.addFunction("hi_set_time_stepping", luaSetTimeStepping);
+    li.addFunction("hi_settimestepping", luaSetTimeStepping);
     li.addFunction("hi_show_grid", LuaInstance::luaNOP);
     li.addFunction("hi_showgrid", LuaInstance::luaNOP);
     li.addFunction("hi_show_mesh", LuaInstance::luaNOP);
@@ -576,21 +580,44 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
     // allow setting verbosity from lua:
     const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
     mesherDoc->Verbose = verbose;
-    if (mesherDoc->HasPeriodicBC()){
-        if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            mesherDoc->problem->unselectAll();
-            lua_error(L, "hi_analyze(): Periodic BC triangulation failed!\n");
-            return 0;
-        }
+    // the mesh is handed to the solver in memory
+    mesherDoc->writeMeshFiles = false;
+    // look up the mesh in the cache, or mesh the problem
+    std::shared_ptr<femm::CMeshCache> meshCache = femmState->meshCache();
+    std::string meshKey;
+    mesherDoc->meshData.reset();
+    if (meshCache)
+    {
+        meshKey = mesherDoc->meshCacheKey();
+        mesherDoc->meshData = meshCache->load(meshKey);
+        if (mesherDoc->meshData && verbose)
+            PrintWarningMsg("hi_analyze(): using cached mesh\n");
     }
-    else{
-        if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
+    if (!mesherDoc->meshData)
+    {
+        if (mesherDoc->HasPeriodicBC()){
+            if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                mesherDoc->problem->unselectAll();
+                lua_error(L, "hi_analyze(): Periodic BC triangulation failed!\n");
+                return 0;
+            }
+        }
+        else{
+            if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                lua_error(L, "hi_analyze(): Nonperiodic BC triangulation failed!\n");
+                return 0;
+            }
+        }
+        if (meshCache)
         {
-            //EndWaitCursor();
-            lua_error(L, "hi_analyze(): Nonperiodic BC triangulation failed!\n");
-            return 0;
+            // keep the node numbering with the mesh, so that a cache hit also skips the renumbering in the solver
+            mesherDoc->meshData->computeNumbering();
+            if (!meshCache->store(meshKey, *mesherDoc->meshData))
+                PrintWarningMsg("hi_analyze(): could not store the mesh in %s\n", meshCache->directory().c_str());
         }
     }
     //EndWaitCursor();
@@ -606,8 +633,10 @@ int femmcli::LuaHeatflowCommands::luaAnalyze(lua_State *L)
     theSolver.PathName = doc->pathName.substr(0,dotpos);
     theSolver.WarnMessage = &PrintWarningMsg;
     theSolver.PrintMessage = &PrintWarningMsg;
+    theSolver.meshData = mesherDoc->meshData;
     theSolver.dT = doc->dT;
     theSolver.previousSolutionFile = doc->previousSolutionFile;
+    theSolver.binarySolutionFile = femmState->binarySolutionFiles();
     if (!theSolver.LoadProblemFile())
     {
         lua_error(L, "hi_analyze(): problem initializing solver!");
@@ -720,6 +749,71 @@ int femmcli::LuaHeatflowCommands::luaProblemDefinition(lua_State *L)
     return 0;
 }
 
+/**
+ * @brief Set up the time stepping of transient problems.
+ *
+ * @param L
+ * @return 0
+ * \ingroup LuaHF
+ *
+ * \internal
+ * ### Implements:
+ * - \lua{hi_settimestepping(dT,steps,(scheme),(tolerance),(interval),(timeseries),(T0))}
+ *
+ * hsolver integrates over \c steps*dT in a single run, keeping the mesh and the matrices.
+ * - \c scheme: 0 backward Euler (default), 1 BDF2, 2 Crank-Nicolson
+ * - \c tolerance: local error [K] per step for adaptive steps, starting with \c dT; 0 (default) for fixed steps
+ * - \c interval: write every \c interval-th step; 0 (default) writes only the last step
+ * - \c timeseries: 1 to write the steps to a single file (\c .tsh) instead of one \c .anh file each
+ * - \c T0: initial temperature, if no previous solution is set with hi_probdef
+ *
+ * Zero steps switch back to the single time step of FEMM.
+ *
+ * ### FEMM source:
+ * - (not in FEMM; introduced by xfemm)
+ * \endinternal
+ */
+int femmcli::LuaHeatflowCommands::luaSetTimeStepping(lua_State *L)
+{
+    auto luaInstance = LuaInstance::instance(L);
+    std::shared_ptr<FemmState> femmState = std::dynamic_pointer_cast<FemmState>(luaInstance->femmState());
+    std::shared_ptr<femm::FemmProblem> doc = femmState->femmDocument();
+
+    if (!luaExpectParameterCount(L, 2, 7))
+        return 0;
+    int n=lua_gettop(L);
+
+    double dT = lua_tonumber(L,1).re;
+    int steps = (int) lua_tonumber(L,2).re;
+    if (steps < 0 || (steps > 0 && dT <= 0))
+    {
+        lua_error(L, "hi_settimestepping(): invalid time step or number of steps");
+        return 0;
+    }
+    int scheme = 0;
+    if (n>2)
+        scheme = (int) lua_tonumber(L,3).re;
+    if (scheme < 0 || scheme > 2)
+    {
+        std::string msg = "hi_settimestepping(): unknown scheme " + std::to_string(scheme);
+        lua_error(L, msg.c_str());
+        return 0;
+    }
+
+    doc->TimeSteps = steps;
+    doc->TimeScheme = scheme;
+    doc->TimeTolerance = (n>3) ? lua_tonumber(L,4).re : 0;
+    doc->OutputInterval = (n>4) ? (int) lua_tonumber(L,5).re : 0;
+    doc->TimeSeries = (n>5) ? (int) lua_tonumber(L,6).re : 0;
+    doc->InitialTemperature = (n>6) ? lua_tonumber(L,7).re : 0;
+    if (steps > 0)
+        doc->dT = dT;
+    else if (doc->previousSolutionFile.empty())
+        doc->dT = 0;
+
+    return 0;
+}
+
 /**
  * @brief Calculate a block integral for the selected blocks
  * @param L
@@ -56,6 +56,7 @@ int luaModifyMaterialProperty(lua_State *L);
 int luaModifyPointProperty(lua_State *L);
 int luaNewDocument(lua_State *L);
 int luaProblemDefinition(lua_State *L);
+int luaSetTimeStepping(lua_State *L);
 }
 
 } /* namespace FemmLua*/
@@ -251,6 +251,8 @@ void femmcli::LuaMagneticsCommands::registerCommands(LuaInstance &li)
     li.addFunction("mi_setnodeprop", luaSetNodeProperty);
     li.addFunction("mi_set_segment_prop", luaSetSegmentProperty);
     li.addFunction("mi_setsegmentprop", luaSetSegmentProperty);
+    li.addFunction("mi_set_solver", LuaCommonCommands::luaSetSolverBackend);
+    li.addFunction("mi_setsolver", LuaCommonCommands::luaSetSolverBackend);
     li.addFunction("mo_show_contour_plot", LuaInstance::luaNOP);
     li.addFunction("mo_showcontourplot", LuaInstance::luaNOP);
     li.addFunction("mo_show_density_plot", LuaInstance::luaNOP);
@@ -774,6 +776,8 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
         lua_error(L,"A data file must be loaded,\nor the current data must saved.");
         return 0;
     }
+    // any stored solution is outdated now
+    femmState->storeSolution(pathName, nullptr);
     if (!doc->saveFEMFile(pathName))
     {
         lua_error(L, "mi_analyze(): Could not save fem file!\n");
@@ -790,21 +794,44 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
     // allow setting verbosity from lua:
     const bool verbose = (luaInstance->getGlobal("XFEMM_VERBOSE") != 0);
     mesherDoc->Verbose = verbose;
-    if (mesherDoc->HasPeriodicBC()){
-        if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
-        {
-            //EndWaitCursor();
-            mesherDoc->problem->unselectAll();
-            lua_error(L, "mi_analyze(): Periodic BC triangulation failed!\n");
-            return 0;
+    // the mesh is handed to the solver in memory
+    mesherDoc->writeMeshFiles = false;
+    // look up the mesh in the cache, or mesh the problem
+    std::shared_ptr<femm::CMeshCache> meshCache = femmState->meshCache();
+    std::string meshKey;
+    mesherDoc->meshData.reset();
+    if (meshCache)
+    {
+        meshKey = mesherDoc->meshCacheKey();
+        mesherDoc->meshData = meshCache->load(meshKey);
+        if (mesherDoc->meshData && verbose)
+            PrintWarningMsg("mi_analyze(): using cached mesh\n");
+    }
+    if (!mesherDoc->meshData)
+    {
+        if (mesherDoc->HasPeriodicBC()){
+            if (mesherDoc->DoPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                mesherDoc->problem->unselectAll();
+                lua_error(L, "mi_analyze(): Periodic BC triangulation failed!\n");
+                return 0;
+            }
         }
-    }
-    else{
-        if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
+        else{
+            if (mesherDoc->DoNonPeriodicBCTriangulation(pathName) != 0)
+            {
+                //EndWaitCursor();
+                lua_error(L, "mi_analyze(): Nonperiodic BC triangulation failed!\n");
+                return 0;
+            }
+        }
+        if (meshCache)
         {
-            //EndWaitCursor();
-            lua_error(L, "mi_analyze(): Nonperiodic BC triangulation failed!\n");
-            return 0;
+            // keep the node numbering with the mesh, so that a cache hit also skips the renumbering in the solver
+            mesherDoc->meshData->computeNumbering();
+            if (!meshCache->store(meshKey, *mesherDoc->meshData))
+                PrintWarningMsg("mi_analyze(): could not store the mesh in %s\n", meshCache->directory().c_str());
         }
     }
     //EndWaitCursor();
@@ -820,6 +847,10 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
     theFSolver.PathName = doc->pathName.substr(0,dotpos);
     theFSolver.WarnMessage = &PrintWarningMsg;
     theFSolver.PrintMessage = &PrintWarningMsg;
+    theFSolver.meshData = mesherDoc->meshData;
+    theFSolver.keepSolution = femmState->inMemoryAnalysis();
+    theFSolver.writeSolutionFile = !femmState->inMemoryAnalysis();
+    theFSolver.binarySolutionFile = femmState->binarySolutionFiles();
     // not supported yet, but set the previous solution so that we can detect this case afterwards:
     theFSolver.previousSolutionFile = doc->previousSolutionFile;
     if (!theFSolver.LoadProblemFile())
@@ -839,7 +870,10 @@ int femmcli::LuaMagneticsCommands::luaAnalyze(lua_State *L)
     if (!theFSolver.runSolver(verbose))
     {
         lua_error(L, "solver failed.");
+        return 0;
     }
+    if (theFSolver.keepSolution)
+        femmState->storeSolution(pathName, theFSolver.solution);
     return 0;
 }
 
@@ -9,6 +9,7 @@
  * along with the source code.
  */
 
+#include "bhcache.h"
 #include "CliTools.h"
 #include "FemmState.h"
 #include "femmversion.h"
@@ -19,9 +20,14 @@
 #include "LuaElectrostaticsCommands.h"
 #include "LuaHeatflowCommands.h"
 #include "LuaMagneticsCommands.h"
+#include "meshcache.h"
+#include "parallel.h"
+#include "solutionfile.h"
 #include "stringTools.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <memory>
 #include <iostream>
 #include <string>
@@ -48,12 +54,18 @@ bool quiet = false;
  * \param luaInit a lua file containing initialization code
  * \param luaTrace enable function tracing for lua
  * \param luaBaseDir base directory for lua
+ * \param inMemory keep magnetics solutions in memory instead of writing \c .ans files
+ * \param binarySolution write binary solution files
+ * \param meshCache the mesh cache, or null
  * \return the result of lua_dostring()
  */
-int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool luaTrace, const std::string &luaBaseDir, bool luaPedanticMode, bool luaDebugGeometry)
+int execLuaFile( const std::string &inputFile, const std::string &luaInit, bool luaTrace, const std::string &luaBaseDir, bool luaPedanticMode, bool luaDebugGeometry, bool inMemory, bool binarySolution, std::shared_ptr<CMeshCache> meshCache)
 {
     // initialize interpreter
     shared_ptr<FemmState> state = make_shared<FemmState>();
+    state->setInMemoryAnalysis(inMemory);
+    state->setBinarySolutionFiles(binarySolution);
+    state->setMeshCache(meshCache);
     LuaInstance li(static_pointer_cast<FemmStateBase>(state));
     LuaBaseCommands::registerCommands(li);
     LuaMagneticsCommands::registerCommands(li);
@@ -126,6 +138,12 @@ int main(int argc, char ** argv)
     bool luaTrace = false;
     bool luaPedanticMode = false;
     bool luaDebugGeometry = false;
+    std::string bhCacheFile;
+    long bhCacheSize = static_cast<long>(femm::CBHCurveCache::DefaultMaxCurves);
+    bool inMemory = false;
+    bool binarySolution = false;
+    std::string meshCacheDir;
+    long meshCacheSize = 1024;
 
     for(int i=1; i<argc; i++)
     {
@@ -178,6 +196,77 @@ int main(int argc, char ** argv)
                 std::cerr << "Using custom base directory " << baseDir << std::endl;
             continue;
         }
+        if (arg == "--threads")
+        {
+            if (value.empty())
+            {
+                i++;
+                if (i<argc)
+                    value = argv[i];
+            }
+            femm::setNumThreads(std::atoi(value.c_str()));
+            if (!quiet)
+                std::cerr << "Using " << femm::numThreads() << " thread(s) for the linear solver" << std::endl;
+            continue;
+        }
+        if (arg == "--bh-cache")
+        {
+            if (value.empty())
+            {
+                i++;
+                if (i<argc)
+                    bhCacheFile = argv[i];
+            } else {
+                bhCacheFile = value;
+            }
+            continue;
+        }
+        if (arg == "--bh-cache-size")
+        {
+            if (value.empty())
+            {
+                i++;
+                if (i<argc)
+                    value = argv[i];
+            }
+            bhCacheSize = std::atol(value.c_str());
+            continue;
+        }
+        if (arg == "--mesh-cache")
+        {
+            if (value.empty())
+            {
+                i++;
+                if (i<argc)
+                    meshCacheDir = argv[i];
+            } else {
+                meshCacheDir = value;
+            }
+            continue;
+        }
+        if (arg == "--mesh-cache-size")
+        {
+            if (value.empty())
+            {
+                i++;
+                if (i<argc)
+                    value = argv[i];
+            }
+            meshCacheSize = std::atol(value.c_str());
+            continue;
+        }
+        if (arg == "--in-memory" )
+        {
+            inMemory = true;
+            continue;
+        }
+        if (arg == "--binary-solution" )
+        {
+            binarySolution = femm::CSolutionFile::hostByteOrderSupported();
+            if (!binarySolution)
+                std::cerr << "Binary solution files need a little-endian host; writing text solution files" << std::endl;
+            continue;
+        }
         if (arg == "--version" )
         {
             std::cout << "femmcli version " << FEMM_VERSION_STRING << "\n"
@@ -211,10 +300,18 @@ int main(int argc, char ** argv)
         }
         std::cout << "Command-line interpreter for FEMM-specific lua files.\n";
         std::cout << "\n";
-        std::cout << "Usage: " << exe << " [-q|--quiet] [--lua-trace-functions] [--lua-pedantic-mode] [--lua-init=<init.lua>] [--lua-base-dir=<dir>] --lua-script=<file.lua>\n";
+        std::cout << "Usage: " << exe << " [-q|--quiet] [--lua-trace-functions] [--lua-pedantic-mode] [--lua-init=<init.lua>] [--lua-base-dir=<dir>] [--threads=<n>] [--bh-cache=<file>] [--bh-cache-size=<n>] [--in-memory] [--binary-solution] [--mesh-cache=<dir>] [--mesh-cache-size=<MiB>] --lua-script=<file.lua>\n";
         std::cout << "       " << exe << " [-h|--help] [--version]\n";
         std::cout << "\n";
         std::cout << "Command line arguments:\n";
+        std::cout << " --bh-cache=<file>        Load the processed BH curves of harmonic problems from the file,\n";
+        std::cout << "                          and save them to it when the script is done.\n";
+        std::cout << " --bh-cache-size=<n>      Number of processed BH curves kept in memory; the least recently\n";
+        std::cout << "                          used curves are removed. 0 means no limit. [default: " << bhCacheSize << "]\n";
+        std::cout << " --binary-solution        Write solution files (.ans, .anh, .res) in the binary format,\n";
+        std::cout << "                          which the postprocessors load much faster.\n";
+        std::cout << " --in-memory              Keep the solutions of magnetics problems in memory\n";
+        std::cout << "                          instead of writing .ans files.\n";
         std::cout << " --lua-base-dir=<dir>     Set base directory for matlib.dat.\n";
         std::cout << "                          [default: " << baseDir << "]\n";
         std::cout << " --lua-debug-geometry     Debug lua functions that change the geometry of the model\n";
@@ -223,6 +320,13 @@ int main(int argc, char ** argv)
         std::cout << " --lua-pedantic-mode      Additional checks for lua scripts.\n";
         std::cout << " --lua-script=<file.lua>  Execute the lua file.\n";
         std::cout << " --lua-trace-functions    Show what lua functions are being executed.\n";
+        std::cout << " --mesh-cache=<dir>       Keep the meshes of the analyze commands in the directory,\n";
+        std::cout << "                          and reuse them if the geometry and mesh settings are unchanged.\n";
+        std::cout << "                          The directory can be shared by concurrent processes.\n";
+        std::cout << " --mesh-cache-size=<MiB>  Size limit of the mesh cache; the least recently used meshes\n";
+        std::cout << "                          are removed. 0 means no limit. [default: " << meshCacheSize << "]\n";
+        std::cout << " --threads=<n>            Number of threads used by the linear solvers.\n";
+        std::cout << "                          [default: " << femm::numThreads() << "]\n";
         std::cout << "\n";
         std::cout << "Additional options:\n";
         std::cout << " -h, --help               Show this help message and exit.\n";
@@ -247,6 +351,27 @@ int main(int argc, char ** argv)
         return 1;
     }
 
-    return execLuaFile(inputFile, luaInit, luaTrace, baseDir, luaPedanticMode, luaDebugGeometry);
+    femm::CBHCurveCache &bhCache = femm::CBHCurveCache::global();
+    bhCache.SetMaxCurves(static_cast<size_t>(std::max(bhCacheSize,0L)));
+    if (!bhCacheFile.empty())
+    {
+        // a missing file is fine: it is created below
+        if (bhCache.Load(bhCacheFile) && !quiet)
+            std::cerr << "Loaded " << bhCache.Size() << " BH curve(s) from " << bhCacheFile << std::endl;
+    }
+
+    std::shared_ptr<CMeshCache> meshCache;
+    if (!meshCacheDir.empty())
+    {
+        meshCache = std::make_shared<CMeshCache>(meshCacheDir, static_cast<uint64_t>(std::max(meshCacheSize,0L)) << 20);
+        if (!quiet)
+            std::cerr << "Using mesh cache " << meshCacheDir << std::endl;
+    }
+
+    int result = execLuaFile(inputFile, luaInit, luaTrace, baseDir, luaPedanticMode, luaDebugGeometry, inMemory, binarySolution, meshCache);
+
+    if (!bhCacheFile.empty() && !bhCache.Save(bhCacheFile))
+        std::cerr << "Could not write BH curve cache " << bhCacheFile << std::endl;
+    return result;
 }
 // vi:expandtab:tabstop=4 shiftwidth=4:
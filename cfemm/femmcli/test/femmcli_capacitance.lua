@@ -0,0 +1,64 @@
+-- femmcli_capacitance.lua
+-- The capacitance matrix, computed together with the problem (ei_computecapacitance),
+-- has to match the charges of sequential single solves with 1 V on one conductor and 0 V on the other.
+-- The file femmcli_capacitance.fee is the same as femmcli_epproc.fee
+-- SUCCESS
+showconsole()
+
+-- compare <value> against <expected> value
+-- if the relative difference is greater than the margin (in percent), complain and return 1
+function check(name, value, expected, margin)
+	diff=100*(value - expected) / expected
+	if abs(diff) > margin then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", diff: " .. diff .. "%, margin: " .. margin .. "%)")
+	return fail
+end
+
+conductors = {"m1t", "b1segm"}
+
+open("femmcli_capacitance.fee")
+ei_saveas("femmcli_capacitance_block.fee")
+ei_computecapacitance(1)
+ei_createmesh()
+ei_analyze(0)
+ei_loadsolution()
+C = {}
+for i = 1, 2 do
+	C[i] = {}
+	for j = 1, 2 do
+		C[i][j] = eo_getcapacitance(conductors[i], conductors[j])
+	end
+end
+
+-- the regular solution is still there:
+V = eo_getpointvalues(0.250, 0)
+failed=0
+failed= failed +check("V", V, 48.37056814422403, 1)
+
+-- sequential solves, one load case at a time:
+ei_computecapacitance(0)
+ei_saveas("femmcli_capacitance_single.fee")
+for j = 1, 2 do
+	for k = 1, 2 do
+		if k == j then
+			ei_modifyconductorprop(conductors[k], 1, 1)
+		else
+			ei_modifyconductorprop(conductors[k], 1, 0)
+		end
+	end
+	ei_analyze(0)
+	ei_loadsolution()
+	for i = 1, 2 do
+		v, q = eo_getconductorproperties(conductors[i])
+		failed= failed +check("C(" .. conductors[i] .. "," .. conductors[j] .. ")", C[i][j], q, 1e-6)
+	end
+end
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,98 @@
+-- femmcli_linsolve.lua
+-- The preconditioners and linear solvers selected in the problem header
+-- have to give the same solution as the default solver (PCG with SSOR).
+-- The variants of the models are generated by test_lua_variant() in CMakeLists.txt;
+-- the models are the same as femmcli_femfile.fem, femmcli_epproc.fee and femmcli_hpproc.feh.
+-- SUCCESS
+showconsole()
+
+-- compare <value> against <expected> value
+-- complain and return 1 if the difference is greater than <margin> times <scale>
+function check(name, value, expected, scale, margin)
+	diff=abs(value - expected)/scale
+	if diff > margin then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", diff: " .. diff .. " of " .. scale .. ", margin: " .. margin .. ")")
+	return fail
+end
+
+-- analyze <file> and return the potential (A, V or T) at the element centroids
+-- <prefix> is the prefix of the lua commands for the problem type ("m", "e" or "h")
+-- <setup> (optional) is called to modify the model before the analysis
+function solve(file, prefix, setup)
+	open(file)
+	if setup then
+		setup()
+	end
+	getglobal(prefix .. "i_analyze")(1)
+	getglobal(prefix .. "i_loadsolution")()
+	local result = {}
+	local n = getglobal(prefix .. "o_numelements")()
+	-- every 37th element is enough to cover the model
+	for i = 1, n, 37 do
+		local p1,p2,p3,x,y = getglobal(prefix .. "o_getelement")(i)
+		tinsert(result, {x, y, getglobal(prefix .. "o_getpointvalues")(x,y)})
+	end
+	return result
+end
+
+-- compare the solution of <variant> against the solution of <file>
+function compare(name, file, variant, prefix, setup)
+	local expected = solve(file, prefix, setup)
+	local actual = solve(variant, prefix, setup)
+	local scale = 0
+	for i = 1, getn(expected) do
+		scale = max(scale, abs(expected[i][3]))
+	end
+	local worst = 1
+	for i = 1, getn(actual) do
+		if abs(actual[i][3]-expected[i][3]) > abs(actual[worst][3]-expected[worst][3]) then
+			worst = i
+		end
+	end
+	return check(name .. " @ " .. actual[worst][1] .. ", " .. actual[worst][2], actual[worst][3], expected[worst][3], scale, 1e-5)
+end
+
+-- femmcli_femfile.fem has on-edge laminations, which are not supported in AC analyses,
+-- and its coils carry next to no current
+function harmonic()
+	mi_modifymaterial("1117 Steel", 9, 0)
+	mi_modifycircprop("Coil A", 1, 1)
+	mi_saveas("femmcli_linsolve_result.fem")
+end
+
+-- the same with Newton-Raphson iterations for the nonlinear materials
+function newton()
+	mi_probdef(50, "meters", "planar", 1e-8, 1.635130595832468, 30, 1)
+	harmonic()
+end
+
+failed=0
+
+-- incomplete Cholesky preconditioner
+failed = failed + compare("magnetics, IC(0)", "femmcli_femfile.fem", "femmcli_linsolve_ic0.fem", "m")
+failed = failed + compare("magnetics, IC(2)", "femmcli_femfile.fem", "femmcli_linsolve_ic2.fem", "m")
+failed = failed + compare("electrostatics, IC(0)", "femmcli_epproc.fee", "femmcli_linsolve_ic0.fee", "e")
+failed = failed + compare("heat flow, IC(0)", "femmcli_hpproc.feh", "femmcli_linsolve_ic0.feh", "h")
+
+-- smoothed aggregation multigrid preconditioner
+failed = failed + compare("magnetics, AMG", "femmcli_femfile.fem", "femmcli_linsolve_amg.fem", "m")
+failed = failed + compare("electrostatics, AMG", "femmcli_epproc.fee", "femmcli_linsolve_amg.fee", "e")
+failed = failed + compare("heat flow, AMG", "femmcli_hpproc.feh", "femmcli_linsolve_amg.feh", "h")
+
+-- sparse direct Cholesky solver
+failed = failed + compare("magnetics, Cholesky", "femmcli_femfile.fem", "femmcli_linsolve_direct.fem", "m")
+failed = failed + compare("electrostatics, Cholesky", "femmcli_epproc.fee", "femmcli_linsolve_direct.fee", "e")
+failed = failed + compare("heat flow, Cholesky", "femmcli_hpproc.feh", "femmcli_linsolve_direct.feh", "h")
+
+-- complex sparse direct solver
+failed = failed + compare("magnetics, harmonic, LDL^T", "femmcli_linsolve_harmonic.fem", "femmcli_linsolve_harmonic_direct.fem", "m", harmonic)
+failed = failed + compare("magnetics, harmonic, Newton, block LDU", "femmcli_linsolve_harmonic.fem", "femmcli_linsolve_harmonic_direct.fem", "m", newton)
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,71 @@
+-- femmcli_newton.lua
+-- The Newton iteration of nonlinear magnetostatic problems has to converge on a saturated model,
+-- with every linear solver and preconditioner (which keep their factorization for some of the steps),
+-- to the solution of a solve with a much tighter tolerance.
+-- The model is femmcli_fpproc.fem with 100 A in "Coil A", which drives the steel deep into saturation.
+-- The variants of the model are generated by test_lua_variant() in CMakeLists.txt.
+-- SUCCESS
+showconsole()
+
+-- compare <value> against <expected> value
+-- complain and return 1 if the difference is greater than <margin> times <scale>
+function check(name, value, expected, scale, margin)
+	diff=abs(value - expected)/scale
+	if diff > margin then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", diff: " .. diff .. " of " .. scale .. ", margin: " .. margin .. ")")
+	return fail
+end
+
+-- analyze <file> with the given <precision>,
+-- and return the vector potential and the flux density at the element centroids
+function solve(file, precision)
+	open(file)
+	mi_modifycircprop("Coil A", 1, 100)
+	mi_probdef(0, "meters", "planar", precision)
+	mi_saveas("femmcli_newton_result.fem")
+	mi_analyze(1)
+	mi_loadsolution()
+	local result = {}
+	local n = mo_numelements()
+	-- every 37th element is enough to cover the model
+	for i = 1, n, 37 do
+		local p1,p2,p3,x,y = mo_getelement(i)
+		local A,B1,B2 = mo_getpointvalues(x,y)
+		tinsert(result, {x, y, A, sqrt(B1^2+B2^2)})
+	end
+	return result
+end
+
+-- compare the solutions of <actual> and <expected> in column <col>
+function compare(name, actual, expected, col, margin)
+	local scale = 0
+	for i = 1, getn(expected) do
+		scale = max(scale, abs(expected[i][col]))
+	end
+	local worst = 1
+	for i = 1, getn(actual) do
+		if abs(actual[i][col]-expected[i][col]) > abs(actual[worst][col]-expected[worst][col]) then
+			worst = i
+		end
+	end
+	return check(name .. " @ " .. actual[worst][1] .. ", " .. actual[worst][2], actual[worst][col], expected[worst][col], scale, margin)
+end
+
+reference = solve("femmcli_fpproc.fem", 1e-12)
+
+failed=0
+-- the iteration stops once the relative update is below 100 times the precision (1e-8)
+for _, variant in {{"SSOR", "femmcli_fpproc.fem"}, {"IC(0)", "femmcli_newton_ic0.fem"}, {"AMG", "femmcli_newton_amg.fem"}, {"Cholesky", "femmcli_newton_direct.fem"}} do
+	local solution = solve(variant[2], 1e-8)
+	failed = failed + compare(variant[1] .. ", A", solution, reference, 3, 1e-6)
+	failed = failed + compare(variant[1] .. ", |B|", solution, reference, 4, 1e-6)
+end
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,79 @@
+-- femmcli_periodic.lua
+-- The CSR solver backend eliminates the periodic and antiperiodic node pairs from the system,
+-- the legacy backend averages the rows of each pair.
+-- Both have to give the same solution for periodic and antiperiodic problems,
+-- static (linear and nonlinear) and harmonic.
+-- The models are the same as femmcli_fpproc.fem and femmcli_antiperiodicBC_flux.fem.
+-- SUCCESS
+showconsole()
+
+-- compare <value> against <expected> value
+-- complain and return 1 if the difference is greater than <margin> times <scale>
+function check(name, value, expected, scale, margin)
+	diff=abs(value - expected)/scale
+	if diff > margin then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", diff: " .. diff .. " of " .. scale .. ", margin: " .. margin .. ")")
+	return fail
+end
+
+-- analyze with solver backend <backend>, and return the vector potential at the element centroids
+function solve(backend)
+	mi_setsolver(backend)
+	mi_analyze(1)
+	mi_loadsolution()
+	local result = {}
+	local n = mo_numelements()
+	-- every 97th element is enough to cover the model
+	for i = 1, n, 97 do
+		local p1,p2,p3,x,y = mo_getelement(i)
+		tinsert(result, {x, y, mo_getpointvalues(x,y)})
+	end
+	return result
+end
+
+-- compare the solutions of both backends for the problem in focus
+function compare(name)
+	local csr = solve("csr")
+	local legacy = solve("legacy")
+	local scale = 0
+	for i = 1, getn(legacy) do
+		scale = max(scale, abs(legacy[i][3]))
+	end
+	local worst = 1
+	for i = 1, getn(csr) do
+		if abs(csr[i][3]-legacy[i][3]) > abs(csr[worst][3]-legacy[worst][3]) then
+			worst = i
+		end
+	end
+	return check(name .. ": A @ " .. csr[worst][1] .. ", " .. csr[worst][2], csr[worst][3], legacy[worst][3], scale, 1e-4)
+end
+
+failed=0
+
+-- periodic, static
+-- the coils carry next to no current in the original model
+open("femmcli_fpproc.fem")
+mi_modifycircprop("Coil A", 1, 1)
+mi_saveas("femmcli_periodic_pbc.fem")
+failed = failed + compare("periodic, static")
+
+-- periodic, harmonic
+-- on-edge laminations are not supported in AC analyses
+mi_probdef(50)
+mi_modifymaterial("1117 Steel", 9, 0)
+mi_saveas("femmcli_periodic_pbc_harmonic.fem")
+failed = failed + compare("periodic, harmonic")
+
+-- antiperiodic, static and nonlinear
+open("femmcli_antiperiodicBC_flux.fem")
+mi_saveas("femmcli_periodic_apbc.fem")
+failed = failed + compare("antiperiodic, nonlinear")
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,58 @@
+-- femmcli_reproducible.lua
+-- Analyzing the same problem twice in one session has to give the same solution,
+-- no matter what was analyzed in between.
+-- It takes a few dozen meshes until the heap of the process looks different enough
+-- to expose results that depend on memory addresses (e.g. the order of the mesh edges).
+-- The model is the same as femmcli_TorqueBenchmark.fem.
+-- Output:
+-- SUCCESS
+showconsole()
+
+-- analyze the problem at rotor angle <deg>,
+-- and return the torque and a few values of the solution
+function solve(deg)
+	mi_modifyboundprop("AGE",10,deg)
+	mi_modifyboundprop("AGE",11,0)
+	mi_saveas("femmcli_reproducible_" .. deg .. ".fem")
+	mi_createmesh()
+	mi_analyze()
+	mi_loadsolution()
+	local result = {}
+	result.torque = mo_gapintegral("AGE", 0)
+	result.A = mo_getpointvalues(0.5, 0.5)
+	result.numnodes = mo_numnodes()
+	return result
+end
+
+-- compare <value> against <expected> value, both have to be equal
+function check(name, value, expected)
+	if value == expected then
+		fail=0
+		result="[  ok  ] "
+	else
+		fail=1
+		result="[FAILED] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ")")
+	return fail
+end
+
+open("femmcli_reproducible.fem")
+
+first = solve(30)
+-- change the state of the session:
+-- other solutions, verbose output, more meshes
+XFEMM_VERBOSE = 1
+for deg = 0, 29 do
+	solve(deg)
+end
+XFEMM_VERBOSE = 0
+second = solve(30)
+
+failed=0
+for _, name in {"torque", "A", "numnodes"} do
+	failed = failed + check(name, second[name], first[name])
+end
+
+assert(failed==0)
+write("SUCCESS\n")
@@ -0,0 +1,88 @@
+-- femmcli_transient.lua
+-- Time integration of a transient heat flow problem (hi_settimestepping):
+-- a slab 0 < x < 1 with a uniform heat source, the temperature fixed to 0 at x=0,
+-- insulated elsewhere, and starting at T=0.
+-- 1. With BDF2 and Crank-Nicolson, the temperature at the insulated end matches the series solution.
+-- 2. The time discretization error is first order for backward Euler, and second order for BDF2 and Crank-Nicolson.
+-- SUCCESS
+showconsole()
+
+-- check variable <name>,
+-- compare <value> against <expected> value
+-- if the relative difference is greater than the margin (in percent), complain and return 1
+function check(name, value, expected, margin)
+	diff=100*(value - expected) / expected
+	if abs(diff) > margin then
+		fail=1
+		result="[FAILED] "
+	else
+		fail=0
+		result="[  ok  ] "
+	end
+	print(result .. name .. ": " .. value .. " (expected: " .. expected .. ", diff: " .. diff .. "%, margin: " .. margin .. "%)")
+	return fail
+end
+
+-- heat source, conductivity and volumetric heat capacity (kt of hi_addmaterial)
+q = 100
+k = 1
+c = 1
+tEnd = 0.1
+
+newdocument(2)
+hi_probdef("meters","planar",1e-10,1,30)
+hi_addnode(0,0)
+hi_addnode(1,0)
+hi_addnode(1,0.2)
+hi_addnode(0,0.2)
+hi_addsegment(0,0,1,0)
+hi_addsegment(1,0,1,0.2)
+hi_addsegment(1,0.2,0,0.2)
+hi_addsegment(0,0.2,0,0)
+hi_addmaterial("slab",k,k,q,c)
+hi_addboundprop("cold",0,0,0,0,0,0)
+hi_addblocklabel(0.5,0.1)
+hi_selectlabel(0.5,0.1)
+hi_setblockprop("slab",0,0.05,0)
+hi_clearselected()
+hi_selectsegment(0,0.1)
+hi_setsegmentprop("cold",0,1,0,0,"")
+hi_clearselected()
+hi_saveas("femmcli_transient.feh")
+
+-- integrate up to tEnd with <steps> fixed steps of <scheme>,
+-- and return the temperature at the insulated end
+function solve(scheme, steps)
+	hi_settimestepping(tEnd/steps, steps, scheme, 0, 0, 0, 0)
+	hi_analyze()
+	hi_loadsolution()
+	return ho_getpointvalues(1, 0.1)
+end
+
+-- series solution at x=1: T = q/(2k) - sum 2q/(k l^3) (-1)^n exp(-l^2 k/c t), l=(2n+1) pi/2
+exact = q/(2*k)
+sign = 1
+for n = 0, 50 do
+	l = (2*n+1)*PI/2
+	exact = exact - sign*2*q/(k*l^3)*exp(-l^2*k/c*tEnd)
+	sign = -sign
+end
+
+failed=0
+failed = failed + check("T (BDF2)", solve(1, 40), exact, 0.1)
+failed = failed + check("T (Crank-Nicolson)", solve(2, 40), exact, 0.1)
+
+-- the spatial error is the same for all step sizes, so compare against many small steps
+reference = solve(1, 640)
+names = {"backward Euler", "BDF2", "Crank-Nicolson"}
+orders = {2, 4, 4}
+for scheme = 0, 2 do
+	local e10 = solve(scheme, 10) - reference
+	local e20 = solve(scheme, 20) - reference
+	local e40 = solve(scheme, 40) - reference
+	failed = failed + check("error ratio 10/20 steps (" .. names[scheme+1] .. ")", e10/e20, orders[scheme+1], 12)
+	failed = failed + check("error ratio 20/40 steps (" .. names[scheme+1] .. ")", e20/e40, orders[scheme+1], 12)
+end
+
+assert(failed==0)
+write("SUCCESS\n")
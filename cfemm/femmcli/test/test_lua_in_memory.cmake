@@ -0,0 +1,31 @@
+## cmake -DFEMMCLI=<exe> -DBASE_DIR=<dir> -DSCRIPT=<file.lua> -DFILES=<files> -P test_lua_in_memory.cmake
+# Run <file.lua> twice, once writing and reading the solution files, and once with --in-memory.
+# Each run gets a directory of its own with copies of <files>,
+# so that the run with --in-memory cannot read a solution file left over by the other run.
+# Both runs have to succeed and print the same output.
+
+foreach(mode file in-memory)
+    file(REMOVE_RECURSE "${mode}")
+    file(MAKE_DIRECTORY "${mode}")
+    file(COPY ${FILES} DESTINATION "${mode}")
+    if(mode STREQUAL "in-memory")
+        set(args --in-memory)
+    else()
+        set(args)
+    endif()
+    execute_process(
+        COMMAND "${FEMMCLI}" ${args} --lua-base-dir "${BASE_DIR}" --lua-script "${SCRIPT}"
+        WORKING_DIRECTORY "${mode}"
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output_${mode}
+        ERROR_VARIABLE output_${mode}
+        )
+    message("${mode}:\n${output_${mode}}")
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${SCRIPT} failed with ${mode} solutions")
+    endif()
+endforeach()
+
+if(NOT output_file STREQUAL output_in-memory)
+    message(FATAL_ERROR "${SCRIPT}: the output with --in-memory differs from the output with solution files")
+endif()
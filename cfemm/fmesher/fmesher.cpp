@@ -32,6 +32,7 @@
 #include "fparse.h"
 #include "IntPoint.h"
 #include "make_unique.h"
+#include "textwriter.h"
 
 #include "triangle_version.h"
 
@@ -138,20 +139,22 @@ bool FMesher::SaveFEMFile(string PathName)
         return false;
     }
 
+    femm::CTextWriter out(fp);
+
     // echo the start of the input file
     for (i = 0; i < probdescstrings.size (); i++)
     {
-        fprintf(fp,"%s", probdescstrings[i].c_str () );
+        out << probdescstrings[i];
     }
 
     // write out node list
-    fprintf(fp,"[NumPoints] = %i\n", (int) problem->nodelist.size());
+    out << "[NumPoints] = " << (int) problem->nodelist.size() << '\n';
     for(i=0; i<problem->nodelist.size(); i++)
     {
         for(j=0,t=0; j<problem->nodeproplist.size(); j++)
             if(problem->nodeproplist[j]->PointName==problem->nodelist[i]->BoundaryMarkerName) t=j+1;
-        fprintf(fp,"%.17g\t%.17g\t%i\t%i",problem->nodelist[i]->x,problem->nodelist[i]->y,t,
-                problem->nodelist[i]->InGroup);
+        out << problem->nodelist[i]->x << '\t' << problem->nodelist[i]->y << '\t' << t << '\t'
+            << problem->nodelist[i]->InGroup;
 
         if (problem->filetype == femm::FileType::HeatFlowFile
                 || problem->filetype == femm::FileType::ElectrostaticsFile )
@@ -160,31 +163,31 @@ bool FMesher::SaveFEMFile(string PathName)
             for (j=0,t=0; j<problem->circproplist.size (); j++)
                 if (problem->circproplist[j]->CircName==problem->nodelist[i]->InConductorName) t=j+1;
 
-            fprintf(fp,"\t%i",t);
+            out << '\t' << t;
         }
 
-        fprintf(fp,"\n");
+        out << '\n';
     }
 
     // write out segment list
-    fprintf(fp,"[NumSegments] = %i\n", (int) problem->linelist.size());
+    out << "[NumSegments] = " << (int) problem->linelist.size() << '\n';
     for(i=0; i<problem->linelist.size(); i++)
     {
         for(j=0,t=0; j<problem->lineproplist.size(); j++)
             if(problem->lineproplist[j]->BdryName==problem->linelist[i]->BoundaryMarkerName) t=j+1;
 
-        fprintf(fp,"%i\t%i\t",problem->linelist[i]->n0,problem->linelist[i]->n1);
+        out << problem->linelist[i]->n0 << '\t' << problem->linelist[i]->n1 << '\t';
 
         if(problem->linelist[i]->MaxSideLength<0)
         {
-            fprintf(fp,"-1\t");
+            out << "-1\t";
         }
         else
         {
-            fprintf(fp,"%.17g\t",problem->linelist[i]->MaxSideLength);
+            out << problem->linelist[i]->MaxSideLength << '\t';
         }
 
-        fprintf(fp,"%i\t%i\t%i",t,problem->linelist[i]->Hidden,problem->linelist[i]->InGroup);
+        out << t << '\t' << problem->linelist[i]->Hidden << '\t' << problem->linelist[i]->InGroup;
 
         if (problem->filetype == femm::FileType::HeatFlowFile
                 || problem->filetype == femm::FileType::ElectrostaticsFile )
@@ -194,27 +197,26 @@ bool FMesher::SaveFEMFile(string PathName)
             {
                 if(problem->circproplist[j]->CircName==problem->linelist[i]->InConductorName) t = j + 1;
             }
-            fprintf(fp,"\t%i",t);
+            out << '\t' << t;
         }
 
-        fprintf(fp,"\n");
+        out << '\n';
     }
 
     // write out arc segment list
-    fprintf(fp,"[NumArcSegments] = %i\n", (int) problem->arclist.size());
+    out << "[NumArcSegments] = " << (int) problem->arclist.size() << '\n';
     for(i=0; i<problem->arclist.size(); i++)
     {
         for(j=0,t=0; j<problem->lineproplist.size(); j++)
             if(problem->lineproplist[j]->BdryName==problem->arclist[i]->BoundaryMarkerName) t=j+1;
 
-        fprintf( fp,"%i\t%i\t%.17g\t%.17g\t%i\t%i\t%i",
-                 problem->arclist[i]->n0,
-                 problem->arclist[i]->n1,
-                 problem->arclist[i]->ArcLength,
-                 problem->arclist[i]->MaxSideLength,
-                 t,
-                 problem->arclist[i]->Hidden,
-                 problem->arclist[i]->InGroup );
+        out << problem->arclist[i]->n0 << '\t'
+            << problem->arclist[i]->n1 << '\t'
+            << problem->arclist[i]->ArcLength << '\t'
+            << problem->arclist[i]->MaxSideLength << '\t'
+            << t << '\t'
+            << problem->arclist[i]->Hidden << '\t'
+            << problem->arclist[i]->InGroup;
 
         if (problem->filetype == femm::FileType::HeatFlowFile
                 || problem->filetype == femm::FileType::ElectrostaticsFile )
@@ -222,14 +224,14 @@ bool FMesher::SaveFEMFile(string PathName)
             // find and write number of conductor property group
             for(j=0,t=0;j<problem->circproplist.size ();j++)
                 if(problem->circproplist[j]->CircName==problem->arclist[i]->InConductorName) t=j+1;
-            fprintf(fp,"\t%i",t);
+            out << '\t' << t;
         }
         else if (problem->filetype == femm::FileType::MagneticsFile)
         {
             std::cout << "fmesher.cpp SaveFEMFile, mySideLength: " << problem->arclist[i]->mySideLength << std::endl;
-            fprintf(fp,"\t%.17g",problem->arclist[i]->mySideLength);
+            out << '\t' << problem->arclist[i]->mySideLength;
         }
-        fprintf(fp,"\n");
+        out << '\n';
     }
 
     // write out list of holes;
@@ -241,18 +243,23 @@ bool FMesher::SaveFEMFile(string PathName)
         }
     }
 
-    fprintf(fp,"[NumHoles] = %i\n",j);
+    out << "[NumHoles] = " << (int) j << '\n';
     for(i=0,k=0; i<problem->labellist.size(); i++)
     {
         if(problem->labellist[i]->BlockTypeName=="<No Mesh>")
         {
-            fprintf(fp,"%.17g\t%.17g\t%i\n",problem->labellist[i]->x,problem->labellist[i]->y,
-                    problem->labellist[i]->InGroup);
+            out << problem->labellist[i]->x << '\t' << problem->labellist[i]->y << '\t'
+                << problem->labellist[i]->InGroup << '\n';
             k++;
         }
     }
 
-    fclose(fp);
+    bool written = out.flush();
+    if (fclose(fp)!=0 || !written)
+    {
+        WarnMessage("Couldn't write to specified file.\n");
+        return false;
+    }
 
     return true;
 }
@@ -261,8 +268,6 @@ bool FMesher::LoadMesh(string PathName)
 {
     int i,j,k,q,nl;
     string pathname,rootname,infile;
-    FILE *fp;
-    char s[1024];
 
     // clear out the old mesh...
     meshnode.clear();
@@ -278,52 +283,38 @@ bool FMesher::LoadMesh(string PathName)
 
     rootname = pathname.substr(0,pathname.find_last_of('.'));
 
-    //read meshnodes;
-    infile = rootname + ".node";
-    if((fp=fopen(infile.c_str(),"rt"))==NULL)
+    femm::CMeshData mesh;
+    if (!mesh.readNodes(rootname + ".node")
+            || !mesh.readEdges(rootname + ".edge")
+            || !mesh.readElements(rootname + ".ele"))
     {
         WarnMessage("No mesh to display");
         return false;
     }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
+
+    //read meshnodes;
+    k = (int) mesh.nodes.size();
     meshnode.resize(k);
     CNode node;
     for(i=0; i<k; i++)
     {
-        fgets(s,1024,fp);
-        sscanf(s,"%i\t%lf\t%lf",&j,&node.x,&node.y);
+        node.x = mesh.nodes[i].x;
+        node.y = mesh.nodes[i].y;
         meshnode[i] = node.clone();
     }
-    fclose(fp);
 
     //read meshlines;
-    infile = rootname + ".edge";
-    if((fp=fopen(infile.c_str(),"rt"))==NULL)
-    {
-        WarnMessage("No mesh to display");
-        return false;
-    }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
-    meshline.resize(k);
-    fclose(fp);
-
-    infile = rootname + ".ele";
-    if((fp=fopen(infile.c_str(),"rt"))==NULL)
-    {
-        WarnMessage("No mesh to display");
-        return false;
-    }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
+    meshline.resize(mesh.edges.size());
 
+    k = (int) mesh.elements.size();
     IntPoint segm;
     int n[3],p;
     for(i=0,nl=0; i<k; i++)
     {
-        fgets(s,1024,fp);
-        sscanf(s,"%i	%i	%i	%i	%i",&q,&n[0],&n[1],&n[2],&j);
+        n[0] = mesh.elements[i].p[0];
+        n[1] = mesh.elements[i].p[1];
+        n[2] = mesh.elements[i].p[2];
+        j = mesh.elements[i].label;
         for(q=0; q<3; q++)
         {
             p=q+1;
@@ -345,7 +336,6 @@ bool FMesher::LoadMesh(string PathName)
         }
     }
     meshline.resize(nl);
-    fclose(fp);
 
     // clear out temporary files
     infile = rootname + ".ele";
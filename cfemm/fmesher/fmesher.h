@@ -40,6 +40,7 @@
 #include "CSegment.h"
 #include "femmenums.h"
 #include "FemmProblem.h"
+#include "meshdata.h"
 
 #include <memory>
 #include <vector>
@@ -90,6 +91,7 @@ public:
     std::shared_ptr<femm::FemmProblem> problem;
     bool Verbose = true;
     bool writePolyFiles = false; ///< write .poly files when calling triangle
+    bool writeMeshFiles = true; ///< write the mesh files (.node, .edge, .ele, .pbc) after triangulation
 
 	std::string BinDir;
 
@@ -97,6 +99,11 @@ public:
     std::vector< std::unique_ptr<femm::IntPoint> > meshline;
     std::vector< std::unique_ptr<femm::IntPoint> > greymeshline;
     std::vector< std::unique_ptr<femm::CNode> >	meshnode;
+    /**
+     * @brief The triangulation of the last call to DoNonPeriodicBCTriangulation() or DoPeriodicBCTriangulation().
+     * It can be handed to a solver directly (see FEASolver::meshData), whether the mesh files are written or not.
+     */
+    std::shared_ptr<femm::CMeshData> meshData;
 
     // used to echo start of input file to output
     std::vector< std::string > probdescstrings;
@@ -135,6 +142,15 @@ public:
 	int DoNonPeriodicBCTriangulation(std::string PathName);
 	int DoPeriodicBCTriangulation(std::string PathName);
 	bool HasPeriodicBC();
+	/**
+	 * @brief A description of everything the triangulation depends on, for use as key of a femm::CMeshCache.
+	 *
+	 * The key contains the geometry with its mesh sizes, the names of the point and boundary properties
+	 * (and of the conductors, except for magnetics problems), the boundary parameters that affect
+	 * periodic and air gap boundaries, and the settings MinAngle, DoSmartMesh and DoForceMaxMeshArea.
+	 * Material properties, circuit currents or the frequency do not change the key.
+	 */
+	std::string meshCacheKey() const;
 
     // pointer to function to call when issuing warning messages
     int (*WarnMessage)(const char*, ...);
@@ -4182,6 +4182,151 @@ struct memorypool *pool;
   return newitem;
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  poolblockcompare()   Compare two block addresses for qsort().            */
+/*                                                                           */
+/*  The addresses are the first entries of two pairs in the array built by   */
+/*  poolblocksinit().                                                        */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int poolblockcompare(const void *a, const void *b)
+#else /* not ANSI_DECLARATORS */
+int poolblockcompare(a, b)
+const void *a;
+const void *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  char *blocka = * (char **) a;
+  char *blockb = * (char **) b;
+
+  if (blocka < blockb) {
+    return -1;
+  }
+  return blocka > blockb;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  poolblocksinit()   Sort the blocks of a pool by address, so that         */
+/*                     poolblockposition() can find the block of an item.    */
+/*                                                                           */
+/*  The blocks are allocated one at a time, and where malloc() places them   */
+/*  depends on everything the process has allocated and freed before.        */
+/*  Comparing the addresses of items from different blocks therefore gives   */
+/*  different answers in different processes, while the traversal order      */
+/*  (block by block, and by address within a block) is always the same.      */
+/*  The returned array holds the block addresses in ascending order, each    */
+/*  followed by the position of the block in the list of blocks.  Free it    */
+/*  with trifree().                                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+VOID **poolblocksinit(struct memorypool *pool, int *blockcount)
+#else /* not ANSI_DECLARATORS */
+VOID **poolblocksinit(pool, blockcount)
+struct memorypool *pool;
+int *blockcount;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  VOID **blocks;
+  VOID **block;
+  int count;
+
+  count = 0;
+  for (block = pool->firstblock; block != (VOID **) NULL;
+       block = (VOID **) *block) {
+    count++;
+  }
+  blocks = (VOID **) trimalloc(2 * count * (int) sizeof(VOID *));
+  count = 0;
+  for (block = pool->firstblock; block != (VOID **) NULL;
+       block = (VOID **) *block) {
+    blocks[2 * count] = (VOID *) block;
+    blocks[2 * count + 1] = (VOID *) (size_t) count;
+    count++;
+  }
+  qsort(blocks, count, 2 * sizeof(VOID *), poolblockcompare);
+  *blockcount = count;
+  return blocks;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  poolblockposition()   Return the position of the block that holds an     */
+/*                        item in the list of blocks of its pool.            */
+/*                                                                           */
+/*  `blocks' and `blockcount' come from poolblocksinit().  A binary search   */
+/*  finds the block with the highest address not above the item.  The first  */
+/*  block is in position zero, the block allocated after it in position one, */
+/*  and so forth.                                                            */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+size_t poolblockposition(VOID **blocks, int blockcount, VOID *item)
+#else /* not ANSI_DECLARATORS */
+size_t poolblockposition(blocks, blockcount, item)
+VOID **blocks;
+int blockcount;
+VOID *item;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  int low, high, middle;
+
+  /* Find the block with the highest address not above the item. */
+  low = 0;
+  high = blockcount - 1;
+  while (low < high) {
+    middle = (low + high + 1) / 2;
+    if ((char *) blocks[2 * middle] <= (char *) item) {
+      low = middle;
+    } else {
+      high = middle - 1;
+    }
+  }
+  return (size_t) blocks[2 * low + 1];
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  poolbefore()   Return nonzero if item `a' comes before item `b' in the   */
+/*                 traversal order of their pool.                            */
+/*                                                                           */
+/*  `blocks' and `blockcount' come from poolblocksinit().  Items in          */
+/*  different blocks are ordered by the positions of their blocks, and       */
+/*  items in the same block by their addresses.  Unlike comparing the raw    */
+/*  addresses, this gives the same answer in every process.                  */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int poolbefore(VOID **blocks, int blockcount, VOID *a, VOID *b)
+#else /* not ANSI_DECLARATORS */
+int poolbefore(blocks, blockcount, a, b)
+VOID **blocks;
+int blockcount;
+VOID *a;
+VOID *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  size_t blocka, blockb;
+
+  blocka = poolblockposition(blocks, blockcount, a);
+  blockb = poolblockposition(blocks, blockcount, b);
+  if (blocka != blockb) {
+    return blocka < blockb;
+  }
+  return (char *) a < (char *) b;
+}
+
 /*****************************************************************************/
 /*                                                                           */
 /*  dummyinit()   Initialize the triangle that fills "outer space" and the   */
@@ -14851,6 +14996,8 @@ char **argv;
   struct osub checkmark;
   vertex p1, p2;
   long edgenumber;
+  VOID **blocks;
+  int blockcount;
   triangle ptr;                         /* Temporary variable used by sym(). */
   subseg sptr;                      /* Temporary variable used by tspivot(). */
 
@@ -14885,17 +15032,21 @@ char **argv;
   traversalinit(&m->triangles);
   triangleloop.tri = triangletraverse(m);
   edgenumber = b->firstnumber;
+  blocks = poolblocksinit(&m->triangles, &blockcount);
   /* To loop over the set of edges, loop over all triangles, and look at   */
   /*   the three edges of each triangle.  If there isn't another triangle  */
   /*   adjacent to the edge, operate on the edge.  If there is another     */
   /*   adjacent triangle, operate on the edge only if the current triangle */
-  /*   has a smaller pointer than its neighbor.  This way, each edge is    */
-  /*   considered only once.                                               */
+  /*   comes before its neighbor in the pool.  This way, each edge is      */
+  /*   considered only once.  (The pool order instead of the pointers      */
+  /*   keeps the order of the edges independent of the heap layout.)       */
   while (triangleloop.tri != (triangle *) NULL) {
     for (triangleloop.orient = 0; triangleloop.orient < 3;
          triangleloop.orient++) {
       sym(triangleloop, trisym);
-      if ((triangleloop.tri < trisym.tri) || (trisym.tri == m->dummytri)) {
+      if ((trisym.tri == m->dummytri) ||
+          poolbefore(blocks, blockcount,
+                     (VOID *) triangleloop.tri, (VOID *) trisym.tri)) {
         org(triangleloop, p1);
         dest(triangleloop, p2);
 #ifdef TRILIBRARY
@@ -14942,6 +15093,7 @@ char **argv;
     }
     triangleloop.tri = triangletraverse(m);
   }
+  trifree((VOID *) blocks);
 
 #ifndef TRILIBRARY
   finishfile(outfile, argc, argv);
@@ -33,6 +33,7 @@
 #include "femmconstants.h"
 #include "CCommonPoint.h"
 #include "CAirGapElement.h"
+#include "textwriter.h"
 //extern "C" {
 #include "triangle.h"
 #ifndef XFEMM_BUILTIN_TRIANGLE
@@ -147,7 +148,12 @@ public:
      * @return \c true, if writing succeeded, \c false otherwise.
      */
     bool writePolyFile(std::string filename, std::string comment) const;
-    bool writeTriangulationFiles(std::string Pathname) const;
+    /**
+     * @brief Copy nodes, edges and elements of the triangulation to \p mesh.
+     * The periodic boundary conditions and air gap elements of \p mesh are not touched.
+     * @return \c true on success, \c false if triangle's mesh can not be retrieved
+     */
+    bool getTriangulation(femm::CMeshData &mesh) const;
 
     // pointer to function to call when issuing warning messages
     int (*WarnMessage)(const char*, ...);
@@ -539,158 +545,150 @@ bool FMesher::HasPeriodicBC()
     return false;
 }
 
-
-bool TriangulateHelper::writeTriangulationFiles(string PathName) const
+/**
+ * @brief FMesher::meshCacheKey
+ * The key lists the input of the triangulation in a canonical form:
+ * property names stand for the marker numbers that the mesher derives from them,
+ * and doubles are written in their shortest exact form.
+ * @return the key
+ */
+std::string FMesher::meshCacheKey() const
 {
-    FILE *fp;
-    std::string msg;
-    std::string plyname;
-
-#ifndef XFEMM_BUILTIN_TRIANGLE
-    if (triangle_check_mesh(ctx)!=0)
+    CTextWriter key;
+    // names are written with their length, so that they may contain any character
+    auto name = [&key](const std::string &s) -> CTextWriter& {
+        return key << (int)s.size() << ':' << s << ' ';
+    };
+    // conductors are only marked for heat flow and electrostatics problems
+    const bool conductors = (problem->filetype != FileType::MagneticsFile);
+
+    key << "xfemm mesh 1\n" << "triangle " << triangleVersionString() << '\n';
+    key << "filetype " << (int)problem->filetype
+        << " minangle " << problem->MinAngle
+        << " smartmesh " << (int)problem->DoSmartMesh
+        << " forcemaxarea " << (int)problem->DoForceMaxMeshArea << '\n';
+
+    key << "pointprops " << (int)problem->nodeproplist.size() << '\n';
+    for (const auto &prop : problem->nodeproplist)
+        name(prop->PointName) << '\n';
+    // the format decides about periodic and air gap boundaries, and the angles are part of the air gap elements
+    key << "boundaryprops " << (int)problem->lineproplist.size() << '\n';
+    for (const auto &prop : problem->lineproplist)
+        name(prop->BdryName) << prop->BdryFormat << ' ' << prop->InnerAngle << ' ' << prop->OuterAngle << '\n';
+    if (conductors)
     {
-        WarnMessage("Mesh has topological inconsistencies!\n");
-        return false;
+        key << "conductors " << (int)problem->circproplist.size() << '\n';
+        for (const auto &prop : problem->circproplist)
+            name(prop->CircName) << '\n';
     }
-#endif
 
-    // write the .node file
-    plyname = PathName.substr(0, PathName.find_last_of('.')) + ".node";
-
-    // check to see if we are ready to write a .node datafile containing
-    // the nodes
-
-    if ((fp = fopen(plyname.c_str(),"wt"))==NULL){
-        WarnMessage("Couldn't write to specified .node file");
-        return false;
+    key << "nodes " << (int)problem->nodelist.size() << '\n';
+    for (const auto &node : problem->nodelist)
+    {
+        key << node->x << ' ' << node->y << ' ';
+        name(node->BoundaryMarkerName);
+        if (conductors)
+            name(node->InConductorName);
+        key << '\n';
     }
-
-#ifdef XFEMM_BUILTIN_TRIANGLE
-    if (out.numberofpoints > 0)
+    key << "segments " << (int)problem->linelist.size() << '\n';
+    for (const auto &line : problem->linelist)
     {
-        // <# of vertices> <dimension (must be 2)> <# of attributes> <# of boundary markers (0 or 1)>
-        fprintf(fp, "%i\t%i\t%i\t%i\n", out.numberofpoints, 2, 0, 1);
-        //fprintf(fp, "%i\t%i\t%i\n", out.numberofpoints, 2, out.numberofpoints, 1);
-
-        // <vertex #> <x> <y> [attributes] [boundary marker]
-        for(int i = 0; i < (2 * out.numberofpoints) - 1; i = i + 2)
-        {
-            fprintf(fp, "%i\t%.17g\t%.17g\t%i\n", i/2, out.pointlist[i], out.pointlist[i+1], out.pointmarkerlist[i/2]);
-        }
-
-        fclose(fp);
+        key << line->n0 << ' ' << line->n1 << ' ' << line->MaxSideLength << ' ';
+        name(line->BoundaryMarkerName);
+        if (conductors)
+            name(line->InConductorName);
+        key << '\n';
     }
-#else
-    int status = triangle_write_nodes(ctx, fp);
-    fclose(fp);
-    if (status != TRI_OK)
+    // the periodic triangulation counts selected arcs when it discretizes air gap boundaries
+    key << "arcs " << (int)problem->arclist.size() << '\n';
+    for (const auto &arc : problem->arclist)
     {
-        msg = "Failed to write to specified .node file\n";
-        WarnMessage(msg.c_str());
-        return false;
+        key << arc->n0 << ' ' << arc->n1 << ' ' << arc->ArcLength << ' ' << arc->MaxSideLength << ' '
+            << (int)arc->IsSelected << ' ';
+        name(arc->BoundaryMarkerName);
+        if (conductors)
+            name(arc->InConductorName);
+        key << '\n';
     }
-#endif
+    key << "labels " << (int)problem->labellist.size() << '\n';
+    for (const auto &label : problem->labellist)
+        key << label->x << ' ' << label->y << ' ' << label->MaxArea << ' ' << (int)label->isHole() << '\n';
 
-    // write the .edge file
-    plyname = PathName.substr(0, PathName.find_last_of('.')) + ".edge";
+    return key.text();
+}
 
-    // check to see if we are ready to write an edge datafile;
 
-    if ((fp = fopen(plyname.c_str(),"wt"))==NULL){
-        msg = "Couldn't write to specified .edge file\n";
-        WarnMessage(msg.c_str());
-        return false;
-    }
+bool TriangulateHelper::getTriangulation(CMeshData &mesh) const
+{
 #ifdef XFEMM_BUILTIN_TRIANGLE
-
-    if (out.numberofedges > 0)
+    mesh.nodes.resize(out.numberofpoints);
+    for(int i=0; i < out.numberofpoints; i++)
     {
-        // write number of edges, number of boundary markers, 0 or 1
-        fprintf(fp, "%i\t%i\n", out.numberofedges, 1);
+        mesh.nodes[i].x = out.pointlist[2*i];
+        mesh.nodes[i].y = out.pointlist[2*i+1];
+        mesh.nodes[i].marker = out.pointmarkerlist[i];
+    }
 
-        // write the edges in the format
-        // <edge #> <endpoint> <endpoint> [boundary marker]
-        // Endpoints are indices into the corresponding .edge file.
-        for(int i=0; i < 2 * (out.numberofedges) - 1; i = i + 2)
-        {
-            fprintf(fp, "%i\t%i\t%i\t%i\n", i/2, out.edgelist[i], out.edgelist[i+1], out.edgemarkerlist[i/2]);
-        }
+    mesh.edges.resize(out.numberofedges);
+    for(int i=0; i < out.numberofedges; i++)
+    {
+        mesh.edges[i].n0 = out.edgelist[2*i];
+        mesh.edges[i].n1 = out.edgelist[2*i+1];
+        mesh.edges[i].marker = out.edgemarkerlist[i];
+    }
 
-        fclose(fp);
-    } else {
-        WarnMessage("No edges to write!\n");
+    // the regional attribute is the number of the block label + 1
+    mesh.elements.resize(out.numberoftriangles);
+    for(int i=0; i < out.numberoftriangles; i++)
+    {
+        for (int j=0; j<3; j++)
+            mesh.elements[i].p[j] = out.trianglelist[i*out.numberofcorners+j];
+        mesh.elements[i].label = 0;
+        if (out.numberoftriangleattributes > 0)
+            mesh.elements[i].label = (int) out.triangleattributelist[i*out.numberoftriangleattributes];
     }
 #else
-    // Note: triangle_write_edges also numbers the edges, which is required for writing the .ele file
-    status = triangle_write_edges(ctx, fp);
-    fclose(fp);
-    if (status != TRI_OK)
+    if (triangle_check_mesh(ctx)!=0)
     {
-        msg = "Failed to write to specified .edge file\n";
-        WarnMessage(msg.c_str());
+        WarnMessage("Mesh has topological inconsistencies!\n");
         return false;
     }
-#endif
 
-    // write the .ele file
-    plyname = PathName.substr(0, PathName.find_last_of('.')) + ".ele";
-
-
-    // check to see if we are ready to write a .ele datafile containing
-    // thr triangle elements
-
-    if ((fp = fopen(plyname.c_str(),"wt"))==NULL){
-        WarnMessage("Couldn't write to specified .ele file");
+    // triangle-api only hands out its mesh in the file formats,
+    // so we let it write to a temporary file and parse that.
+    FILE *fp = tmpfile();
+    if (fp==NULL)
+    {
+        WarnMessage("Couldn't create a temporary file for the mesh\n");
         return false;
     }
-
-#ifdef XFEMM_BUILTIN_TRIANGLE
-    if (out.numberoftriangles > 0)
+    bool parsed = false;
+    int status = triangle_write_nodes(ctx, fp);
+    if (status == TRI_OK)
     {
-        // write number of triangle elements, number of corners per triangle and
-        // the number of attributes per triangle
-        fprintf(fp, "%i\t%i\t%i\n", out.numberoftriangles, out.numberofcorners, out.numberoftriangleattributes);
-
-        // write the triangle info to the file with the format
-        // <triangle #> <node> <node> <node> ... [attributes]
-        // Endpoints are indices into the corresponding .node file.
-        for(int i=0, nexttriattrib=0; i < (out.numberofcorners) * (out.numberoftriangles) - (out.numberofcorners - 1); i = i + (out.numberofcorners))
-        {
-            // print the triangle number
-            fprintf(fp, "%i\t", i / (out.numberofcorners));
-
-            // print the corner nodes
-            for (int j = 0; j < (out.numberofcorners); j++)
-            {
-                fprintf(fp, "%i\t", out.trianglelist[i+j]);
-            }
-
-            // print the triangle attributes, if there are any
-            if (out.numberoftriangleattributes > 0)
-            {
-                for(int j = 0; j < (out.numberoftriangleattributes); j++)
-                {
-                    fprintf(fp, "%.17g\t", out.triangleattributelist[nexttriattrib+j]);
-                }
-
-                // set the position of the next set of triangle attributes
-                nexttriattrib = nexttriattrib + (out.numberoftriangleattributes);
-            }
-
-            // go to the next line
-            fprintf(fp, "\n");
-        }
-
-        fclose(fp);
-
+        rewind(fp);
+        parsed = mesh.readNodes(fp);
+        rewind(fp);
+        // Note: triangle_write_edges also numbers the edges, which is required for writing the .ele file
+        status = triangle_write_edges(ctx, fp);
+    }
+    if (status == TRI_OK && parsed)
+    {
+        rewind(fp);
+        parsed = mesh.readEdges(fp);
+        rewind(fp);
+        status = triangle_write_elements(ctx, fp);
+    }
+    if (status == TRI_OK && parsed)
+    {
+        rewind(fp);
+        parsed = mesh.readElements(fp);
     }
-#else
-    status = triangle_write_elements(ctx, fp);
     fclose(fp);
-    if (status != TRI_OK)
+    if (status != TRI_OK || !parsed)
     {
-        msg = "Failed to write to specified .ele file\n";
-        WarnMessage(msg.c_str());
+        WarnMessage("Failed to retrieve the mesh from triangle\n");
         return false;
     }
 #endif
@@ -715,10 +713,8 @@ int FMesher::DoNonPeriodicBCTriangulation(string PathName)
     // if (!problem->previousSolutionFile.empty() && problem->Frequency>0)
     //     return true;
 
-    FILE *fp;
     double dL;
     //CStdString s;
-    string plyname;
     std::vector < std::unique_ptr<CNode> >       nodelst;
     std::vector < std::unique_ptr<CSegment> >    linelst;
 
@@ -771,15 +767,6 @@ int FMesher::DoNonPeriodicBCTriangulation(string PathName)
 //        }
 //    fclose(fp);
 
-    // write out a trivial pbc file
-    plyname = pn.substr(0,pn.find_last_of('.')) + ".pbc";
-    if ((fp=fopen(plyname.c_str(),"wt"))==NULL){
-        WarnMessage("Couldn't write to specified .pbc file");
-        return -1;
-    }
-    fprintf(fp,"0\n");
-    fclose(fp);
-
     // **********         call triangle       ***********
 
     {
@@ -803,10 +790,19 @@ int FMesher::DoNonPeriodicBCTriangulation(string PathName)
         if (tristatus != 0)
             return tristatus;
 
-        triHelper.writeTriangulationFiles(PathName);
+        // no periodic boundary conditions: the pbc list stays empty
+        meshData = std::make_shared<CMeshData>();
+        if (!triHelper.getTriangulation(*meshData))
+            return -1;
     }
     problem->clearNotationTags();
 
+    if (writeMeshFiles && !meshData->writeFiles(pn.substr(0,pn.find_last_of('.'))))
+    {
+        WarnMessage("Couldn't write the mesh files");
+        return -1;
+    }
+
     return 0;
 }
 
@@ -826,15 +822,12 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     // // we can just bail out in that case.
     // if (!problem->previousSolutionFile.empty() && problem->Frequency>0)
     //     return true;
-    FILE *fp;
     int i, j, k, n;
     int l,n0,n1,n2;
     double z,R,dL;
     CComplex a0,a1,a2,c;
     CComplex b0,b1,b2;
-    char instring[1024];
     //string s;
-    string plyname;
     std::vector < std::unique_ptr<CNode> >              nodelst;
     std::vector < std::unique_ptr<CSegment> >           linelst;
     //std::vector < std::unique_ptr<CCBlockLabel> >       blocklst;
@@ -846,6 +839,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     CCommonPoint pt;
     CPeriodicBoundary pbc;
     CAirGapElement age;
+    CMeshData trialMesh;
 
 #ifdef DEBUG
     WarnMessage("writepoly: beginning periodic boundary triangulation\n");
@@ -903,14 +897,19 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
         if (tristatus != 0)
             return tristatus;
 
-        triHelper.writeTriangulationFiles(PathName);
+        if (!triHelper.getTriangulation(trialMesh))
+        {
+            WarnMessage("Call to triangle was unsuccessful\n");
+            problem->undo();  problem->unselectAll();
+            return -1;
+        }
     }
 
 #ifdef DEBUG
     WarnMessage("writepoly: finished calling triangle\n");
 #endif // DEBUG
 
-    // So far, so good.  Now, read back in the .edge file
+    // So far, so good.  Now, look at the edges of the trial mesh
     // to make sure the points in the segments and arc
     // segments are ordered in a consistent way so that
     // the (anti)periodic boundary conditions can be applied.
@@ -919,15 +918,8 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     WarnMessage("writepoly: 876\n");
 #endif // DEBUG
 
-    // read meshlines;
-    plyname = pn.substr(0,pn.find_last_of('.')) + ".edge";
-    if((fp=fopen(plyname.c_str(),"rt"))==NULL){
-        WarnMessage("Call to triangle was unsuccessful\n");
-        problem->undo();  problem->unselectAll();
-        return -1;
-    }
-    fgets(instring,1024,fp);
-    sscanf(instring,"%i",&k);
+    // meshlines;
+    k = (int) trialMesh.edges.size();
     problem->clearNotationTags();
     // use cnt again to keep a
     // tally of how many subsegments each
@@ -952,11 +944,11 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
     for(i=0;i<k;i++)
     {
-        // get the next edge from the file
-        fgets(instring,1024,fp);
-        // get the edge number, start and end points (n0 and n1) and the
+        // get the start and end points (n0 and n1) of the next edge and the
         // segment/arc marker j
-        sscanf(instring,"%i    %i    %i    %i",&l,&n0,&n1,&j);
+        n0 = trialMesh.edges[i].n0;
+        n1 = trialMesh.edges[i].n1;
+        j = trialMesh.edges[i].marker;
         // if j != 0, this edge is part of a segment/arc
         if(j!=0)
         {
@@ -1008,7 +1000,6 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
             }
         }
     }
-    fclose(fp);
 
 #ifdef DEBUG
     WarnMessage("writepoly: 974\n");
@@ -1023,14 +1014,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     // elements each reference segment appears in.  If a
     // segment is on the boundary, it ought to appear in just
     // one element.  Otherwise, it appears in two.
-    plyname = pn.substr(0,pn.find_last_of('.')) + ".ele";
-    if((fp=fopen(plyname.c_str(),"rt"))==NULL){
-        WarnMessage("Call to triangle was unsuccessful");
-        problem->undo();  problem->unselectAll();
-        return -1;
-    }
-    fgets(instring,1024,fp);
-    sscanf(instring,"%i",&k);
+    k = (int) trialMesh.elements.size();
 
 #ifdef DEBUG
     WarnMessage("writepoly: 996\n");
@@ -1038,8 +1022,9 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
     for(i=0;i<k;i++)
     {
-        fgets(instring,1024,fp);
-        sscanf(instring,"%i    %i    %i    %i",&j,&n0,&n1,&n2);
+        n0 = trialMesh.elements[i].p[0];
+        n1 = trialMesh.elements[i].p[1];
+        n2 = trialMesh.elements[i].p[2];
 
         // Sort out the three nodes...
         if (n0>n1) { n=n0; n0=n1; n1=n; }
@@ -1055,7 +1040,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
             if ((n1==ptlst[j]->x) && (n2==ptlst[j]->y)) ptlst[j]->t--;
         }
     }
-    fclose(fp);
+    trialMesh.clear();
 
 #ifdef DEBUG
     WarnMessage("writepoly: 1021\n");
@@ -1816,18 +1801,12 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
         return false;
     }
 */
-    // write out a pbc file containing a list of linked nodes
-    plyname = pn.substr(0,pn.find_last_of('.')) + ".pbc";
-    if ((fp=fopen(plyname.c_str(),"wt"))==NULL){
-        WarnMessage("Couldn't write to specified .pbc file");
-        problem->undo();  problem->unselectAll();
-        return -1;
-    }
-    fprintf(fp,"%i\n", (int) ptlst.size());
-
+    // keep the list of linked nodes with the mesh
+    meshData = std::make_shared<CMeshData>();
+    meshData->pbcs.reserve(ptlst.size());
     for(k=0;k<(int)ptlst.size();k++)
     {
-        fprintf(fp,"%i    %i    %i    %i\n",k,ptlst[k]->x,ptlst[k]->y,ptlst[k]->t);
+        meshData->pbcs.push_back(*ptlst[k]);
     }
 
 #ifdef DEBUG
@@ -1837,7 +1816,7 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
         WarnMessage(buf);
     }
 #endif // DEBUG
-	fprintf(fp,"%i\n",(int) agelst.size());
+	meshData->ages.reserve(agelst.size());
 	for(k=0;k<(int)agelst.size();k++)
 	{
 		double dtta;
@@ -1929,13 +1908,20 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 			if (bDone) break;
 		}
 
-		// print out AGE definition
-		fprintf(fp,"\"%s\"\n",agelst[k]->BdryName.c_str ());
-		fprintf(fp,"%i %.17g %.17g %.17g %.17g %.17g %.17g %.17g %i %.17g %.17g\n",
-			agelst[k]->BdryFormat,agelst[k]->InnerAngle,agelst[k]->OuterAngle,
-			agelst[k]->ri,agelst[k]->ro,agelst[k]->totalArcLength,
-			Re(agelst[k]->agc),Im(agelst[k]->agc),n,
-			InnerRing[0].w0,OuterRing[0].w0);
+		// store AGE definition, with the name as it appears in the .pbc file
+		CAirGapElement meshAge;
+		meshAge.BdryName = "\"" + agelst[k]->BdryName + "\"\n";
+		meshAge.BdryFormat = agelst[k]->BdryFormat;
+		meshAge.InnerAngle = agelst[k]->InnerAngle;
+		meshAge.OuterAngle = agelst[k]->OuterAngle;
+		meshAge.ri = agelst[k]->ri;
+		meshAge.ro = agelst[k]->ro;
+		meshAge.totalArcLength = agelst[k]->totalArcLength;
+		meshAge.agc = agelst[k]->agc;
+		meshAge.totalArcElements = n;
+		meshAge.InnerShift = InnerRing[0].w0;
+		meshAge.OuterShift = OuterRing[0].w0;
+		meshAge.quadNode.resize(n+1);
 
 		for(i=0;i<=n;i++)
 		{
@@ -1946,12 +1932,13 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
 			// ring points that bracket points in the annulus mesh
 			// and their sign, for the purposes of periodicity/antiperiodicity
-			fprintf(fp,"%i %g %i %g %i %g %i %g\n",
-				InnerRing[p0].n0, InnerRing[p0].w1,
-				InnerRing[p1].n0, InnerRing[p1].w1,
-				OuterRing[p0].n0, OuterRing[p0].w1,
-				OuterRing[p1].n0, OuterRing[p1].w1);
+			CQuadPoint &qp = meshAge.quadNode[i];
+			qp.n0 = InnerRing[p0].n0; qp.w0 = InnerRing[p0].w1;
+			qp.n1 = InnerRing[p1].n0; qp.w1 = InnerRing[p1].w1;
+			qp.n2 = OuterRing[p0].n0; qp.w2 = OuterRing[p0].w1;
+			qp.n3 = OuterRing[p1].n0; qp.w3 = OuterRing[p1].w1;
 		}
+		meshData->ages.push_back(meshAge);
 
 /*
 		fprintf(fp,"%s\n",agelst[k]->BdryName);
@@ -1967,9 +1954,6 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
 
 	}
 
-
-    fclose(fp);
-
     // call triangle with -Y flag.
     {
         TriangulateHelper triHelper;
@@ -1994,7 +1978,8 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
         if (tristatus != 0)
             return tristatus;
 
-        triHelper.writeTriangulationFiles(PathName);
+        if (!triHelper.getTriangulation(*meshData))
+            return -1;
     }
 
     problem->unselectAll();
@@ -2010,6 +1995,12 @@ int FMesher::DoPeriodicBCTriangulation(string PathName)
     //SaveFEMFile(pn);
     problem->saveFEMFile(pn);
 
+    if (writeMeshFiles && !meshData->writeFiles(pn.substr(0,pn.find_last_of('.'))))
+    {
+        WarnMessage("Couldn't write the mesh files");
+        return -1;
+    }
+
     return 0;
 }
 
@@ -33,6 +33,7 @@
 #include <cstdio>
 #include <cmath>
 #include <regex>
+#include <sstream>
 #include "femmcomplex.h"
 #include "femmconstants.h"
 #include "fparse.h"
@@ -219,15 +220,25 @@ bool FPProc::NewDocument()
 
 
 bool FPProc::OpenDocument(string pathname)
+{
+    return LoadDocument(pathname, nullptr);
+}
+
+bool FPProc::LoadSolution(const std::string &problemFile, const femm::CMSolution &solution)
+{
+    return LoadDocument(problemFile, &solution);
+}
+
+bool FPProc::LoadDocument(const std::string &pathname, const femm::CMSolution *solution)
 {
 
     FILE *fp;
-    int i,j,k,t, sscnt;
+    int i,j,k,t;
     char s[1024],q[1024];
     char *v;
     double b,bi,br;
-    double zr,zi;
     bool flag = false;
+    long binaryOffset = -1;
     CMPointProp    PProp;
     CMBoundaryProp BProp;
     CMMaterialProp MProp;
@@ -235,9 +246,7 @@ bool FPProc::OpenDocument(string pathname)
     CNode         node;
     CSegment      segm;
     CArcSegment   asegm;
-    femmpostproc::CPostProcMElement      elm;
     CMBlockLabel   blk;
-    femmsolver::CMMeshNode     mnode;
     //CPoint        mline;
 
     // clear out all the document data and set defaults to standard values
@@ -1058,6 +1067,14 @@ bool FPProc::OpenDocument(string pathname)
             flag = true;
             q[0] = '\0';
         }
+
+        // binary solution, see femm::CSolutionFileWriter
+        if(_strnicmp(q,"[binarysolution]",16)==0)
+        {
+            flag = true;
+            binaryOffset = ftell(fp);
+            q[0] = '\0';
+        }
     }
 
     // ensure memory is freed now
@@ -1065,7 +1082,7 @@ bool FPProc::OpenDocument(string pathname)
     MProp.Hdata.clear();
     MProp.slope.clear();
 
-    if (flag == false)
+    if (flag == false && solution == nullptr)
     {
         // The flag was never set to true during the while loop.
         // This means the "[solution]" string was never
@@ -1085,372 +1102,127 @@ bool FPProc::OpenDocument(string pathname)
         return false;
     }
 
-    // read in meshnodes;
-    fscanf(fp,"%i\n",&k);
-#ifdef DEBUG_FPPROC
-    printf("numnodes: %d\n", k);
-#endif // DEBUG_FPPROC
-    meshnode.resize(k);
-    for(i=0; i<k; i++)
+    bool ok;
+    if (solution)
+        ok = CopySolution(*solution);
+    else if (binaryOffset>=0)
     {
-        if ( fgets(s,1024,fp) != NULL )
-        {
-            if (Frequency!=0)
-            {
-                if (!bIncremental)
-                {
-                    sscnt = sscanf(s,"%lf\t%lf\t%lf\t%lf",
-                                   &mnode.x,
-                                   &mnode.y,
-                                   &mnode.A.re,
-                                   &mnode.A.im) ;
-
-                    if (sscnt != 4)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 4).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-                        fclose(fp);
-                        return false;
-                    }
-                }
-                else
-                {
-                    int bc;
-                    double tmpAprev = 0;
+        femm::CSolutionFile file;
+        std::stringstream err;
+        ok = file.open(pathname, binaryOffset, err) && ReadBinarySolution(file);
+        if (!err.str().empty())
+            WarnMessage(err.str().c_str());
+    }
+    else
+        ok = ReadSolution(fp);
+    fclose(fp);
+    if (!ok)
+    {
+        return false;
+    }
 
-                    sscanf(s,"%lf\t%lf\t%lf\t%lf\t%i\t%lf",
-                           &mnode.x,
-                           &mnode.y,
-                           &mnode.A.re,
-                           &mnode.A.im,
-                           &bc,
-                           &tmpAprev);
+	// figure out amplitudes of harmonics for AGE boundary conditions
+	for (i=0;i<(int)agelist.size();i++)
+	{
+		int m;
+		double tta,R,dr,ri,ro,n,dt;
+		CComplex brc,brs,btc,bts;
+		double brcPrev,brsPrev,btcPrev,btsPrev;
 
-                    Aprev.push_back(tmpAprev);
+		R=(agelist[i].ri + agelist[i].ro)/2.;
+		dr=(agelist[i].ro - agelist[i].ri);
+		ri=agelist[i].ri/R;
+		ro=agelist[i].ro/R;
+		dt=(PI/180.)*agelist[i].totalArcLength/((double) agelist[i].totalArcElements);
 
-                    if (sscnt != 6)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 6).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-                        fclose(fp);
-                        return false;
-                    }
-                }
-            }
-            else
-            {
-                if (!bIncremental)
-                {
-                    sscnt = sscanf(s,"%lf\t%lf\t%lf",
-                                   &mnode.x,
-                                   &mnode.y,
-                                   &mnode.A.re);
+		if (agelist[i].BdryFormat==0)
+		{
+			agelist[i].nn=(agelist[i].totalArcElements/2)+1; // periodic AGE
+			m = (int) round(360./agelist[i].totalArcLength);
+		}
+		else
+		{
+			agelist[i].nn=(agelist[i].totalArcElements+1)/2; // antiperiodic AGE
+			m = (int) round(180./agelist[i].totalArcLength);
+		}
 
+		// for present solution
+		agelist[i].brc=(CComplex *)calloc(agelist[i].nn,sizeof(CComplex));
+		agelist[i].brs=(CComplex *)calloc(agelist[i].nn,sizeof(CComplex));
+		agelist[i].btc=(CComplex *)calloc(agelist[i].nn,sizeof(CComplex));
+		agelist[i].bts=(CComplex *)calloc(agelist[i].nn,sizeof(CComplex));
+		agelist[i].br=(CComplex *)calloc(agelist[i].totalArcElements,sizeof(CComplex));
+		agelist[i].bt=(CComplex *)calloc(agelist[i].totalArcElements,sizeof(CComplex));
+		agelist[i].nh=(int *)calloc(agelist[i].nn,sizeof(int));
 
-                    if (sscnt != 3)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 3).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-    #ifdef DEBUG_FPPROC
-                        printf("s: %s\n", s);
-    #endif // DEBUG_FPPROC
-                        fclose(fp);
-                        return false;
-                    }
-                }
-                else
-                {
-                    int bc;
-                    double tmpAprev = 0;
+		// for previous solution;
+		if (bIncremental == MS_LEGACY_FALSE)
+		{
+			agelist[i].brcPrev=NULL;
+			agelist[i].brsPrev=NULL;
+			agelist[i].btcPrev=NULL;
+			agelist[i].btsPrev=NULL;
+			agelist[i].brPrev=NULL;
+			agelist[i].btPrev=NULL;
+		}
+		else{
+			agelist[i].brcPrev=(double *)calloc(agelist[i].nn,sizeof(double));
+			agelist[i].brsPrev=(double *)calloc(agelist[i].nn,sizeof(double));
+			agelist[i].btcPrev=(double *)calloc(agelist[i].nn,sizeof(double));
+			agelist[i].btsPrev=(double *)calloc(agelist[i].nn,sizeof(double));
+			agelist[i].brPrev=(double *)calloc(agelist[i].totalArcElements,sizeof(double));
+			agelist[i].btPrev=(double *)calloc(agelist[i].totalArcElements,sizeof(double));
+		}
 
-                    sscnt = sscanf(s, "%lf\t%lf\t%lf\t%i\t%lf",
-                                   &mnode.x,
-                                   &mnode.y,
-                                   &mnode.A.re,
-                                   &bc,
-                                   &tmpAprev);
+		// compute A and B at center of each gap element
+		agelist[i].aco=0;
+		for(k=0;k<agelist[i].totalArcElements;k++)
+		{
+			int nn[10];
+			double ww[10];
+			int kk;
+			CComplex a[10];
+			CComplex ac;
 
-                    Aprev.push_back(tmpAprev);
+			double ci=agelist[i].InnerShift;
+			double co=agelist[i].OuterShift;
 
-                    if (sscnt != 5)
-                    {
-                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
-                                + " (expected 5).\n";
-                        WarnMessage(msg.c_str()); /* Error */
-    #ifdef DEBUG_FPPROC
-                        printf("s: %s\n", s);
-    #endif // DEBUG_FPPROC
-                        fclose(fp);
-                        return false;
-                    }
 
-                }
-                mnode.A.im=0;
-            }
-            meshnode[i] = mnode;
-        }
-        else
-        {
-            // There was some read error while trying to read the file
-            WarnMessage("An error occured while reading mesh nodes section of file.\n"); /* Error */
-            fclose(fp);
-            return false;
-        }
+			// inner nodes
+			if ((k-1)<0){
+				nn[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].n0;
+				ww[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].w0;
+			}
+			else{
+				nn[0]=agelist[i].quadNode[k-1].n0;
+				ww[0]=agelist[i].quadNode[k-1].w0;
+			}
 
-    }
+			nn[1]=agelist[i].quadNode[k].n0;
+			nn[2]=agelist[i].quadNode[k].n1;
+			nn[3]=agelist[i].quadNode[k+1].n1;
+			ww[1]=agelist[i].quadNode[k].w0;
+			ww[2]=agelist[i].quadNode[k].w1;
+			ww[3]=agelist[i].quadNode[k+1].w1;
 
-    // read in elements;
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
-    //fscanf(fp,"%i\n",&k);
-    meshelem.resize(k);
-#ifdef DEBUG_FPPROC
-    printf("numelement: %d\n", k);
-#endif // DEBUG_FPPROC
-    for(i=0; i<k; i++)
-    {
-        if ( fgets(s,1024,fp) != NULL )
-        {
-            if (!bIncremental)
-            {
-                sscnt = sscanf(s,"%i\t%i\t%i\t%i",&elm.p[0],&elm.p[1],&elm.p[2],&elm.lbl);
-#ifdef DEBUG_FPPROC
-                printf("s: %s\n", s);
-                //getchar();
-#endif // DEBUG_FPPROC
-                if (sscnt != 4)
-                {
-                    std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                            + std::to_string(sscnt) + ") for element " + std::to_string(i) + ".\n";
-                    WarnMessage(msg.c_str()); /* Error */
-                    fclose(fp);
-                    return false;
-                }
-            }
-            else
-            {
-                sscanf(s,"%i	%i	%i	%i	%lf",&elm.p[0],&elm.p[1],&elm.p[2],&elm.lbl,&elm.Jprev);
+			if((k+2)>agelist[i].totalArcElements){
+				nn[4]=agelist[i].quadNode[1].n1;
+				ww[4]=agelist[i].quadNode[1].w1;
+			}
+			else{
+				nn[4]=agelist[i].quadNode[k+2].n1;
+				ww[4]=agelist[i].quadNode[k+2].w1;
+			}
 
-#ifdef DEBUG_FPPROC
-                printf("s: %s\n", s);
-                //getchar();
-#endif // DEBUG_FPPROC
-                if (sscnt != 5)
-                {
-                    std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
-                            + std::to_string(sscnt) + ") for element " + std::to_string(i) + ".\n";
-                    WarnMessage(msg.c_str()); /* Error */
-                    fclose(fp);
-                    return false;
-                }
-            }
-
-            elm.blk=blocklist[elm.lbl].BlockType;
-            meshelem[i] = elm;
-#ifdef DEBUG_FPPROC
-            printf("numelement: %d\n", k);
-#endif // DEBUG_FPPROC
-        }
-        else
-        {
-            // There was some read error while trying to read the file
-            WarnMessage("An error occured while reading mesh elements section of file.\n"); /* Error */
-            fclose(fp);
-            return false;
-        }
-    }
-
-    // read in circuit data;
-    fscanf(fp,"%i\n",&k);
-    for(i=0; i<k; i++)
-    {
-        fgets(s,1024,fp);
-        if (Frequency==0)
-        {
-            sscanf(s,"%i\t%lf",&j,&zr);
-            blocklist[i].Case=j;
-            if (j==0) blocklist[i].dVolts=zr;
-            else blocklist[i].J=zr;
-        }
-        else
-        {
-            sscanf(s,"%i\t%lf\t%lf",&j,&zr,&zi);
-            blocklist[i].Case=j;
-            if (j==0) blocklist[i].dVolts=zr + I*zi;
-            else blocklist[i].J=zr + I*zi;
-        }
-    }
-
-	// fpproc doesn't actively use PBC data, but it needs to read it to get to the
-	// air gap element data beyond
-	if (fgets(s,1024,fp)!=NULL)
-	{
-		sscanf(s,"%i",&k);
-		for(i=0;i<k;i++)
-			fgets(s,1024,fp);
-	}
-
-	// Read in Air Gap Element information
-	fgets(s,1024,fp); sscanf(s,"%i",&k);
-	for(i=0;i<k;i++){
-		CAirGapElement age;
-
-		fgets(s,1024,fp);
-		age.BdryName = std::string(s);
-		age.BdryName = std::regex_replace (age.BdryName, std::regex("\""), "");
-		age.BdryName = std::regex_replace (age.BdryName, std::regex("\n"), "");
-		fgets(s,1024,fp);
-		sscanf(s,"%i %lf %lf %lf %lf %lf %lf %lf %i %lf %lf",
-			&age.BdryFormat,&age.InnerAngle,&age.OuterAngle,
-			&age.ri,&age.ro,&age.totalArcLength,
-			&age.agc.re,&age.agc.im,&age.totalArcElements,
-			&age.InnerShift,&age.OuterShift);
-
-		age.ri*=LengthConv[LengthUnits];
-		age.ro*=LengthConv[LengthUnits];
-
-		// allocate space
-		if (age.totalArcElements>0)
-		{
-			j = age.totalArcElements+1;
-
-			age.quadNode.clear ();
-			age.quadNode.shrink_to_fit ();
-			age.quadNode.reserve (j);
-
-			//age.quadNode=(CQuadPoint *)calloc(j,sizeof(CQuadPoint));		// list of nodes on inner radius
-		}
-
-		for(j=0;j<=age.totalArcElements;j++)
-        {
-			CQuadPoint q;
-
-			fgets(s,1024,fp);
-			sscanf(s,"%i %lf %i %lf %i %lf %i %lf",
-				&q.n0, &q.w0,
-				&q.n1, &q.w1,
-				&q.n2, &q.w2,
-				&q.n3, &q.w3);
-			age.quadNode.push_back(q);
-		}
-
-		if (age.totalArcElements>0)
-        {
-            agelist.push_back (age);
-        }
-	}
-
-	fclose(fp);
-
-	// figure out amplitudes of harmonics for AGE boundary conditions
-	for (i=0;i<(int)agelist.size();i++)
-	{
-		int m;
-		double tta,R,dr,ri,ro,n,dt;
-		CComplex brc,brs,btc,bts;
-		double brcPrev,brsPrev,btcPrev,btsPrev;
-
-		R=(agelist[i].ri + agelist[i].ro)/2.;
-		dr=(agelist[i].ro - agelist[i].ri);
-		ri=agelist[i].ri/R;
-		ro=agelist[i].ro/R;
-		dt=(PI/180.)*agelist[i].totalArcLength/((double) agelist[i].totalArcElements);
-
-		if (agelist[i].BdryFormat==0)
-		{
-			agelist[i].nn=(agelist[i].totalArcElements/2)+1; // periodic AGE
-			m = (int) round(360./agelist[i].totalArcLength);
-		}
-		else
-		{
-			agelist[i].nn=(agelist[i].totalArcElements+1)/2; // antiperiodic AGE
-			m = (int) round(180./agelist[i].totalArcLength);
-		}
-
-		// for present solution
-		agelist[i].brc=(CComplex *)calloc(agelist[i].nn,sizeof(CComplex));
-		agelist[i].brs=(CComplex *)calloc(agelist[i].nn,sizeof(CComplex));
-		agelist[i].btc=(CComplex *)calloc(agelist[i].nn,sizeof(CComplex));
-		agelist[i].bts=(CComplex *)calloc(agelist[i].nn,sizeof(CComplex));
-		agelist[i].br=(CComplex *)calloc(agelist[i].totalArcElements,sizeof(CComplex));
-		agelist[i].bt=(CComplex *)calloc(agelist[i].totalArcElements,sizeof(CComplex));
-		agelist[i].nh=(int *)calloc(agelist[i].nn,sizeof(int));
-
-		// for previous solution;
-		if (bIncremental == MS_LEGACY_FALSE)
-		{
-			agelist[i].brcPrev=NULL;
-			agelist[i].brsPrev=NULL;
-			agelist[i].btcPrev=NULL;
-			agelist[i].btsPrev=NULL;
-			agelist[i].brPrev=NULL;
-			agelist[i].btPrev=NULL;
-		}
-		else{
-			agelist[i].brcPrev=(double *)calloc(agelist[i].nn,sizeof(double));
-			agelist[i].brsPrev=(double *)calloc(agelist[i].nn,sizeof(double));
-			agelist[i].btcPrev=(double *)calloc(agelist[i].nn,sizeof(double));
-			agelist[i].btsPrev=(double *)calloc(agelist[i].nn,sizeof(double));
-			agelist[i].brPrev=(double *)calloc(agelist[i].totalArcElements,sizeof(double));
-			agelist[i].btPrev=(double *)calloc(agelist[i].totalArcElements,sizeof(double));
-		}
-
-		// compute A and B at center of each gap element
-		agelist[i].aco=0;
-		for(k=0;k<agelist[i].totalArcElements;k++)
-		{
-			int nn[10];
-			double ww[10];
-			int kk;
-			CComplex a[10];
-			CComplex ac;
-
-			double ci=agelist[i].InnerShift;
-			double co=agelist[i].OuterShift;
-
-
-			// inner nodes
-			if ((k-1)<0){
-				nn[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].n0;
-				ww[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].w0;
-			}
-			else{
-				nn[0]=agelist[i].quadNode[k-1].n0;
-				ww[0]=agelist[i].quadNode[k-1].w0;
-			}
-
-			nn[1]=agelist[i].quadNode[k].n0;
-			nn[2]=agelist[i].quadNode[k].n1;
-			nn[3]=agelist[i].quadNode[k+1].n1;
-			ww[1]=agelist[i].quadNode[k].w0;
-			ww[2]=agelist[i].quadNode[k].w1;
-			ww[3]=agelist[i].quadNode[k+1].w1;
-
-			if((k+2)>agelist[i].totalArcElements){
-				nn[4]=agelist[i].quadNode[1].n1;
-				ww[4]=agelist[i].quadNode[1].w1;
-			}
-			else{
-				nn[4]=agelist[i].quadNode[k+2].n1;
-				ww[4]=agelist[i].quadNode[k+2].w1;
-			}
-
-			// outer nodes
-			if ((k-1)<0){
-				nn[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].n2;
-				ww[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].w2;
-			}
-			else{
-				nn[5]=agelist[i].quadNode[k-1].n2;
-				ww[5]=agelist[i].quadNode[k-1].w2;
-			}
+			// outer nodes
+			if ((k-1)<0){
+				nn[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].n2;
+				ww[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].w2;
+			}
+			else{
+				nn[5]=agelist[i].quadNode[k-1].n2;
+				ww[5]=agelist[i].quadNode[k-1].w2;
+			}
 
 			nn[6]=agelist[i].quadNode[k].n2;
 			nn[7]=agelist[i].quadNode[k].n3;
@@ -1993,6 +1765,475 @@ bool FPProc::OpenDocument(string pathname)
     return true;
 }
 
+bool FPProc::ReadSolution(FILE *fp)
+{
+    int i,j,k,sscnt;
+    char s[1024];
+    double zr,zi;
+    femmpostproc::CPostProcMElement      elm;
+    femmsolver::CMMeshNode     mnode;
+
+    // read in meshnodes;
+    fscanf(fp,"%i\n",&k);
+#ifdef DEBUG_FPPROC
+    printf("numnodes: %d\n", k);
+#endif // DEBUG_FPPROC
+    meshnode.resize(k);
+    for(i=0; i<k; i++)
+    {
+        if ( fgets(s,1024,fp) != NULL )
+        {
+            if (Frequency!=0)
+            {
+                if (!bIncremental)
+                {
+                    sscnt = sscanf(s,"%lf\t%lf\t%lf\t%lf",
+                                   &mnode.x,
+                                   &mnode.y,
+                                   &mnode.A.re,
+                                   &mnode.A.im) ;
+
+                    if (sscnt != 4)
+                    {
+                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
+                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
+                                + " (expected 4).\n";
+                        WarnMessage(msg.c_str()); /* Error */
+                        return false;
+                    }
+                }
+                else
+                {
+                    int bc;
+                    double tmpAprev = 0;
+
+                    sscanf(s,"%lf\t%lf\t%lf\t%lf\t%i\t%lf",
+                           &mnode.x,
+                           &mnode.y,
+                           &mnode.A.re,
+                           &mnode.A.im,
+                           &bc,
+                           &tmpAprev);
+
+                    Aprev.push_back(tmpAprev);
+
+                    if (sscnt != 6)
+                    {
+                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
+                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
+                                + " (expected 6).\n";
+                        WarnMessage(msg.c_str()); /* Error */
+                        return false;
+                    }
+                }
+            }
+            else
+            {
+                if (!bIncremental)
+                {
+                    sscnt = sscanf(s,"%lf\t%lf\t%lf",
+                                   &mnode.x,
+                                   &mnode.y,
+                                   &mnode.A.re);
+
+
+                    if (sscnt != 3)
+                    {
+                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
+                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
+                                + " (expected 3).\n";
+                        WarnMessage(msg.c_str()); /* Error */
+    #ifdef DEBUG_FPPROC
+                        printf("s: %s\n", s);
+    #endif // DEBUG_FPPROC
+                        return false;
+                    }
+                }
+                else
+                {
+                    int bc;
+                    double tmpAprev = 0;
+
+                    sscnt = sscanf(s, "%lf\t%lf\t%lf\t%i\t%lf",
+                                   &mnode.x,
+                                   &mnode.y,
+                                   &mnode.A.re,
+                                   &bc,
+                                   &tmpAprev);
+
+                    Aprev.push_back(tmpAprev);
+
+                    if (sscnt != 5)
+                    {
+                        std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
+                                + std::to_string(sscnt) + ") for node " + std::to_string(i)
+                                + " (expected 5).\n";
+                        WarnMessage(msg.c_str()); /* Error */
+    #ifdef DEBUG_FPPROC
+                        printf("s: %s\n", s);
+    #endif // DEBUG_FPPROC
+                        return false;
+                    }
+
+                }
+                mnode.A.im=0;
+            }
+            meshnode[i] = mnode;
+        }
+        else
+        {
+            // There was some read error while trying to read the file
+            WarnMessage("An error occured while reading mesh nodes section of file.\n"); /* Error */
+            return false;
+        }
+
+    }
+
+    // read in elements;
+    fgets(s,1024,fp);
+    sscanf(s,"%i",&k);
+    //fscanf(fp,"%i\n",&k);
+    meshelem.resize(k);
+#ifdef DEBUG_FPPROC
+    printf("numelement: %d\n", k);
+#endif // DEBUG_FPPROC
+    for(i=0; i<k; i++)
+    {
+        if ( fgets(s,1024,fp) != NULL )
+        {
+            if (!bIncremental)
+            {
+                sscnt = sscanf(s,"%i\t%i\t%i\t%i",&elm.p[0],&elm.p[1],&elm.p[2],&elm.lbl);
+#ifdef DEBUG_FPPROC
+                printf("s: %s\n", s);
+                //getchar();
+#endif // DEBUG_FPPROC
+                if (sscnt != 4)
+                {
+                    std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
+                            + std::to_string(sscnt) + ") for element " + std::to_string(i) + ".\n";
+                    WarnMessage(msg.c_str()); /* Error */
+                    return false;
+                }
+            }
+            else
+            {
+                sscnt = sscanf(s,"%i	%i	%i	%i	%lf",&elm.p[0],&elm.p[1],&elm.p[2],&elm.lbl,&elm.Jprev);
+
+#ifdef DEBUG_FPPROC
+                printf("s: %s\n", s);
+                //getchar();
+#endif // DEBUG_FPPROC
+                if (sscnt != 5)
+                {
+                    std::string msg = "An error occured while reading mesh nodes section of file, wrong number of inputs ("
+                            + std::to_string(sscnt) + ") for element " + std::to_string(i) + ".\n";
+                    WarnMessage(msg.c_str()); /* Error */
+                    return false;
+                }
+            }
+
+            elm.blk=blocklist[elm.lbl].BlockType;
+            meshelem[i] = elm;
+#ifdef DEBUG_FPPROC
+            printf("numelement: %d\n", k);
+#endif // DEBUG_FPPROC
+        }
+        else
+        {
+            // There was some read error while trying to read the file
+            WarnMessage("An error occured while reading mesh elements section of file.\n"); /* Error */
+            return false;
+        }
+    }
+
+    // read in circuit data;
+    fscanf(fp,"%i\n",&k);
+    for(i=0; i<k; i++)
+    {
+        fgets(s,1024,fp);
+        if (Frequency==0)
+        {
+            sscanf(s,"%i\t%lf",&j,&zr);
+            blocklist[i].Case=j;
+            if (j==0) blocklist[i].dVolts=zr;
+            else blocklist[i].J=zr;
+        }
+        else
+        {
+            sscanf(s,"%i\t%lf\t%lf",&j,&zr,&zi);
+            blocklist[i].Case=j;
+            if (j==0) blocklist[i].dVolts=zr + I*zi;
+            else blocklist[i].J=zr + I*zi;
+        }
+    }
+
+	// fpproc doesn't actively use PBC data, but it needs to read it to get to the
+	// air gap element data beyond
+	if (fgets(s,1024,fp)!=NULL)
+	{
+		sscanf(s,"%i",&k);
+		for(i=0;i<k;i++)
+			fgets(s,1024,fp);
+	}
+
+	// Read in Air Gap Element information
+	fgets(s,1024,fp); sscanf(s,"%i",&k);
+	for(i=0;i<k;i++){
+		CAirGapElement age;
+
+		fgets(s,1024,fp);
+		age.BdryName = std::string(s);
+		age.BdryName = std::regex_replace (age.BdryName, std::regex("\""), "");
+		age.BdryName = std::regex_replace (age.BdryName, std::regex("\n"), "");
+		fgets(s,1024,fp);
+		sscanf(s,"%i %lf %lf %lf %lf %lf %lf %lf %i %lf %lf",
+			&age.BdryFormat,&age.InnerAngle,&age.OuterAngle,
+			&age.ri,&age.ro,&age.totalArcLength,
+			&age.agc.re,&age.agc.im,&age.totalArcElements,
+			&age.InnerShift,&age.OuterShift);
+
+		age.ri*=LengthConv[LengthUnits];
+		age.ro*=LengthConv[LengthUnits];
+
+		// allocate space
+		if (age.totalArcElements>0)
+		{
+			j = age.totalArcElements+1;
+
+			age.quadNode.clear ();
+			age.quadNode.shrink_to_fit ();
+			age.quadNode.reserve (j);
+
+			//age.quadNode=(CQuadPoint *)calloc(j,sizeof(CQuadPoint));		// list of nodes on inner radius
+		}
+
+		for(j=0;j<=age.totalArcElements;j++)
+        {
+			CQuadPoint q;
+
+			fgets(s,1024,fp);
+			sscanf(s,"%i %lf %i %lf %i %lf %i %lf",
+				&q.n0, &q.w0,
+				&q.n1, &q.w1,
+				&q.n2, &q.w2,
+				&q.n3, &q.w3);
+			age.quadNode.push_back(q);
+		}
+
+		if (age.totalArcElements>0)
+        {
+            agelist.push_back (age);
+        }
+	}
+
+    return true;
+}
+
+bool FPProc::ReadBinarySolution(const femm::CSolutionFile &file)
+{
+    using namespace femm;
+    size_t numNodes, numElements, n;
+
+    // the mesh nodes
+    const SolutionNode *nodes = file.section<SolutionNode>(SolutionSection::Nodes, numNodes);
+    const double *potentials = nullptr;
+    const SolutionComplex *complexPotentials = nullptr;
+    if (Frequency==0)
+        potentials = file.section<double>(SolutionSection::Potentials, n);
+    else
+        complexPotentials = file.section<SolutionComplex>(SolutionSection::ComplexPotentials, n);
+    if (!nodes || (!potentials && !complexPotentials) || n!=numNodes)
+    {
+        WarnMessage("The binary solution contains no mesh nodes or no potentials.\n");
+        return false;
+    }
+    meshnode.resize(numNodes);
+    for (size_t i=0; i<numNodes; i++)
+    {
+        meshnode[i].x = nodes[i].x;
+        meshnode[i].y = nodes[i].y;
+        if (potentials)
+            meshnode[i].A = CComplex(potentials[i], 0);
+        else
+            meshnode[i].A = CComplex(complexPotentials[i].re, complexPotentials[i].im);
+    }
+    if (bIncremental)
+    {
+        const double *prev = file.section<double>(SolutionSection::PreviousPotentials, n);
+        if (!prev || n!=numNodes)
+        {
+            WarnMessage("The solution contains no previous solution for the incremental problem.\n");
+            return false;
+        }
+        Aprev.assign(prev, prev+n);
+    }
+
+    // the mesh elements
+    const SolutionElement *elements = file.section<SolutionElement>(SolutionSection::Elements, numElements);
+    const double *Jprev = nullptr;
+    if (bIncremental)
+    {
+        Jprev = file.section<double>(SolutionSection::PreviousCurrentDensities, n);
+        if (!Jprev || n!=numElements)
+        {
+            WarnMessage("The solution contains no previous solution for the incremental problem.\n");
+            return false;
+        }
+    }
+    if (!elements)
+    {
+        WarnMessage("The binary solution contains no mesh elements.\n");
+        return false;
+    }
+    meshelem.resize(numElements);
+    for (size_t i=0; i<numElements; i++)
+    {
+        femmpostproc::CPostProcMElement &elm = meshelem[i];
+        for (int j=0; j<3; j++)
+        {
+            elm.p[j] = elements[i].p[j];
+            if (elm.p[j]<0 || elm.p[j]>=(int)numNodes)
+            {
+                WarnMessage("The binary solution contains an element with an invalid node.\n");
+                return false;
+            }
+        }
+        elm.lbl = elements[i].lbl;
+        if (elm.lbl<0 || elm.lbl>=(int)blocklist.size())
+        {
+            WarnMessage("The binary solution contains an element with an invalid block label.\n");
+            return false;
+        }
+        if (Jprev)
+            elm.Jprev = Jprev[i];
+        elm.blk = blocklist[elm.lbl].BlockType;
+    }
+
+    // circuit data
+    const SolutionCircuit *circuits = file.section<SolutionCircuit>(SolutionSection::Circuits, n);
+    for (size_t i=0; i<n && i<blocklist.size(); i++)
+    {
+        const SolutionCircuit &circ = circuits[i];
+        CComplex value = (Frequency==0) ? CComplex(circ.value[0]) : CComplex(circ.value[0], circ.value[1]);
+        blocklist[i].Case = circ.Case;
+        if (circ.Case==0)
+            blocklist[i].dVolts = value;
+        else
+            blocklist[i].J = value;
+    }
+
+    // the air gap elements, as ReadSolution() would read them
+    size_t numAges, numQuadPoints, namesLength;
+    const SolutionAirGapElement *ages = file.section<SolutionAirGapElement>(SolutionSection::AirGapElements, numAges);
+    const SolutionQuadPoint *quadPoints = file.section<SolutionQuadPoint>(SolutionSection::AirGapQuadPoints, numQuadPoints);
+    const char *names = file.section<char>(SolutionSection::AirGapNames, namesLength);
+    for (size_t i=0; i<numAges; i++)
+    {
+        const SolutionAirGapElement &solutionAge = ages[i];
+        if (solutionAge.totalArcElements<=0)
+            continue;
+        if (solutionAge.firstQuadPoint<0 || (size_t)solutionAge.firstQuadPoint+solutionAge.totalArcElements >= numQuadPoints
+                || solutionAge.nameOffset<0 || solutionAge.nameLength<0
+                || (size_t)solutionAge.nameOffset+solutionAge.nameLength > namesLength)
+        {
+            WarnMessage("The binary solution contains an invalid air gap element.\n");
+            return false;
+        }
+        CAirGapElement age;
+        age.BdryName = std::string(names+solutionAge.nameOffset, solutionAge.nameLength);
+        age.BdryName = std::regex_replace (age.BdryName, std::regex("\""), "");
+        age.BdryName = std::regex_replace (age.BdryName, std::regex("\n"), "");
+        age.BdryFormat = solutionAge.BdryFormat;
+        age.InnerAngle = solutionAge.InnerAngle;
+        age.OuterAngle = solutionAge.OuterAngle;
+        age.ri = solutionAge.ri*LengthConv[LengthUnits];
+        age.ro = solutionAge.ro*LengthConv[LengthUnits];
+        age.totalArcLength = solutionAge.totalArcLength;
+        age.agc = CComplex(solutionAge.agc.re, solutionAge.agc.im);
+        age.totalArcElements = solutionAge.totalArcElements;
+        age.InnerShift = solutionAge.InnerShift;
+        age.OuterShift = solutionAge.OuterShift;
+        age.quadNode.resize(age.totalArcElements+1);
+        for (int j=0; j<=age.totalArcElements; j++)
+        {
+            const SolutionQuadPoint &qp = quadPoints[solutionAge.firstQuadPoint+j];
+            age.quadNode[j] = CQuadPoint{qp.n[0], qp.n[1], qp.n[2], qp.n[3], qp.w[0], qp.w[1], qp.w[2], qp.w[3]};
+        }
+        agelist.push_back(age);
+    }
+
+    return true;
+}
+
+bool FPProc::CopySolution(const femm::CMSolution &solution)
+{
+    meshnode.resize(solution.nodes.size());
+    for (int i=0; i<(int)solution.nodes.size(); i++)
+    {
+        meshnode[i].x = solution.nodes[i].x;
+        meshnode[i].y = solution.nodes[i].y;
+        meshnode[i].A = solution.nodes[i].A;
+        if (Frequency==0)
+            meshnode[i].A.im = 0;
+    }
+    if (bIncremental)
+    {
+        if (solution.Aprev.size() != solution.nodes.size())
+        {
+            WarnMessage("The solution contains no previous solution for the incremental problem.\n");
+            return false;
+        }
+        Aprev = solution.Aprev;
+    }
+
+    meshelem.resize(solution.elements.size());
+    for (int i=0; i<(int)solution.elements.size(); i++)
+    {
+        femmpostproc::CPostProcMElement &elm = meshelem[i];
+        for (int j=0; j<3; j++)
+            elm.p[j] = solution.elements[i].p[j];
+        elm.lbl = solution.elements[i].lbl;
+        if (bIncremental)
+            elm.Jprev = solution.elements[i].Jprev;
+        elm.blk = blocklist[elm.lbl].BlockType;
+    }
+
+    for (int i=0; i<(int)solution.circuits.size() && i<(int)blocklist.size(); i++)
+    {
+        const femm::CMSolution::Circuit &circ = solution.circuits[i];
+        blocklist[i].Case = circ.Case;
+        if (circ.Case==0)
+            blocklist[i].dVolts = (Frequency==0) ? CComplex(circ.value.re) : circ.value;
+        else
+            blocklist[i].J = (Frequency==0) ? CComplex(circ.value.re) : circ.value;
+    }
+
+    // the air gap elements, as ReadSolution() would read them
+    for (const CAirGapElement &solutionAge : solution.ages)
+    {
+        if (solutionAge.totalArcElements<=0)
+            continue;
+        CAirGapElement age;
+        age.BdryName = std::regex_replace (solutionAge.BdryName, std::regex("\""), "");
+        age.BdryName = std::regex_replace (age.BdryName, std::regex("\n"), "");
+        age.BdryFormat = solutionAge.BdryFormat;
+        age.InnerAngle = solutionAge.InnerAngle;
+        age.OuterAngle = solutionAge.OuterAngle;
+        age.ri = solutionAge.ri*LengthConv[LengthUnits];
+        age.ro = solutionAge.ro*LengthConv[LengthUnits];
+        age.totalArcLength = solutionAge.totalArcLength;
+        age.agc = solutionAge.agc;
+        age.totalArcElements = solutionAge.totalArcElements;
+        age.InnerShift = solutionAge.InnerShift;
+        age.OuterShift = solutionAge.OuterShift;
+        age.quadNode = solutionAge.quadNode;
+        agelist.push_back(age);
+    }
+
+    return true;
+}
+
 //bool FPProc::LoadPBCFromSolution(FILE* fp)
 //{
 //    char s[1024];
@@ -48,6 +48,8 @@
 #include "CNode.h"
 #include "CPointProp.h"
 #include "CSegment.h"
+#include "msolution.h"
+#include "solutionfile.h"
 #include "PostProcessor.h"
 
 #include <vector>
@@ -274,6 +276,13 @@ public:
     bool NewDocument();
 //     virtual void Serialize(CArchive& ar);
     bool OpenDocument(std::string lpszPathName) override;
+    /**
+     * @brief Load a solution that is held in memory, instead of reading it from a \c .ans file.
+     * @param problemFile the \c .fem file of the problem, i.e. the file that was solved
+     * @param solution the solution, see FSolver::keepSolution
+     * @return \c true on success, \c false otherwise.
+     */
+    bool LoadSolution(const std::string &problemFile, const femm::CMSolution &solution);
     bool MakeMask();
     //bool LoadMeshNodesFromSolution(bool loadA, FILE* fp);
     //bool LoadMeshElementsFromSolution(FILE* fp);
@@ -289,6 +298,17 @@ private:
 
     char warnBuf [1028];
 
+    /**
+     * @brief Read the problem description from \p pathname and take the solution either from the same file,
+     * or from \p solution if it is not null. Then compute the derived data.
+     */
+    bool LoadDocument(const std::string &pathname, const femm::CMSolution *solution);
+    /// read the \c [Solution] section of a \c .ans file; \p fp is positioned after the section header
+    bool ReadSolution(FILE *fp);
+    /// take the solution from the mapped container of a binary \c .ans file
+    bool ReadBinarySolution(const femm::CSolutionFile &file);
+    bool CopySolution(const femm::CMSolution &solution);
+
 //#ifdef _DEBUG
     //virtual void AssertValid() const;
     //virtual void Dump(CDumpContext& dc) const;
@@ -35,6 +35,9 @@
 #include <fparse.h>
 #include <fsolver.h>
 #include <LuaInstance.h>
+#include <lua.h>
+#include <meshdata.h>
+#include <solutionfile.h>
 #include <spars.h>
 
 #include <algorithm>
@@ -46,6 +49,7 @@
 #include <iostream>
 #include <malloc.h>
 #include <math.h>
+#include <memory>
 #include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
@@ -67,6 +71,16 @@ template class FEASolver<
 #define _strnicmp strncasecmp
 #endif
 
+#ifdef _MSC_VER
+  #ifndef SNPRINTF
+  #define SNPRINTF _snprintf
+  #endif
+#else
+  #ifndef SNPRINTF
+  #define SNPRINTF std::snprintf
+  #endif
+#endif
+
 #ifdef DEBUG_FSOLVER
 #define debug std::cerr << __func__ << "(): "
 #else
@@ -350,23 +364,25 @@ bool FSolver::LoadProblemFile ()
 LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 {
     int i,j,k,q,n0,n1;
-    char infile[256];
-    FILE *fp;
-    char s[1024];
 
     if (meshLoadedFromPrevSolution)
     {
         return NOERROR;
     }
 
-    //read meshnodes;
-    sprintf(infile,"%s.node",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
+    // use the triangulation handed over by the mesher, or read the mesh files
+    femm::CMeshData fileMesh;
+    const femm::CMeshData *mesh = meshData.get();
+    if (!mesh)
     {
-        return BADNODEFILE;
+        LoadMeshErr err = fileMesh.readFiles(PathName);
+        if (err != NOERROR)
+            return err;
+        mesh = &fileMesh;
     }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
+
+    // mesh nodes
+    k = (int) mesh->nodes.size();
     NumNodes = k;
 
     meshnode.clear();
@@ -375,10 +391,9 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
     CNode node;
     for(i=0; i<k; i++)
     {
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%lf",&node.x);
-        fscanf(fp,"%lf",&node.y);
-        fscanf(fp,"%i",&j);
+        node.x = mesh->nodes[i].x;
+        node.y = mesh->nodes[i].y;
+        j = mesh->nodes[i].marker;
         if(j>1) j=j-2;
         else j=-1;
         node.BoundaryMarker=j;
@@ -389,30 +404,10 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 
         meshnode.push_back (node);
     }
-    fclose(fp);
-
-    //read in periodic boundary conditions;
-    sprintf(infile,"%s.pbc",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
-    {
-        return BADPBCFILE;
-    }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&NumPBCs);
 
-    if (NumPBCs!=0)
-    {
-        pbclist.clear();
-        pbclist.shrink_to_fit();
-        pbclist.reserve(NumPBCs);
-    }
-    CCommonPoint pbc;
-    for(i=0; i<NumPBCs; i++)
-    {
-        fgets(s,1024,fp);
-        sscanf(s,"%i %i %i %i",&j,&pbc.x,&pbc.y,&pbc.t);
-        pbclist.push_back(pbc);
-    }
+    // periodic boundary conditions
+    NumPBCs = (int) mesh->pbcs.size();
+    pbclist = mesh->pbcs;
 
 #ifdef DEBUG
     {
@@ -421,96 +416,12 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
     }
 #endif // DEBUG
 
-    // read in air gap element info
-    fgets(s,1024,fp);
-    sscanf(s,"%i", &NumAirGapElems);
-
-#ifdef DEBUG
-    {
-        char buf[1048]; SNPRINTF(buf, sizeof(buf), "Found %i ages, line was: \"%s\"\n", NumAirGapElems, s);
-        WarnMessage(buf);
-    }
-#endif // DEBUG
-
-    CAirGapElement age;
-
-    agelist.clear();
-    agelist.shrink_to_fit();
-    agelist.reserve(NumAirGapElems);
-
-    for(i=0;i<NumAirGapElems;i++)
-    {
-        fgets(s,80,fp);
-#ifdef DEBUG
-        {
-            char buf[1048]; SNPRINTF( buf, sizeof(buf), "Read line:\n%s\n", s);
-            WarnMessage(buf);
-        }
-#endif // DEBUG
-        age.BdryName = std::string (s);
-
-        fgets(s,1024,fp);
-
-        sscanf(s,"%i %lf %lf %lf %lf %lf %lf %lf %i %lf %lf",
-                &age.BdryFormat,
-                &age.InnerAngle,
-                &age.OuterAngle,
-                &age.ri,
-                &age.ro,
-                &age.totalArcLength,
-                &age.agc.re,
-                &age.agc.im,
-                &age.totalArcElements,
-                &age.InnerShift,
-                &age.OuterShift );
-
-#ifdef DEBUG
-        {
-            char buf[1048]; SNPRINTF( buf, sizeof(buf), "Read age:\n\tBdryFormat: %i \n\tInnerAngle: %lf \n\tOuterAngle %lf \n\ttotalArcElements: %i \n",
-                                      age.BdryFormat,
-                                      age.InnerAngle,
-                                      age.OuterAngle,
-                                      age.totalArcElements );
-            WarnMessage(buf);
-        }
-#endif // DEBUG
-        age.quadNode.clear();
-        age.quadNode.shrink_to_fit();
-        age.quadNode.reserve(age.totalArcElements+1);
-
-        for(k=0;k<=age.totalArcElements;k++)
-        {
-            fgets(s,1024,fp);
-
-            CQuadPoint qp;
-
-            sscanf(s,"%i %lf %i %lf %i %lf %i %lf",
-                &qp.n0, &qp.w0,
-                &qp.n1, &qp.w1,
-                &qp.n2, &qp.w2,
-                &qp.n3, &qp.w3);
-
-            age.quadNode.push_back(qp);
-        }
-        agelist.push_back (age);
-    }
+    // air gap elements
+    NumAirGapElems = (int) mesh->ages.size();
+    agelist = mesh->ages;
 
-    fclose(fp);
-
-    // read in elements;
-    sprintf(infile,"%s.ele",PathName.c_str());
-#ifdef DEBUG
-    {
-        char buf[1028]; SNPRINTF(buf, sizeof(buf), "Reading in elements from %s\n", infile);
-        WarnMessage(buf);
-    }
-#endif // DEBUG
-    if((fp=fopen(infile,"rt"))==NULL)
-    {
-        return BADELEMENTFILE;
-    }
-    fgets(s,1024,fp);
-    sscanf(s,"%i",&k);
+    // elements
+    k = (int) mesh->elements.size();
     NumEls = k;
 
     meshele.clear();
@@ -530,11 +441,10 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 
     for(i=0; i<k; i++)
     {
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%i",&elm.p[0]);
-        fscanf(fp,"%i",&elm.p[1]);
-        fscanf(fp,"%i",&elm.p[2]);
-        fscanf(fp,"%i",&elm.lbl);
+        elm.p[0] = mesh->elements[i].p[0];
+        elm.p[1] = mesh->elements[i].p[1];
+        elm.p[2] = mesh->elements[i].p[2];
+        elm.lbl = mesh->elements[i].label;
         elm.lbl--;
 
         if(elm.lbl<0)
@@ -549,19 +459,9 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
             char buf[1028]; SNPRINTF(buf, sizeof(buf), "The element number %i had label %i\n", i, elm.lbl);
             msg += std::string (buf);
             WarnMessage(msg.c_str());
-            fclose(fp);
             if (deleteFiles)
             {
-                sprintf(infile,"%s.ele",PathName.c_str());
-                remove(infile);
-                sprintf(infile,"%s.node",PathName.c_str());
-                remove(infile);
-                sprintf(infile,"%s.pbc",PathName.c_str());
-                remove(infile);
-                sprintf(infile,"%s.poly",PathName.c_str());
-                remove(infile);
-                sprintf(infile,"%s.edge",PathName.c_str());
-                remove(infile);
+                femm::CMeshData::removeFiles(PathName);
             }
             return MISSINGMATPROPS;
         }
@@ -571,19 +471,9 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
             char buf[1028];
             SNPRINTF(buf, sizeof(buf), "The element number %i had label %i which is greater than the number of available labels (%i)\n", i+1, elm.lbl+1, (int)labellist.size());
             WarnMessage(buf);
-            fclose(fp);
             if (deleteFiles)
             {
-                sprintf(infile,"%s.ele",PathName.c_str());
-                remove(infile);
-                sprintf(infile,"%s.node",PathName.c_str());
-                remove(infile);
-                sprintf(infile,"%s.pbc",PathName.c_str());
-                remove(infile);
-                sprintf(infile,"%s.poly",PathName.c_str());
-                remove(infile);
-                sprintf(infile,"%s.edge",PathName.c_str());
-                remove(infile);
+                femm::CMeshData::removeFiles(PathName);
             }
             return ELMLABELTOOBIG;
         }
@@ -593,7 +483,6 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
 
         meshele.push_back(elm);
     }
-    fclose(fp);
 
     // initialize edge bc's and element permeabilities;
     for(i=0; i<NumEls; i++)
@@ -637,20 +526,12 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
             nmbr[k]++;
         }
 
-    sprintf(infile,"%s.edge",PathName.c_str());
-    if((fp=fopen(infile,"rt"))==NULL)
-    {
-        return BADEDGEFILE;
-    }
-    fscanf(fp,"%i",&k);// read in number of lines
-
-    fscanf(fp,"%i",&j);// read in boundarymarker flag;
+    k = (int) mesh->edges.size();
     for(i=0; i<k; i++)
     {
-        fscanf(fp,"%i",&j);
-        fscanf(fp,"%i",&n0);
-        fscanf(fp,"%i",&n1);
-        fscanf(fp,"%i",&j);
+        n0 = mesh->edges[i].n0;
+        n1 = mesh->edges[i].n1;
+        j = mesh->edges[i].marker;
 
         if(j<0)
         {
@@ -675,24 +556,16 @@ LoadMeshErr FSolver::LoadMesh(bool deleteFiles)
         }
 
     }
-    fclose(fp);
 
     // free up the connectivity information
     free(nmbr);
     for(i=0; i<NumNodes; i++) free(mbr[i]);
     free(mbr);
 
-    if (deleteFiles)
+    if (deleteFiles && !meshData)
     {
-        // clear out temporary files
-        sprintf(infile,"%s.ele",PathName.c_str());
-        remove(infile);
-        sprintf(infile,"%s.node",PathName.c_str());
-        remove(infile);
-        sprintf(infile,"%s.pbc",PathName.c_str());
-        remove(infile);
-        sprintf(infile,"%s.poly",PathName.c_str());
-        remove(infile);
+        // clear out temporary files; the edge file is still needed by Cuthill()
+        femm::CMeshData::removeFiles(PathName, false);
     }
 
     return NOERROR;
@@ -1002,6 +875,14 @@ bool FSolver::loadPreviousSolution(bool loadAprev)
             hasSolution=true;
             break;
         }
+        if( _strnicmp(q,"[binarysolution]",16)==0){
+            fclose(fp);
+            SNPRINTF (warnbuf, sizeof(warnbuf),
+                      "Previous solution files in the binary format are not supported, file path was:\n%s\n",
+                      previousSolutionFile.c_str());
+            WarnMessage(warnbuf);
+            return false;
+        }
     }
 
     // case where the solution is never found.
@@ -1174,6 +1055,94 @@ double FSolver::ElmArea(int i)
 
 }
 
+bool FSolver::GetMagDirections(std::vector<double> &magdir)
+{
+    char magbuff[4096];
+    std::string str;
+    CComplex X;
+    int j,top1,top2,lua_error_code;
+    double units[]= {2.54,0.1,1.,100.,0.00254,1.e-04};
+
+    magdir.resize(NumEls);
+    for(int i=0; i<NumEls; i++)
+    {
+        const femmsolver::CMElement &El = meshele[i];
+
+        magdir[i] = labellist[El.lbl].MagDir;
+        if (labellist[El.lbl].MagDirFctn.empty())
+            continue;
+
+        // functional magnetization direction
+        for (j=0,X=0; j<3; j++)
+        {
+            X += (CComplex)(meshnode[El.p[j]].x + I * meshnode[El.p[j]].y);
+        }
+        X = X/units[LengthUnits]/3.;
+        if (ProblemType==AXISYMMETRIC)
+        {
+            SNPRINTF(magbuff, sizeof magbuff, "r=%.17g\nz=%.17g\nx=r\ny=z\ntheta=%.17g\nR=%.17g\nreturn %s",
+                     (X.re) , (X.im) , (arg(X)*180/PI) , (abs(X)) , (labellist[El.lbl].MagDirFctn.c_str()));
+        }
+        else
+        {
+            SNPRINTF(magbuff, sizeof magbuff, "x=%.17g\ny=%.17g\nr=x\nz=y\ntheta=%.17g\nR=%.17g\nreturn %s",
+                     (X.re) , (X.im) , (arg(X)*180/PI) , (abs(X)) , (labellist[El.lbl].MagDirFctn.c_str()));
+        }
+        str = magbuff;
+        lua_State * lua = theLua->getLuaState();
+
+        top1 = lua_gettop(lua);
+
+        lua_error_code = theLua->doString(str, femm::LuaInstance::LuaStackMode::Unsafe);
+
+        if(lua_error_code != 0)
+        {
+            if (lua_error_code==LUA_ERRRUN)
+                WarnMessage("Lua run Error (LUA_ERRRUN) when evaluating magnetization direction function");
+            if (lua_error_code==LUA_ERRMEM)
+                WarnMessage("Lua memory Error (LUA_ERRMEM) when evaluating magnetization direction function");
+            if (lua_error_code==LUA_ERRERR)
+                WarnMessage("Lua user error error (LUA_ERRERR) when evaluating magnetization direction function");
+            if (lua_error_code==LUA_ERRFILE)
+                WarnMessage("Lua file error (LUA_ERRFILE) when evaluating magnetization direction function");
+
+            SNPRINTF(magbuff, sizeof magbuff,
+                     "Lua error occurred when evaluating:\n\"%s\"",
+                     labellist[El.lbl].MagDirFctn.c_str());
+
+            WarnMessage (magbuff);
+
+            return false;
+        }
+
+        top2 = lua_gettop(lua);
+
+        if (top2!=top1)
+        {
+            str = lua_tostring(lua,-1);
+
+            if (str.length()==0)
+            {
+                SNPRINTF(magbuff, sizeof magbuff,
+                         "\"%s\" does not evaluate to a numerical value",
+                         labellist[El.lbl].MagDirFctn.c_str());
+
+                WarnMessage (magbuff);
+
+                return false;
+            }
+            else
+            {
+                magdir[i] = Re(lua_tonumber(lua,-1));
+            }
+
+            lua_pop(lua, 1);
+        }
+    }
+
+    return true;
+}
+
 bool FSolver::runSolver(bool verbose)
 {
     // load mesh
@@ -1213,8 +1182,10 @@ bool FSolver::runSolver(bool verbose)
             WarnMessage("Cannot handle incremental permeability problems with frequency 0.\n");
             return false;
         }
-        CBigLinProb L;
-        L.Precision = Precision;
+        std::unique_ptr<CBigLinProb> Lp = createLinProb();
+        if (!Lp)
+            return false;
+        CBigLinProb &L = *Lp;
 
         // initialize the problem, allocating the space required to solve it.
         if (L.Create(NumNodes, BandWidth) == false)
@@ -1222,6 +1193,10 @@ bool FSolver::runSolver(bool verbose)
             WarnMessage("couldn't allocate enough space for matrices\n");
             return false;
         }
+        // fix the sparsity pattern once, so that assembly only fills in values
+        CSparsityPattern pattern(NumNodes);
+        BuildSparsityPattern(pattern);
+        L.SetPattern(pattern);
 
         // Create element matrices and solve the problem;
         if (ProblemType == PLANAR)
@@ -1244,16 +1219,26 @@ bool FSolver::runSolver(bool verbose)
                 PrintMessage("Static axisymmetric problem solved\n");
         }
 
-        if (WriteStatic2D(L) == false)
+        if (keepSolution || (writeSolutionFile && binarySolutionFile))
+            StoreStatic2D(L);
+        if (writeSolutionFile)
         {
-            WarnMessage("couldn't write results to disk\n");
-            return false;
+            bool written = binarySolutionFile ? WriteBinarySolution(*solution) : WriteStatic2D(L);
+            if (!keepSolution)
+                solution.reset();
+            if (written == false)
+            {
+                WarnMessage("couldn't write results to disk\n");
+                return false;
+            }
+            if (verbose)
+                PrintMessage("results written to disk\n");
         }
-        if (verbose)
-            PrintMessage("results written to disk\n");
     } else {
-        CBigComplexLinProb L;
-        L.Precision = Precision;
+        std::unique_ptr<CBigComplexLinProb> Lp = createComplexLinProb();
+        if (!Lp)
+            return false;
+        CBigComplexLinProb &L = *Lp;
 
         // initialize the problem, allocating the space required to solve it.
         if (!L.Create(NumNodes+NumCircProps, BandWidth, NumNodes))
@@ -1261,6 +1246,17 @@ bool FSolver::runSolver(bool verbose)
             WarnMessage("couldn't allocate enough space for matrices\n");
             return false;
         }
+        // fix the sparsity pattern once, so that assembly only fills in values.
+        // Elements in a circuit may be coupled to the circuit's unknown (if the circuit turns out to be Case 2).
+        std::vector<int> circuitdof(NumEls,-1);
+        for (int i=0; i<NumEls; i++)
+        {
+            if (meshele[i].lbl>=0 && labellist[meshele[i].lbl].InCircuit>=0)
+                circuitdof[i] = NumNodes+labellist[meshele[i].lbl].InCircuit;
+        }
+        CSparsityPattern pattern(NumNodes+NumCircProps);
+        BuildSparsityPattern(pattern, std::vector<int>(), circuitdof);
+        L.SetPattern(pattern);
 
         // Create element matrices and solve the problem;
         if (ProblemType == PLANAR)
@@ -1291,16 +1287,132 @@ bool FSolver::runSolver(bool verbose)
             if (verbose){ PrintMessage("Harmonic axisymmetric problem solved\n"); }
         }
 
-        if (!WriteHarmonic2D(L))
+        if (keepSolution || (writeSolutionFile && binarySolutionFile))
+            StoreHarmonic2D(L);
+        if (writeSolutionFile)
         {
-            WarnMessage("couldn't write results to disk\n");
-            return false;
+            bool written = binarySolutionFile ? WriteBinarySolution(*solution) : WriteHarmonic2D(L);
+            if (!keepSolution)
+                solution.reset();
+            if (!written)
+            {
+                WarnMessage("couldn't write results to disk\n");
+                return false;
+            }
+            if (verbose){ PrintMessage("results written to disk.\n"); }
         }
-        if (verbose){ PrintMessage("results written to disk.\n"); }
     }
     return true;
 }
 
+std::shared_ptr<femm::CMSolution> FSolver::newSolution() const
+{
+    double unitconv[]= {2.54,0.1,1.,100.,0.00254,1.e-04};
+    double cf = unitconv[LengthUnits];
+    std::shared_ptr<femm::CMSolution> sol = std::make_shared<femm::CMSolution>();
+
+    sol->nodes.resize(NumNodes);
+    for(int i=0; i<NumNodes; i++)
+    {
+        sol->nodes[i].x = meshnode[i].x/cf;
+        sol->nodes[i].y = meshnode[i].y/cf;
+        sol->nodes[i].A = 0;
+        sol->nodes[i].marker = meshnode[i].BoundaryMarker;
+    }
+    sol->Aprev = Aprev;
+
+    sol->elements.resize(NumEls);
+    for(int i=0; i<NumEls; i++)
+    {
+        for (int j=0; j<3; j++)
+            sol->elements[i].p[j] = meshele[i].p[j];
+        sol->elements[i].lbl = meshele[i].lbl;
+        sol->elements[i].Jprev = meshele[i].Jprev;
+    }
+
+    sol->pbcs.assign(pbclist.begin(), pbclist.begin()+NumPBCs);
+    sol->ages.assign(agelist.begin(), agelist.begin()+NumAirGapElems);
+    return sol;
+}
+
+bool FSolver::WriteBinarySolution(const femm::CMSolution &sol) const
+{
+    using namespace femm;
+    CSolutionFileWriter writer;
+
+    std::vector<SolutionNode> nodes(sol.nodes.size());
+    std::vector<double> potentials;
+    std::vector<SolutionComplex> complexPotentials;
+    if (Frequency==0)
+        potentials.resize(sol.nodes.size());
+    else
+        complexPotentials.resize(sol.nodes.size());
+    for (size_t i=0; i<sol.nodes.size(); i++)
+    {
+        nodes[i] = SolutionNode{sol.nodes[i].x, sol.nodes[i].y, sol.nodes[i].marker, 0};
+        if (Frequency==0)
+            potentials[i] = sol.nodes[i].A.re;
+        else
+            complexPotentials[i] = SolutionComplex{sol.nodes[i].A.re, sol.nodes[i].A.im};
+    }
+    writer.addSection(SolutionSection::Nodes, nodes);
+    if (Frequency==0)
+        writer.addSection(SolutionSection::Potentials, potentials);
+    else
+        writer.addSection(SolutionSection::ComplexPotentials, complexPotentials);
+
+    std::vector<SolutionElement> elements(sol.elements.size());
+    std::vector<double> Jprev;
+    for (size_t i=0; i<sol.elements.size(); i++)
+    {
+        const CMSolution::Element &elm = sol.elements[i];
+        elements[i] = SolutionElement{{elm.p[0], elm.p[1], elm.p[2]}, elm.lbl};
+    }
+    writer.addSection(SolutionSection::Elements, elements);
+    // include A and J from the previous solution if this is an incremental permeability problem
+    if (!sol.Aprev.empty())
+    {
+        writer.addSection(SolutionSection::PreviousPotentials, sol.Aprev);
+        Jprev.resize(sol.elements.size());
+        for (size_t i=0; i<sol.elements.size(); i++)
+            Jprev[i] = sol.elements[i].Jprev;
+        writer.addSection(SolutionSection::PreviousCurrentDensities, Jprev);
+    }
+
+    std::vector<SolutionCircuit> circuits(sol.circuits.size());
+    for (size_t i=0; i<sol.circuits.size(); i++)
+    {
+        const CMSolution::Circuit &circ = sol.circuits[i];
+        circuits[i] = SolutionCircuit{circ.Case, 0, {circ.value.re, circ.value.im}};
+    }
+    writer.addSection(SolutionSection::Circuits, circuits);
+
+    std::vector<SolutionPBC> pbcs(sol.pbcs.size());
+    for (size_t i=0; i<sol.pbcs.size(); i++)
+        pbcs[i] = SolutionPBC{sol.pbcs[i].x, sol.pbcs[i].y, sol.pbcs[i].t};
+    writer.addSection(SolutionSection::PeriodicBCs, pbcs);
+
+    std::vector<SolutionAirGapElement> ages(sol.ages.size());
+    std::vector<SolutionQuadPoint> quadPoints;
+    std::string names;
+    for (size_t i=0; i<sol.ages.size(); i++)
+    {
+        const CAirGapElement &age = sol.ages[i];
+        ages[i] = SolutionAirGapElement{age.BdryFormat, age.totalArcElements,
+                (int)quadPoints.size(), (int)names.size(), (int)age.BdryName.size(), 0,
+                age.InnerAngle, age.OuterAngle, age.ri, age.ro, age.totalArcLength,
+                {age.agc.re, age.agc.im}, age.InnerShift, age.OuterShift};
+        names += age.BdryName;
+        for (const CQuadPoint &qp : age.quadNode)
+            quadPoints.push_back(SolutionQuadPoint{{qp.n0, qp.n1, qp.n2, qp.n3}, {qp.w0, qp.w1, qp.w2, qp.w3}});
+    }
+    writer.addSection(SolutionSection::AirGapElements, ages);
+    writer.addSection(SolutionSection::AirGapQuadPoints, quadPoints);
+    writer.addSection(SolutionSection::AirGapNames, names.data(), names.size(), 1);
+
+    return writer.write(PathName+".ans", PathName+".fem");
+}
+
 // SortNodes: sorts mesh nodes based on a new numbering
 void FSolver::SortNodes (int* newnum)
 {
@@ -32,16 +32,19 @@
 #ifndef FSOLVER_H
 #define FSOLVER_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "feasolver.h"
 #include "cspars.h"
+#include "ccsrspars.h"
 #include "CBlockLabel.h"
 #include "CCircuit.h"
 #include "CElement.h"
 #include "CMaterialProp.h"
 #include "CNode.h"
 #include "CPointProp.h"
+#include "msolution.h"
 
 namespace femm {
 class LuaInstance;
@@ -71,6 +74,13 @@ public:
     std::vector <femm::CNode> meshnode;
     int NumCircPropsOrig;
 
+    /// write the solution to the \c .ans file
+    bool writeSolutionFile = true;
+    /// keep the solution in memory, see FPProc::LoadSolution()
+    bool keepSolution = false;
+    /// the solution of the last call to runSolver(), if keepSolution is set
+    std::shared_ptr<femm::CMSolution> solution;
+
 
 // Operations
 public:
@@ -102,12 +112,32 @@ public:
      * \endinternal
      */
     int WriteStatic2D(CBigLinProb &L);
+    /**
+     * @brief Store the solution in \c solution, with the same contents that WriteStatic2D() writes to disk.
+     */
+    void StoreStatic2D(CBigLinProb &L);
     int Harmonic2D(CBigComplexLinProb &L);
     int WriteHarmonic2D(CBigComplexLinProb &L);
+    /**
+     * @brief Store the solution in \c solution, with the same contents that WriteHarmonic2D() writes to disk.
+     */
+    void StoreHarmonic2D(CBigComplexLinProb &L);
+    /**
+     * @brief Write a solution stored by StoreStatic2D() or StoreHarmonic2D() to a binary \c .ans file.
+     * @return \c true on success, \c false otherwise.
+     */
+    bool WriteBinarySolution(const femm::CMSolution &sol) const;
     int StaticAxisymmetric(CBigLinProb &L);
     int HarmonicAxisymmetric(CBigComplexLinProb &L);
     void GetFillFactor(int lbl);
     double ElmArea(int i);
+    /**
+     * @brief Magnetization direction of each element in degrees.
+     * Lua defined directions are evaluated here, one element after the other,
+     * so that the element matrices can be assembled concurrently afterwards.
+     * @return \c false if a direction function can not be evaluated.
+     */
+    bool GetMagDirections(std::vector<double> &magdir);
 
     virtual bool runSolver(bool verbose=false) override;
 
@@ -141,6 +171,11 @@ private:
     // override parent class virtual method
     void SortNodes (int* newnum) override;
 
+    /**
+     * @brief Create a solution object with the mesh data filled in, but without the solution values.
+     */
+    std::shared_ptr<femm::CMSolution> newSolution() const;
+
     bool handleToken(const std::string &token, std::istream &input, std::ostream &err) override;
 
     femm::LuaInstance *theLua;
@@ -20,10 +20,13 @@
 */
 
 #include "CElement.h"
+#include "coloring.h"
+#include "triangleshapes.h"
 #include "femmcomplex.h"
 #include "femmconstants.h"
 #include "fsolver.h"
 #include "spars.h"
+#include "textwriter.h"
 
 #include <algorithm>
 #include <malloc.h>
@@ -37,13 +40,10 @@ double Power(double x, int y);
 
 int FSolver::Harmonic2D(CBigComplexLinProb &L)
 {
-    int i,j,k,ww,s;
-    CComplex Mx[3][3],My[3][3],Mxy[3][3];
-    CComplex Me[3][3],be[3];		// element matrices;
-    double l[3],p[3],q[3];		// element shape parameters;
-    int n[3];					// numbers of nodes for a particular element;
-    double a,r,t,x,y,B,res,lastres,ds,Cduct;
-    CComplex K,mu,dv,B1,B2,v[3],halflag,Jv; //u[3],
+    int i,j,k,s;
+    double p[3],q[3];			// element shape parameters;
+    double a,r,t,x,y,res,lastres,ds,Cduct;
+    CComplex K,halflag; //u[3],
     CComplex **Mu,*V_old;
     double c=PI*4.e-05;
     double units[]= {2.54,0.1,1.,100.,0.00254,1.e-04};
@@ -56,16 +56,6 @@ int FSolver::Harmonic2D(CBigComplexLinProb &L)
 
     res=0;
 
-// #ifndef NEWTON
-    CComplex murel,muinc;
-// #else;
-    CComplex Mnh[3][3];
-    CComplex Mna[3][3];
-    CComplex Mns[3][3];
-// #endif
-
-    CComplex Mn[3][3];
-
     const CComplex deg45=1+I;
     const double w=Frequency*2.*PI;
 
@@ -92,6 +82,11 @@ int FSolver::Harmonic2D(CBigComplexLinProb &L)
 
     V_old=(CComplex *) calloc(NumNodes+NumCircProps,sizeof(CComplex));
 
+    // shape parameters and geometric element matrices of all elements
+    CTriangleShapes shapes;
+    shapes.Create(meshnode.data(),NumNodes,meshele);
+    shapes.ComputePlanarMatrices();
+
     // check to see if any circuits have been defined and process them;
     if (NumCircProps>0)
     {
@@ -106,14 +101,7 @@ int FSolver::Harmonic2D(CBigComplexLinProb &L)
                     El=&meshele[i];
 
                     // get element area;
-                    for(k=0; k<3; k++) n[k]=El->p[k];
-                    p[0]=meshnode[n[1]].y - meshnode[n[2]].y;
-                    p[1]=meshnode[n[2]].y - meshnode[n[0]].y;
-                    p[2]=meshnode[n[0]].y - meshnode[n[1]].y;
-                    q[0]=meshnode[n[2]].x - meshnode[n[1]].x;
-                    q[1]=meshnode[n[0]].x - meshnode[n[2]].x;
-                    q[2]=meshnode[n[1]].x - meshnode[n[0]].x;
-                    a=(p[0]*q[1]-p[1]*q[0])/2.;
+                    shapes.Get(i,p,q,a);
                     //	r=(meshnode[n[0]].x+meshnode[n[1]].x+meshnode[n[2]].x)/3.;
 
                     // if coils are wound, they act like they have
@@ -214,382 +202,449 @@ int FSolver::Harmonic2D(CBigComplexLinProb &L)
 
     }
 
-    do
-    {
+    // build element matrices using the matrices derived in Allaire's book.
+    // Only the elements with a nonlinear material change from one iteration to the next,
+    // so everything else is assembled once and restored at the start of each iteration
+    // (see CBigComplexLinProb::SaveAssembly()).
+    std::vector<int> nonlinearElements;
 
 //		TheView->SetDlgItemText(IDC_FRAME1,"Matrix Construction");
 //		TheView->m_prog1.SetPos(0);
-        printf("Matrix Construction\n");
+    printf("Matrix Construction\n");
 
-        if(Iter>0) L.Wipe();
+    // first, tack in air gap element contributions
+    for(i=0;i<NumAirGapElems;i++)
+    {
+        double K,Ki;
+        double MG[10][10];
+        double ci,co;
+        int nn[10];
+        double ww[10];
 
-        // first, tack in air gap element contributions
-        for(i=0;i<NumAirGapElems;i++)
+        // K = dr/(R*dtta)
+        K=2.*(agelist[i].ro-agelist[i].ri)/
+           ((PI/180.)*(agelist[i].totalArcLength/agelist[i].totalArcElements)*
+           (agelist[i].ro+agelist[i].ri));
+        Ki=1./K;
+        ci=agelist[i].InnerShift;
+        co=agelist[i].OuterShift;
+
+        if (ci>co)
         {
-            double K,Ki;
-            double MG[10][10];
-            double ci,co;
-            int nn[10];
-            double ww[10];
+            ci=ci-co;
+            co=0;
+        }
+        else{
+            ci=1-co+ci;
+            co=1;
+        }
 
-            // K = dr/(R*dtta)
-            K=2.*(agelist[i].ro-agelist[i].ri)/
-               ((PI/180.)*(agelist[i].totalArcLength/agelist[i].totalArcElements)*
-               (agelist[i].ro+agelist[i].ri));
-            Ki=1./K;
-            ci=agelist[i].InnerShift;
-            co=agelist[i].OuterShift;
+        // build the element matrix for each quad element in the annulus (same for each element)
+        // matrix for quad element derived from serendipity element
+        MG[0][0] = (5*Power (-1 + ci,2)*Power (ci,4)*(K + Ki))/48.;
+        MG[0][1] = -((-1 + ci)*Power (ci,3)*(5*(-1 + ci*(-5 + 4*ci))*K + (-5 + ci*(-19 + 14*ci))*Ki))/48.;
+        MG[0][2] = ((-1 + ci)*Power (ci,2)*(5*(2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (10 + ci*(1 + 3*ci*(-7 + 4*ci)))*Ki))/48.;
+        MG[0][3] = -(Power (-1 + ci,2)*Power (ci,2)*(5*(-2 + ci*(-3 + 4*ci))*K + (2 + ci*(-3 + 2*ci))*Ki))/48.;
+        MG[0][4] = (Power (-1 + ci,3)*Power (ci,3)*(5*K - Ki))/48.;
+        MG[0][5] = ((-1 + ci)*Power (ci,2)*(-1 + co)*Power (co,2)*(K - 5*Ki))/48.;
+        MG[0][6] = -((-1 + ci)*Power (ci,2)*co*((-1 + co*(-5 + 4*co))*K + (5 + (19 - 14*co)*co)*Ki))/48.;
+        MG[0][7] = ((-1 + ci)*Power (ci,2)*((2 + co*(-1 - 9*co + 6*Power (co,2)))*K - (10 + co*(1 + 3*co*(-7 + 4*co)))*Ki))/48.;
+        MG[0][8] = -((-1 + ci)*Power (ci,2)*(-1 + co)*((-2 + co*(-3 + 4*co))*K + (-2 + (3 - 2*co)*co)*Ki))/48.;
+        MG[0][9] = ((-1 + ci)*Power (ci,2)*Power (-1 + co,2)*co*(K + Ki))/48.;
+        MG[1][1] = (Power (ci,2)*(5*Power (1 + (5 - 4*ci)*ci,2)*K + (5 + ci*(38 + ci*(49 + 4*ci*(-29 + 11*ci))))*Ki))/48.;
+        MG[1][2] = (-5*ci*(-1 + 2*ci)*(-2 + 3*(-1 + ci)*ci)*(-1 + ci*(-5 + 4*ci))*K + ci*(10 + ci*(39 - ci*(50 + ci*(85 + 6*ci*(-23 + 8*ci)))))*Ki)/48.;
+        MG[1][3] = ((-1 + ci)*ci*(5*(2 + ci*(13 + ci*(3 + 16*(-2 + ci)*ci)))*K + (-2 + 5*ci*(1 + ci*(3 + 4*(-2 + ci)*ci)))*Ki))/48.;
+        MG[1][4] = -(Power (-1 + ci,2)*Power (ci,2)*(5*(-1 + ci*(-5 + 4*ci))*K + Ki + ci*(-1 + 2*ci)*Ki))/48.;
+        MG[1][5] = -(ci*(-1 + co)*Power (co,2)*((-1 + ci*(-5 + 4*ci))*K + (5 + (19 - 14*ci)*ci)*Ki))/48.;
+        MG[1][6] = (ci*co*((-1 + ci*(-5 + 4*ci))*(-1 + co*(-5 + 4*co))*K + (-5 + ci*(-19 + 14*ci) - 19*co + ci*(-77 + 58*ci)*co + 2*(7 + (29 - 22*ci)*ci)*Power (co,2))*Ki))/48.;
+        MG[1][7] = (-(ci*(-1 + ci*(-5 + 4*ci))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K) + ci*(-10 + co*(-1 + 3*(7 - 4*co)*co) + ci*(-38 + co + 99*Power (co,2) - 60*Power (co,3)) + Power (ci,2)*(28 + 2*co*(-1 + 3*co*(-13 + 8*co))))*Ki)/48.;
+        MG[1][8] = (ci*(-1 + co)*((-1 + ci*(-5 + 4*ci))*(-2 + co*(-3 + 4*co))*K + (2 + co*(-3 + 2*co) + Power (ci,2)*(4 + 2*(9 - 10*co)*co) + ci*(-2 + co*(-21 + 22*co)))*Ki))/48.;
+        MG[1][9] = -(ci*Power (-1 + co,2)*co*((-1 + ci*(-5 + 4*ci))*K + (-1 + ci - 2*Power (ci,2))*Ki))/48.;
+        MG[2][2] = (5*Power (-2 + ci + 9*Power (ci,2) - 6*Power (ci,3),2)*K + (20 + (-1 + ci)*ci*(-4 + 3*(-1 + ci)*ci*(-25 + 24*(-1 + ci)*ci)))*Ki)/48.;
+        MG[2][3] = (-5*(4 + Power (ci,2)*(-33 + ci*(18 + ci*(65 + 6*ci*(-13 + 4*ci)))))*K + (4 + Power (ci,2)*(39 - ci*(30 + ci*(115 + 6*ci*(-25 + 8*ci)))))*Ki)/48.;
+        MG[2][4] = (Power (-1 + ci,2)*ci*(5*(2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (-2 + ci*(-5 + 3*ci*(-5 + 4*ci)))*Ki))/48.;
+        MG[2][5] = ((-1 + co)*Power (co,2)*((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K - (10 + ci*(1 + 3*ci*(-7 + 4*ci)))*Ki))/48.;
+        MG[2][6] = (-((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*co*(-1 + co*(-5 + 4*co))*K) + co*(-10 - 38*co + 28*Power (co,2) + Power (ci,2)*(21 + 99*co - 78*Power (co,2)) + ci*(-1 + co - 2*Power (co,2)) + 12*Power (ci,3)*(-1 + co*(-5 + 4*co)))*Ki)/48.;
+        MG[2][7] = ((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K - (2*(10 + co) + 6*Power (co,2)*(-7 + 4*co) + 3*Power (ci,2)*(-14 + co*(5 + (55 - 36*co)*co)) + ci*(2 + co*(5 + 3*(5 - 4*co)*co)) + 12*Power (ci,3)*(2 + co*(-1 - 9*co + 6*Power (co,2))))*Ki)/48.;
+        MG[2][8] = (-((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*(2 + co - 7*Power (co,2) + 4*Power (co,3))*K) + (-1 + co)*(4 + 2*ci*(5 + 3*(5 - 4*ci)*ci) + 3*(-2 + ci*(3 + (17 - 12*ci)*ci))*co + 2*(2 + ci*(-7 + 3*ci*(-11 + 8*ci)))*Power (co,2))*Ki)/48.;
+        MG[2][9] = (Power (-1 + co,2)*co*((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (2 + ci*(5 + 3*(5 - 4*ci)*ci))*Ki))/48.;
+        MG[3][3] = (Power (-1 + ci,2)*(5*Power (2 + (3 - 4*ci)*ci,2)*K + (20 + ci*(36 + ci*(-35 - 60*ci + 44*Power (ci,2))))*Ki))/48.;
+        MG[3][4] = -(Power (-1 + ci,3)*ci*(5*(-2 + ci*(-3 + 4*ci))*K + (-10 + ci*(-9 + 14*ci))*Ki))/48.;
+        MG[3][5] = -((-1 + ci)*(-1 + co)*Power (co,2)*((-2 + ci*(-3 + 4*ci))*K + (-2 + (3 - 2*ci)*ci)*Ki))/48.;
+        MG[3][6] = ((-1 + ci)*co*((-2 + ci*(-3 + 4*ci))*(-1 + co*(-5 + 4*co))*K + (2 + ci*(-3 + 2*ci) - 2*co + ci*(-21 + 22*ci)*co + 2*(2 + (9 - 10*ci)*ci)*Power (co,2))*Ki))/48.;
+        MG[3][7] = (-((2 + ci - 7*Power (ci,2) + 4*Power (ci,3))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K) + (-1 + ci)*(4 + 2*co*(5 + 3*(5 - 4*co)*co) + ci*(-6 + 3*co*(3 + (17 - 12*co)*co)) + 2*Power (ci,2)*(2 + co*(-7 + 3*co*(-11 + 8*co))))*Ki)/48.;
+        MG[3][8] = ((-1 + ci)*(-1 + co)*((-2 + ci*(-3 + 4*ci))*(-2 + co*(-3 + 4*co))*K + (-20 + 3*ci*(1 + 2*co)*(-6 + 5*co) + 2*co*(-9 + 14*co) + Power (ci,2)*(28 + 30*co - 44*Power (co,2)))*Ki))/48.;
+        MG[3][9] = -((-1 + ci)*Power (-1 + co,2)*co*((-2 + ci*(-3 + 4*ci))*K + (10 + (9 - 14*ci)*ci)*Ki))/48.;
+        MG[4][4] = (5*Power (-1 + ci,4)*Power (ci,2)*(K + Ki))/48.;
+        MG[4][5] = (Power (-1 + ci,2)*ci*(-1 + co)*Power (co,2)*(K + Ki))/48.;
+        MG[4][6] = -(Power (-1 + ci,2)*ci*co*((-1 + co*(-5 + 4*co))*K + (-1 + co - 2*Power (co,2))*Ki))/48.;
+        MG[4][7] = (Power (-1 + ci,2)*ci*((2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (2 + co*(5 + 3*(5 - 4*co)*co))*Ki))/48.;
+        MG[4][8] = -(Power (-1 + ci,2)*ci*(-1 + co)*((-2 + co*(-3 + 4*co))*K + (10 + (9 - 14*co)*co)*Ki))/48.;
+        MG[4][9] = (Power (-1 + ci,2)*ci*Power (-1 + co,2)*co*(K - 5*Ki))/48.;
+        MG[5][5] = (5*Power (-1 + co,2)*Power (co,4)*(K + Ki))/48.;
+        MG[5][6] = -((-1 + co)*Power (co,3)*(5*(-1 + co*(-5 + 4*co))*K + (-5 + co*(-19 + 14*co))*Ki))/48.;
+        MG[5][7] = ((-1 + co)*Power (co,2)*(5*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (10 + co*(1 + 3*co*(-7 + 4*co)))*Ki))/48.;
+        MG[5][8] = -(Power (-1 + co,2)*Power (co,2)*(5*(-2 + co*(-3 + 4*co))*K + (2 + co*(-3 + 2*co))*Ki))/48.;
+        MG[5][9] = (Power (-1 + co,3)*Power (co,3)*(5*K - Ki))/48.;
+        MG[6][6] = (Power (co,2)*(5*Power (1 + (5 - 4*co)*co,2)*K + (5 + co*(38 + co*(49 + 4*co*(-29 + 11*co))))*Ki))/48.;
+        MG[6][7] = (-5*co*(-1 + 2*co)*(-2 + 3*(-1 + co)*co)*(-1 + co*(-5 + 4*co))*K + co*(10 + co*(39 - co*(50 + co*(85 + 6*co*(-23 + 8*co)))))*Ki)/48.;
+        MG[6][8] = ((-1 + co)*co*(5*(2 + co*(13 + co*(3 + 16*(-2 + co)*co)))*K + (-2 + 5*co*(1 + co*(3 + 4*(-2 + co)*co)))*Ki))/48.;
+        MG[6][9] = -(Power (-1 + co,2)*Power (co,2)*(5*(-1 + co*(-5 + 4*co))*K + Ki + co*(-1 + 2*co)*Ki))/48.;
+        MG[7][7] = (5*Power (-2 + co + 9*Power (co,2) - 6*Power (co,3),2)*K + (20 + (-1 + co)*co*(-4 + 3*(-1 + co)*co*(-25 + 24*(-1 + co)*co)))*Ki)/48.;
+        MG[7][8] = (-5*(4 + Power (co,2)*(-33 + co*(18 + co*(65 + 6*co*(-13 + 4*co)))))*K + (4 + Power (co,2)*(39 - co*(30 + co*(115 + 6*co*(-25 + 8*co)))))*Ki)/48.;
+        MG[7][9] = (Power (-1 + co,2)*co*(5*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (-2 + co*(-5 + 3*co*(-5 + 4*co)))*Ki))/48.;
+        MG[8][8] = (Power (-1 + co,2)*(5*Power (2 + (3 - 4*co)*co,2)*K + (20 + co*(36 + co*(-35 - 60*co + 44*Power (co,2))))*Ki))/48.;
+        MG[8][9] = -(Power (-1 + co,3)*co*(5*(-2 + co*(-3 + 4*co))*K + (-10 + co*(-9 + 14*co))*Ki))/48.;
+        MG[9][9] = (5*Power (-1 + co,4)*Power (co,2)*(K + Ki))/48.;
 
-            if (ci>co)
-            {
-                ci=ci-co;
-                co=0;
+        // Add each annulus element to the global stiffness matrix
+        for(k=0;k<agelist[i].totalArcElements;k++)
+        {
+            // inner nodes
+            if ((k-1)<0){
+                nn[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].n0;
+                ww[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].w0;
             }
             else{
-                ci=1-co+ci;
-                co=1;
+                nn[0]=agelist[i].quadNode[k-1].n0;
+                ww[0]=agelist[i].quadNode[k-1].w0;
             }
 
-            // build the element matrix for each quad element in the annulus (same for each element)
-            // matrix for quad element derived from serendipity element
-            MG[0][0] = (5*Power (-1 + ci,2)*Power (ci,4)*(K + Ki))/48.;
-            MG[0][1] = -((-1 + ci)*Power (ci,3)*(5*(-1 + ci*(-5 + 4*ci))*K + (-5 + ci*(-19 + 14*ci))*Ki))/48.;
-            MG[0][2] = ((-1 + ci)*Power (ci,2)*(5*(2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (10 + ci*(1 + 3*ci*(-7 + 4*ci)))*Ki))/48.;
-            MG[0][3] = -(Power (-1 + ci,2)*Power (ci,2)*(5*(-2 + ci*(-3 + 4*ci))*K + (2 + ci*(-3 + 2*ci))*Ki))/48.;
-            MG[0][4] = (Power (-1 + ci,3)*Power (ci,3)*(5*K - Ki))/48.;
-            MG[0][5] = ((-1 + ci)*Power (ci,2)*(-1 + co)*Power (co,2)*(K - 5*Ki))/48.;
-            MG[0][6] = -((-1 + ci)*Power (ci,2)*co*((-1 + co*(-5 + 4*co))*K + (5 + (19 - 14*co)*co)*Ki))/48.;
-            MG[0][7] = ((-1 + ci)*Power (ci,2)*((2 + co*(-1 - 9*co + 6*Power (co,2)))*K - (10 + co*(1 + 3*co*(-7 + 4*co)))*Ki))/48.;
-            MG[0][8] = -((-1 + ci)*Power (ci,2)*(-1 + co)*((-2 + co*(-3 + 4*co))*K + (-2 + (3 - 2*co)*co)*Ki))/48.;
-            MG[0][9] = ((-1 + ci)*Power (ci,2)*Power (-1 + co,2)*co*(K + Ki))/48.;
-            MG[1][1] = (Power (ci,2)*(5*Power (1 + (5 - 4*ci)*ci,2)*K + (5 + ci*(38 + ci*(49 + 4*ci*(-29 + 11*ci))))*Ki))/48.;
-            MG[1][2] = (-5*ci*(-1 + 2*ci)*(-2 + 3*(-1 + ci)*ci)*(-1 + ci*(-5 + 4*ci))*K + ci*(10 + ci*(39 - ci*(50 + ci*(85 + 6*ci*(-23 + 8*ci)))))*Ki)/48.;
-            MG[1][3] = ((-1 + ci)*ci*(5*(2 + ci*(13 + ci*(3 + 16*(-2 + ci)*ci)))*K + (-2 + 5*ci*(1 + ci*(3 + 4*(-2 + ci)*ci)))*Ki))/48.;
-            MG[1][4] = -(Power (-1 + ci,2)*Power (ci,2)*(5*(-1 + ci*(-5 + 4*ci))*K + Ki + ci*(-1 + 2*ci)*Ki))/48.;
-            MG[1][5] = -(ci*(-1 + co)*Power (co,2)*((-1 + ci*(-5 + 4*ci))*K + (5 + (19 - 14*ci)*ci)*Ki))/48.;
-            MG[1][6] = (ci*co*((-1 + ci*(-5 + 4*ci))*(-1 + co*(-5 + 4*co))*K + (-5 + ci*(-19 + 14*ci) - 19*co + ci*(-77 + 58*ci)*co + 2*(7 + (29 - 22*ci)*ci)*Power (co,2))*Ki))/48.;
-            MG[1][7] = (-(ci*(-1 + ci*(-5 + 4*ci))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K) + ci*(-10 + co*(-1 + 3*(7 - 4*co)*co) + ci*(-38 + co + 99*Power (co,2) - 60*Power (co,3)) + Power (ci,2)*(28 + 2*co*(-1 + 3*co*(-13 + 8*co))))*Ki)/48.;
-            MG[1][8] = (ci*(-1 + co)*((-1 + ci*(-5 + 4*ci))*(-2 + co*(-3 + 4*co))*K + (2 + co*(-3 + 2*co) + Power (ci,2)*(4 + 2*(9 - 10*co)*co) + ci*(-2 + co*(-21 + 22*co)))*Ki))/48.;
-            MG[1][9] = -(ci*Power (-1 + co,2)*co*((-1 + ci*(-5 + 4*ci))*K + (-1 + ci - 2*Power (ci,2))*Ki))/48.;
-            MG[2][2] = (5*Power (-2 + ci + 9*Power (ci,2) - 6*Power (ci,3),2)*K + (20 + (-1 + ci)*ci*(-4 + 3*(-1 + ci)*ci*(-25 + 24*(-1 + ci)*ci)))*Ki)/48.;
-            MG[2][3] = (-5*(4 + Power (ci,2)*(-33 + ci*(18 + ci*(65 + 6*ci*(-13 + 4*ci)))))*K + (4 + Power (ci,2)*(39 - ci*(30 + ci*(115 + 6*ci*(-25 + 8*ci)))))*Ki)/48.;
-            MG[2][4] = (Power (-1 + ci,2)*ci*(5*(2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (-2 + ci*(-5 + 3*ci*(-5 + 4*ci)))*Ki))/48.;
-            MG[2][5] = ((-1 + co)*Power (co,2)*((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K - (10 + ci*(1 + 3*ci*(-7 + 4*ci)))*Ki))/48.;
-            MG[2][6] = (-((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*co*(-1 + co*(-5 + 4*co))*K) + co*(-10 - 38*co + 28*Power (co,2) + Power (ci,2)*(21 + 99*co - 78*Power (co,2)) + ci*(-1 + co - 2*Power (co,2)) + 12*Power (ci,3)*(-1 + co*(-5 + 4*co)))*Ki)/48.;
-            MG[2][7] = ((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K - (2*(10 + co) + 6*Power (co,2)*(-7 + 4*co) + 3*Power (ci,2)*(-14 + co*(5 + (55 - 36*co)*co)) + ci*(2 + co*(5 + 3*(5 - 4*co)*co)) + 12*Power (ci,3)*(2 + co*(-1 - 9*co + 6*Power (co,2))))*Ki)/48.;
-            MG[2][8] = (-((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*(2 + co - 7*Power (co,2) + 4*Power (co,3))*K) + (-1 + co)*(4 + 2*ci*(5 + 3*(5 - 4*ci)*ci) + 3*(-2 + ci*(3 + (17 - 12*ci)*ci))*co + 2*(2 + ci*(-7 + 3*ci*(-11 + 8*ci)))*Power (co,2))*Ki)/48.;
-            MG[2][9] = (Power (-1 + co,2)*co*((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (2 + ci*(5 + 3*(5 - 4*ci)*ci))*Ki))/48.;
-            MG[3][3] = (Power (-1 + ci,2)*(5*Power (2 + (3 - 4*ci)*ci,2)*K + (20 + ci*(36 + ci*(-35 - 60*ci + 44*Power (ci,2))))*Ki))/48.;
-            MG[3][4] = -(Power (-1 + ci,3)*ci*(5*(-2 + ci*(-3 + 4*ci))*K + (-10 + ci*(-9 + 14*ci))*Ki))/48.;
-            MG[3][5] = -((-1 + ci)*(-1 + co)*Power (co,2)*((-2 + ci*(-3 + 4*ci))*K + (-2 + (3 - 2*ci)*ci)*Ki))/48.;
-            MG[3][6] = ((-1 + ci)*co*((-2 + ci*(-3 + 4*ci))*(-1 + co*(-5 + 4*co))*K + (2 + ci*(-3 + 2*ci) - 2*co + ci*(-21 + 22*ci)*co + 2*(2 + (9 - 10*ci)*ci)*Power (co,2))*Ki))/48.;
-            MG[3][7] = (-((2 + ci - 7*Power (ci,2) + 4*Power (ci,3))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K) + (-1 + ci)*(4 + 2*co*(5 + 3*(5 - 4*co)*co) + ci*(-6 + 3*co*(3 + (17 - 12*co)*co)) + 2*Power (ci,2)*(2 + co*(-7 + 3*co*(-11 + 8*co))))*Ki)/48.;
-            MG[3][8] = ((-1 + ci)*(-1 + co)*((-2 + ci*(-3 + 4*ci))*(-2 + co*(-3 + 4*co))*K + (-20 + 3*ci*(1 + 2*co)*(-6 + 5*co) + 2*co*(-9 + 14*co) + Power (ci,2)*(28 + 30*co - 44*Power (co,2)))*Ki))/48.;
-            MG[3][9] = -((-1 + ci)*Power (-1 + co,2)*co*((-2 + ci*(-3 + 4*ci))*K + (10 + (9 - 14*ci)*ci)*Ki))/48.;
-            MG[4][4] = (5*Power (-1 + ci,4)*Power (ci,2)*(K + Ki))/48.;
-            MG[4][5] = (Power (-1 + ci,2)*ci*(-1 + co)*Power (co,2)*(K + Ki))/48.;
-            MG[4][6] = -(Power (-1 + ci,2)*ci*co*((-1 + co*(-5 + 4*co))*K + (-1 + co - 2*Power (co,2))*Ki))/48.;
-            MG[4][7] = (Power (-1 + ci,2)*ci*((2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (2 + co*(5 + 3*(5 - 4*co)*co))*Ki))/48.;
-            MG[4][8] = -(Power (-1 + ci,2)*ci*(-1 + co)*((-2 + co*(-3 + 4*co))*K + (10 + (9 - 14*co)*co)*Ki))/48.;
-            MG[4][9] = (Power (-1 + ci,2)*ci*Power (-1 + co,2)*co*(K - 5*Ki))/48.;
-            MG[5][5] = (5*Power (-1 + co,2)*Power (co,4)*(K + Ki))/48.;
-            MG[5][6] = -((-1 + co)*Power (co,3)*(5*(-1 + co*(-5 + 4*co))*K + (-5 + co*(-19 + 14*co))*Ki))/48.;
-            MG[5][7] = ((-1 + co)*Power (co,2)*(5*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (10 + co*(1 + 3*co*(-7 + 4*co)))*Ki))/48.;
-            MG[5][8] = -(Power (-1 + co,2)*Power (co,2)*(5*(-2 + co*(-3 + 4*co))*K + (2 + co*(-3 + 2*co))*Ki))/48.;
-            MG[5][9] = (Power (-1 + co,3)*Power (co,3)*(5*K - Ki))/48.;
-            MG[6][6] = (Power (co,2)*(5*Power (1 + (5 - 4*co)*co,2)*K + (5 + co*(38 + co*(49 + 4*co*(-29 + 11*co))))*Ki))/48.;
-            MG[6][7] = (-5*co*(-1 + 2*co)*(-2 + 3*(-1 + co)*co)*(-1 + co*(-5 + 4*co))*K + co*(10 + co*(39 - co*(50 + co*(85 + 6*co*(-23 + 8*co)))))*Ki)/48.;
-            MG[6][8] = ((-1 + co)*co*(5*(2 + co*(13 + co*(3 + 16*(-2 + co)*co)))*K + (-2 + 5*co*(1 + co*(3 + 4*(-2 + co)*co)))*Ki))/48.;
-            MG[6][9] = -(Power (-1 + co,2)*Power (co,2)*(5*(-1 + co*(-5 + 4*co))*K + Ki + co*(-1 + 2*co)*Ki))/48.;
-            MG[7][7] = (5*Power (-2 + co + 9*Power (co,2) - 6*Power (co,3),2)*K + (20 + (-1 + co)*co*(-4 + 3*(-1 + co)*co*(-25 + 24*(-1 + co)*co)))*Ki)/48.;
-            MG[7][8] = (-5*(4 + Power (co,2)*(-33 + co*(18 + co*(65 + 6*co*(-13 + 4*co)))))*K + (4 + Power (co,2)*(39 - co*(30 + co*(115 + 6*co*(-25 + 8*co)))))*Ki)/48.;
-            MG[7][9] = (Power (-1 + co,2)*co*(5*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (-2 + co*(-5 + 3*co*(-5 + 4*co)))*Ki))/48.;
-            MG[8][8] = (Power (-1 + co,2)*(5*Power (2 + (3 - 4*co)*co,2)*K + (20 + co*(36 + co*(-35 - 60*co + 44*Power (co,2))))*Ki))/48.;
-            MG[8][9] = -(Power (-1 + co,3)*co*(5*(-2 + co*(-3 + 4*co))*K + (-10 + co*(-9 + 14*co))*Ki))/48.;
-            MG[9][9] = (5*Power (-1 + co,4)*Power (co,2)*(K + Ki))/48.;
-
-            // Add each annulus element to the global stiffness matrix
-            for(k=0;k<agelist[i].totalArcElements;k++)
-            {
-                // inner nodes
-                if ((k-1)<0){
-                    nn[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].n0;
-                    ww[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].w0;
-                }
-                else{
-                    nn[0]=agelist[i].quadNode[k-1].n0;
-                    ww[0]=agelist[i].quadNode[k-1].w0;
-                }
+            nn[1]=agelist[i].quadNode[k].n0;
+            nn[2]=agelist[i].quadNode[k].n1;
+            nn[3]=agelist[i].quadNode[k+1].n1;
+            ww[1]=agelist[i].quadNode[k].w0;
+            ww[2]=agelist[i].quadNode[k].w1;
+            ww[3]=agelist[i].quadNode[k+1].w1;
 
-                nn[1]=agelist[i].quadNode[k].n0;
-                nn[2]=agelist[i].quadNode[k].n1;
-                nn[3]=agelist[i].quadNode[k+1].n1;
-                ww[1]=agelist[i].quadNode[k].w0;
-                ww[2]=agelist[i].quadNode[k].w1;
-                ww[3]=agelist[i].quadNode[k+1].w1;
-
-                if((k+2)>agelist[i].totalArcElements){
-                    nn[4]=agelist[i].quadNode[1].n1;
-                    ww[4]=agelist[i].quadNode[1].w1;
-                }
-                else{
-                    nn[4]=agelist[i].quadNode[k+2].n1;
-                    ww[4]=agelist[i].quadNode[k+2].w1;
-                }
-
-                // outer nodes
-                if ((k-1)<0){
-                    nn[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].n2;
-                    ww[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].w2;
-                }
-                else{
-                    nn[5]=agelist[i].quadNode[k-1].n2;
-                    ww[5]=agelist[i].quadNode[k-1].w2;
-                }
-
-                nn[6]=agelist[i].quadNode[k].n2;
-                nn[7]=agelist[i].quadNode[k].n3;
-                nn[8]=agelist[i].quadNode[k+1].n3;
-                ww[6]=agelist[i].quadNode[k].w2;
-                ww[7]=agelist[i].quadNode[k].w3;
-                ww[8]=agelist[i].quadNode[k+1].w3;
-
-                if((k+2)>agelist[i].totalArcElements){
-                    nn[9]=agelist[i].quadNode[1].n3;
-                    ww[9]=agelist[i].quadNode[1].w3;
-                }
-                else{
-                    nn[9]=agelist[i].quadNode[k+2].n3;
-                    ww[9]=agelist[i].quadNode[k+2].w3;
-                }
-
-                // fix antiperiodic weights...
-                if ((k==0) && (agelist[i].BdryFormat==1))
-                {
-                    ww[0]=-ww[0];
-                    ww[5]=-ww[5];
-                }
-                if ((k==agelist[i].totalArcElements) && (agelist[i].BdryFormat==1))
-                {
-                    ww[4]=-ww[4];
-                    ww[9]=-ww[9];
-                }
-
-                // scale by weight to get periodic/antiperiodic right
-                for(int ii=0;ii<10;ii++)
-                    for(int jj=ii;jj<10;jj++)
-                        L.AddTo(-MG[ii][jj]*ww[ii]*ww[jj],nn[ii],nn[jj]); //needs different sign than prob1big version
-            }
-        }
+            if((k+2)>agelist[i].totalArcElements){
+                nn[4]=agelist[i].quadNode[1].n1;
+                ww[4]=agelist[i].quadNode[1].w1;
+            }
+            else{
+                nn[4]=agelist[i].quadNode[k+2].n1;
+                ww[4]=agelist[i].quadNode[k+2].w1;
+            }
 
-        // build element matrices using the matrices derived in Allaire's book.
-        for(i=0; i<NumEls; i++)
-        {
-            // zero out Me, be;
-            for(j=0; j<3; j++)
-            {
-                for(k=0; k<3; k++)
-                {
-                    Me[j][k]=0;
-                    Mx[j][k]=0;
-                    My[j][k]=0;
-                    Mxy[j][k]=0;
-//#ifdef NEWTON
-                    if (ACSolver==1)
-                    {
-                        Mnh[j][k]=0;
-                        Mna[j][k]=0;
-                        Mns[j][k]=0;
-                    }
-//#endif
-                    Mn[j][k]=0;
-                }
-                be[j]=0;
+            // outer nodes
+            if ((k-1)<0){
+                nn[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].n2;
+                ww[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].w2;
+            }
+            else{
+                nn[5]=agelist[i].quadNode[k-1].n2;
+                ww[5]=agelist[i].quadNode[k-1].w2;
             }
 
-            // Determine shape parameters.
-            // l == element side lengths;
-            // p corresponds to the `b' parameter in Allaire
-            // q corresponds to the `c' parameter in Allaire
-            El=&meshele[i];
+            nn[6]=agelist[i].quadNode[k].n2;
+            nn[7]=agelist[i].quadNode[k].n3;
+            nn[8]=agelist[i].quadNode[k+1].n3;
+            ww[6]=agelist[i].quadNode[k].w2;
+            ww[7]=agelist[i].quadNode[k].w3;
+            ww[8]=agelist[i].quadNode[k+1].w3;
 
-            for(k=0; k<3; k++) n[k]=El->p[k];
-            p[0]=meshnode[n[1]].y - meshnode[n[2]].y;
-            p[1]=meshnode[n[2]].y - meshnode[n[0]].y;
-            p[2]=meshnode[n[0]].y - meshnode[n[1]].y;
-            q[0]=meshnode[n[2]].x - meshnode[n[1]].x;
-            q[1]=meshnode[n[0]].x - meshnode[n[2]].x;
-            q[2]=meshnode[n[1]].x - meshnode[n[0]].x;
-            for(j=0,k=1; j<3; k++,j++)
+            if((k+2)>agelist[i].totalArcElements){
+                nn[9]=agelist[i].quadNode[1].n3;
+                ww[9]=agelist[i].quadNode[1].w3;
+            }
+            else{
+                nn[9]=agelist[i].quadNode[k+2].n3;
+                ww[9]=agelist[i].quadNode[k+2].w3;
+            }
+
+            // fix antiperiodic weights...
+            if ((k==0) && (agelist[i].BdryFormat==1))
+            {
+                ww[0]=-ww[0];
+                ww[5]=-ww[5];
+            }
+            if ((k==agelist[i].totalArcElements) && (agelist[i].BdryFormat==1))
             {
-                if (k==3) k=0;
-                l[j]=sqrt( pow(meshnode[n[k]].x-meshnode[n[j]].x,2.) +
-                           pow(meshnode[n[k]].y-meshnode[n[j]].y,2.) );
+                ww[4]=-ww[4];
+                ww[9]=-ww[9];
             }
-            a=(p[0]*q[1]-p[1]*q[0])/2.;
 
-            // x-contribution;
-            K = (-1./(4.*a));
-            for(j=0; j<3; j++)
-                for(k=j; k<3; k++)
-                {
-                    Mx[j][k] += K*p[j]*p[k];
-                    if (j!=k) Mx[k][j]+=K*p[j]*p[k];
-                }
+            // scale by weight to get periodic/antiperiodic right
+            for(int ii=0;ii<10;ii++)
+                for(int jj=ii;jj<10;jj++)
+                    L.AddTo(-MG[ii][jj]*ww[ii]*ww[jj],nn[ii],nn[jj]); //needs different sign than prob1big version
+        }
+    }
 
-            // y-contribution;
-            K = (-1./(4.*a));
-            for(j=0; j<3; j++)
-                for(k=j; k<3; k++)
-                {
-                    My[j][k] +=K*q[j]*q[k];
-                    if (j!=k) My[k][j]+=K*q[j]*q[k];
-                }
+    // the bookkeeping of the nonlinear elements is done up front,
+    // so that the elements can be assembled in parallel.
+    for(i=0; i<NumEls; i++)
+    {
+        if ((blockproplist[meshele[i].blk].BHpoints != 0) && (bIncremental == MS_LEGACY_FALSE))
+        {
+            // There's no previous solution.  This is a standard nonlinear time harmonic problem
+            LinearFlag=false;
+            nonlinearElements.push_back(i);
+        }
+    }
 
-            // xy-contribution;
-            K = (-1./(4.*a));
-            for(j=0;j<3;j++)
-                for(k=j;k<3;k++)
-                {
-                    Mxy[j][k] += K*(p[j]*q[k] + p[k]*q[j]);
-                    if (j!=k) Mxy[k][j] += K*(p[j]*q[k] + p[k]*q[j]);
-                }
+    // elements of the same color do not share nodes, so that they can add to the matrix concurrently.
+    // Elements in a Case 2 circuit also add to the row of the circuit, so they are assembled serially.
+    CElementColoring coloring;
+    coloring.Create(NumNodes);
+    for(i=0; i<NumEls; i++)
+    {
+        k=labellist[meshele[i].lbl].InCircuit;
+        coloring.Add(i, meshele[i].p, (k>=0) && (circproplist[k].Case==2));
+    }
+    coloring.Finish();
 
-            // contribution from eddy currents;
-            K=-I*a*w*blockproplist[meshele[i].blk].Cduct*c/12.;
+    coloring.ForEach([&](int i)
+    {
+        CComplex Mx[3][3],My[3][3],Mxy[3][3];
+        CComplex Me[3][3],be[3];		// element matrices;
+        double l[3],p[3],q[3];		// element shape parameters;
+        int n[3];					// numbers of nodes for a particular element;
+        double a,ds;
+        CComplex K,Jv;
+        int j,k;
+
+        // zero out Me, be;
+        for(j=0; j<3; j++)
+        {
+            for(k=0; k<3; k++)
+            {
+                Me[j][k]=0;
+            }
+            be[j]=0;
+        }
+
+        // Determine shape parameters.
+        // l == element side lengths;
+        // p corresponds to the `b' parameter in Allaire
+        // q corresponds to the `c' parameter in Allaire
+        femmsolver::CMElement *El=&meshele[i];
+
+        for(k=0; k<3; k++) n[k]=El->p[k];
+        shapes.Get(i,p,q,a);
+        shapes.GetSides(i,l);
+
+        // x-, y- and xy-contributions, from the batch;
+        shapes.GetPlanarMatrices(i, Mx, My, Mxy);
+
+        // contribution from eddy currents;
+        K=-I*a*w*blockproplist[meshele[i].blk].Cduct*c/12.;
+
+        // in-plane laminated blocks appear to have no conductivity;
+        // eddy currents are accounted for in these elements by their
+        // frequency-dependent permeability.
+        if((blockproplist[El->blk].LamType==0) &&
+                (blockproplist[El->blk].Lam_d>0)) K=0;
 
-            // in-plane laminated blocks appear to have no conductivity;
-            // eddy currents are accounted for in these elements by their
-            // frequency-dependent permeability.
-            if((blockproplist[El->blk].LamType==0) &&
-                    (blockproplist[El->blk].Lam_d>0)) K=0;
+        // if this element is part of a wound coil,
+        // it should have a zero "bulk" conductivity...
+        if(labellist[El->lbl].bIsWound) K=0;
 
-            // if this element is part of a wound coil,
-            // it should have a zero "bulk" conductivity...
-            if(labellist[El->lbl].bIsWound) K=0;
+        for(j=0; j<3; j++)
+        {
+            for(k=j; k<3; k++)
+            {
+                Me[j][k]+=K;
+                Me[k][j]+=K;
+            }
+        }
 
-            for(j=0; j<3; j++)
+        // contributions to Me, be from derivative boundary conditions;
+        for(j=0; j<3; j++)
+        {
+            if (El->e[j] >= 0)
             {
-                for(k=j; k<3; k++)
+                if (lineproplist[El->e[j]].BdryFormat==2)
                 {
+                    // conversion factor is 10^(-4) (I think...)
+                    K=(-0.0001*c*lineproplist[ El->e[j] ].c0*l[j]/6.);
+                    k=j+1;
+                    if(k==3) k=0;
+                    Me[j][j]+=2*K;
+                    Me[k][k]+=2*K;
                     Me[j][k]+=K;
                     Me[k][j]+=K;
+
+                    K=(lineproplist[ El->e[j] ].c1*l[j]/2.)*0.0001;
+                    be[j]+=K;
+                    be[k]+=K;
                 }
-            }
 
-            // contributions to Me, be from derivative boundary conditions;
-            for(j=0; j<3; j++)
-            {
-                if (El->e[j] >= 0)
+                if (lineproplist[El->e[j]].BdryFormat==1)
                 {
-                    if (lineproplist[El->e[j]].BdryFormat==2)
-                    {
-                        // conversion factor is 10^(-4) (I think...)
-                        K=(-0.0001*c*lineproplist[ El->e[j] ].c0*l[j]/6.);
-                        k=j+1;
-                        if(k==3) k=0;
-                        Me[j][j]+=2*K;
-                        Me[k][k]+=2*K;
-                        Me[j][k]+=K;
-                        Me[k][j]+=K;
-
-                        K=(lineproplist[ El->e[j] ].c1*l[j]/2.)*0.0001;
-                        be[j]+=K;
-                        be[k]+=K;
-                    }
-
-                    if (lineproplist[El->e[j]].BdryFormat==1)
-                    {
-                        ds=sqrt(2./(0.4*PI*w*lineproplist[El->e[j]].Sig*
-                                    lineproplist[El->e[j]].Mu));
-                        K=deg45/(-ds*lineproplist[El->e[j]].Mu*100.);
-                        K*=(l[j]/6.);
-                        k=j+1;
-                        if(k==3) k=0;
-                        Me[j][j]+=2*K;
-                        Me[k][k]+=2*K;
-                        Me[j][k]+=K;
-                        Me[k][j]+=K;
-                    }
+                    ds=sqrt(2./(0.4*PI*w*lineproplist[El->e[j]].Sig*
+                                lineproplist[El->e[j]].Mu));
+                    K=deg45/(-ds*lineproplist[El->e[j]].Mu*100.);
+                    K*=(l[j]/6.);
+                    k=j+1;
+                    if(k==3) k=0;
+                    Me[j][j]+=2*K;
+                    Me[k][k]+=2*K;
+                    Me[j][k]+=K;
+                    Me[k][j]+=K;
                 }
             }
+        }
 
-            // contribution to be from current density in the block
-            for(j=0; j<3; j++)
+        // contribution to be from current density in the block
+        for(j=0; j<3; j++)
+        {
+            Jv=0;
+            if(labellist[El->lbl].InCircuit>=0)
             {
-                Jv=0;
-                if(labellist[El->lbl].InCircuit>=0)
-                {
-                    k=labellist[El->lbl].InCircuit;
-                    if(circproplist[k].Case==1) Jv=circproplist[k].J;
-                    if(circproplist[k].Case==0)
-                        Jv=-circproplist[k].dV*blockproplist[El->blk].Cduct;
-                }
-                K=-(blockproplist[El->blk].J.re+I*blockproplist[El->blk].J.im+Jv)*a/3.;
-                be[j]+=K;
-
-                if(labellist[El->lbl].InCircuit>=0)
-                {
-                    k=labellist[El->lbl].InCircuit;
-                    if(circproplist[k].Case==2) L.b[NumNodes+k]+=K;
-                }
+                k=labellist[El->lbl].InCircuit;
+                if(circproplist[k].Case==1) Jv=circproplist[k].J;
+                if(circproplist[k].Case==0)
+                    Jv=-circproplist[k].dV*blockproplist[El->blk].Cduct;
             }
+            K=-(blockproplist[El->blk].J.re+I*blockproplist[El->blk].J.im+Jv)*a/3.;
+            be[j]+=K;
 
-            // do Case 2 circuit stuff for element
             if(labellist[El->lbl].InCircuit>=0)
             {
                 k=labellist[El->lbl].InCircuit;
-                if(circproplist[k].Case==2)
+                if(circproplist[k].Case==2) L.b[NumNodes+k]+=K;
+            }
+        }
+
+        // do Case 2 circuit stuff for element
+        if(labellist[El->lbl].InCircuit>=0)
+        {
+            k=labellist[El->lbl].InCircuit;
+            if(circproplist[k].Case==2)
+            {
+                K=-I*a*w*blockproplist[meshele[i].blk].Cduct*c;
+                for(j=0; j<3; j++) L.AddTo(K/3.,n[j],NumNodes+k);
+                L.AddTo(K,NumNodes+k,NumNodes+k);
+            }
+        }
+
+        // update permeability for the element;
+        k=meshele[i].blk;
+        meshele[i].mu1=Mu[k][0];
+        meshele[i].mu2=Mu[k][1];
+        meshele[i].v12=0;
+        if ((blockproplist[k].BHpoints != 0) && (bIncremental != MS_LEGACY_FALSE)) {
+            double B,B1p,B2p;
+            CComplex murel,muinc;
+
+            // Get B from previous solution
+            getPrev2DB(i,B1p,B2p);
+            B = sqrt(B1p*B1p + B2p*B2p);
+
+            // look up incremental permeability and assign it to the element;
+            blockproplist[k].incrementalPermeability(B,w,muinc,murel);
+            if (B==0)
+            {
+                meshele[i].mu1=muinc;
+                meshele[i].mu2=muinc;
+                meshele[i].v12=0;
+            }
+            else{
+                // need to actually compute B1 and B2 to build incremental permeability tensor
+                meshele[i].mu1=B*B*muinc*murel/(B1p*B1p*murel + B2p*B2p*muinc);
+                meshele[i].mu2=B*B*muinc*murel/(B1p*B1p*muinc + B2p*B2p*murel);
+                meshele[i].v12=-B1p*B2p*(murel-muinc)/(B*B*murel*muinc);
+            }
+        }
+
+        // Apply correction for elements subject to prox effects
+        if(blockproplist[meshele[i].blk].LamType>2)
+        {
+            meshele[i].mu1=labellist[meshele[i].lbl].ProximityMu;
+            meshele[i].mu2=labellist[meshele[i].lbl].ProximityMu;
+        }
+
+        // the permeability part of the elements with a nonlinear material is assembled in each iteration, see below
+        if ((blockproplist[El->blk].BHpoints == 0) || (bIncremental != MS_LEGACY_FALSE))
+        {
+            // combine block matrices into global matrices;
+            for(j=0; j<3; j++)
+                for(k=0; k<3; k++)
                 {
-                    K=-I*a*w*blockproplist[meshele[i].blk].Cduct*c;
-                    for(j=0; j<3; j++) L.Put(L.Get(n[j],NumNodes+k)+K/3.,n[j],NumNodes+k);
-                    L.Put(L.Get(NumNodes+k,NumNodes+k)+K,NumNodes+k,NumNodes+k);
+                    if (ACSolver==1)
+                        Me[j][k]+= (Mx[j][k]/(El->mu2) + My[j][k]/(El->mu1));
+                    else
+                        Me[j][k]+= (Mx[j][k]/(El->mu2) + My[j][k]/(El->mu1) + Mxy[j][k] * (El->v12));
                 }
-            }
+        }
 
+        for (j=0; j<3; j++)
+        {
+            for (k=j; k<3; k++)
+                L.AddTo(Me[j][k],n[j],n[k]);
+            L.b[n[j]]+=be[j];
+        }
+    });
 
-///////////////////////////////////////////////////////////////
-//
-//	New Nonlinear stuff
-//
-///////////////////////////////////////////////////////////////
+    CElementColoring nonlinearColoring;
+    nonlinearColoring.Create(NumNodes);
+    for(s=0; s<static_cast<int>(nonlinearElements.size()); s++)
+    {
+        nonlinearColoring.Add(s, meshele[nonlinearElements[s]].p);
+    }
+    nonlinearColoring.Finish();
 
-            // update permeability for the element;
-            if (Iter==0)
+    if (!nonlinearElements.empty())
+    {
+        L.SaveAssembly();
+    }
+
+    do
+    {
+        if(Iter>0)
+        {
+            printf("Matrix Construction\n");
+            L.RestoreAssembly();
+        }
+
+        // the Newton matrices must exist before the elements are added concurrently
+        if ((ACSolver==1) && (Iter>0) && !nonlinearElements.empty())
+        {
+            L.CreateNewtonMatrices();
+        }
+
+        // permeability part of the elements with a nonlinear material
+        nonlinearColoring.ForEach([&](int s)
+        {
+            CComplex Mx[3][3],My[3][3],Mxy[3][3];
+            CComplex Me[3][3],be[3];		// element matrices;
+            CComplex Mnh[3][3],Mna[3][3],Mns[3][3],Mn[3][3];
+            double p[3],q[3];			// element shape parameters;
+            int n[3];					// numbers of nodes for a particular element;
+            double a,B;
+            CComplex K,mu,dv,B1,B2,v[3],murel,muinc;
+            int j,k,ww;
+
+            // zero out Me, be;
+            for(j=0; j<3; j++)
             {
-                k=meshele[i].blk;
-                meshele[i].mu1=Mu[k][0];
-                meshele[i].mu2=Mu[k][1];
-                meshele[i].v12=0;
-                if (blockproplist[k].BHpoints != 0) {
-                    if (bIncremental == MS_LEGACY_FALSE) {
-                        // There's no previous solution.  This is a standard nonlinear time harmonic problem
-                        LinearFlag=false;
-                    } else {
-                        double B1p,B2p;
-
-                        // Get B from previous solution
-                        getPrev2DB(i,B1p,B2p);
-                        B = sqrt(B1p*B1p + B2p*B2p);
-
-                        // look up incremental permeability and assign it to the element;
-                        blockproplist[k].incrementalPermeability(B,w,muinc,murel);
-                        if (B==0)
-                        {
-                            meshele[i].mu1=muinc;
-                            meshele[i].mu2=muinc;
-                            meshele[i].v12=0;
-                        }
-                        else{
-                            // need to actually compute B1 and B2 to build incremental permeability tensor
-                            meshele[i].mu1=B*B*muinc*murel/(B1p*B1p*murel + B2p*B2p*muinc);
-                            meshele[i].mu2=B*B*muinc*murel/(B1p*B1p*muinc + B2p*B2p*murel);
-                            meshele[i].v12=-B1p*B2p*(murel-muinc)/(B*B*murel*muinc);
-                        }
+                for(k=0; k<3; k++)
+                {
+                    Me[j][k]=0;
+//#ifdef NEWTON
+                    if (ACSolver==1)
+                    {
+                        Mnh[j][k]=0;
+                        Mna[j][k]=0;
+                        Mns[j][k]=0;
                     }
+//#endif
+                    Mn[j][k]=0;
                 }
+                be[j]=0;
             }
-            else
+
+            // Determine shape parameters.
+            const int i=nonlinearElements[s];
+            femmsolver::CMElement *El=&meshele[i];
+            for(k=0; k<3; k++) n[k]=El->p[k];
+            shapes.Get(i,p,q,a);
+
+            // x-, y- and xy-contributions, from the batch;
+            shapes.GetPlanarMatrices(i, Mx, My, Mxy);
+
+            if (Iter>0)
             {
 
                 k=meshele[i].blk;
@@ -659,13 +714,6 @@ int FSolver::Harmonic2D(CBigComplexLinProb &L)
                 }
             }
 
-            // Apply correction for elements subject to prox effects
-            if((blockproplist[meshele[i].blk].LamType>2) && (Iter==0))
-            {
-                meshele[i].mu1=labellist[meshele[i].lbl].ProximityMu;
-                meshele[i].mu2=labellist[meshele[i].lbl].ProximityMu;
-            }
-
             // combine block matrices into global matrices;
             for(j=0; j<3; j++)
                 for(k=0; k<3; k++)
@@ -704,7 +752,7 @@ int FSolver::Harmonic2D(CBigComplexLinProb &L)
                 }
                 L.b[n[j]]+=be[j];
             }
-        }
+        });
 
         // add in contribution from point currents;
         for(i=0; i<NumNodes; i++)
@@ -822,7 +870,7 @@ int FSolver::Harmonic2D(CBigComplexLinProb &L)
             L.Precision=std::min(1.e-4,0.001*res);
             if (L.Precision<Precision) L.Precision=Precision;
         }
-        if (L.PBCGSolveMod(Iter)==false) return false;
+        if (L.Solve(Iter)==false) return false;
 
 
         if (LinearFlag==false)
@@ -918,34 +966,32 @@ int FSolver::WriteHarmonic2D(CBigComplexLinProb &L)
         return false;
     }
 
-    while(fgets(c,1024,fz)!=NULL) fputs(c,fp);
+    femm::CTextWriter out(fp);
+    out.copyFrom(fz);
     fclose(fz);
 
     // then print out node, line, and element information
-    fprintf(fp,"[Solution]\n");
+    out << "[Solution]\n";
     cf=unitconv[LengthUnits];
-    fprintf(fp,"%i\n",NumNodes);
-    for(i=0; i<NumNodes; i++)
-    {
-        fprintf(fp,"%.17g\t%.17g\t%.17g\t%.17g\t%i",meshnode[i].x/cf,
-                meshnode[i].y/cf,L.b[i].re,L.b[i].im,
-                meshnode[i].BoundaryMarker
-                );
+    out << NumNodes << '\n';
+    out.writeRecords(NumNodes, [&](femm::CTextWriter &w, int i) {
+        w << meshnode[i].x/cf << '\t'
+          << meshnode[i].y/cf << '\t'
+          << L.b[i].re << '\t' << L.b[i].im << '\t'
+          << meshnode[i].BoundaryMarker;
         // include A from previous solution if this is an incremental permeability problem
-        if (!Aprev.empty ()) fprintf(fp,"\t%.17g\n",Aprev[i]);
-        else fprintf(fp,"\n");
-    }
-    fprintf(fp,"%i\n",NumEls);
-    for(i=0; i<NumEls; i++)
-    {
-        fprintf(fp,"%i\t%i\t%i\t%i\t%i\t%i\t%i",
-                meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl,
-                meshele[i].e[0],meshele[i].e[1],meshele[i].e[2]
-                );
+        if (!Aprev.empty ()) w << '\t' << Aprev[i] << '\n';
+        else w << '\n';
+    });
+    out << NumEls << '\n';
+    out.writeRecords(NumEls, [&](femm::CTextWriter &w, int i) {
+        w << meshele[i].p[0] << '\t' << meshele[i].p[1] << '\t' << meshele[i].p[2] << '\t'
+          << meshele[i].lbl << '\t'
+          << meshele[i].e[0] << '\t' << meshele[i].e[1] << '\t' << meshele[i].e[2];
         // include J from previous problem if this is an incremental permeability problem
-        if (!Aprev.empty ()) fprintf(fp,"\t%.17g\n",meshele[i].Jprev);
-        else fprintf(fp,"\n");
-    }
+        if (!Aprev.empty ()) w << '\t' << meshele[i].Jprev << '\n';
+        else w << '\n';
+    });
 
     /*
     	// print out circuit info
@@ -964,7 +1010,7 @@ int FSolver::WriteHarmonic2D(CBigComplexLinProb &L)
     	}
     */
     // print out circuit info on a blocklabel by blocklabel basis;
-    fprintf(fp,"%i\n",NumBlockLabels);
+    out << NumBlockLabels << '\n';
     for(k=0; k<NumBlockLabels; k++)
     {
         i=labellist[k].InCircuit;
@@ -973,67 +1019,100 @@ int FSolver::WriteHarmonic2D(CBigComplexLinProb &L)
             // print out some "dummy" propeties that say that
             // there is a fixed additional current density,
             // but that that additional current density is zero.
-            fprintf(fp,"1\t0\t0\n");
+            out << "1\t0\t0\n";
         }
         else
         {
             if (circproplist[i].Case==0)
-                fprintf(fp,"0\t%.17g\t%.17g\n",circproplist[i].dV.Re(),
-                        circproplist[i].dV.Im());
+                out << "0\t" << circproplist[i].dV.Re() << '\t'
+                    << circproplist[i].dV.Im() << '\n';
             if (circproplist[i].Case==1)
-                fprintf(fp,"1\t%.17g\t%.17g\n",circproplist[i].J.Re(),
-                        circproplist[i].J.Im());
+                out << "1\t" << circproplist[i].J.Re() << '\t'
+                    << circproplist[i].J.Im() << '\n';
 
             if (circproplist[i].Case==2)
-                fprintf(fp,"0\t%.17g\t%.17g\n",L.b[NumNodes+i].Re(),
-                        L.b[NumNodes+i].Im());
+                out << "0\t" << L.b[NumNodes+i].Re() << '\t'
+                    << L.b[NumNodes+i].Im() << '\n';
         }
     }
 
     // print out information on periodic boundary conditions
-    fprintf(fp,"%i\n",NumPBCs);
+    out << NumPBCs << '\n';
     for(k=0;k<NumPBCs;k++)
     {
-        fprintf(fp,"%i  %i %i\n",pbclist[k].x,pbclist[k].y,pbclist[k].t);
+        out << pbclist[k].x << "  " << pbclist[k].y << ' ' << pbclist[k].t << '\n';
     }
 
 	// print out air gap element info
-    fprintf(fp,"%i\n",NumAirGapElems);
+    out << NumAirGapElems << '\n';
 	for(i=0;i<NumAirGapElems;i++)
     {
-		fprintf(fp,"%s",agelist[i].BdryName.c_str ());
+		out << agelist[i].BdryName;
 
-		fprintf( fp,"%i %.17g %.17g %.17g %.17g %.17g %.17g %.17g %i %.17g %.17g\n",
-                 agelist[i].BdryFormat,
-                 agelist[i].InnerAngle,
-                 agelist[i].OuterAngle,
-                 agelist[i].ri,
-                 agelist[i].ro,
-                 agelist[i].totalArcLength,
-                 agelist[i].agc.re,
-                 agelist[i].agc.im,
-                 agelist[i].totalArcElements,
-                 agelist[i].InnerShift,
-                 agelist[i].OuterShift );
+		out << agelist[i].BdryFormat << ' '
+            << agelist[i].InnerAngle << ' '
+            << agelist[i].OuterAngle << ' '
+            << agelist[i].ri << ' '
+            << agelist[i].ro << ' '
+            << agelist[i].totalArcLength << ' '
+            << agelist[i].agc.re << ' '
+            << agelist[i].agc.im << ' '
+            << agelist[i].totalArcElements << ' '
+            << agelist[i].InnerShift << ' '
+            << agelist[i].OuterShift << '\n';
 
 		for(k=0;k<=agelist[i].totalArcElements;k++)
         {
-			fprintf( fp,"%i %.17g %i %.17g %i %.17g %i %.17g\n",
-                     agelist[i].quadNode[k].n0,
-                     agelist[i].quadNode[k].w0,
-                     agelist[i].quadNode[k].n1,
-                     agelist[i].quadNode[k].w1,
-                     agelist[i].quadNode[k].n2,
-                     agelist[i].quadNode[k].w2,
-                     agelist[i].quadNode[k].n3,
-                     agelist[i].quadNode[k].w3 );
+			const femm::CQuadPoint &qp = agelist[i].quadNode[k];
+			out << qp.n0 << ' ' << qp.w0 << ' '
+                << qp.n1 << ' ' << qp.w1 << ' '
+                << qp.n2 << ' ' << qp.w2 << ' '
+                << qp.n3 << ' ' << qp.w3 << '\n';
 		}
 	}
 
-    fclose(fp);
+    bool written = out.flush();
+    if (fclose(fp)!=0 || !written)
+    {
+        printf("Couldn't write to %s.ans\n",PathName.c_str());
+        return false;
+    }
     return true;
 }
 
+void FSolver::StoreHarmonic2D(CBigComplexLinProb &L)
+{
+    solution = newSolution();
+    for(int i=0; i<NumNodes; i++)
+    {
+        solution->nodes[i].A = L.b[i];
+    }
+
+    // circuit info on a blocklabel by blocklabel basis, see WriteHarmonic2D()
+    solution->circuits.resize(NumBlockLabels);
+    for(int k=0; k<NumBlockLabels; k++)
+    {
+        femm::CMSolution::Circuit &circ = solution->circuits[k];
+        int i=labellist[k].InCircuit;
+        circ.Case = 1;
+        circ.value = 0;
+        if (i<0)
+            continue;
+        if (circproplist[i].Case==0)
+        {
+            circ.Case = 0;
+            circ.value = circproplist[i].dV;
+        }
+        if (circproplist[i].Case==1)
+            circ.value = circproplist[i].J;
+        if (circproplist[i].Case==2)
+        {
+            circ.Case = 0;
+            circ.value = L.b[NumNodes+i];
+        }
+    }
+}
+
 
 
 
@@ -26,6 +26,8 @@
 #include "femmcomplex.h"
 #include "femmconstants.h"
 #include "CElement.h"
+#include "coloring.h"
+#include "triangleshapes.h"
 #include "spars.h"
 #include "fsolver.h"
 
@@ -33,13 +35,11 @@
 
 int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
 {
-    int i,j,k,s,flag,ww,Iter=0;
-    int pctr;
-    CComplex Mx[3][3],My[3][3],Mxy[3][3],Mn[3][3],Me[3][3],be[3];		// element matrices;
-    double l[3],p[3],q[3];		// element shape parameters;
+    int i,j,k,s,Iter=0;
+    double p[3],q[3];		// element shape parameters;
     int n[3];					// numbers of nodes for a particular element;
-    double a,r,t,x,y,B,w,res,lastres,ds,R,rn[3],g[3],a_hat,R_hat,vol,Cduct;
-    CComplex K,mu,dv,B1,B2,v[3],mu1,mu2,lag,halflag,deg45,Jv; //u[3],
+    double a,r,t,x,y,w,res,lastres,ds,Cduct;
+    CComplex K,halflag,deg45; //u[3],
     CComplex **Mu,*V_old;
     double c=PI*4.e-05;
     double units[]= {2.54,0.1,1.,100.,0.00254,1.e-04};
@@ -48,14 +48,6 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
     int bIncremental=0;
     res=0;
 
-// #ifndef NEWTON
-    CComplex murel,muinc;
-// #else
-    CComplex Mnh[3][3];
-    CComplex Mna[3][3];
-    CComplex Mns[3][3];
-// #endif
-
     extRo*=units[LengthUnits];
     extRi*=units[LengthUnits];
     extZo*=units[LengthUnits];
@@ -80,6 +72,10 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
 
     V_old=(CComplex *) calloc(NumNodes+NumCircProps,sizeof(CComplex));
 
+    // shape parameters of all elements
+    CTriangleShapes shapes;
+    shapes.Create(meshnode.data(),NumNodes,meshele);
+
     CComplex *CircInt1 = nullptr;
     CComplex *CircInt2 = nullptr;
     CComplex *CircInt3 = nullptr;
@@ -99,13 +95,7 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
 
                     // get element area;
                     for(k=0; k<3; k++) n[k]=El->p[k];
-                    p[0]=meshnode[n[1]].y - meshnode[n[2]].y;
-                    p[1]=meshnode[n[2]].y - meshnode[n[0]].y;
-                    p[2]=meshnode[n[0]].y - meshnode[n[1]].y;
-                    q[0]=meshnode[n[2]].x - meshnode[n[1]].x;
-                    q[1]=meshnode[n[0]].x - meshnode[n[2]].x;
-                    q[2]=meshnode[n[1]].x - meshnode[n[0]].x;
-                    a=(p[0]*q[1]-p[1]*q[0])/2.;
+                    shapes.Get(i,p,q,a);
                     r=(meshnode[n[0]].x+meshnode[n[1]].x+meshnode[n[2]].x)/3.;
 
                     // if coils are wound, they act like they have
@@ -203,29 +193,59 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
     }
 
 
+    // the bookkeeping of the nonlinear elements is done up front,
+    // so that the elements can be assembled in parallel.
+    for(i=0; i<NumEls; i++)
+    {
+        if ((blockproplist[meshele[i].blk].BHpoints > 0) && (bIncremental==0)) LinearFlag=false;
+    }
+
+    // elements of the same color do not share nodes, so that they can add to the matrix concurrently.
+    // Elements in a Case 2 circuit also add to the row of the circuit, so they are assembled serially.
+    CElementColoring coloring;
+    coloring.Create(NumNodes);
+    for(i=0; i<NumEls; i++)
+    {
+        k=labellist[meshele[i].lbl].InCircuit;
+        coloring.Add(i, meshele[i].p, (k>=0) && (circproplist[k].Case==2));
+    }
+    coloring.Finish();
+
+
     do
     {
 
 //		TheView->SetDlgItemText(IDC_FRAME1,"Matrix Construction");
 //		TheView->m_prog1.SetPos(0);
         printf("Matrix Construction\n");
-        pctr=0;
+//        pctr=0;
 
         if (Iter>0) L.Wipe();
 
+        // the Newton matrices must exist before the elements are added concurrently
+        if ((ACSolver==1) && (Iter>0)) L.CreateNewtonMatrices();
+
         // build element matrices using the matrices derived in Allaire's book.
-        for(i=0; i<NumEls; i++)
+        coloring.ForEach([&](int i)
         {
-
-            // update ``building matrix'' progress bar...
-            j=(i*20)/NumEls+1;
-            if(j>pctr)
-            {
-                j=pctr*5;
-                if (j>100) j=100;
+            CComplex Mx[3][3],My[3][3],Mxy[3][3],Mn[3][3],Me[3][3],be[3];		// element matrices;
+            CComplex Mnh[3][3],Mna[3][3],Mns[3][3];
+            double l[3],p[3],q[3];		// element shape parameters;
+            int n[3];					// numbers of nodes for a particular element;
+            double a,r,B,ds,R,rn[3],g[3],a_hat,R_hat,vol;
+            CComplex K,mu,dv,v[3],Jv,murel,muinc;
+            int j,k,ww,flag;
+
+
+//            // update ``building matrix'' progress bar...
+//            j=(i*20)/NumEls+1;
+//            if(j>pctr)
+//            {
+//                j=pctr*5;
+//                if (j>100) j=100;
 //			TheView->m_prog1.SetPos(j);
-                pctr++;
-            }
+//                pctr++;
+//            }
 
             // zero out Me, be;
             for(j=0; j<3; j++)
@@ -252,7 +272,7 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
             // l == element side lengths;
             // p corresponds to the `b' parameter in Allaire
             // q corresponds to the `c' parameter in Allaire
-            El=&meshele[i];
+            femmsolver::CMElement *El=&meshele[i];
 
             for(k=0; k<3; k++)
             {
@@ -260,23 +280,11 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
                 rn[k]=meshnode[n[k]].x;
             }
 
-            p[0]=meshnode[n[1]].y - meshnode[n[2]].y;
-            p[1]=meshnode[n[2]].y - meshnode[n[0]].y;
-            p[2]=meshnode[n[0]].y - meshnode[n[1]].y;
-            q[0]=meshnode[n[2]].x - meshnode[n[1]].x;
-            q[1]=meshnode[n[0]].x - meshnode[n[2]].x;
-            q[2]=meshnode[n[1]].x - meshnode[n[0]].x;
+            shapes.Get(i,p,q,a);
             g[0]=(meshnode[n[2]].x + meshnode[n[1]].x)/2.;
             g[1]=(meshnode[n[0]].x + meshnode[n[2]].x)/2.;
             g[2]=(meshnode[n[1]].x + meshnode[n[0]].x)/2.;
-
-            for(j=0,k=1; j<3; k++,j++)
-            {
-                if (k==3) k=0;
-                l[j]=sqrt( pow(meshnode[n[k]].x-meshnode[n[j]].x,2.) +
-                           pow(meshnode[n[k]].y-meshnode[n[j]].y,2.) );
-            }
-            a=(p[0]*q[1]-p[1]*q[0])/2.;
+            shapes.GetSides(i,l);
             R=(meshnode[n[0]].x+meshnode[n[1]].x+meshnode[n[2]].x)/3.;
 
             for(j=0,a_hat=0; j<3; j++) a_hat+=(rn[j]*rn[j]*p[j]/(4.*R));
@@ -450,8 +458,8 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
                 {
                     K=-2.*I*a*w*blockproplist[meshele[i].blk].Cduct*c;
                     for(j=0; j<3; j++)
-                        L.Put(L.Get(n[j],NumNodes+k)+K/3.,n[j],NumNodes+k);
-                    L.Put(L.Get(NumNodes+k,NumNodes+k)+K/R,NumNodes+k,NumNodes+k);
+                        L.AddTo(K/3.,n[j],NumNodes+k);
+                    L.AddTo(K/R,NumNodes+k,NumNodes+k);
                 }
             }
 
@@ -470,8 +478,8 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
                 meshele[i].v12=0;
                 if (blockproplist[k].BHpoints > 0)
                 {
-                    if (bIncremental==0) LinearFlag=false;
-                    else{
+                    if (bIncremental!=0)
+                    {
                         double B1p,B2p;
 
                         //	Get B from previous solution
@@ -608,7 +616,7 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
             {
                 for (k=j; k<3; k++)
                 {
-                    L.Put(L.Get(n[j],n[k])+Me[j][k],n[j],n[k]);
+                    L.AddTo(Me[j][k],n[j],n[k]);
 //#ifdef NEWTON
                     if (ACSolver==1)
                     {
@@ -623,7 +631,7 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
 
 ///////////////////////////////////////////////////
 
-        }
+        });
 
         // add in contribution from point currents;
         for(i=0; i<NumNodes; i++)
@@ -747,7 +755,7 @@ int FSolver::HarmonicAxisymmetric(CBigComplexLinProb &L)
             if (L.Precision<Precision) L.Precision=Precision;
         }
 
-        if (L.PBCGSolveMod(Iter)==0) return 0;
+        if (L.Solve(Iter)==0) return 0;
 
         if (LinearFlag==false)
         {
@@ -24,8 +24,9 @@
 #include "CElement.h"
 #include "spars.h"
 #include "fsolver.h"
-#include "lua.h"
-#include "LuaInstance.h"
+#include "coloring.h"
+#include "triangleshapes.h"
+#include "textwriter.h"
 
 #include <stdio.h>
 #include <math.h>
@@ -35,16 +36,6 @@
 
 #include <csignal>
 
-#ifdef _MSC_VER
-  #ifndef SNPRINTF
-  #define SNPRINTF _snprintf
-  #endif
-#else
-  #ifndef SNPRINTF
-  #define SNPRINTF std::snprintf
-  #endif
-#endif
-
 double Power(double x, int y)
 {
 	return pow(x,(double) y);
@@ -53,12 +44,9 @@ double Power(double x, int y)
 int FSolver::Static2D(CBigLinProb &L)
 {
 
-    int i,j,k,w,s;
-    double Me[3][3],be[3];      // element matrices;
-    double Mx[3][3],My[3][3],Mxy[3][3],Mn[3][3];
-    double l[3],p[3],q[3];      // element shape parameters;
-    int n[3];                   // numbers of nodes for a particular element;
-    double a,K,Ki,r,t,x,y,B,B1,B2,mu,v[3],u[3],dv,res,lastres,Cduct;
+    int i,j,k,s;
+    double p[3],q[3];           // element shape parameters;
+    double a,K,Ki,r,t,x,y,res,Cduct;
     double *V_old=nullptr;
     double *CircInt1=nullptr;
     double *CircInt2=nullptr;
@@ -68,7 +56,6 @@ int FSolver::Static2D(CBigLinProb &L)
     int Iter=0;
     bool LinearFlag=true;
     int bIncremental = MS_LEGACY_FALSE;
-	double murel, muinc;
 
 	if (!previousSolutionFile.empty()) bIncremental = PrevType;
 
@@ -76,6 +63,11 @@ int FSolver::Static2D(CBigLinProb &L)
     femmsolver::CMElement *El;
     V_old = (double *) calloc(NumNodes,sizeof(double));
 
+    // shape parameters and geometric element matrices of all elements
+    CTriangleShapes shapes;
+    shapes.Create(meshnode.data(), NumNodes, meshele);
+    shapes.ComputePlanarMatrices();
+
     for(i = 0; i < NumBlockLabels; i++)
     {
         GetFillFactor(i);
@@ -97,19 +89,7 @@ int FSolver::Static2D(CBigLinProb &L)
                     El = &meshele[i];
 
                     // get element area;
-                    for(k = 0; k<3; k++)
-                    {
-                        n[k] = El->p[k];
-                    }
-
-                    p[0] = meshnode[n[1]].y - meshnode[n[2]].y;
-                    p[1] = meshnode[n[2]].y - meshnode[n[0]].y;
-                    p[2] = meshnode[n[0]].y - meshnode[n[1]].y;
-                    q[0] = meshnode[n[2]].x - meshnode[n[1]].x;
-                    q[1] = meshnode[n[0]].x - meshnode[n[2]].x;
-                    q[2] = meshnode[n[1]].x - meshnode[n[0]].x;
-
-                    a = (p[0]*q[1] - p[1]*q[0]) / 2.;
+                    shapes.Get(i, p, q, a);
 
                     //	r = (meshnode[n[0]].x+meshnode[n[1]].x+meshnode[n[2]].x)/3.;
 
@@ -173,184 +153,225 @@ int FSolver::Static2D(CBigLinProb &L)
     // permeability must be updated from iteration to iteration...
 
     // build element matrices using the matrices derived in Allaire's book.
-
-    do
-    {
+    // Only the elements with a nonlinear material change from one iteration to the next,
+    // so everything else, including all sources and boundary conditions of the elements,
+    // is assembled once and restored at the start of each iteration (see CBigLinProb::SaveAssembly()).
+    std::vector<int> nonlinearElements;
 
 //	TheView->SetDlgItemText(IDC_FRAME1,"Matrix Construction");
 //	TheView->m_prog1.SetPos(0);
-        PrintMessage("Matrix Construction\n");
+    PrintMessage("Matrix Construction\n");
 
 //        pctr = 0;
 
-        if(Iter > 0)
+    // first, tack in air gap element contributions
+    for(i=0;i<NumAirGapElems;i++)
+    {
+        double MG[10][10];
+        double ci,co;
+        int nn[10];
+        double ww[10];
+        double dt;
+
+        // K = dr/(R*dtta)
+        dt=(PI/180.)*(agelist[i].totalArcLength/agelist[i].totalArcElements);
+        K=2.*(agelist[i].ro-agelist[i].ri)/
+           (dt*(agelist[i].ro+agelist[i].ri));
+        Ki=1./K;
+        ci=agelist[i].InnerShift;
+        co=agelist[i].OuterShift;
+
+        if (ci>co)
         {
-            L.Wipe();
+            ci=ci-co;
+            co=0;
+        }
+        else{
+            ci=1-co+ci;
+            co=1;
         }
 
-        // first, tack in air gap element contributions
-        for(i=0;i<NumAirGapElems;i++)
+        // build the element matrix for each quad element in the annulus (same for each element)
+        // matrix for quad element derived from serendipity element
+        MG[0][0] = (5*Power (-1 + ci,2)*Power (ci,4)*(K + Ki))/48.;
+        MG[0][1] = -((-1 + ci)*Power (ci,3)*(5*(-1 + ci*(-5 + 4*ci))*K + (-5 + ci*(-19 + 14*ci))*Ki))/48.;
+        MG[0][2] = ((-1 + ci)*Power (ci,2)*(5*(2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (10 + ci*(1 + 3*ci*(-7 + 4*ci)))*Ki))/48.;
+        MG[0][3] = -(Power (-1 + ci,2)*Power (ci,2)*(5*(-2 + ci*(-3 + 4*ci))*K + (2 + ci*(-3 + 2*ci))*Ki))/48.;
+        MG[0][4] = (Power (-1 + ci,3)*Power (ci,3)*(5*K - Ki))/48.;
+        MG[0][5] = ((-1 + ci)*Power (ci,2)*(-1 + co)*Power (co,2)*(K - 5*Ki))/48.;
+        MG[0][6] = -((-1 + ci)*Power (ci,2)*co*((-1 + co*(-5 + 4*co))*K + (5 + (19 - 14*co)*co)*Ki))/48.;
+        MG[0][7] = ((-1 + ci)*Power (ci,2)*((2 + co*(-1 - 9*co + 6*Power (co,2)))*K - (10 + co*(1 + 3*co*(-7 + 4*co)))*Ki))/48.;
+        MG[0][8] = -((-1 + ci)*Power (ci,2)*(-1 + co)*((-2 + co*(-3 + 4*co))*K + (-2 + (3 - 2*co)*co)*Ki))/48.;
+        MG[0][9] = ((-1 + ci)*Power (ci,2)*Power (-1 + co,2)*co*(K + Ki))/48.;
+        MG[1][1] = (Power (ci,2)*(5*Power (1 + (5 - 4*ci)*ci,2)*K + (5 + ci*(38 + ci*(49 + 4*ci*(-29 + 11*ci))))*Ki))/48.;
+        MG[1][2] = (-5*ci*(-1 + 2*ci)*(-2 + 3*(-1 + ci)*ci)*(-1 + ci*(-5 + 4*ci))*K + ci*(10 + ci*(39 - ci*(50 + ci*(85 + 6*ci*(-23 + 8*ci)))))*Ki)/48.;
+        MG[1][3] = ((-1 + ci)*ci*(5*(2 + ci*(13 + ci*(3 + 16*(-2 + ci)*ci)))*K + (-2 + 5*ci*(1 + ci*(3 + 4*(-2 + ci)*ci)))*Ki))/48.;
+        MG[1][4] = -(Power (-1 + ci,2)*Power (ci,2)*(5*(-1 + ci*(-5 + 4*ci))*K + Ki + ci*(-1 + 2*ci)*Ki))/48.;
+        MG[1][5] = -(ci*(-1 + co)*Power (co,2)*((-1 + ci*(-5 + 4*ci))*K + (5 + (19 - 14*ci)*ci)*Ki))/48.;
+        MG[1][6] = (ci*co*((-1 + ci*(-5 + 4*ci))*(-1 + co*(-5 + 4*co))*K + (-5 + ci*(-19 + 14*ci) - 19*co + ci*(-77 + 58*ci)*co + 2*(7 + (29 - 22*ci)*ci)*Power (co,2))*Ki))/48.;
+        MG[1][7] = (-(ci*(-1 + ci*(-5 + 4*ci))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K) + ci*(-10 + co*(-1 + 3*(7 - 4*co)*co) + ci*(-38 + co + 99*Power (co,2) - 60*Power (co,3)) + Power (ci,2)*(28 + 2*co*(-1 + 3*co*(-13 + 8*co))))*Ki)/48.;
+        MG[1][8] = (ci*(-1 + co)*((-1 + ci*(-5 + 4*ci))*(-2 + co*(-3 + 4*co))*K + (2 + co*(-3 + 2*co) + Power (ci,2)*(4 + 2*(9 - 10*co)*co) + ci*(-2 + co*(-21 + 22*co)))*Ki))/48.;
+        MG[1][9] = -(ci*Power (-1 + co,2)*co*((-1 + ci*(-5 + 4*ci))*K + (-1 + ci - 2*Power (ci,2))*Ki))/48.;
+        MG[2][2] = (5*Power (-2 + ci + 9*Power (ci,2) - 6*Power (ci,3),2)*K + (20 + (-1 + ci)*ci*(-4 + 3*(-1 + ci)*ci*(-25 + 24*(-1 + ci)*ci)))*Ki)/48.;
+        MG[2][3] = (-5*(4 + Power (ci,2)*(-33 + ci*(18 + ci*(65 + 6*ci*(-13 + 4*ci)))))*K + (4 + Power (ci,2)*(39 - ci*(30 + ci*(115 + 6*ci*(-25 + 8*ci)))))*Ki)/48.;
+        MG[2][4] = (Power (-1 + ci,2)*ci*(5*(2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (-2 + ci*(-5 + 3*ci*(-5 + 4*ci)))*Ki))/48.;
+        MG[2][5] = ((-1 + co)*Power (co,2)*((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K - (10 + ci*(1 + 3*ci*(-7 + 4*ci)))*Ki))/48.;
+        MG[2][6] = (-((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*co*(-1 + co*(-5 + 4*co))*K) + co*(-10 - 38*co + 28*Power (co,2) + Power (ci,2)*(21 + 99*co - 78*Power (co,2)) + ci*(-1 + co - 2*Power (co,2)) + 12*Power (ci,3)*(-1 + co*(-5 + 4*co)))*Ki)/48.;
+        MG[2][7] = ((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K - (2*(10 + co) + 6*Power (co,2)*(-7 + 4*co) + 3*Power (ci,2)*(-14 + co*(5 + (55 - 36*co)*co)) + ci*(2 + co*(5 + 3*(5 - 4*co)*co)) + 12*Power (ci,3)*(2 + co*(-1 - 9*co + 6*Power (co,2))))*Ki)/48.;
+        MG[2][8] = (-((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*(2 + co - 7*Power (co,2) + 4*Power (co,3))*K) + (-1 + co)*(4 + 2*ci*(5 + 3*(5 - 4*ci)*ci) + 3*(-2 + ci*(3 + (17 - 12*ci)*ci))*co + 2*(2 + ci*(-7 + 3*ci*(-11 + 8*ci)))*Power (co,2))*Ki)/48.;
+        MG[2][9] = (Power (-1 + co,2)*co*((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (2 + ci*(5 + 3*(5 - 4*ci)*ci))*Ki))/48.;
+        MG[3][3] = (Power (-1 + ci,2)*(5*Power (2 + (3 - 4*ci)*ci,2)*K + (20 + ci*(36 + ci*(-35 - 60*ci + 44*Power (ci,2))))*Ki))/48.;
+        MG[3][4] = -(Power (-1 + ci,3)*ci*(5*(-2 + ci*(-3 + 4*ci))*K + (-10 + ci*(-9 + 14*ci))*Ki))/48.;
+        MG[3][5] = -((-1 + ci)*(-1 + co)*Power (co,2)*((-2 + ci*(-3 + 4*ci))*K + (-2 + (3 - 2*ci)*ci)*Ki))/48.;
+        MG[3][6] = ((-1 + ci)*co*((-2 + ci*(-3 + 4*ci))*(-1 + co*(-5 + 4*co))*K + (2 + ci*(-3 + 2*ci) - 2*co + ci*(-21 + 22*ci)*co + 2*(2 + (9 - 10*ci)*ci)*Power (co,2))*Ki))/48.;
+        MG[3][7] = (-((2 + ci - 7*Power (ci,2) + 4*Power (ci,3))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K) + (-1 + ci)*(4 + 2*co*(5 + 3*(5 - 4*co)*co) + ci*(-6 + 3*co*(3 + (17 - 12*co)*co)) + 2*Power (ci,2)*(2 + co*(-7 + 3*co*(-11 + 8*co))))*Ki)/48.;
+        MG[3][8] = ((-1 + ci)*(-1 + co)*((-2 + ci*(-3 + 4*ci))*(-2 + co*(-3 + 4*co))*K + (-20 + 3*ci*(1 + 2*co)*(-6 + 5*co) + 2*co*(-9 + 14*co) + Power (ci,2)*(28 + 30*co - 44*Power (co,2)))*Ki))/48.;
+        MG[3][9] = -((-1 + ci)*Power (-1 + co,2)*co*((-2 + ci*(-3 + 4*ci))*K + (10 + (9 - 14*ci)*ci)*Ki))/48.;
+        MG[4][4] = (5*Power (-1 + ci,4)*Power (ci,2)*(K + Ki))/48.;
+        MG[4][5] = (Power (-1 + ci,2)*ci*(-1 + co)*Power (co,2)*(K + Ki))/48.;
+        MG[4][6] = -(Power (-1 + ci,2)*ci*co*((-1 + co*(-5 + 4*co))*K + (-1 + co - 2*Power (co,2))*Ki))/48.;
+        MG[4][7] = (Power (-1 + ci,2)*ci*((2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (2 + co*(5 + 3*(5 - 4*co)*co))*Ki))/48.;
+        MG[4][8] = -(Power (-1 + ci,2)*ci*(-1 + co)*((-2 + co*(-3 + 4*co))*K + (10 + (9 - 14*co)*co)*Ki))/48.;
+        MG[4][9] = (Power (-1 + ci,2)*ci*Power (-1 + co,2)*co*(K - 5*Ki))/48.;
+        MG[5][5] = (5*Power (-1 + co,2)*Power (co,4)*(K + Ki))/48.;
+        MG[5][6] = -((-1 + co)*Power (co,3)*(5*(-1 + co*(-5 + 4*co))*K + (-5 + co*(-19 + 14*co))*Ki))/48.;
+        MG[5][7] = ((-1 + co)*Power (co,2)*(5*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (10 + co*(1 + 3*co*(-7 + 4*co)))*Ki))/48.;
+        MG[5][8] = -(Power (-1 + co,2)*Power (co,2)*(5*(-2 + co*(-3 + 4*co))*K + (2 + co*(-3 + 2*co))*Ki))/48.;
+        MG[5][9] = (Power (-1 + co,3)*Power (co,3)*(5*K - Ki))/48.;
+        MG[6][6] = (Power (co,2)*(5*Power (1 + (5 - 4*co)*co,2)*K + (5 + co*(38 + co*(49 + 4*co*(-29 + 11*co))))*Ki))/48.;
+        MG[6][7] = (-5*co*(-1 + 2*co)*(-2 + 3*(-1 + co)*co)*(-1 + co*(-5 + 4*co))*K + co*(10 + co*(39 - co*(50 + co*(85 + 6*co*(-23 + 8*co)))))*Ki)/48.;
+        MG[6][8] = ((-1 + co)*co*(5*(2 + co*(13 + co*(3 + 16*(-2 + co)*co)))*K + (-2 + 5*co*(1 + co*(3 + 4*(-2 + co)*co)))*Ki))/48.;
+        MG[6][9] = -(Power (-1 + co,2)*Power (co,2)*(5*(-1 + co*(-5 + 4*co))*K + Ki + co*(-1 + 2*co)*Ki))/48.;
+        MG[7][7] = (5*Power (-2 + co + 9*Power (co,2) - 6*Power (co,3),2)*K + (20 + (-1 + co)*co*(-4 + 3*(-1 + co)*co*(-25 + 24*(-1 + co)*co)))*Ki)/48.;
+        MG[7][8] = (-5*(4 + Power (co,2)*(-33 + co*(18 + co*(65 + 6*co*(-13 + 4*co)))))*K + (4 + Power (co,2)*(39 - co*(30 + co*(115 + 6*co*(-25 + 8*co)))))*Ki)/48.;
+        MG[7][9] = (Power (-1 + co,2)*co*(5*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (-2 + co*(-5 + 3*co*(-5 + 4*co)))*Ki))/48.;
+        MG[8][8] = (Power (-1 + co,2)*(5*Power (2 + (3 - 4*co)*co,2)*K + (20 + co*(36 + co*(-35 - 60*co + 44*Power (co,2))))*Ki))/48.;
+        MG[8][9] = -(Power (-1 + co,3)*co*(5*(-2 + co*(-3 + 4*co))*K + (-10 + co*(-9 + 14*co))*Ki))/48.;
+        MG[9][9] = (5*Power (-1 + co,4)*Power (co,2)*(K + Ki))/48.;
+
+        // Add each annulus element to the global stiffness matrix
+        for(k=0;k<agelist[i].totalArcElements;k++)
         {
-            double MG[10][10];
-            double ci,co;
-            int nn[10];
-            double ww[10];
-            double dt;
-
-            // K = dr/(R*dtta)
-            dt=(PI/180.)*(agelist[i].totalArcLength/agelist[i].totalArcElements);
-            K=2.*(agelist[i].ro-agelist[i].ri)/
-               (dt*(agelist[i].ro+agelist[i].ri));
-            Ki=1./K;
-            ci=agelist[i].InnerShift;
-            co=agelist[i].OuterShift;
-
-            if (ci>co)
-            {
-                ci=ci-co;
-                co=0;
+
+            // inner nodes
+            if ((k-1)<0){
+                nn[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].n0;
+                ww[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].w0;
             }
             else{
-                ci=1-co+ci;
-                co=1;
+                nn[0]=agelist[i].quadNode[k-1].n0;
+                ww[0]=agelist[i].quadNode[k-1].w0;
             }
 
-            // build the element matrix for each quad element in the annulus (same for each element)
-            // matrix for quad element derived from serendipity element
-            MG[0][0] = (5*Power (-1 + ci,2)*Power (ci,4)*(K + Ki))/48.;
-            MG[0][1] = -((-1 + ci)*Power (ci,3)*(5*(-1 + ci*(-5 + 4*ci))*K + (-5 + ci*(-19 + 14*ci))*Ki))/48.;
-            MG[0][2] = ((-1 + ci)*Power (ci,2)*(5*(2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (10 + ci*(1 + 3*ci*(-7 + 4*ci)))*Ki))/48.;
-            MG[0][3] = -(Power (-1 + ci,2)*Power (ci,2)*(5*(-2 + ci*(-3 + 4*ci))*K + (2 + ci*(-3 + 2*ci))*Ki))/48.;
-            MG[0][4] = (Power (-1 + ci,3)*Power (ci,3)*(5*K - Ki))/48.;
-            MG[0][5] = ((-1 + ci)*Power (ci,2)*(-1 + co)*Power (co,2)*(K - 5*Ki))/48.;
-            MG[0][6] = -((-1 + ci)*Power (ci,2)*co*((-1 + co*(-5 + 4*co))*K + (5 + (19 - 14*co)*co)*Ki))/48.;
-            MG[0][7] = ((-1 + ci)*Power (ci,2)*((2 + co*(-1 - 9*co + 6*Power (co,2)))*K - (10 + co*(1 + 3*co*(-7 + 4*co)))*Ki))/48.;
-            MG[0][8] = -((-1 + ci)*Power (ci,2)*(-1 + co)*((-2 + co*(-3 + 4*co))*K + (-2 + (3 - 2*co)*co)*Ki))/48.;
-            MG[0][9] = ((-1 + ci)*Power (ci,2)*Power (-1 + co,2)*co*(K + Ki))/48.;
-            MG[1][1] = (Power (ci,2)*(5*Power (1 + (5 - 4*ci)*ci,2)*K + (5 + ci*(38 + ci*(49 + 4*ci*(-29 + 11*ci))))*Ki))/48.;
-            MG[1][2] = (-5*ci*(-1 + 2*ci)*(-2 + 3*(-1 + ci)*ci)*(-1 + ci*(-5 + 4*ci))*K + ci*(10 + ci*(39 - ci*(50 + ci*(85 + 6*ci*(-23 + 8*ci)))))*Ki)/48.;
-            MG[1][3] = ((-1 + ci)*ci*(5*(2 + ci*(13 + ci*(3 + 16*(-2 + ci)*ci)))*K + (-2 + 5*ci*(1 + ci*(3 + 4*(-2 + ci)*ci)))*Ki))/48.;
-            MG[1][4] = -(Power (-1 + ci,2)*Power (ci,2)*(5*(-1 + ci*(-5 + 4*ci))*K + Ki + ci*(-1 + 2*ci)*Ki))/48.;
-            MG[1][5] = -(ci*(-1 + co)*Power (co,2)*((-1 + ci*(-5 + 4*ci))*K + (5 + (19 - 14*ci)*ci)*Ki))/48.;
-            MG[1][6] = (ci*co*((-1 + ci*(-5 + 4*ci))*(-1 + co*(-5 + 4*co))*K + (-5 + ci*(-19 + 14*ci) - 19*co + ci*(-77 + 58*ci)*co + 2*(7 + (29 - 22*ci)*ci)*Power (co,2))*Ki))/48.;
-            MG[1][7] = (-(ci*(-1 + ci*(-5 + 4*ci))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K) + ci*(-10 + co*(-1 + 3*(7 - 4*co)*co) + ci*(-38 + co + 99*Power (co,2) - 60*Power (co,3)) + Power (ci,2)*(28 + 2*co*(-1 + 3*co*(-13 + 8*co))))*Ki)/48.;
-            MG[1][8] = (ci*(-1 + co)*((-1 + ci*(-5 + 4*ci))*(-2 + co*(-3 + 4*co))*K + (2 + co*(-3 + 2*co) + Power (ci,2)*(4 + 2*(9 - 10*co)*co) + ci*(-2 + co*(-21 + 22*co)))*Ki))/48.;
-            MG[1][9] = -(ci*Power (-1 + co,2)*co*((-1 + ci*(-5 + 4*ci))*K + (-1 + ci - 2*Power (ci,2))*Ki))/48.;
-            MG[2][2] = (5*Power (-2 + ci + 9*Power (ci,2) - 6*Power (ci,3),2)*K + (20 + (-1 + ci)*ci*(-4 + 3*(-1 + ci)*ci*(-25 + 24*(-1 + ci)*ci)))*Ki)/48.;
-            MG[2][3] = (-5*(4 + Power (ci,2)*(-33 + ci*(18 + ci*(65 + 6*ci*(-13 + 4*ci)))))*K + (4 + Power (ci,2)*(39 - ci*(30 + ci*(115 + 6*ci*(-25 + 8*ci)))))*Ki)/48.;
-            MG[2][4] = (Power (-1 + ci,2)*ci*(5*(2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (-2 + ci*(-5 + 3*ci*(-5 + 4*ci)))*Ki))/48.;
-            MG[2][5] = ((-1 + co)*Power (co,2)*((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K - (10 + ci*(1 + 3*ci*(-7 + 4*ci)))*Ki))/48.;
-            MG[2][6] = (-((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*co*(-1 + co*(-5 + 4*co))*K) + co*(-10 - 38*co + 28*Power (co,2) + Power (ci,2)*(21 + 99*co - 78*Power (co,2)) + ci*(-1 + co - 2*Power (co,2)) + 12*Power (ci,3)*(-1 + co*(-5 + 4*co)))*Ki)/48.;
-            MG[2][7] = ((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K - (2*(10 + co) + 6*Power (co,2)*(-7 + 4*co) + 3*Power (ci,2)*(-14 + co*(5 + (55 - 36*co)*co)) + ci*(2 + co*(5 + 3*(5 - 4*co)*co)) + 12*Power (ci,3)*(2 + co*(-1 - 9*co + 6*Power (co,2))))*Ki)/48.;
-            MG[2][8] = (-((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*(2 + co - 7*Power (co,2) + 4*Power (co,3))*K) + (-1 + co)*(4 + 2*ci*(5 + 3*(5 - 4*ci)*ci) + 3*(-2 + ci*(3 + (17 - 12*ci)*ci))*co + 2*(2 + ci*(-7 + 3*ci*(-11 + 8*ci)))*Power (co,2))*Ki)/48.;
-            MG[2][9] = (Power (-1 + co,2)*co*((2 + ci*(-1 - 9*ci + 6*Power (ci,2)))*K + (2 + ci*(5 + 3*(5 - 4*ci)*ci))*Ki))/48.;
-            MG[3][3] = (Power (-1 + ci,2)*(5*Power (2 + (3 - 4*ci)*ci,2)*K + (20 + ci*(36 + ci*(-35 - 60*ci + 44*Power (ci,2))))*Ki))/48.;
-            MG[3][4] = -(Power (-1 + ci,3)*ci*(5*(-2 + ci*(-3 + 4*ci))*K + (-10 + ci*(-9 + 14*ci))*Ki))/48.;
-            MG[3][5] = -((-1 + ci)*(-1 + co)*Power (co,2)*((-2 + ci*(-3 + 4*ci))*K + (-2 + (3 - 2*ci)*ci)*Ki))/48.;
-            MG[3][6] = ((-1 + ci)*co*((-2 + ci*(-3 + 4*ci))*(-1 + co*(-5 + 4*co))*K + (2 + ci*(-3 + 2*ci) - 2*co + ci*(-21 + 22*ci)*co + 2*(2 + (9 - 10*ci)*ci)*Power (co,2))*Ki))/48.;
-            MG[3][7] = (-((2 + ci - 7*Power (ci,2) + 4*Power (ci,3))*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K) + (-1 + ci)*(4 + 2*co*(5 + 3*(5 - 4*co)*co) + ci*(-6 + 3*co*(3 + (17 - 12*co)*co)) + 2*Power (ci,2)*(2 + co*(-7 + 3*co*(-11 + 8*co))))*Ki)/48.;
-            MG[3][8] = ((-1 + ci)*(-1 + co)*((-2 + ci*(-3 + 4*ci))*(-2 + co*(-3 + 4*co))*K + (-20 + 3*ci*(1 + 2*co)*(-6 + 5*co) + 2*co*(-9 + 14*co) + Power (ci,2)*(28 + 30*co - 44*Power (co,2)))*Ki))/48.;
-            MG[3][9] = -((-1 + ci)*Power (-1 + co,2)*co*((-2 + ci*(-3 + 4*ci))*K + (10 + (9 - 14*ci)*ci)*Ki))/48.;
-            MG[4][4] = (5*Power (-1 + ci,4)*Power (ci,2)*(K + Ki))/48.;
-            MG[4][5] = (Power (-1 + ci,2)*ci*(-1 + co)*Power (co,2)*(K + Ki))/48.;
-            MG[4][6] = -(Power (-1 + ci,2)*ci*co*((-1 + co*(-5 + 4*co))*K + (-1 + co - 2*Power (co,2))*Ki))/48.;
-            MG[4][7] = (Power (-1 + ci,2)*ci*((2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (2 + co*(5 + 3*(5 - 4*co)*co))*Ki))/48.;
-            MG[4][8] = -(Power (-1 + ci,2)*ci*(-1 + co)*((-2 + co*(-3 + 4*co))*K + (10 + (9 - 14*co)*co)*Ki))/48.;
-            MG[4][9] = (Power (-1 + ci,2)*ci*Power (-1 + co,2)*co*(K - 5*Ki))/48.;
-            MG[5][5] = (5*Power (-1 + co,2)*Power (co,4)*(K + Ki))/48.;
-            MG[5][6] = -((-1 + co)*Power (co,3)*(5*(-1 + co*(-5 + 4*co))*K + (-5 + co*(-19 + 14*co))*Ki))/48.;
-            MG[5][7] = ((-1 + co)*Power (co,2)*(5*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (10 + co*(1 + 3*co*(-7 + 4*co)))*Ki))/48.;
-            MG[5][8] = -(Power (-1 + co,2)*Power (co,2)*(5*(-2 + co*(-3 + 4*co))*K + (2 + co*(-3 + 2*co))*Ki))/48.;
-            MG[5][9] = (Power (-1 + co,3)*Power (co,3)*(5*K - Ki))/48.;
-            MG[6][6] = (Power (co,2)*(5*Power (1 + (5 - 4*co)*co,2)*K + (5 + co*(38 + co*(49 + 4*co*(-29 + 11*co))))*Ki))/48.;
-            MG[6][7] = (-5*co*(-1 + 2*co)*(-2 + 3*(-1 + co)*co)*(-1 + co*(-5 + 4*co))*K + co*(10 + co*(39 - co*(50 + co*(85 + 6*co*(-23 + 8*co)))))*Ki)/48.;
-            MG[6][8] = ((-1 + co)*co*(5*(2 + co*(13 + co*(3 + 16*(-2 + co)*co)))*K + (-2 + 5*co*(1 + co*(3 + 4*(-2 + co)*co)))*Ki))/48.;
-            MG[6][9] = -(Power (-1 + co,2)*Power (co,2)*(5*(-1 + co*(-5 + 4*co))*K + Ki + co*(-1 + 2*co)*Ki))/48.;
-            MG[7][7] = (5*Power (-2 + co + 9*Power (co,2) - 6*Power (co,3),2)*K + (20 + (-1 + co)*co*(-4 + 3*(-1 + co)*co*(-25 + 24*(-1 + co)*co)))*Ki)/48.;
-            MG[7][8] = (-5*(4 + Power (co,2)*(-33 + co*(18 + co*(65 + 6*co*(-13 + 4*co)))))*K + (4 + Power (co,2)*(39 - co*(30 + co*(115 + 6*co*(-25 + 8*co)))))*Ki)/48.;
-            MG[7][9] = (Power (-1 + co,2)*co*(5*(2 + co*(-1 - 9*co + 6*Power (co,2)))*K + (-2 + co*(-5 + 3*co*(-5 + 4*co)))*Ki))/48.;
-            MG[8][8] = (Power (-1 + co,2)*(5*Power (2 + (3 - 4*co)*co,2)*K + (20 + co*(36 + co*(-35 - 60*co + 44*Power (co,2))))*Ki))/48.;
-            MG[8][9] = -(Power (-1 + co,3)*co*(5*(-2 + co*(-3 + 4*co))*K + (-10 + co*(-9 + 14*co))*Ki))/48.;
-            MG[9][9] = (5*Power (-1 + co,4)*Power (co,2)*(K + Ki))/48.;
-
-            // Add each annulus element to the global stiffness matrix
-            for(k=0;k<agelist[i].totalArcElements;k++)
-            {
+            nn[1]=agelist[i].quadNode[k].n0;
+            nn[2]=agelist[i].quadNode[k].n1;
+            nn[3]=agelist[i].quadNode[k+1].n1;
+            ww[1]=agelist[i].quadNode[k].w0;
+            ww[2]=agelist[i].quadNode[k].w1;
+            ww[3]=agelist[i].quadNode[k+1].w1;
 
-                // inner nodes
-                if ((k-1)<0){
-                    nn[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].n0;
-                    ww[0]=agelist[i].quadNode[agelist[i].totalArcElements-1].w0;
-                }
-                else{
-                    nn[0]=agelist[i].quadNode[k-1].n0;
-                    ww[0]=agelist[i].quadNode[k-1].w0;
-                }
+            if((k+2)>agelist[i].totalArcElements){
+                nn[4]=agelist[i].quadNode[1].n1;
+                ww[4]=agelist[i].quadNode[1].w1;
+            }
+            else{
+                nn[4]=agelist[i].quadNode[k+2].n1;
+                ww[4]=agelist[i].quadNode[k+2].w1;
+            }
 
-                nn[1]=agelist[i].quadNode[k].n0;
-                nn[2]=agelist[i].quadNode[k].n1;
-                nn[3]=agelist[i].quadNode[k+1].n1;
-                ww[1]=agelist[i].quadNode[k].w0;
-                ww[2]=agelist[i].quadNode[k].w1;
-                ww[3]=agelist[i].quadNode[k+1].w1;
+            // outer nodes
+            if ((k-1)<0){
+                nn[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].n2;
+                ww[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].w2;
+            }
+            else{
+                nn[5]=agelist[i].quadNode[k-1].n2;
+                ww[5]=agelist[i].quadNode[k-1].w2;
+            }
 
-                if((k+2)>agelist[i].totalArcElements){
-                    nn[4]=agelist[i].quadNode[1].n1;
-                    ww[4]=agelist[i].quadNode[1].w1;
-                }
-                else{
-                    nn[4]=agelist[i].quadNode[k+2].n1;
-                    ww[4]=agelist[i].quadNode[k+2].w1;
-                }
+            nn[6]=agelist[i].quadNode[k].n2;
+            nn[7]=agelist[i].quadNode[k].n3;
+            nn[8]=agelist[i].quadNode[k+1].n3;
+            ww[6]=agelist[i].quadNode[k].w2;
+            ww[7]=agelist[i].quadNode[k].w3;
+            ww[8]=agelist[i].quadNode[k+1].w3;
 
-                // outer nodes
-                if ((k-1)<0){
-                    nn[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].n2;
-                    ww[5]=agelist[i].quadNode[agelist[i].totalArcElements-1].w2;
-                }
-                else{
-                    nn[5]=agelist[i].quadNode[k-1].n2;
-                    ww[5]=agelist[i].quadNode[k-1].w2;
-                }
+            if((k+2)>agelist[i].totalArcElements){
+                nn[9]=agelist[i].quadNode[1].n3;
+                ww[9]=agelist[i].quadNode[1].w3;
+            }
+            else{
+                nn[9]=agelist[i].quadNode[k+2].n3;
+                ww[9]=agelist[i].quadNode[k+2].w3;
+            }
 
-                nn[6]=agelist[i].quadNode[k].n2;
-                nn[7]=agelist[i].quadNode[k].n3;
-                nn[8]=agelist[i].quadNode[k+1].n3;
-                ww[6]=agelist[i].quadNode[k].w2;
-                ww[7]=agelist[i].quadNode[k].w3;
-                ww[8]=agelist[i].quadNode[k+1].w3;
+            // fix antiperiodic weights...
+            if ((k==0) && (agelist[i].BdryFormat==1))
+            {
+                ww[0]=-ww[0];
+                ww[5]=-ww[5];
+            }
+            if (((k+1)==agelist[i].totalArcElements) && (agelist[i].BdryFormat==1))
+            {
+                ww[4]=-ww[4];
+                ww[9]=-ww[9];
+            }
 
-                if((k+2)>agelist[i].totalArcElements){
-                    nn[9]=agelist[i].quadNode[1].n3;
-                    ww[9]=agelist[i].quadNode[1].w3;
-                }
-                else{
-                    nn[9]=agelist[i].quadNode[k+2].n3;
-                    ww[9]=agelist[i].quadNode[k+2].w3;
-                }
+            // scale by weight to get periodic/antiperiodic right and tack into mesh
+            for(int ii=0;ii<10;ii++)
+                for(int jj=ii;jj<10;jj++)
+                    L.AddTo(MG[ii][jj]*ww[ii]*ww[jj],nn[ii],nn[jj]);
+        }
 
-                // fix antiperiodic weights...
-                if ((k==0) && (agelist[i].BdryFormat==1))
-                {
-                    ww[0]=-ww[0];
-                    ww[5]=-ww[5];
-                }
-                if (((k+1)==agelist[i].totalArcElements) && (agelist[i].BdryFormat==1))
-                {
-                    ww[4]=-ww[4];
-                    ww[9]=-ww[9];
-                }
+    }
 
-                // scale by weight to get periodic/antiperiodic right and tack into mesh
-                for(int ii=0;ii<10;ii++)
-                    for(int jj=ii;jj<10;jj++)
-                        L.AddTo(MG[ii][jj]*ww[ii]*ww[jj],nn[ii],nn[jj]);
-            }
+    // Lua magnetization directions and the bookkeeping of the nonlinear elements
+    // are done up front, so that the elements can be assembled in parallel.
+    for(i = 0; i < NumEls; i++)
+    {
+        k = meshele[i].blk;
+        if (blockproplist[k].BHpoints == 0)
+            continue;
 
+        if (bIncremental == MS_LEGACY_FALSE)
+        {
+            // There's no previous solution.  This is a standard nonlinear problem
+            LinearFlag = false;
+            nonlinearElements.push_back(i);
         }
-
-        for(i = 0; i < NumEls; i++)
+        else if (blockproplist[k].LamType > 0)
         {
+            // too lazy to consistently code incremental/frozen formulation for on-edge lams.
+            // detect this condition, throw an error, and exit.
+            PrintMessage("On-edge Lam Types not yet supported in\nincremental/frozen permeability problems");
+            exit(0);
+        }
+    }
+
+    std::vector<double> magdir;
+    if (!GetMagDirections(magdir))
+    {
+        return -7;
+    }
+
+    // elements of the same color do not share nodes,
+    // so that they can add to the matrix concurrently.
+    CElementColoring coloring;
+    coloring.Create(NumNodes);
+    for(i = 0; i < NumEls; i++)
+    {
+        coloring.Add(i, meshele[i].p);
+    }
+    coloring.Finish();
+
+    coloring.ForEach([&](int i)
+    {
+        double Me[3][3],be[3];      // element matrices;
+        double Mx[3][3],My[3][3],Mxy[3][3];
+        double l[3],p[3],q[3];      // element shape parameters;
+        int n[3];                   // numbers of nodes for a particular element;
+        double a,K,t,mu;
+        int j,k;
 
 //            // update ``building matrix'' progress bar...
 //            j = (i*20) / NumEls + 1;
@@ -365,322 +386,244 @@ int FSolver::Static2D(CBigLinProb &L)
 //                pctr++;
 //            }
 
-            // zero out Me, be;
-            for(j = 0; j < 3; j++)
-            {
-                for(k = 0; k < 3; k++)
-                {
-                    Me[j][k] = 0.;
-                    Mx[j][k] = 0.;
-                    My[j][k] = 0.;
-                    Mn[j][k] = 0.;
-                    Mxy[j][k] = 0.;
-                }
-                be[j] = 0.;
-            }
-
-            // Determine shape parameters.
-            // l == element side lengths;
-            // p corresponds to the `b' parameter in Allaire
-            // q corresponds to the `c' parameter in Allaire
-            El = &meshele[i];
-
-            for(k = 0; k<3; k++)
+        // zero out Me, be;
+        for(j = 0; j < 3; j++)
+        {
+            for(k = 0; k < 3; k++)
             {
-                n[k] = El->p[k];
+                Me[j][k] = 0.;
             }
+            be[j] = 0.;
+        }
 
-            p[0] = meshnode[n[1]].y - meshnode[n[2]].y;
-            p[1] = meshnode[n[2]].y - meshnode[n[0]].y;
-            p[2] = meshnode[n[0]].y - meshnode[n[1]].y;
-            q[0] = meshnode[n[2]].x - meshnode[n[1]].x;
-            q[1] = meshnode[n[0]].x - meshnode[n[2]].x;
-            q[2] = meshnode[n[1]].x - meshnode[n[0]].x;
-
-            for(j = 0,k = 1; j<3; k++, j++)
-            {
-                if (k == 3)
-                {
-                    k = 0;
-                }
-
-                l[j] = sqrt( pow(meshnode[n[k]].x-meshnode[n[j]].x,2.) +
-                             pow(meshnode[n[k]].y-meshnode[n[j]].y,2.) );
-
-            }
+        // Determine shape parameters.
+        // l == element side lengths;
+        // p corresponds to the `b' parameter in Allaire
+        // q corresponds to the `c' parameter in Allaire
+        femmsolver::CMElement *El = &meshele[i];
 
-            a = (p[0]*q[1] - p[1]*q[0]) / 2.;
+        for(k = 0; k<3; k++)
+        {
+            n[k] = El->p[k];
+        }
 
-            r = (meshnode[n[0]].x + meshnode[n[1]].x + meshnode[n[2]].x) / 3.;
+        shapes.Get(i, p, q, a);
+        shapes.GetSides(i, l);
 
-            // x-contribution; only need to do main diagonal and above;
-            K = (-1. / (4.*a));
+        // x-, y- and xy-contributions, from the batch;
+        shapes.GetPlanarMatrices(i, Mx, My, Mxy);
 
-            for(j = 0; j<3; j++)
+        // contributions to Me, be from derivative boundary conditions;
+        for(j = 0; j<3; j++)
+        {
+            if (El->e[j] >= 0)
             {
-                for(k = j; k<3; k++)
+                if (lineproplist[El->e[j]].BdryFormat==2)
                 {
-                    Mx[j][k] += K * p[j] * p[k];
-                    if (j != k)
-                    {
-                        Mx[k][j] += K * p[j] * p[k];
-                    }
+                    // conversion factor is 10^(-4) (I think...)
+                    K = -0.0001*c*lineproplist[ El->e[j] ].c0.re*l[j]/6.;
+                    k = j+1;
+                    if(k==3) k = 0;
+                    Me[j][j]+=K*2.;
+                    Me[k][k]+=K*2.;
+                    Me[j][k]+=K;
+                    Me[k][j]+=K;
+
+                    K = (lineproplist[ El->e[j] ].c1.re*l[j]/2.)*0.0001;
+                    be[j]+=K;
+                    be[k]+=K;
                 }
             }
+        }
 
-            // y-contribution; only need to do main diagonal and above;
-            K = (-1. / (4.*a));
-            for(j = 0; j < 3; j++)
+        // contribution to be from current density in the block
+        for(j = 0; j<3; j++)
+        {
+            t = 0;
+            if ( labellist[El->lbl].InCircuit >= 0 )
             {
-                for(k = j; k < 3; k++)
-                {
-                    My[j][k] +=K*q[j]*q[k];
-                    if (j != k)
-                    {
-                        My[k][j] += K * q[j] * q[k];
-                    }
-                }
-            }
+                k = labellist[El->lbl].InCircuit;
 
-            // xy-contribution;
-            K = (-1. / (4.*a));
-            for (j = 0; j < 3; j++)
-            {
-                for (k = j; k < 3; k++)
+                if(circproplist[k].Case==1)
                 {
-                    Mxy[j][k] += K*(p[j] * q[k] + p[k] * q[j]);
-                    if (j != k)
-                    {
-                        Mxy[k][j] += K*(p[j] * q[k] + p[k] * q[j]);
-                    }
+                    t = circproplist[k].J.Re();
                 }
-            }
 
-            // contributions to Me, be from derivative boundary conditions;
-            for(j = 0; j<3; j++)
-            {
-                if (El->e[j] >= 0)
+                if(circproplist[k].Case==0)
                 {
-                    if (lineproplist[El->e[j]].BdryFormat==2)
-                    {
-                        // conversion factor is 10^(-4) (I think...)
-                        K = -0.0001*c*lineproplist[ El->e[j] ].c0.re*l[j]/6.;
-                        k = j+1;
-                        if(k==3) k = 0;
-                        Me[j][j]+=K*2.;
-                        Me[k][k]+=K*2.;
-                        Me[j][k]+=K;
-                        Me[k][j]+=K;
-
-                        K = (lineproplist[ El->e[j] ].c1.re*l[j]/2.)*0.0001;
-                        be[j]+=K;
-                        be[k]+=K;
-                    }
+                    t = -circproplist[k].dV.Re()*blockproplist[El->blk].Cduct;
                 }
             }
 
-            // contribution to be from current density in the block
-            for(j = 0; j<3; j++)
-            {
-                t = 0;
-                if ( labellist[El->lbl].InCircuit >= 0 )
-                {
-                    k = labellist[El->lbl].InCircuit;
+            K = -(blockproplist[El->blk].J.re+t)*a/3.;
 
-                    if(circproplist[k].Case==1)
-                    {
-                        t = circproplist[k].J.Re();
-                    }
-
-                    if(circproplist[k].Case==0)
-                    {
-                        t = -circproplist[k].dV.Re()*blockproplist[El->blk].Cduct;
-                    }
-                }
+            be[j]+=K;
 
-                K = -(blockproplist[El->blk].J.re+t)*a/3.;
-
-                be[j]+=K;
+            // record avg current density in the block for use in incremental solutions
+            if (bIncremental==MS_LEGACY_FALSE) El->Jprev+=(blockproplist[El->blk].J.Re()+t)/3.;
+        }
 
-                // record avg current density in the block for use in incremental solutions
-                if (bIncremental==MS_LEGACY_FALSE) El->Jprev+=(blockproplist[El->blk].J.Re()+t)/3.;
+        // contribution to be from magnetization in the block;
+        t = magdir[i];
+        for(j = 0; j<3; j++)
+        {
+            k = j+1;
+            if(k==3)
+            {
+                k = 0;
             }
+            // need to scale so that everything is in proper units...
+            // conversion is 0.0001
+            K = 0.0001*blockproplist[El->blk].H_c*(
+                    cos(t*PI/180.)*(meshnode[n[k]].x-meshnode[n[j]].x) +
+                    sin(t*PI/180.)*(meshnode[n[k]].y-meshnode[n[j]].y) )/2.;
+            be[j]+=K;
+            be[k]+=K;
+        }
 
-            // contribution to be from magnetization in the block;
-            t = labellist[El->lbl].MagDir;
-            // create the formatter object in case of a lua defined mag direction
-//                boost::format fmatter("x=%.17g\ny=%.17g\nr=x\nz=y\ntheta=%.17g\nR=%.17g\nreturn %s");
-            if (!labellist[El->lbl].MagDirFctn.empty()) // functional magnetization direction
-            {
+        // update permeability for the element;
+        k = meshele[i].blk;
 
-                char magbuff[4096];
-                std::string str;
-                CComplex X;
-                int top1,top2,lua_error_code;
+        if (blockproplist[k].LamType==0)
+        {
+            t = blockproplist[k].LamFill;
+            meshele[i].mu1 = blockproplist[k].mu_x*t + (1.-t);
+            meshele[i].mu2 = blockproplist[k].mu_y*t + (1.-t);
+        }
+        if (blockproplist[k].LamType==1)
+        {
+            t = blockproplist[k].LamFill;
+            mu = blockproplist[k].mu_x;
+            meshele[i].mu1 = mu*t + (1.-t);
+            meshele[i].mu2 = mu/(t + mu*(1.-t));
+        }
+        if (blockproplist[k].LamType==2)
+        {
+            t = blockproplist[k].LamFill;
+            mu = blockproplist[k].mu_y;
+            meshele[i].mu2 = mu*t + (1.-t);
+            meshele[i].mu1 = mu/(t + mu*(1.-t));
+        }
+        if (blockproplist[k].LamType>2)
+        {
+            meshele[i].mu1 = 1;
+            meshele[i].mu2 = 1;
+        }
 
-                for (j = 0,X = 0; j<3; j++)
-                {
-                    X += (CComplex)(meshnode[n[j]].x + I * meshnode[n[j]].y);
-                }
-                X = X/units[LengthUnits]/3.;
-                // generate the string using boost::format
-//                    fmatter % (X.re) % (X.im) % (arg(X)*180/PI) % (abs(X)) % (labellist[El->lbl].MagDirFctn);
-                // get the created string
-//                    str = fmatter.str();
-                SNPRINTF(magbuff, sizeof magbuff, "x=%.17g\ny=%.17g\nr=x\nz=y\ntheta=%.17g\nR=%.17g\nreturn %s",
-                              (X.re) , (X.im) , (arg(X)*180/PI) , (abs(X)) , (labellist[El->lbl].MagDirFctn.c_str()));
-                str = magbuff;
-                lua_State * lua = theLua->getLuaState();
+        if (blockproplist[k].BHpoints != 0)
+        {
+            if (bIncremental != MS_LEGACY_FALSE)
+            {
+                double B, B1p, B2p, murel, muinc;
 
-                top1 = lua_gettop(lua);
+                //	Get B from previous solution
+                getPrev2DB(i, B1p, B2p);
+                B = sqrt(B1p*B1p + B2p*B2p);
 
-                lua_error_code = theLua->doString(str, femm::LuaInstance::LuaStackMode::Unsafe);
+                // look up incremental permeability and assign it to the element;
+                blockproplist[k].IncrementalPermeability(B, muinc, murel);
 
-                if(lua_error_code != 0)
+                if (B == 0)
                 {
-                    if (lua_error_code==LUA_ERRRUN)
-                        WarnMessage("Lua run Error (LUA_ERRRUN) when evaluating magnetization direction function");
-                    if (lua_error_code==LUA_ERRMEM)
-                        WarnMessage("Lua memory Error (LUA_ERRMEM) when evaluating magnetization direction function");
-                    if (lua_error_code==LUA_ERRERR)
-                        WarnMessage("Lua user error error (LUA_ERRERR) when evaluating magnetization direction function");
-                    if (lua_error_code==LUA_ERRFILE)
-                        WarnMessage("Lua file error (LUA_ERRFILE) when evaluating magnetization direction function");
-
-                    SNPRINTF(magbuff, sizeof magbuff,
-                             "Lua error occurred when evaluating:\n\"%s\"",
-                             labellist[El->lbl].MagDirFctn.c_str());
-
-                    WarnMessage (magbuff);
-
-                    return -7;
+                    meshele[i].mu1 = muinc;
+                    meshele[i].mu2 = muinc;
+                    meshele[i].v12 = 0;
                 }
-
-                top2 = lua_gettop(lua);
-
-                if (top2!=top1)
-                {
-                    str = lua_tostring(lua,-1);
-
-                    if (str.length()==0)
+                else {
+                    if (bIncremental == 1)
                     {
-                        SNPRINTF(magbuff, sizeof magbuff,
-                                 "\"%s\" does not evaluate to a numerical value",
-                                 labellist[El->lbl].MagDirFctn.c_str());
-
-                        WarnMessage (magbuff);
-
-                        return -7;
+                        // Need to actually compute B1 and B2 to build incremental permeability tensor
+                        meshele[i].mu1 = B*B*muinc*murel / (B1p*B1p*murel + B2p*B2p*muinc);
+                        meshele[i].mu2 = B*B*muinc*murel / (B1p*B1p*muinc + B2p*B2p*murel);
+                        meshele[i].v12 = -B1p*B2p*(murel - muinc) / (B*B*murel*muinc);
                     }
-                    else
-                    {
-                        t = Re(lua_tonumber(lua,-1));
+                    else {
+                        // Define "frozen permeability"
+                        meshele[i].mu1 = murel;
+                        meshele[i].mu2 = murel;
+                        meshele[i].v12 = 0;
                     }
-
-                    lua_pop(lua, 1);
-                }
-
-            }
-            for(j = 0; j<3; j++)
-            {
-                k = j+1;
-                if(k==3)
-                {
-                    k = 0;
                 }
-                // need to scale so that everything is in proper units...
-                // conversion is 0.0001
-                K = 0.0001*blockproplist[El->blk].H_c*(
-                        cos(t*PI/180.)*(meshnode[n[k]].x-meshnode[n[j]].x) +
-                        sin(t*PI/180.)*(meshnode[n[k]].y-meshnode[n[j]].y) )/2.;
-                be[j]+=K;
-                be[k]+=K;
             }
+        }
 
-//////// Nonlinear Part
+        // the stiffness of the elements with a nonlinear material is assembled in each iteration, see below
+        if ((blockproplist[El->blk].BHpoints == 0) || (bIncremental != MS_LEGACY_FALSE))
+        {
+            // combine block matrices into global matrices;
+            for (j = 0; j<3; j++)
+                for (k = 0; k<3; k++)
+                    Me[j][k]+= (Mx[j][k]/Re(El->mu2) + My[j][k]/Re(El->mu1) + Mxy[j][k] * Re(El->v12));
+        }
 
-            // update permeability for the element;
-            if (Iter==0)
+        for (j = 0; j<3; j++)
+        {
+            for (k = j; k<3; k++)
             {
-                k = meshele[i].blk;
+                L.AddTo(-Me[j][k],n[j],n[k]);
+            }
 
-                if (blockproplist[k].LamType==0)
-                {
-                    t = blockproplist[k].LamFill;
-                    meshele[i].mu1 = blockproplist[k].mu_x*t + (1.-t);
-                    meshele[i].mu2 = blockproplist[k].mu_y*t + (1.-t);
-                }
-                if (blockproplist[k].LamType==1)
-                {
-                    t = blockproplist[k].LamFill;
-                    mu = blockproplist[k].mu_x;
-                    meshele[i].mu1 = mu*t + (1.-t);
-                    meshele[i].mu2 = mu/(t + mu*(1.-t));
-                }
-                if (blockproplist[k].LamType==2)
-                {
-                    t = blockproplist[k].LamFill;
-                    mu = blockproplist[k].mu_y;
-                    meshele[i].mu2 = mu*t + (1.-t);
-                    meshele[i].mu1 = mu/(t + mu*(1.-t));
-                }
-                if (blockproplist[k].LamType>2)
-                {
-                    meshele[i].mu1 = 1;
-                    meshele[i].mu2 = 1;
-                }
+            L.b[n[j]]-=be[j];
+        }
+    });
 
-                if (blockproplist[k].BHpoints != 0)
-                {
-                    if (bIncremental == MS_LEGACY_FALSE)
-                    {
-                        // There's no previous solution.  This is a standard nonlinear problem
-                        LinearFlag = false;
-                    }
-                    else {
-                        double B1p, B2p;
+    CElementColoring nonlinearColoring;
+    nonlinearColoring.Create(NumNodes);
+    for(s = 0; s < static_cast<int>(nonlinearElements.size()); s++)
+    {
+        nonlinearColoring.Add(s, meshele[nonlinearElements[s]].p);
+    }
+    nonlinearColoring.Finish();
 
-                        // too lazy to consistently code incremental/frozen formulation for on-edge lams.
-                        // detect this condition, throw an error, and exit.
-                        if (blockproplist[k].LamType > 0)
-                        {
-                            PrintMessage("On-edge Lam Types not yet supported in\nincremental/frozen permeability problems");
-                            exit(0);
-                        }
+    if (!nonlinearElements.empty())
+    {
+        L.SaveAssembly();
+    }
 
-                        //	Get B from previous solution
-                        getPrev2DB(i, B1p, B2p);
-                        B = sqrt(B1p*B1p + B2p*B2p);
+    // assemble the system at the current solution L.V;
+    // with update set, the permeabilities and the Newton terms of the nonlinear elements are updated from L.V
+    auto assemble = [&](bool update)
+    {
+        if(update)
+        {
+            PrintMessage("Matrix Construction\n");
+            L.RestoreAssembly();
+        }
 
-                        // look up incremental permeability and assign it to the element;
-                        blockproplist[k].IncrementalPermeability(B, muinc, murel);
+        // stiffness of the elements with a nonlinear material
+        nonlinearColoring.ForEach([&](int s)
+        {
+            double Me[3][3],be[3];      // element matrices;
+            double Mx[3][3],My[3][3],Mxy[3][3],Mn[3][3];
+            double p[3],q[3];           // element shape parameters;
+            int n[3];                   // numbers of nodes for a particular element;
+            double a,K,t,B,B1,B2,mu,dv,v[3],u[3];
+            int j,k,w;
 
-                        if (B == 0)
-                        {
-                            meshele[i].mu1 = muinc;
-                            meshele[i].mu2 = muinc;
-                            meshele[i].v12 = 0;
-                        }
-                        else {
-                            if (bIncremental == 1)
-                            {
-                                // Need to actually compute B1 and B2 to build incremental permeability tensor
-                                meshele[i].mu1 = B*B*muinc*murel / (B1p*B1p*murel + B2p*B2p*muinc);
-                                meshele[i].mu2 = B*B*muinc*murel / (B1p*B1p*muinc + B2p*B2p*murel);
-                                meshele[i].v12 = -B1p*B2p*(murel - muinc) / (B*B*murel*muinc);
-                            }
-                            else {
-                                // Define "frozen permeability"
-                                meshele[i].mu1 = murel;
-                                meshele[i].mu2 = murel;
-                                meshele[i].v12 = 0;
-                            }
-                        }
-                    }
+            // zero out Me, be;
+            for(j = 0; j < 3; j++)
+            {
+                for(k = 0; k < 3; k++)
+                {
+                    Me[j][k] = 0.;
+                    Mn[j][k] = 0.;
                 }
+                be[j] = 0.;
+            }
 
+            // Determine shape parameters.
+            const int i = nonlinearElements[s];
+            femmsolver::CMElement *El = &meshele[i];
+            for(k = 0; k<3; k++)
+            {
+                n[k] = El->p[k];
             }
-            else
+            shapes.Get(i, p, q, a);
+
+            // x-, y- and xy-contributions, from the batch;
+            shapes.GetPlanarMatrices(i, Mx, My, Mxy);
+
+            if (update)
             {
                 k = meshele[i].blk;
 
@@ -813,7 +756,7 @@ int FSolver::Static2D(CBigLinProb &L)
 
                 L.b[n[j]]-=be[j];
             }
-        }
+        });
 
         // add in contribution from point currents;
         for(i = 0; i<NumNodes; i++)
@@ -939,23 +882,43 @@ int FSolver::Static2D(CBigLinProb &L)
             }
         }
 
+    };
+
+    // Newton iteration:
+    //  - each step is damped by a backtracking line search on the norm of the residual (Armijo rule),
+    //    and the system assembled at the accepted point is the one solved in the next step;
+    //  - the linear systems are only solved as accurately as the progress of the iteration warrants
+    //    (forcing terms of Eisenstat and Walker, choice 2);
+    //  - while the residual drops quickly, the preconditioner or factorization of the previous step is kept;
+    //  - once the residual drops quickly, the step that would only confirm convergence is skipped.
+    std::vector<double> dV(NumNodes);
+    double resNorm = 0;         // residual norm at the current solution
+    double lastResNorm = 0;     // residual norm at the previous solution
+    double eta = 0;             // relative tolerance of the next linear solve; 0 for full precision
+    bool reuse = false;         // reuse the preconditioner of the previous step
+
+    assemble(false);
+    do
+    {
         // solve the problem;
         for(j=0;j<NumNodes;j++)
         {
             V_old[j]=L.V[j];
         }
 
-        if (L.PCGSolve(Iter)==false)
+        L.ForcingTerm = eta;
+        L.ReusePC = reuse;
+        if (L.Solve(Iter)==false)
         {
             return false;
         }
 
         if (LinearFlag==false)
         {
-
             for(j = 0,x = 0,y = 0; j<NumNodes; j++)
             {
-                x+=(L.V[j]-V_old[j])*(L.V[j]-V_old[j]);
+                dV[j] = L.V[j]-V_old[j];
+                x+=dV[j]*dV[j];
                 y+=(L.V[j]*L.V[j]);
             }
 
@@ -965,49 +928,79 @@ int FSolver::Static2D(CBigLinProb &L)
             }
             else
             {
-                lastres = res;
                 res = sqrt(x/y);
             }
+        }
 
+        // nonlinear iteration has to have a looser tolerance
+        // than the linear solver--otherwise, things can't ever
+        // converge.  Arbitrarily choose 100*tolerance.
+        if((res<100.*Precision) && (Iter>0))
+        {
+            LinearFlag = true;
+        }
 
-            // relaxation if we need it
-            if(Iter>5)
+        if (LinearFlag==false)
+        {
+            // line search; the first solution only provides the starting point of the Newton iteration
+            double trialNorm;
+            Relax = 1.;
+            while (true)
             {
-                if ((res>lastres) && (Relax>0.125))
-                {
-                    Relax/=2.;
-                }
-                else
+                assemble(true);
+                trialNorm = L.ResidualNorm();
+                if ((Iter==0) || (trialNorm<=(1.-1.e-4*Relax)*resNorm) || (Relax<=0.125))
                 {
-                    Relax+= 0.1 * (1. - Relax);
+                    break;
                 }
 
+                Relax/=2.;
                 for(j = 0; j<NumNodes; j++)
                 {
-                    L.V[j] = Relax*L.V[j]+(1.0-Relax)*V_old[j];
+                    L.V[j] = V_old[j]+Relax*dV[j];
                 }
             }
+            lastResNorm = resNorm;
+            resNorm = trialNorm;
 
+            // the next update is about as much smaller than the last one as the residual dropped in this step;
+            // if that estimate is well below the stopping tolerance, the next step would only confirm convergence
+            if ((Iter>1) && (Relax==1.) && (resNorm<0.1*lastResNorm) && (res*resNorm/lastResNorm<10.*Precision))
+            {
+                LinearFlag = true;
+            }
 
-            // report some results
-            char outstr[256];
-            sprintf(outstr,"Newton Iteration(%i) Relax=%.4g\n",Iter,Relax);
-            PrintMessage(outstr);
-//        TheView->SetDlgItemText(IDC_FRAME2,outstr);
-            j = (int)  (100.*log10(res)/(log10(Precision)+2.));
-            if (j>100)
+            if (Iter==0)
             {
-                j = 100;
+                // the iteration stops on the size of the update (see above),
+                // so a first step that is less accurate than that only adds iterations at the end
+                eta = 100.*Precision;
+                reuse = false;
+            }
+            else
+            {
+                // the forcing term follows the convergence rate of the residual,
+                // but it must not exceed the relative size of the last update,
+                // or the inexact steps keep the update from dropping below the stopping tolerance
+                double ratio = (lastResNorm>0) ? resNorm/lastResNorm : 0.;
+                eta = 0.9*ratio*ratio;
+                if (eta>10.*res)
+                {
+                    eta = 10.*res;
+                }
+                if (eta>0.1)
+                {
+                    eta = 0.1;
+                }
+                // only keep the preconditioner (or the factorization) once the iteration converges quadratically;
+                // an older one costs more PCG iterations, and a chord step of the direct solver more outer iterations
+                reuse = (Relax==1.) && (ratio<0.01);
             }
-//        TheView->m_prog2.SetPos(j);
-        }
 
-        // nonlinear iteration has to have a looser tolerance
-        // than the linear solver--otherwise, things can't ever
-        // converge.  Arbitrarily choose 100*tolerance.
-        if((res<100.*Precision) && (Iter>0))
-        {
-            LinearFlag = true;
+            // report some results
+            char outstr[256];
+            sprintf(outstr,"Newton Iteration(%i) Relax=%.4g Residual=%.4g\n",Iter,Relax,resNorm);
+            PrintMessage(outstr);
         }
 
         Iter++;
@@ -1015,6 +1008,9 @@ int FSolver::Static2D(CBigLinProb &L)
     }
     while(LinearFlag==false);
 
+    L.ForcingTerm = 0;
+    L.ReusePC = false;
+
     for(i = 0; i<NumNodes; i++)
     {
         L.b[i] = L.V[i]*c;    // convert answer to Amps
@@ -1068,45 +1064,39 @@ int FSolver::WriteStatic2D(CBigLinProb &L)
         return false;
     }
 
-    while(fgets(c,1024,fz)!=NULL)
-    {
-        fputs(c,fp);
-    }
-
+    femm::CTextWriter out(fp);
+    out.copyFrom(fz);
     fclose(fz);
 
     // then print out node, line, and element information
-    fprintf(fp,"[Solution]\n");
+    out << "[Solution]\n";
 
     cf = unitconv[LengthUnits];
 
-    fprintf(fp,"%i\n",NumNodes);
+    out << NumNodes << '\n';
 
-    for(i = 0; i<NumNodes; i++)
-    {
-        fprintf( fp, "%.17g\t%.17g\t%.17g\t%i",
-                 meshnode[i].x/cf,
-                 meshnode[i].y/cf,
-                 L.b[i],
-                 meshnode[i].BoundaryMarker );
+    out.writeRecords(NumNodes, [&](femm::CTextWriter &w, int i) {
+        w << meshnode[i].x/cf << '\t'
+          << meshnode[i].y/cf << '\t'
+          << L.b[i] << '\t'
+          << meshnode[i].BoundaryMarker;
 
         // include A from previous solution if this is an incremental permeability problem
-		if (!Aprev.empty ())
+        if (!Aprev.empty ())
         {
-            fprintf(fp, "%.17g\n", Aprev[i]);
+            w << Aprev[i] << '\n';
         }
-		else
+        else
         {
-            fprintf(fp, "\n");
+            w << '\n';
         }
-    }
+    });
 
-    fprintf(fp,"%i\n",NumEls);
+    out << NumEls << '\n';
 
-    for(i = 0; i<NumEls; i++)
-    {
-        fprintf(fp,"%i\t%i\t%i\t%i\n",meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl);
-    }
+    out.writeRecords(NumEls, [&](femm::CTextWriter &w, int i) {
+        w << meshele[i].p[0] << '\t' << meshele[i].p[1] << '\t' << meshele[i].p[2] << '\t' << meshele[i].lbl << '\n';
+    });
 
     /*
     	// print out circuit info
@@ -1120,7 +1110,7 @@ int FSolver::WriteStatic2D(CBigLinProb &L)
     */
 
     // print out circuit info on a blocklabel by blocklabel basis;
-    fprintf(fp,"%i\n",NumBlockLabels);
+    out << NumBlockLabels << '\n';
 
     for(k = 0; k<NumBlockLabels; k++)
     {
@@ -1131,66 +1121,95 @@ int FSolver::WriteStatic2D(CBigLinProb &L)
             // print out some "dummy" propeties that say that
             // there is a fixed additional current density,
             // but that that additional current density is zero.
-            fprintf(fp,"1\t0\n");
+            out << "1\t0\n";
         }
         else
         {
             if (circproplist[i].Case==0)
             {
-                fprintf(fp,"0\t%.17g\n",circproplist[i].dV.Re());
+                out << "0\t" << circproplist[i].dV.Re() << '\n';
             }
 
             if (circproplist[i].Case==1)
             {
-                fprintf(fp,"1\t%.17g\n",circproplist[i].J.Re());
+                out << "1\t" << circproplist[i].J.Re() << '\n';
             }
         }
     }
 
 	// print out information on periodic boundary conditions for
 	// possible re-use in AC incremental permeability solutions
-	fprintf(fp,"%i\n",NumPBCs);
+	out << NumPBCs << '\n';
 	for(k=0;k<NumPBCs;k++)
     {
-        fprintf(fp,"%i\t%i\t%i\n",pbclist[k].x,pbclist[k].y,pbclist[k].t);
+        out << pbclist[k].x << '\t' << pbclist[k].y << '\t' << pbclist[k].t << '\n';
     }
 
     // print out information on periodic boundary conditions for
 	// possible re-use in AC incremental permeability solutions
 	// and in post-processing of forces and torques
-	fprintf(fp,"%i\n",NumAirGapElems);
+	out << NumAirGapElems << '\n';
 	for(i=0;i<NumAirGapElems;i++)
     {
-		fprintf(fp,"%s",agelist[i].BdryName.c_str ());
-
-		fprintf( fp,"%i %.17g %.17g %.17g %.17g %.17g %.17g %.17g %i %.17g %.17g\n",
-                 agelist[i].BdryFormat,
-                 agelist[i].InnerAngle,
-                 agelist[i].OuterAngle,
-                 agelist[i].ri,
-                 agelist[i].ro,
-                 agelist[i].totalArcLength,
-                 agelist[i].agc.re,
-                 agelist[i].agc.im,
-                 agelist[i].totalArcElements,
-                 agelist[i].InnerShift,
-                 agelist[i].OuterShift );
+		out << agelist[i].BdryName;
+
+		out << agelist[i].BdryFormat << ' '
+            << agelist[i].InnerAngle << ' '
+            << agelist[i].OuterAngle << ' '
+            << agelist[i].ri << ' '
+            << agelist[i].ro << ' '
+            << agelist[i].totalArcLength << ' '
+            << agelist[i].agc.re << ' '
+            << agelist[i].agc.im << ' '
+            << agelist[i].totalArcElements << ' '
+            << agelist[i].InnerShift << ' '
+            << agelist[i].OuterShift << '\n';
 
 		for(k=0;k<=agelist[i].totalArcElements;k++)
 		{
-			fprintf( fp,"%i %.17g %i %.17g %i %.17g %i %.17g\n",
-                     agelist[i].quadNode[k].n0,
-                     agelist[i].quadNode[k].w0,
-                     agelist[i].quadNode[k].n1,
-                     agelist[i].quadNode[k].w1,
-                     agelist[i].quadNode[k].n2,
-                     agelist[i].quadNode[k].w2,
-                     agelist[i].quadNode[k].n3,
-                     agelist[i].quadNode[k].w3 );
+			const femm::CQuadPoint &qp = agelist[i].quadNode[k];
+			out << qp.n0 << ' ' << qp.w0 << ' '
+                << qp.n1 << ' ' << qp.w1 << ' '
+                << qp.n2 << ' ' << qp.w2 << ' '
+                << qp.n3 << ' ' << qp.w3 << '\n';
 		}
 	}
 
-    fclose(fp);
+    bool written = out.flush();
+    if (fclose(fp)!=0 || !written)
+    {
+        sprintf(msgbuff,"Couldn't write to %s.ans\n",PathName.c_str());
+        WarnMessage(msgbuff);
+        return false;
+    }
     return true;
 }
 
+void FSolver::StoreStatic2D(CBigLinProb &L)
+{
+    solution = newSolution();
+    for(int i = 0; i<NumNodes; i++)
+    {
+        solution->nodes[i].A = L.b[i];
+    }
+
+    // circuit info on a blocklabel by blocklabel basis, see WriteStatic2D()
+    solution->circuits.resize(NumBlockLabels);
+    for(int k = 0; k<NumBlockLabels; k++)
+    {
+        femm::CMSolution::Circuit &circ = solution->circuits[k];
+        int i = labellist[k].InCircuit;
+        circ.Case = 1;
+        circ.value = 0;
+        if (i<0)
+            continue;
+        if (circproplist[i].Case==0)
+        {
+            circ.Case = 0;
+            circ.value = circproplist[i].dV.Re();
+        }
+        if (circproplist[i].Case==1)
+            circ.value = circproplist[i].J.Re();
+    }
+}
+
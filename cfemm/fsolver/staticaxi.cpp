@@ -20,11 +20,11 @@
 */
 
 #include "CElement.h"
+#include "coloring.h"
+#include "triangleshapes.h"
 #include "femmcomplex.h"
 #include "femmconstants.h"
 #include "fsolver.h"
-#include "lua.h"
-#include "LuaInstance.h"
 #include "spars.h"
 
 #include <cstdio>
@@ -32,30 +32,18 @@
 #include <math.h>
 #include <string>
 
-#ifdef _WIN32
-  #ifndef SNPRINTF
-  #define SNPRINTF _snprintf
-  #endif
-#else
-  #ifndef SNPRINTF
-  #define SNPRINTF std::snprintf
-  #endif
-#endif
-
 int FSolver::StaticAxisymmetric(CBigLinProb &L)
 {
-    int i,j,k,s,w;
-    double Me[3][3],Mx[3][3],My[3][3],Mxy[3][3],Mn[3][3];
-    double l[3],p[3]={0.,0.,0.},q[3]={0.,0.,0.},g[3],be[3],u[3],v[3],res,lastres=0.,dv,vol;
+    int i,j,k,s;
+    double p[3]={0.,0.,0.},q[3]={0.,0.,0.},res,lastres=0.;
     int n[3] = { 0, 0, 0}; // numbers of nodes for a particular element;
-    double a,K,r,t=0.,x,y,B,mu,R,rn[3],a_hat,R_hat=0.,Cduct;
+    double a,r,t=0.,x,y,Cduct;
     double c=PI*4.e-05;
     double units[]= {2.54,0.1,1.,100.,0.00254,1.e-04};
     double *V_old=NULL,*CircInt1=NULL,*CircInt2=NULL,*CircInt3=NULL;
-    int flag,Iter=0;
+    int Iter=0;
     int LinearFlag=true;
     int bIncremental = 0;
-	double murel, muinc;
 
 	if (!previousSolutionFile.empty()) bIncremental = PrevType;
 
@@ -64,6 +52,10 @@ int FSolver::StaticAxisymmetric(CBigLinProb &L)
     femmsolver::CMElement *El;
     V_old=(double *) calloc(NumNodes,sizeof(double));
 
+    // shape parameters of all elements
+    CTriangleShapes shapes;
+    shapes.Create(meshnode.data(),NumNodes,meshele);
+
     for(i=0; i<NumBlockLabels; i++) GetFillFactor(i);
 
     extRo*=units[LengthUnits];
@@ -85,13 +77,7 @@ int FSolver::StaticAxisymmetric(CBigLinProb &L)
 
                     // get element area;
                     for(k=0; k<3; k++) n[k]=El->p[k];
-                    p[0]=meshnode[n[1]].y - meshnode[n[2]].y;
-                    p[1]=meshnode[n[2]].y - meshnode[n[0]].y;
-                    p[2]=meshnode[n[0]].y - meshnode[n[1]].y;
-                    q[0]=meshnode[n[2]].x - meshnode[n[1]].x;
-                    q[1]=meshnode[n[0]].x - meshnode[n[2]].x;
-                    q[2]=meshnode[n[1]].x - meshnode[n[0]].x;
-                    a=(p[0]*q[1]-p[1]*q[0])/2.;
+                    shapes.Get(i,p,q,a);
                     r=(meshnode[n[0]].x+meshnode[n[1]].x+meshnode[n[2]].x)/3.;
 
                     // if coils are wound, they act like they have
@@ -143,6 +129,38 @@ int FSolver::StaticAxisymmetric(CBigLinProb &L)
 
     // build element matrices using the matrices derived in Allaire's book.
 
+    // Lua magnetization directions and the bookkeeping of the nonlinear elements
+    // are done up front, so that the elements can be assembled in parallel.
+    for(i=0; i<NumEls; i++)
+    {
+        k=meshele[i].blk;
+        if (blockproplist[k].BHpoints == 0)
+            continue;
+
+        if (bIncremental == 0)
+        {
+            // There's no previous solution.  This is a standard nonlinear problem
+            LinearFlag = 0;
+        }
+        else if (blockproplist[k].LamType > 0)
+        {
+            // too lazy to consistently code incremental/frozen formulation for on-edge lams.
+            // detect this condition, throw an error, and exit.
+            PrintMessage("On-edge Lam Types not yet supported in incremental/frozen permeability problems");
+            exit(0);
+        }
+    }
+
+    std::vector<double> magdir;
+    if (!GetMagDirections(magdir)) return -7;
+
+    // elements of the same color do not share nodes,
+    // so that they can add to the matrix concurrently.
+    CElementColoring coloring;
+    coloring.Create(NumNodes);
+    for(i=0; i<NumEls; i++) coloring.Add(i,meshele[i].p);
+    coloring.Finish();
+
     do
     {
 
@@ -153,8 +171,14 @@ int FSolver::StaticAxisymmetric(CBigLinProb &L)
 
         if(Iter>0) L.Wipe();
 
-        for(i=0; i<NumEls; i++)
+        coloring.ForEach([&](int i)
         {
+            double Me[3][3],Mx[3][3],My[3][3],Mxy[3][3],Mn[3][3];
+            double l[3],p[3],q[3],g[3],be[3],u[3],v[3],dv,vol;
+            int n[3]; // numbers of nodes for a particular element;
+            double a,K,r,t=0.,B,mu,R,rn[3],a_hat,R_hat=0.;
+            int j,k,w,flag;
+
 
 //            // update ``building matrix'' progress bar...
 //            j=(i*20)/NumEls+1;
@@ -184,7 +208,7 @@ int FSolver::StaticAxisymmetric(CBigLinProb &L)
             // l == element side lengths;
             // p corresponds to the `b' parameter in Allaire
             // q corresponds to the `c' parameter in Allaire
-            El=&meshele[i];
+            femmsolver::CMElement *El=&meshele[i];
 
             for(k=0; k<3; k++)
             {
@@ -192,24 +216,11 @@ int FSolver::StaticAxisymmetric(CBigLinProb &L)
                 rn[k]=meshnode[n[k]].x;
             }
 
-            p[0]=meshnode[n[1]].y - meshnode[n[2]].y;
-            p[1]=meshnode[n[2]].y - meshnode[n[0]].y;
-            p[2]=meshnode[n[0]].y - meshnode[n[1]].y;
-            q[0]=meshnode[n[2]].x - meshnode[n[1]].x;
-            q[1]=meshnode[n[0]].x - meshnode[n[2]].x;
-            q[2]=meshnode[n[1]].x - meshnode[n[0]].x;
+            shapes.Get(i,p,q,a);
             g[0]=(meshnode[n[2]].x + meshnode[n[1]].x)/2.;
             g[1]=(meshnode[n[0]].x + meshnode[n[2]].x)/2.;
             g[2]=(meshnode[n[1]].x + meshnode[n[0]].x)/2.;
-
-            for(j=0,k=1; j<3; k++,j++)
-            {
-                if (k==3) k=0;
-                l[j]=sqrt( pow(meshnode[n[k]].x-meshnode[n[j]].x,2.) +
-                           pow(meshnode[n[k]].y-meshnode[n[j]].y,2.) );
-            }
-
-            a=(p[0]*q[1]-p[1]*q[0])/2.;
+            shapes.GetSides(i,l);
             R=(meshnode[n[0]].x+meshnode[n[1]].x+meshnode[n[2]].x)/3.;
 
             for(j=0,a_hat=0; j<3; j++) a_hat+=(rn[j]*rn[j]*p[j]/(4.*R));
@@ -348,68 +359,7 @@ int FSolver::StaticAxisymmetric(CBigLinProb &L)
             }
 
             // contribution to be from magnetization in the block;
-            t=labellist[El->lbl].MagDir;
-            // create the formatter object in case of a lua defined mag direction
-//                boost::format fmatter("r=%.17g\nz=%.17g\nx=r\ny=z\ntheta=%.17g\nR=%.17g\nreturn %s");
-            if (!labellist[El->lbl].MagDirFctn.empty()) // functional magnetization direction
-            {
-                char magbuff[4096];
-                std::string str;
-                CComplex X;
-                int top1,top2;
-                for (j=0,X=0; j<3; j++) X+=(meshnode[n[j]].x + I*meshnode[n[j]].y);
-                X=X/units[LengthUnits]/3.;
-                // generate the string using boost::format
-//                    fmatter % (X.re) % (X.im) % (arg(X)*180/PI) % (abs(X)) % (labellist[El->lbl].MagDirFctn);
-                // get the created string
-//                    str = fmatter.str();
-                SNPRINTF(magbuff, sizeof magbuff, "r=%.17g\nz=%.17g\nx=r\ny=z\ntheta=%.17g\nR=%.17g\nreturn %s",
-                             (X.re) , (X.im) , (arg(X)*180/PI) , (abs(X)) , (labellist[El->lbl].MagDirFctn.c_str()));
-                str = magbuff;
-
-                lua_State *lua = theLua->getLuaState();
-
-                top1=lua_gettop(lua);
-
-                int lua_error_code = theLua->doString(str, femm::LuaInstance::LuaStackMode::Unsafe);
-
-                if(lua_error_code != 0)
-                {
-                    if (lua_error_code==LUA_ERRRUN)
-                        WarnMessage("Lua run Error (LUA_ERRRUN) when evaluating magnetization direction function");
-                    if (lua_error_code==LUA_ERRMEM)
-                        WarnMessage("Lua memory Error (LUA_ERRMEM) when evaluating magnetization direction function");
-                    if (lua_error_code==LUA_ERRERR)
-                        WarnMessage("Lua user error error (LUA_ERRERR) when evaluating magnetization direction function");
-                    if (lua_error_code==LUA_ERRFILE)
-                        WarnMessage("Lua file error (LUA_ERRFILE) when evaluating magnetization direction function");
-
-                    SNPRINTF(magbuff, sizeof magbuff,
-                             "Lua error occurred when evaluating:\n\"%s\"",
-                             labellist[El->lbl].MagDirFctn.c_str());
-
-                    WarnMessage(magbuff);
-
-                    return -7;
-                }
-
-                top2=lua_gettop(lua);
-                if (top2!=top1)
-                {
-                    str=lua_tostring(lua,-1);
-                    if (str.length()==0)
-                    {
-                        SNPRINTF(magbuff, sizeof magbuff,
-                                 "\"%s\" does not evaluate to a numerical value",
-                                 labellist[El->lbl].MagDirFctn.c_str());
-
-                        WarnMessage (magbuff);
-
-                        return -7;
-                    }
-                    else t=Re(lua_tonumber(lua,-1));
-                }
-            }
+            t=magdir[i];
             for(j=0; j<3; j++)
             {
                 k=j+1;
@@ -453,21 +403,9 @@ int FSolver::StaticAxisymmetric(CBigLinProb &L)
 
                 if (blockproplist[k].BHpoints != 0)
                 {
-                    if (bIncremental == 0)
+                    if (bIncremental != 0)
                     {
-                        // There's no previous solution.  This is a standard nonlinear problem
-                        LinearFlag = 0;
-                    }
-                    else {
-                        double B1p, B2p;
-
-                        // too lazy to consistently code incremental/frozen formulation for on-edge lams.
-                        // detect this condition, throw an error, and exit.
-                        if (blockproplist[k].LamType > 0)
-                        {
-                            PrintMessage("On-edge Lam Types not yet supported in incremental/frozen permeability problems");
-                            exit(0);
-                        }
+                        double B1p, B2p, murel, muinc;
 
                         //	Get B from previous solution
                         getPrevAxiB(i,B1p,B2p);
@@ -627,10 +565,10 @@ int FSolver::StaticAxisymmetric(CBigLinProb &L)
             for (j=0; j<3; j++)
             {
                 for (k=j; k<3; k++)
-                    L.Put(L.Get(n[j],n[k])-Me[j][k],n[j],n[k]);
+                    L.AddTo(-Me[j][k],n[j],n[k]);
                 L.b[n[j]]-=be[j];
             }
-        }
+        });
 
         // add in contribution from point currents;
         for(i=0; i<NumNodes; i++)
@@ -726,7 +664,7 @@ int FSolver::StaticAxisymmetric(CBigLinProb &L)
 
         // solve the problem;
         for(j=0;j<NumNodes;j++) V_old[j]=L.V[j];
-        if (L.PCGSolve(Iter)==false) return false;
+        if (L.Solve(Iter)==false) return false;
 
         if (LinearFlag==false)
         {
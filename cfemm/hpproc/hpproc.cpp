@@ -837,6 +837,74 @@ ParserResult HPProc::parseSolution(std::istream &input, std::ostream &err)
     return femm::F_FILE_OK;
 }
 
+ParserResult HPProc::parseBinarySolution(const femm::CSolutionFile &solution, std::ostream &err)
+{
+    using femmsolver::CHMeshNode;
+    using femmsolver::CHSElement;
+
+    size_t numNodes, numElements, n;
+    // mesh nodes
+    const femm::SolutionNode *nodes = solution.section<femm::SolutionNode>(femm::SolutionSection::Nodes, numNodes);
+    const double *potentials = solution.section<double>(femm::SolutionSection::Potentials, n);
+    if (!nodes || !potentials || n!=numNodes)
+    {
+        err << "The binary solution contains no mesh nodes or no temperatures.\n";
+        return femm::F_FILE_MALFORMED;
+    }
+    meshnodes.reserve(numNodes);
+    for(size_t i=0;i<numNodes;i++)
+    {
+        std::unique_ptr<CHMeshNode> node = MAKE_UNIQUE<CHMeshNode>();
+        node->x = nodes[i].x;
+        node->y = nodes[i].y;
+        node->T = potentials[i];
+        node->Q = nodes[i].marker;
+        meshnodes.push_back(std::move(node));
+    }
+
+    // elements
+    const femm::SolutionElement *elements = solution.section<femm::SolutionElement>(femm::SolutionSection::Elements, numElements);
+    if (!elements)
+    {
+        err << "The binary solution contains no mesh elements.\n";
+        return femm::F_FILE_MALFORMED;
+    }
+    meshelems.reserve(numElements);
+    auto &labellist = problem->labellist;
+    for(size_t i=0;i<numElements;i++)
+    {
+        CHSElement elm;
+        for (int j=0; j<3; j++)
+            elm.p[j] = elements[i].p[j];
+        elm.lbl = elements[i].lbl;
+        if (elm.p[0]<0 || elm.p[1]<0 || elm.p[2]<0
+                || elm.p[0]>=(int)numNodes || elm.p[1]>=(int)numNodes || elm.p[2]>=(int)numNodes)
+        {
+            err << "The binary solution contains an element with an invalid node.\n";
+            return femm::F_FILE_MALFORMED;
+        }
+        if (elm.lbl<0 || elm.lbl>=(int)labellist.size())
+        {
+            err << "The binary solution contains an element with an invalid block label.\n";
+            return femm::F_FILE_MALFORMED;
+        }
+        elm.blk = labellist[elm.lbl]->BlockType;
+        meshelems.push_back(MAKE_UNIQUE<CHSElement>(elm));
+    }
+
+    // circuit data
+    auto &circproplist = problem->circproplist;
+    const femm::SolutionCircuit *circuits = solution.section<femm::SolutionCircuit>(femm::SolutionSection::Circuits, n);
+    for(size_t i=0;i<n && i<circproplist.size();i++)
+    {
+        auto circuit = reinterpret_cast<CHConductor*>(circproplist[i].get());
+        // partially overwrite circuit data:
+        circuit->V = circuits[i].value[0];
+        circuit->q = circuits[i].value[1];
+    }
+    return femm::F_FILE_OK;
+}
+
 double HPProc::getA_High() const
 {
     return A_High;
@@ -69,6 +69,7 @@ public:
 
     bool OpenDocument(std::string solutionFile) override;
     femm::ParserResult parseSolution( std::istream &input, std::ostream &err = std::cerr ) override;
+    femm::ParserResult parseBinarySolution( const femm::CSolutionFile &solution, std::ostream &err = std::cerr ) override;
 
 protected:
     // General problem attributes
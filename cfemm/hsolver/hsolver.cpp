@@ -36,13 +36,21 @@
 #include "femmconstants.h"
 #include "spars.h"
 #include "fparse.h"
+#include "coloring.h"
+#include "triangleshapes.h"
 #include "hsolver.h"
+#include "meshdata.h"
+#include "solutionfile.h"
+#include "textwriter.h"
 
+#include <algorithm>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <cstring>
+#include <functional>
 #include <malloc.h>
+#include <vector>
 
 // template instantiation:
 #include "../libfemm/feasolver.cpp"
@@ -77,8 +85,16 @@ using namespace femm;
 // HSolver construction/destruction
 
 HSolver::HSolver()
-    : meshnode(nullptr)
+    : dT(0)
+    , TimeSteps(0)
+    , TimeScheme(TIME_EULER)
+    , TimeTolerance(0)
+    , OutputInterval(0)
+    , TimeSeries(0)
+    , InitialTemperature(0)
+    , meshnode(nullptr)
     , Tprev(nullptr)
+    , TimeSeriesFile(nullptr)
 {
 
     // initialise the warning message box function pointer to
@@ -106,6 +122,11 @@ void HSolver::CleanUp()
         delete[] Tprev;
         Tprev = nullptr;
     }
+    if (TimeSeriesFile)
+    {
+        fclose(TimeSeriesFile);
+        TimeSeriesFile = nullptr;
+    }
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -126,8 +147,20 @@ bool HSolver::LoadProblemFile ()
 
 int HSolver::LoadPrev()
 {
+    if ((TimeSteps>0) && (dT==0))
+    {
+        TimeSteps = 0;
+        WarnMessage("Warning: time stepping needs a non-zero dT. Solving the steady state problem...\n");
+    }
     if (previousSolutionFile.empty())
     {
+        if (TimeSteps>0)
+        {
+            // start the time stepping at a uniform temperature
+            Tprev=new double[NumNodes];
+            for(int k=0;k<NumNodes;k++) Tprev[k]=InitialTemperature;
+            return true;
+        }
         if (dT!=0)
         {
             dT = 0;
@@ -155,6 +188,10 @@ int HSolver::LoadPrev()
 			k=1;
 			break;
 		}
+		if( _strnicmp(q,"[binarysolution]",16)==0){
+			WarnMessage("Previous solution files in the binary format are not supported\n");
+			break;
+		}
 	}
 
 	// case where the solution is never found.
@@ -188,28 +225,31 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 {
 	int i,j,k,q,n0,n1,n;
 	char infile[256];
-	FILE *fp;
-	char s[1024];
     double c[]={0.0254,0.001,0.01,1,2.54e-5,1.e-6};
 
 
-	//read meshnodes;
-	sprintf(infile,"%s.node",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL){
-		return BADELEMENTFILE;
+	// use the triangulation handed over by the mesher, or read the mesh files
+	femm::CMeshData fileMesh;
+	const femm::CMeshData *mesh = meshData.get();
+	if (!mesh)
+	{
+		LoadMeshErr err = fileMesh.readFiles(PathName);
+		if (err != NOERROR)
+			return err;
+		mesh = &fileMesh;
 	}
-	fgets(s,1024,fp);
-	sscanf(s,"%i",&k);
+
+	//read meshnodes;
+	k = (int) mesh->nodes.size();
 	NumNodes = k;
 
     meshnode = new CNode[k];
     CNode node;
 	for(i = 0; i < k; i++)
 	{
-		fscanf(fp,"%i",&j);
-		fscanf(fp,"%lf",&node.x);
-		fscanf(fp,"%lf",&node.y);
-		fscanf(fp,"%i",&n);
+		node.x = mesh->nodes[i].x;
+		node.y = mesh->nodes[i].y;
+		n = mesh->nodes[i].marker;
 
 		if (n > 1)
 		{
@@ -238,35 +278,14 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 
 		meshnode[i] = node;
 	}
-	fclose(fp);
 
 	//read in periodic boundary conditions;
-	sprintf(infile,"%s.pbc",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL){
-		return BADPBCFILE;
-	}
-	fgets(s,1024,fp);
-	sscanf(s,"%i",&k);
-	NumPBCs=k;
-
-    if (k!=0) pbclist.reserve(k);
-	CCommonPoint pbc;
-	for(i=0;i<k;i++){
-		fscanf(fp,"%i",&j);
-		fscanf(fp,"%i",&pbc.x);
-		fscanf(fp,"%i",&pbc.y);
-		fscanf(fp,"%i",&pbc.t);
-        pbclist.push_back(pbc);
-	}
-	fclose(fp);
+	NumPBCs = (int) mesh->pbcs.size();
+	pbclist = mesh->pbcs;
 
 	// read in elements;
-	sprintf(infile,"%s.ele",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL){
-		return BADELEMENTFILE;
-	}
-	fgets(s,1024,fp);
-	sscanf(s,"%i",&k); NumEls=k;
+	k = (int) mesh->elements.size();
+	NumEls = k;
 
     meshele.reserve(k);
     femmsolver::CElement elm;
@@ -276,11 +295,10 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 		if (labellist[i].IsDefault) defaultLabel=i;
 
 	for(i=0;i<k;i++){
-		fscanf(fp,"%i",&j);
-		fscanf(fp,"%i",&elm.p[0]);
-		fscanf(fp,"%i",&elm.p[1]);
-		fscanf(fp,"%i",&elm.p[2]);
-		fscanf(fp,"%i",&elm.lbl);
+		elm.p[0] = mesh->elements[i].p[0];
+		elm.p[1] = mesh->elements[i].p[1];
+		elm.p[2] = mesh->elements[i].p[2];
+		elm.lbl = mesh->elements[i].label;
 		elm.lbl--;
 		if(elm.lbl<0) elm.lbl=defaultLabel;
 		if(elm.lbl<0){
@@ -289,7 +307,6 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
             msg += "button to highlight the problem regions.";
             WarnMessage(msg.c_str());
 
-			fclose(fp);
             if (deleteFiles)
             {
                 sprintf(infile,"%s.ele",PathName.c_str());
@@ -310,7 +327,6 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 
         meshele.push_back(elm);
 	}
-	fclose(fp);
 
 	// initialize edge bc's and element permeabilities;
 	for(i=0;i<NumEls;i++)
@@ -349,20 +365,12 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 				nmbr[k]++;
 			}
 
-	sprintf(infile,"%s.edge",PathName.c_str());
-	if((fp=fopen(infile,"rt"))==NULL)
-	{
-		return BADEDGEFILE;
-	}
-	fscanf(fp,"%i",&k);	// read in number of lines
-
-	fscanf(fp,"%i",&j);	// read in boundarymarker flag;
+	k = (int) mesh->edges.size();
 	for(i=0;i<k;i++)
 	{
-		fscanf(fp,"%i",&j);
-		fscanf(fp,"%i",&n0);
-		fscanf(fp,"%i",&n1);
-		fscanf(fp,"%i",&n);
+		n0 = mesh->edges[i].n0;
+		n1 = mesh->edges[i].n1;
+		n = mesh->edges[i].marker;
 
 		// BC number;
 		if (n<0)
@@ -407,7 +415,6 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 		}
 
 	}
-	fclose(fp);
 
 	// free up the connectivity information
 	free(nmbr);
@@ -455,42 +462,273 @@ LoadMeshErr HSolver::LoadMesh(bool deleteFiles)
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+/**
+ * @brief Solve op(x)=rhs with GMRES, starting from x=0.
+ * @param op the (nonsymmetric) operator; returns \c false if it can not be applied
+ * @param tol stop when the residual dropped by this factor
+ * @param maxit maximum number of iterations, i.e. of calls to op()
+ * @param its receives the number of iterations
+ * @return \c false if op() failed; if the tolerance is not met after \p maxit iterations, x is the best approximation found.
+ */
+bool gmresSolve(int n, const std::function<bool(const double *, double *)> &op,
+				const double *rhs, double *x, double tol, int maxit, int &its)
+{
+	std::vector<std::vector<double>> V(1, std::vector<double>(rhs,rhs+n));
+	std::vector<std::vector<double>> H;
+	std::vector<double> cs, sn, g(1), w(n);
+	auto norm = [n](const double *v) {
+		double s=0;
+		for(int i=0;i<n;i++) s+=v[i]*v[i];
+		return sqrt(s);
+	};
+
+	its=0;
+	for(int i=0;i<n;i++) x[i]=0;
+	g[0]=norm(rhs);
+	const double bnorm=g[0];
+	if(bnorm==0) return true;
+	for(double &v : V[0]) v/=g[0];
+
+	int k;
+	for(k=0;k<maxit;k++)
+	{
+		if(!op(V[k].data(),w.data())) return false;
+		its++;
+
+		// modified Gram-Schmidt
+		H.push_back(std::vector<double>(k+2));
+		std::vector<double> &h=H[k];
+		for(int j=0;j<=k;j++)
+		{
+			double d=0;
+			for(int i=0;i<n;i++) d+=w[i]*V[j][i];
+			h[j]=d;
+			for(int i=0;i<n;i++) w[i]-=d*V[j][i];
+		}
+		h[k+1]=norm(w.data());
+
+		// update the QR factorization of the Hessenberg matrix
+		for(int j=0;j<k;j++)
+		{
+			double t=cs[j]*h[j]+sn[j]*h[j+1];
+			h[j+1]=-sn[j]*h[j]+cs[j]*h[j+1];
+			h[j]=t;
+		}
+		double r=sqrt(h[k]*h[k]+h[k+1]*h[k+1]);
+		cs.push_back(h[k]/r);
+		sn.push_back(h[k+1]/r);
+		double hk1=h[k+1];
+		h[k]=r;
+		h[k+1]=0;
+		g.push_back(-sn[k]*g[k]);
+		g[k]*=cs[k];
+
+		if((fabs(g[k+1])<=tol*bnorm) || (hk1==0))
+		{
+			k++;
+			break;
+		}
+		V.push_back(w);
+		for(double &v : V[k+1]) v/=hk1;
+	}
+
+	// x = V y with H y = g
+	std::vector<double> y(k);
+	for(int j=k-1;j>=0;j--)
+	{
+		double s=g[j];
+		for(int m=j+1;m<k;m++) s-=H[m][j]*y[m];
+		y[j]=s/H[j][j];
+	}
+	for(int j=0;j<k;j++)
+		for(int i=0;i<n;i++) x[i]+=y[j]*V[j][i];
+
+	return true;
+}
+
+} // namespace
+
 int HSolver::AnalyzeProblem(CBigLinProb &L)
 {
-	int i,j,k,bf,pctr=0;
-	double Me[3][3],be[3];		// element matrices;
-	double l[3],p[3],q[3];		// element shape parameters;
-	int n[3],ne[3];				// numbers of nodes for a particular element;
-	double a,K,r,z,kludge;
-	double bta,Tinf,Tlast,*Vo;
+	int i,j,k;
+	double K;
     int IsNonlinear=false;
-    femmsolver::CElement *El;
-	CComplex kn;
 	int iter=0;
 
 	Depth*=units[LengthUnits];
 	extRo*=units[LengthUnits];
 	extRi*=units[LengthUnits];
 	extZo*=units[LengthUnits];
-	kludge=1;
 
 	//TheView->SetDlgItemText(IDC_FRAME1,"Matrix Construction");
 
-	Vo=(double *) calloc(NumNodes,sizeof(double));
+	std::vector<double> Vo(L.n);
+
+	// time-transient term M (T-Tstar)/tau with the lumped mass matrix M;
+	// a single backward Euler step has tau=dT and Tstar=Tprev, see below for the time stepping.
+	if ((TimeSteps>0) && !Tprev)
+	{
+		WarnMessage("couldn't load the initial temperatures\n");
+		return false;
+	}
+	double tau=(Tprev) ? dT : 0;
+	std::vector<double> Tstar;
+	if (Tprev) Tstar.assign(Tprev,Tprev+NumNodes);
+
+	// shape parameters of all elements
+	CTriangleShapes shapes;
+	shapes.Create(meshnode,NumNodes,meshele);
 
 	// scan through the problem to see if there are any elements
-	// with a nonlinear conductivity
-	for(i=0;i<NumNodes;i++)
+	// with a nonlinear conductivity or a radiation boundary condition;
+	// these contribute to the Jacobian of the Newton iteration.
+	std::vector<int> newtonElements;
+	for(i=0;i<NumEls;i++)
+	{
+		bool nonlinear=(blockproplist[meshele[i].blk].npts>0);
+		for(j=0;j<3;j++)
+			if((meshele[i].e[j]>=0) && (lineproplist[meshele[i].e[j]].BdryFormat==3))
+				nonlinear=true;
+		if (nonlinear) newtonElements.push_back(i);
+	}
+	std::vector<char> prescribed(NumNodes);
+	std::vector<double> step(L.n), w(L.n);
+
+	// elements of the same color do not share nodes, so that they can add to the matrix concurrently.
+	// Elements with a node in a conductor of unknown voltage also add to the conductor's row,
+	// so they are assembled serially.
+	CElementColoring coloring;
+	coloring.Create(NumNodes);
+	for(i=0;i<NumEls;i++)
 	{
-		if (blockproplist[meshele[i].blk].npts>0){
-            IsNonlinear=true;
-            break;
+		bool serial=false;
+		for(j=0;j<3;j++)
+		{
+			k=meshnode[meshele[i].p[j]].InConductor;
+			if((k>=0) && (circproplist[k].CircType==0)) serial=true;
 		}
+		coloring.Add(i,meshele[i].p,serial);
 	}
+	coloring.Finish();
+
+	// rows that are not assembled from the element equations do not get a Jacobian term
+	auto isEquationRow = [&](int n)
+	{
+		if (prescribed[n]) return false;
+		int c=meshnode[n].InConductor;
+		return (c<0) || (circproplist[c].CircType!=0);
+	};
+
+	// Nv += N v, where N = (dA/dT) T - db/dT at T=Vo is the part of the Jacobian
+	// that the matrix A of the successive substitution lacks:
+	// the derivative of the mean element conductivity, and the derivative of
+	// the radiation coefficients with respect to the mean edge temperature.
+	// Returns false if nothing was added.
+	auto addJacobian = [&](const double *v, double *Nv)
+	{
+		bool nonzero=false;
+		for(int i : newtonElements)
+		{
+			double l[3],p[3],q[3];
+			double a,g,r,z,kludge=1;
+			double depth=Depth;
+			int n[3],j,k;
+
+			femmsolver::CElement *El=&meshele[i];
+			const CHMaterialProp &prop=blockproplist[El->blk];
+			for(k=0;k<3;k++) n[k]=El->p[k];
+
+			if (prop.npts>0)
+			{
+				for(k=0,g=0;k<3;k++)
+				{
+					double dKdT;
+					prop.GetK(Vo[n[k]],dKdT);
+					g+=dKdT*v[n[k]]/3.;
+				}
+				if (g!=0)
+				{
+					shapes.Get(i,p,q,a);
+					if (ProblemType==AXISYMMETRIC){
+						r=(meshnode[n[0]].x+meshnode[n[1]].x+meshnode[n[2]].x)/3.;
+						depth=2.*PI*r;
+						if(labellist[El->lbl].IsExternal)
+						{
+							z=(meshnode[n[0]].y+meshnode[n[1]].y+meshnode[n[2]].y)/3. - extZo;
+							kludge=(r*r+z*z)/(extRi*extRo);
+						}
+					}
+					for(j=0;j<3;j++)
+					{
+						if (!isEquationRow(n[j])) continue;
+						double f=0;
+						for(k=0;k<3;k++) f+=(p[j]*p[k]+q[j]*q[k])*Vo[n[k]];
+						Nv[n[j]]+=depth*f*g/(4.*a*kludge);
+						nonzero=true;
+					}
+				}
+			}
 
-	do{
+			for(j=0;j<3;j++)
+			{
+				if ((El->e[j]<0) || (lineproplist[El->e[j]].BdryFormat!=3)) continue;
+				k=j+1; if(k==3) k=0;
+
+				// c0 = 4 beta Ksb Tl^3 and c1 = -beta Ksb (Tinf^4 + 3 Tl^4) with the mean edge temperature Tl
+				double Tl=(Vo[n[j]]+Vo[n[k]])/2.;
+				g=6.*lineproplist[El->e[j]].beta*Ksb*Tl*Tl*(v[n[j]]+v[n[k]]);
+				if (g==0) continue;
+
+				// edge mass matrix times T, minus Tl times the edge load vector
+				double fj,fk;
+				shapes.GetSides(i,l);
+				if (ProblemType==AXISYMMETRIC)
+				{
+					double xj=meshnode[n[j]].x;
+					double xk=meshnode[n[k]].x;
+					fj=2.*PI*l[j]/6.*((3.*xj+xk)/2.*Vo[n[j]] + (xj+xk)/2.*Vo[n[k]]) - Tl*2.*PI*l[j]/2.*(2.*xj+xk)/3.;
+					fk=2.*PI*l[j]/6.*((xj+xk)/2.*Vo[n[j]] + (xj+3.*xk)/2.*Vo[n[k]]) - Tl*2.*PI*l[j]/2.*(xj+2.*xk)/3.;
+				}
+				else
+				{
+					fj=Depth*l[j]*(Vo[n[j]]-Vo[n[k]])/12.;
+					fk=-fj;
+				}
+				if (isEquationRow(n[j])) Nv[n[j]]+=fj*g;
+				if (isEquationRow(n[k])) Nv[n[k]]+=fk*g;
+				nonzero=true;
+			}
+		}
+
+		// same treatment of the right hand side as in CBigLinProb::Periodicity() and AntiPeriodicity()
+		for(int k=0;k<NumPBCs;k++)
+		{
+			double c;
+			int x=pbclist[k].x;
+			int y=pbclist[k].y;
+			if (pbclist[k].t==0)
+			{
+				c=(Nv[x]+Nv[y])/2.;
+				Nv[x]=c;
+				Nv[y]=c;
+			}
+			if (pbclist[k].t==1)
+			{
+				c=(Nv[x]-Nv[y])/2.;
+				Nv[x]=c;
+				Nv[y]=-c;
+			}
+		}
+		return nonzero;
+	};
+
+	// assemble the system of the successive substitution at the temperatures L.V
+	auto assemble = [&]()
+	{
 		// copy old solution
-		for(i=0;i<NumNodes;i++) Vo[i]=L.V[i];
+		for(i=0;i<L.n;i++) Vo[i]=L.V[i];
 		L.Wipe();
 
 		// do some book-keeping related to fixed boundary conditions;
@@ -531,16 +769,19 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 				}
 			}
 		}
-
+		for(i=0;i<NumNodes;i++) prescribed[i]=(L.Q[i]!=-2);
 
 		// build element matrices using the matrices derived in Allaire's book.
-		for(i=0;i<NumEls;i++)
+		coloring.ForEach([&](int i)
 		{
-			// update progress bar
-			j=5*((i*20)/NumEls);
-			if(j!=pctr){ pctr=j;
-               // TheView->m_prog1.SetPos(pctr);
-            }
+			double Me[3][3],be[3];		// element matrices;
+			double l[3],p[3],q[3];		// element shape parameters;
+			int n[3],ne[3];				// numbers of nodes for a particular element;
+			double a,K,r,z,kludge=1;
+			double bta,Tinf,Tlast;
+			double depth=Depth;
+			CComplex kn;
+			int j,k,bf;
 
 			// zero out Me, be;
 			for(j=0;j<3;j++){
@@ -552,21 +793,11 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 			// l's are element side lengths;
 			// p's corresponds to the `b' parameter in Allaire
 			// q's corresponds to the `c' parameter in Allaire
-			El=&meshele[i];
+			femmsolver::CElement *El=&meshele[i];
 
 			for(k=0;k<3;k++) n[k]=El->p[k];
-			p[0]=meshnode[n[1]].y - meshnode[n[2]].y;
-			p[1]=meshnode[n[2]].y - meshnode[n[0]].y;
-			p[2]=meshnode[n[0]].y - meshnode[n[1]].y;
-			q[0]=meshnode[n[2]].x - meshnode[n[1]].x;
-			q[1]=meshnode[n[0]].x - meshnode[n[2]].x;
-			q[2]=meshnode[n[1]].x - meshnode[n[0]].x;
-			for(j=0,k=1;j<3;k++,j++){
-				if (k==3) k=0;
-				l[j]=sqrt( sqr(meshnode[n[k]].x-meshnode[n[j]].x) +
-						   sqr(meshnode[n[k]].y-meshnode[n[j]].y) );
-			}
-			a=(p[0]*q[1]-p[1]*q[0])/2.;
+			shapes.Get(i,p,q,a);
+			shapes.GetSides(i,l);
 			r=(meshnode[n[0]].x+meshnode[n[1]].x+meshnode[n[2]].x)/3.;
 
 			// get the thermal conductivites to use for this element;
@@ -575,7 +806,7 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 				  blockproplist[El->blk].GetK(Vo[n[2]]))/3.;
 
 			if (ProblemType==AXISYMMETRIC){
-				Depth=2.*PI*r;
+				depth=2.*PI*r;
 
 				// "Warp" the permeability of this element is part of
 				// the conformally mapped external region
@@ -584,12 +815,11 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 					z=(meshnode[n[0]].y+meshnode[n[1]].y+meshnode[n[2]].y)/3. - extZo;
 					kludge=(r*r+z*z)/(extRi*extRo);
 				}
-				else kludge=1;
 			}
 
 
 			// x-contribution;
-			K = -Depth*Re(kn)/(4.*a)/kludge;
+			K = -depth*Re(kn)/(4.*a)/kludge;
 			for(j=0;j<3;j++)
 				for(k=j;k<3;k++)
 				{
@@ -598,7 +828,7 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 				}
 
 			// y-contribution;
-			K = -Depth*Im(kn)/(4.*a)/kludge;
+			K = -depth*Im(kn)/(4.*a)/kludge;
 			for(j=0;j<3;j++)
 				for(k=j;k<3;k++)
 				{
@@ -609,7 +839,7 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 			// contribution to Me and be from time-transient term
 /*			if (dT!=0)
 			{
-				K = -Depth*blockproplist[El->blk].Kt*a/(12.*dT);
+				K = -depth*blockproplist[El->blk].Kt*a/(12.*dT);
 
 				Me[0][0]+=2.*K;
 				Me[1][1]+=2.*K;
@@ -623,22 +853,22 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 				be[2]+=K*(   Tprev[n[0]] +    Tprev[n[1]] + 2.*Tprev[n[2]]);
 			} */
 
-			if (dT!=0)
+			if (tau!=0)
 			{
-				K = -Depth*blockproplist[El->blk].Kt*a/(3.*dT);
+				K = -depth*blockproplist[El->blk].Kt*a/(3.*tau);
 
 				Me[0][0]+=K;
 				Me[1][1]+=K;
 				Me[2][2]+=K;
 
-				be[0]+=K*Tprev[n[0]];
-				be[1]+=K*Tprev[n[1]];
-				be[2]+=K*Tprev[n[2]];
+				be[0]+=K*Tstar[n[0]];
+				be[1]+=K*Tstar[n[1]];
+				be[2]+=K*Tstar[n[2]];
 			}
 
 			// contribution to be[] from volume charge density
 			for(j = 0;j<3;j++){
-				K = -Depth*(blockproplist[El->blk].qv)*a/3.;
+				K = -depth*(blockproplist[El->blk].qv)*a/3.;
 				be[j]+=K;
 			}
 
@@ -650,7 +880,7 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 					k=j+1; if(k==3) k=0;
 
 					if (ProblemType==AXISYMMETRIC)
-						Depth=PI*(meshnode[n[j]].x + meshnode[n[k]].x);
+						depth=PI*(meshnode[n[j]].x + meshnode[n[k]].x);
 
 					// contributions to Me, be from derivative boundary conditions;
 					// !!! need to put in contribution here for radiation....
@@ -670,10 +900,12 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 								c1=-c0*lineproplist[El->e[j]].Tinf;
 								break;
 							case 3:
-                                IsNonlinear=true;
 								bta =lineproplist[El->e[j]].beta;
 								Tinf=lineproplist[El->e[j]].Tinf;
 								Tlast=(Vo[n[j]]+Vo[n[k]])/2.;
+								// the iteration starts at zero temperature, where radiation vanishes;
+								// the first solution is better linearized about the ambient temperature.
+								if((iter==0) && (Tlast<Tinf)) Tlast=Tinf;
 
 								c0 = 4.*bta*Ksb*pow(Tlast,3.);
 								c1 = -(bta*Ksb*(pow(Tinf,4.) + 3.*pow(Tlast,4.)));
@@ -698,13 +930,13 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 						}
 						else
 						{
-							K =-Depth*c0*l[j]/6.;
+							K =-depth*c0*l[j]/6.;
 							Me[j][j]+=K*2.;
 							Me[k][k]+=K*2.;
 							Me[j][k]+=K;
 							Me[k][j]+=K;
 
-							K = Depth*c1*l[j]/2.;
+							K = depth*c1*l[j]/2.;
 							be[j]+=K;
 							be[k]+=K;
 						}
@@ -713,7 +945,7 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 					// contribution to be[] from surface heating
 					if (lineproplist[El->e[j]].BdryFormat==2)
 					{
-						K =-Depth*lineproplist[El->e[j]].qs*l[j]/2.;
+						K =-depth*lineproplist[El->e[j]].qs*l[j]/2.;
 						be[j]+=K;
 						be[k]+=K;
 					}
@@ -748,17 +980,17 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 			}
 			for (j=0;j<3;j++){
 				for (k=j;k<3;k++)
-                L.Put(L.Get(ne[j],ne[k])-Me[j][k],ne[j],ne[k]);
+                L.AddTo(-Me[j][k],ne[j],ne[k]);
 				L.b[ne[j]]-=be[j];
 
 				if(ne[j]!=n[j])
 				{
-					L.Put(L.Get(n[j],n[j])-Me[j][j],n[j],n[j]);
-					L.Put(L.Get(n[j],ne[j])+Me[j][j],n[j],ne[j]);
+					L.AddTo(-Me[j][j],n[j],n[j]);
+					L.AddTo(Me[j][j],n[j],ne[j]);
 				}
 			}
 
-		} // end of loop that builds element matrices
+		}); // end of loop that builds element matrices
 
 		// add in contribution from point charge density;
 		for(i=0;i<NumNodes;i++)
@@ -775,7 +1007,7 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 		}
 
 		// Apply any periodicity/antiperiodicity boundary conditions that we have
-		for(k=0,pctr=0;k<NumPBCs;k++)
+		for(k=0;k<NumPBCs;k++)
 		{
 			if (pbclist[k].t==0) L.Periodicity(pbclist[k].x,pbclist[k].y);
 			if (pbclist[k].t==1) L.AntiPeriodicity(pbclist[k].x,pbclist[k].y);
@@ -806,40 +1038,236 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 
 			}
 		}
+	};
+
+	// Newton iteration, as for magnetostatic problems:
+	//  - L.V-Vo after solving the system of the successive substitution is -A^-1 R(Vo).
+	//    The Newton step solves (A+N) dT = -R(Vo), i.e. (I + A^-1 N) dT = L.V-Vo,
+	//    by GMRES with one more solution of A (same matrix, same preconditioner) per iteration;
+	//  - each step is damped by a backtracking line search on the norm of the residual (Armijo rule),
+	//    and the system assembled at the accepted point is the one solved in the next step;
+	//  - the GMRES tolerance follows the forcing terms of Eisenstat and Walker.
+	double resNorm;		// residual norm at the current solution
+	double lastResNorm;	// residual norm at the previous solution
+	double eta;			// relative tolerance of GMRES and of the solutions within GMRES
+	double Relax;
+
+	// solve for the temperatures of the current time level, starting at L.V
+	auto solve = [&]()
+	{
+		IsNonlinear=!newtonElements.empty();
+		iter=0;
+		resNorm=0;
+		lastResNorm=0;
+		eta=0.1;
+		assemble();
+		do{
+			// solve the problem;
+            if (L.Solve(iter++)==false){
+                return false;
+			}
 
-		// solve the problem;
-        if (L.PCGSolve(iter++)==false){
-			free(Vo);
-            return false;
+            if (IsNonlinear == true)
+			{
+				for(i=0;i<L.n;i++) w[i]=L.V[i]-Vo[i];
+				std::vector<double> rhs(w);
+				L.ReusePC=true;
+				L.ForcingTerm=eta;
+				auto op = [&](const double *v, double *y)
+				{
+					for(int i=0;i<L.n;i++) w[i]=0;
+					if (addJacobian(v,w.data()))
+					{
+						for(int i=0;i<L.n;i++){
+							L.b[i]=w[i];
+							L.V[i]=0;
+						}
+						if (!L.Solve(0)) return false;
+						for(int i=0;i<L.n;i++) y[i]=v[i]+L.V[i];
+					}
+					else for(int i=0;i<L.n;i++) y[i]=v[i];
+					return true;
+				};
+				int its;
+				bool ok=gmresSolve(L.n,op,rhs.data(),step.data(),eta,20,its);
+				L.ReusePC=false;
+				L.ForcingTerm=0;
+				if (!ok)
+				{
+					return false;
+				}
+				for(i=0;i<L.n;i++) L.V[i]=Vo[i]+step[i];
+
+				double e1=0;
+				double e2=0;
+				int prog;
+				char fmsg[256];
+
+				for(i=0;i<NumNodes;i++){
+					e1+=(L.V[i]-Vo[i])*(L.V[i]-Vo[i]);
+					e2+=(Vo[i]*Vo[i]);
+				}
+				if(e2!=0)
+				{
+					// test to see if we have converged.
+                    if(sqrt(e1/e2) < Precision*100.) IsNonlinear=false;
+					prog=(int)  (100.*log10(e1/e2)/(log10(Precision)+2.));
+					if (prog>100) prog=100;
+				//	TheView->m_prog2.SetPos(prog);
+
+				}
+
+				if (IsNonlinear == true)
+				{
+					// line search; the first solution only provides the starting point of the Newton iteration
+					std::vector<double> origin(Vo);
+					double trialNorm;
+					Relax=1;
+					while(true)
+					{
+						assemble();
+						trialNorm=L.ResidualNorm();
+						if((iter==1) || (trialNorm<=(1.-1.e-4*Relax)*resNorm) || (Relax<=0.125)) break;
+
+						Relax/=2.;
+						for(i=0;i<L.n;i++) L.V[i]=origin[i]+Relax*step[i];
+					}
+					lastResNorm=resNorm;
+					resNorm=trialNorm;
+
+					// the forcing term follows the convergence rate of the residual;
+					// below 0.01, GMRES needs more solutions than it saves Newton iterations.
+					if (iter>1)
+					{
+						double ratio=(lastResNorm>0) ? resNorm/lastResNorm : 0.;
+						eta=std::max(std::min(0.9*ratio*ratio,0.1),0.01);
+					}
+
+					sprintf(fmsg,"Newton Iteration(%i) Relax=%.4g Residual=%.4g\n",iter,Relax,resNorm);
+					printf("%s", fmsg);
+					//TheView->SetDlgItemText(IDC_FRAME2,fmsg);
+				}
+			}
+
+        }while(IsNonlinear == true);
+		return true;
+	};
+
+	if (TimeSteps==0)
+	{
+		if (!solve()) return false;
+	}
+	else
+	{
+		// In-process time stepping over TimeSteps*dT. Each step solves M (T-Tstar)/tau = F(T),
+		// where F(T) = b - A(T) T is the stationary part of the heat equation:
+		//  - backward Euler: tau=h, Tstar=T(n);
+		//  - BDF2 with w=h/h(n-1): tau=h (1+w)/(1+2w), Tstar=((1+w) T(n) - w^2/(1+w) T(n-1)) tau/h;
+		//  - Crank-Nicolson: tau=h/2, Tstar=T(n) + h/2 M^-1 F(T(n)).
+		// The same equation gives M^-1 F(T) = (T-Tstar)/tau at the new time level.
+		// The mesh, the matrix pattern and, for linear problems with an unchanged tau,
+		// the preconditioner or factorization are kept from step to step.
+		//
+		// Adaptive steps estimate the local error from the distance to an explicit predictor
+		// (Milne's device): forward Euler for backward Euler, second order Adams-Bashforth for
+		// BDF2 and Crank-Nicolson. The first step, taken with dT, has no estimate.
+		const double tEnd=TimeSteps*dT;
+		std::vector<double> Tn(Tprev,Tprev+NumNodes), Tnm1(Tn);
+		std::vector<double> rate(NumNodes), rateOld(NumNodes), pred(NumNodes);
+		int rates=0;		// number of valid rates in rate and rateOld
+		int steps=0,rejected=0;
+		double t=0,h=dT,hOld=dT,solvedTau=0;
+
+		if (TimeSeries && (OutputInterval>0))
+		{
+			for(i=0;i<NumNodes;i++) L.V[i]=Tn[i];
+			if (!WriteTimeStep(L,0,t)) return false;
 		}
 
-        if (IsNonlinear == true)
+		while((TimeTolerance>0) ? (t<tEnd*(1.-1.e-12)) : (steps<TimeSteps))
 		{
-			double e1=0;
-			double e2=0;
-			int prog;
-			char fmsg[256];
-
-			sprintf(fmsg,"Iteration(%i) ",iter);
-            printf("%s", fmsg);
-			//TheView->SetDlgItemText(IDC_FRAME2,fmsg);
-
-			for(i=0;i<NumNodes;i++){
-				e1+=(L.V[i]-Vo[i])*(L.V[i]-Vo[i]);
-				e2+=(Vo[i]*Vo[i]);
+			if ((TimeTolerance>0) && (t+h>tEnd)) h=tEnd-t;
+
+			const int scheme=(steps==0) ? TIME_EULER : TimeScheme;
+			const double w=h/hOld;
+			switch(scheme)
+			{
+				case TIME_BDF2:
+					tau=h*(1.+w)/(1.+2.*w);
+					for(i=0;i<NumNodes;i++) Tstar[i]=((1.+w)*Tn[i]-w*w/(1.+w)*Tnm1[i])*tau/h;
+					break;
+				case TIME_CN:
+					tau=h/2.;
+					for(i=0;i<NumNodes;i++) Tstar[i]=Tn[i]+h/2.*rate[i];
+					break;
+				default:
+					tau=h;
+					for(i=0;i<NumNodes;i++) Tstar[i]=Tn[i];
+					break;
 			}
-			if(e2!=0)
+
+			// predictor and error constant of the local error estimate
+			int order=1;
+			double C=1./2.;
+			if ((rates==2) && (scheme!=TIME_EULER))
 			{
-				// test to see if we have converged.
-                if(sqrt(e1/e2) < Precision*100.) IsNonlinear=false;
-				prog=(int)  (100.*log10(e1/e2)/(log10(Precision)+2.));
-				if (prog>100) prog=100;
-			//	TheView->m_prog2.SetPos(prog);
+				for(i=0;i<NumNodes;i++) pred[i]=Tn[i]+h*((1.+w/2.)*rate[i]-w/2.*rateOld[i]);
+				order=2;
+				C=(scheme==TIME_CN) ? 1./6. : 8./23.;
+			}
+			else for(i=0;i<NumNodes;i++) pred[i]=Tn[i]+h*rate[i];
+
+			for(i=0;i<NumNodes;i++) L.V[i]=Tn[i];
+			L.ReusePC=newtonElements.empty() && (tau==solvedTau);
+			bool ok=solve();
+			L.ReusePC=false;
+			if (!ok) return false;
+			solvedTau=tau;
+
+			const bool estimated=(TimeTolerance>0) && (rates>0);
+			double err=0;
+			if (estimated)
+			{
+				for(i=0;i<NumNodes;i++)
+					if (isEquationRow(i)) err=std::max(err,C*fabs(L.V[i]-pred[i]));
+				if ((err>TimeTolerance) && (h>1.e-8*tEnd))
+				{
+					// reject the step
+					h*=std::max(0.2,0.9*pow(TimeTolerance/err,1./(order+1)));
+					rejected++;
+					continue;
+				}
+			}
 
+			for(i=0;i<NumNodes;i++)
+			{
+				rateOld[i]=rate[i];
+				rate[i]=(L.V[i]-Tstar[i])/tau;
+				Tnm1[i]=Tn[i];
+				Tn[i]=L.V[i];
 			}
-		}
+			rates=std::min(rates+1,2);
+			hOld=h;
+			steps++;
+			t=(TimeTolerance>0) ? t+h : steps*dT;
 
-    }while(IsNonlinear == true);
+			const bool last=(TimeTolerance>0) ? (t>=tEnd*(1.-1.e-12)) : (steps==TimeSteps);
+			if ((OutputInterval>0) && ((steps%OutputInterval==0) || last))
+				if (!WriteTimeStep(L,steps,t)) return false;
+
+			if (estimated)
+			{
+				double f=(err>0) ? 0.9*pow(TimeTolerance/err,1./(order+1)) : 5.;
+				h*=std::min(std::max(f,0.2),5.);
+			}
+		}
+		if (TimeSeriesFile)
+		{
+			fclose(TimeSeriesFile);
+			TimeSeriesFile=nullptr;
+		}
+		printf("Time stepping: %i steps, %i rejected, t=%.6g\n",steps,rejected,t);
+	}
 
 	// compute total charge on conductors
 	// with a specified voltage
@@ -847,7 +1275,6 @@ int HSolver::AnalyzeProblem(CBigLinProb &L)
 		if(circproplist[i].CircType==1)
 			circproplist[i].q=ChargeOnConductor(i,L);
 
-	free(Vo);
     return true;
 }
 
@@ -886,15 +1313,30 @@ bool HSolver::runSolver(bool verbose)
         PrintMessage(stats.c_str());
     }
 
-    CBigLinProb L;
+    std::unique_ptr<CBigLinProb> Lp = createLinProb();
+    if (!Lp)
+        return false;
+    CBigLinProb &L = *Lp;
 
-    L.Precision = Precision;
     if (!L.Create(NumNodes+NumCircProps,BandWidth))
     {
         WarnMessage("couldn't allocate enough space for matrices\n");
         return false;
     }
 
+    // fix the sparsity pattern once, so that assembly only fills in values.
+    // Nodes in a conductor with a prescribed charge are assembled into the conductor's unknown.
+    std::vector<int> dofmap(NumNodes);
+    for (int i=0; i<NumNodes; i++)
+    {
+        dofmap[i] = i;
+        if (meshnode[i].InConductor>=0 && circproplist[meshnode[i].InConductor].CircType==0)
+            dofmap[i] = meshnode[i].InConductor+NumNodes;
+    }
+    CSparsityPattern pattern(NumNodes+NumCircProps);
+    BuildSparsityPattern(pattern, dofmap);
+    L.SetPattern(pattern);
+
     if (!AnalyzeProblem(L))
     {
         WarnMessage("Couldn't solve the problem\n");
@@ -920,6 +1362,14 @@ bool HSolver::runSolver(bool verbose)
 
 int HSolver::WriteResults(CBigLinProb &L)
 {
+	return WriteResults(L, PathName+".anh");
+}
+
+int HSolver::WriteResults(CBigLinProb &L, const std::string &fileName)
+{
+	if (binarySolutionFile)
+		return WriteBinaryResults(L, fileName);
+
 	// write solution to disk;
 
 	char c[1024];
@@ -936,50 +1386,112 @@ int HSolver::WriteResults(CBigLinProb &L)
         return false;
 	}
 
-    sprintf(c,"%s.anh",PathName.c_str());
-    fp=fopen(c,"wt");
+    fp=fopen(fileName.c_str(),"wt");
 	if(fp==NULL)
     {
-		printf("Couldn't write to %s.anh",PathName.c_str());
+		printf("Couldn't write to %s",fileName.c_str());
+		fclose(fz);
         return false;
 	}
 
-	while(fgets(c,1024,fz)!=NULL)
-    {
-        fputs(c,fp);
-    }
+	femm::CTextWriter out(fp);
+	out.copyFrom(fz);
 	fclose(fz);
 
 	// then print out node, line, and element information
-	fprintf(fp,"[Solution]\n");
+	out << "[Solution]\n";
     // get conversion factor for conversion from internal working units of
     // mm to the specified length units
 	cf = units[LengthUnits];
-	fprintf(fp,"%i\n",NumNodes);
-	for(i=0;i<NumNodes;i++)
-    {
-		fprintf(fp,"%.17g	%.17g	%.17g	%i\n",meshnode[i].x/cf,meshnode[i].y/cf,L.V[i],L.Q[i]);
-    }
+	out << NumNodes << '\n';
+	out.writeRecords(NumNodes, [&](femm::CTextWriter &w, int i) {
+		w << meshnode[i].x/cf << '\t' << meshnode[i].y/cf << '\t' << L.V[i] << '\t' << L.Q[i] << '\n';
+	});
 
-	fprintf(fp,"%i\n",NumEls);
+	out << NumEls << '\n';
 
-	for(i=0;i<NumEls;i++)
-    {
-		fprintf(fp,"%i	%i	%i	%i\n",
-			meshele[i].p[0],meshele[i].p[1],meshele[i].p[2],meshele[i].lbl);
-    }
+	out.writeRecords(NumEls, [&](femm::CTextWriter &w, int i) {
+		w << meshele[i].p[0] << '\t' << meshele[i].p[1] << '\t' << meshele[i].p[2] << '\t' << meshele[i].lbl << '\n';
+	});
 
 	// print out circuit info
-	fprintf(fp,"%i\n",NumCircProps);
+	out << NumCircProps << '\n';
 	for(i=0;i<NumCircProps;i++)
     {
-		fprintf(fp,"%.17g	%.17g\n",L.V[NumNodes+i],circproplist[i].q);
+		out << L.V[NumNodes+i] << '\t' << circproplist[i].q << '\n';
     }
 
-	fclose(fp);
+	bool written = out.flush();
+	if (fclose(fp)!=0 || !written)
+	{
+		printf("Couldn't write to %s",fileName.c_str());
+		return false;
+	}
     return true;
 }
 
+bool HSolver::WriteBinaryResults(CBigLinProb &L, const std::string &fileName)
+{
+    using namespace femm;
+    CSolutionFileWriter writer;
+
+    // get conversion factor for conversion from internal working units of
+    // mm to the specified length units
+    double cf = units[LengthUnits];
+    std::vector<SolutionNode> nodes(NumNodes);
+    for (int i=0; i<NumNodes; i++)
+        nodes[i] = SolutionNode{meshnode[i].x/cf, meshnode[i].y/cf, L.Q[i], 0};
+    writer.addSection(SolutionSection::Nodes, nodes);
+    writer.addSection(SolutionSection::Potentials, L.V, NumNodes, sizeof(double));
+
+    std::vector<SolutionElement> elements(NumEls);
+    for (int i=0; i<NumEls; i++)
+        elements[i] = SolutionElement{{meshele[i].p[0], meshele[i].p[1], meshele[i].p[2]}, meshele[i].lbl};
+    writer.addSection(SolutionSection::Elements, elements);
+
+    std::vector<SolutionCircuit> circuits(NumCircProps);
+    for (int i=0; i<NumCircProps; i++)
+        circuits[i] = SolutionCircuit{0, 0, {L.V[NumNodes+i], circproplist[i].q}};
+    writer.addSection(SolutionSection::Circuits, circuits);
+
+    return writer.write(fileName, PathName+".feh");
+}
+
+bool HSolver::WriteTimeStep(CBigLinProb &L, int step, double time)
+{
+	// a snapshot is a complete solution file
+	if (!TimeSeries)
+		return WriteResults(L, PathName+"_"+to_string(step)+".anh");
+
+	// the time series has the node positions once, followed by one line per step:
+	// step number, time and the nodal temperatures
+	if (!TimeSeriesFile)
+	{
+		std::string fileName=PathName+".tsh";
+		TimeSeriesFile=fopen(fileName.c_str(),"wt");
+		if (TimeSeriesFile==NULL)
+		{
+			printf("Couldn't write to %s",fileName.c_str());
+			return false;
+		}
+		double cf=units[LengthUnits];
+		femm::CTextWriter out(TimeSeriesFile);
+		out << "[TimeSeries]\n";
+		out << NumNodes << '\n';
+		out.writeRecords(NumNodes, [&](femm::CTextWriter &w, int i) {
+			w << meshnode[i].x/cf << '\t' << meshnode[i].y/cf << '\n';
+		});
+	}
+
+	femm::CTextWriter out(TimeSeriesFile);
+	out << step << '\t' << time;
+	out.writeRecords(NumNodes, [&](femm::CTextWriter &w, int i) {
+		w << '\t' << L.V[i];
+	});
+	out << '\n';
+	return out.flush() && !ferror(TimeSeriesFile);
+}
+
 //=========================================================================
 //=========================================================================
 
@@ -1058,6 +1570,47 @@ bool HSolver::handleToken(const string &token, istream &input, ostream &err)
         parseValue(input, dT, err);
         return true;
     }
+    if( token == "[timesteps]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, TimeSteps, err);
+        return true;
+    }
+    if( token == "[timescheme]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, TimeScheme, err);
+        if (TimeScheme<TIME_EULER || TimeScheme>TIME_CN)
+        {
+            err << "Warning: unknown [TimeScheme] " << TimeScheme << ", using backward Euler!\n";
+            TimeScheme = TIME_EULER;
+        }
+        return true;
+    }
+    if( token == "[timetolerance]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, TimeTolerance, err);
+        return true;
+    }
+    if( token == "[outputinterval]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, OutputInterval, err);
+        return true;
+    }
+    if( token == "[timeseries]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, TimeSeries, err);
+        return true;
+    }
+    if( token == "[initialtemperature]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, InitialTemperature, err);
+        return true;
+    }
     if( token == "[frequency]")
     {
         err << "Warning: [frequency] is not an allowed parameter for heat flow problems!\n";
@@ -44,8 +44,17 @@
 #include "CMaterialProp.h"
 #include "CPointProp.h"
 
+#include <cstdio>
 #include <string>
 
+/// time integration schemes of the in-process time stepping, see HSolver::TimeScheme
+enum TimeSchemeType
+{
+    TIME_EULER = 0, ///< backward Euler
+    TIME_BDF2 = 1,  ///< second order backward differences, started by a backward Euler step
+    TIME_CN = 2     ///< Crank-Nicolson, started by a backward Euler step
+};
+
 class HSolver : public FEASolver<
         femm::CHPointProp
         , femm::CHBoundaryProp
@@ -66,6 +75,16 @@ public:
     // General problem attributes
     double	dT; ///< \brief delta T used by hsolver \verbatim[dT]\endverbatim
 
+    // In-process time stepping (introduced by xfemm).
+    // With TimeSteps>0, hsolver integrates over TimeSteps*dT in a single run,
+    // starting from the previous solution or from InitialTemperature.
+    int TimeSteps; ///< \brief number of time steps of length dT; 0: a single step, if there is a previous solution \verbatim[TimeSteps]\endverbatim
+    int TimeScheme; ///< \brief time integration scheme, see TimeSchemeType \verbatim[TimeScheme]\endverbatim
+    double TimeTolerance; ///< \brief local error [K] per time step for adaptive steps, with dT as first step; 0: fixed steps \verbatim[TimeTolerance]\endverbatim
+    int OutputInterval; ///< \brief write every OutputInterval-th step; 0: only the last one (as .anh) \verbatim[OutputInterval]\endverbatim
+    int TimeSeries; ///< \brief 1: write the steps to one time series file (.tsh) instead of one .anh file per step \verbatim[TimeSeries]\endverbatim
+    double InitialTemperature; ///< \brief initial temperature [K] if there is no previous solution \verbatim[InitialTemperature]\endverbatim
+
     // mesh information
     femm::CNode *meshnode;
 
@@ -81,6 +100,12 @@ public:
     bool LoadProblemFile();
     double ChargeOnConductor(int OnConductor, CBigLinProb &L);
 	int WriteResults(CBigLinProb &L);
+	int WriteResults(CBigLinProb &L, const std::string &fileName);
+    /**
+     * @brief Write the results to a binary solution file, see femm::CSolutionFileWriter.
+     * WriteResults() calls this if binarySolutionFile is set.
+     */
+    bool WriteBinaryResults(CBigLinProb &L, const std::string &fileName);
     int AnalyzeProblem(CBigLinProb &L);
     int (*WarnMessage)(const char*, ...);
 
@@ -93,6 +118,10 @@ private:
     // override parent class virtual method
     void SortNodes (int* newnum) override;
 
+    /// write the solution of a time step as snapshot or time series record
+    bool WriteTimeStep(CBigLinProb &L, int step, double time);
+    FILE *TimeSeriesFile;
+
     virtual bool handleToken(const std::string &token, std::istream &input, std::ostream &err) override;
 
 };
@@ -32,8 +32,10 @@
 #include <math.h>
 #include <string.h>
 #include "femmcomplex.h"
+#include "parallel.h"
 #include "spars.h"
 #include "hsolver.h"
+#include "solutionfile.h"
 
 //using namespace std;
 
@@ -43,7 +45,26 @@ int main(int argc, char** argv)
     HSolver theHSolver;
     char PathName[512];
 
-    if (argc < 2)
+    int argi = 1;
+
+    // options: the number of threads for the linear solver, e.g. "--threads=4",
+    // and "--binary-solution" to write the solution file in the binary format
+    for (; argi < argc; argi++)
+    {
+        if (strncmp(argv[argi], "--threads=", 10) == 0)
+            femm::setNumThreads(atoi(argv[argi]+10));
+        else if (strcmp(argv[argi], "--binary-solution") == 0)
+        {
+            if (femm::CSolutionFile::hostByteOrderSupported())
+                theHSolver.binarySolutionFile = true;
+            else
+                printf("Binary solution files need a little-endian host; writing a text solution file\n");
+        }
+        else
+            break;
+    }
+
+    if (argc - argi < 1)
     {
         // request the file name from the user
         printf("Enter feh file name without extension:\n");
@@ -54,13 +75,13 @@ int main(int argc, char** argv)
             *pos = '\0';
 
     }
-    else if(argc > 2)
+    else if(argc - argi > 1)
     {
         printf("Too many arguments");
     }
     else
     {
-        strcpy(PathName, argv[1]);
+        strcpy(PathName, argv[argi]);
     }
 
     theHSolver.PathName = PathName;
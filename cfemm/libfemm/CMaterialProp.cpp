@@ -26,7 +26,7 @@
 */
 #include "CMaterialProp.h"
 
-#include "fullmatrix.h"
+#include "bhcache.h"
 #include "femmcomplex.h"
 #include "femmconstants.h"
 #include "fparse.h"
@@ -70,6 +70,8 @@ CMMaterialProp::CMMaterialProp()
     , Bdata()
     , Hdata()
     , slope()
+    , SegmentTable()
+    , SegmentScale(0.)
     , LamType(0)
     , LamFill(1.)
     , H_c(0.)
@@ -103,6 +105,8 @@ CMMaterialProp::CMMaterialProp( const CMMaterialProp& other )
     Bdata = other.Bdata;
     Hdata = other.Hdata;
     slope = other.slope;
+    SegmentTable = other.SegmentTable;
+    SegmentScale = other.SegmentScale;
 
     H_c = other.H_c;                // magnetization, A/m
     Nrg = other.Nrg;
@@ -121,6 +125,7 @@ CMMaterialProp::CMMaterialProp( const CMMaterialProp& other )
 void CMMaterialProp::clearSlopes()
 {
     slope.clear();
+    SegmentTable.clear();
 }
 
 void CMMaterialProp::GetSlopes(double omega)
@@ -131,18 +136,11 @@ void CMMaterialProp::GetSlopes(double omega)
     int i,k;
     bool CurveOK=false;
     bool ProcessedLams=false;
-    CComplexFullMatrix L;
     double l1,l2;
     CComplex *hn;
     double *bn;
     CComplex mu;
 
-    L.Create(BHpoints);
-    bn   =(double *)  calloc(BHpoints,sizeof(double));
-    hn   =(CComplex *)calloc(BHpoints,sizeof(CComplex));
-    slope.reserve(BHpoints);
-
-
     // strip off some info that we can use during the first
     // nonlinear iteration;
     mu_x = Bdata[1] / (muo*abs(Hdata[1]));
@@ -150,6 +148,29 @@ void CMMaterialProp::GetSlopes(double omega)
     Theta_hx = Theta_hn;
     Theta_hy = Theta_hn;
 
+    // the processed curve only depends on the DC curve, the frequency,
+    // and the lamination parameters; a frequency sweep repeats these.
+    CBHCurveCache &cache = CBHCurveCache::global();
+    if (cache.Lookup(*this, omega))
+    {
+        BuildSegmentTable();
+        return;
+    }
+    const std::vector<double> dcB = Bdata;
+    std::vector<double> dcH(2*BHpoints);
+    for(i=0;i<BHpoints;i++)
+    {
+        dcH[2*i] = Hdata[i].re;
+        dcH[2*i+1] = Hdata[i].im;
+    }
+
+    // the spline system is tridiagonal and diagonally dominant:
+    std::vector<double> sub(BHpoints), diag(BHpoints), sup(BHpoints);
+    std::vector<CComplex> rhs(BHpoints);
+    bn   =(double *)  calloc(BHpoints,sizeof(double));
+    hn   =(CComplex *)calloc(BHpoints,sizeof(CComplex));
+    slope.reserve(BHpoints);
+
     // first, we need to doctor the curve if the problem is
     // being evaluated at a nonzero frequency.
     if(omega!=0)
@@ -198,37 +219,46 @@ void CMMaterialProp::GetSlopes(double omega)
     {
         slope.clear();
         debug << "curve not ok yet.\n";
-        // make sure that the space for computing slopes is cleared out
-        L.Wipe();
 
         // impose natural BC on the `left'
         l1=Bdata[1]-Bdata[0];
-        L.M[0][0]=4./l1;
-        L.M[0][1]=2./l1;
-        L.b[0]=6.*(Hdata[1]-Hdata[0])/(l1*l1);
+        sub[0]=0;
+        diag[0]=4./l1;
+        sup[0]=2./l1;
+        rhs[0]=6.*(Hdata[1]-Hdata[0])/(l1*l1);
 
         // impose natural BC on the `right'
         int n=BHpoints;
         l1=Bdata[n-1]-Bdata[n-2];
-        L.M[n-1][n-1]=4./l1;
-        L.M[n-1][n-2]=2./l1;
-        L.b[n-1]=6.*(Hdata[n-1]-Hdata[n-2])/(l1*l1);
+        sub[n-1]=2./l1;
+        diag[n-1]=4./l1;
+        sup[n-1]=0;
+        rhs[n-1]=6.*(Hdata[n-1]-Hdata[n-2])/(l1*l1);
 
         for(i=1;i<BHpoints-1;i++)
         {
             l1=Bdata[i]-Bdata[i-1];
             l2=Bdata[i+1]-Bdata[i];
 
-            L.M[i][i-1]=2./l1;
-            L.M[i][i]=4.*(l1+l2)/(l1*l2);
-            L.M[i][i+1]=2./l2;
+            sub[i]=2./l1;
+            diag[i]=4.*(l1+l2)/(l1*l2);
+            sup[i]=2./l2;
 
-            L.b[i]=6.*(Hdata[i]-Hdata[i-1])/(l1*l1) +
+            rhs[i]=6.*(Hdata[i]-Hdata[i-1])/(l1*l1) +
                     6.*(Hdata[i+1]-Hdata[i])/(l2*l2);
         }
 
-        L.GaussSolve();
-        for(i=0;i<BHpoints;i++) slope.push_back(L.b[i]);
+        // Thomas algorithm; no pivoting needed, since the rows are diagonally dominant
+        for(i=1;i<n;i++)
+        {
+            double m=sub[i]/diag[i-1];
+            diag[i]-=m*sup[i-1];
+            rhs[i]-=m*rhs[i-1];
+        }
+        rhs[n-1]/=diag[n-1];
+        for(i=n-2;i>=0;i--)
+            rhs[i]=(rhs[i]-sup[i]*rhs[i+1])/diag[i];
+        for(i=0;i<BHpoints;i++) slope.push_back(rhs[i]);
 
         // now, test to see if there are any "bad" segments in there.
         // it is probably sufficient to do this test just on the
@@ -343,9 +373,62 @@ void CMMaterialProp::GetSlopes(double omega)
 
     free(bn);
     free(hn);
+
+    cache.Store(dcB, dcH, *this, omega);
+    // the laminations may have changed Bdata
+    BuildSegmentTable();
     return;
 }
 
+void CMMaterialProp::BuildSegmentTable()
+{
+    SegmentTable.clear();
+    if (BHpoints<2)
+        return;
+    for (int i=1; i<BHpoints; i++)
+        if (!(Bdata[i]>=Bdata[i-1]))
+            return;
+    const double bmax = Bdata[BHpoints-1];
+    if (!(bmax>0))
+        return;
+
+    // a few buckets per segment, so that FindSegment() rarely has to step forward
+    const int nb = 4*BHpoints;
+    SegmentScale = nb/bmax;
+    SegmentTable.resize(nb+1);
+    int i=0;
+    for (int k=0; k<=nb; k++)
+    {
+        while ((i<BHpoints-2) && (static_cast<int>(Bdata[i+1]*SegmentScale)<k))
+            i++;
+        SegmentTable[k]=i;
+    }
+}
+
+int CMMaterialProp::FindSegment(double b) const
+{
+    if (SegmentTable.empty())
+    {
+        for(int i=0; i<BHpoints-1; i++)
+            if((b>=Bdata[i]) && (b<=Bdata[i+1]))
+                return i;
+        return -1;
+    }
+
+    // the curve is sorted, so the first segment that ends at or above b is the one a linear search finds
+    if (!((b>=Bdata[0]) && (b<=Bdata[BHpoints-1])))
+        return -1;
+    int k = static_cast<int>(b*SegmentScale);
+    if (k<0)
+        k=0;
+    if (k>=static_cast<int>(SegmentTable.size()))
+        k=static_cast<int>(SegmentTable.size())-1;
+    int i = SegmentTable[k];
+    while ((i<BHpoints-2) && (Bdata[i+1]<b))
+        i++;
+    return i;
+}
+
 
 CComplex CMMaterialProp::LaminatedBH(double w, int i)
 {
@@ -470,16 +553,16 @@ CComplex CMMaterialProp::GetdHdB(const double B) const
     if(b>Bdata[BHpoints-1])
         return slope[BHpoints-1];
 
-    for(i=0;i<BHpoints-1;i++)
-        if((b>=Bdata[i]) && (b<=Bdata[i+1])){
-            l=(Bdata[i+1]-Bdata[i]);
-            z=(b-Bdata[i])/l;
-            h=6.*z*(z-1.)*Hdata[i]/l +
-                    (1.-4.*z+3.*z*z)*slope[i] +
-                    6.*z*(1.-z)*Hdata[i+1]/l +
-                    z*(3.*z-2.)*slope[i+1];
-            return h;
-        }
+    i=FindSegment(b);
+    if(i>=0){
+        l=(Bdata[i+1]-Bdata[i]);
+        z=(b-Bdata[i])/l;
+        h=6.*z*(z-1.)*Hdata[i]/l +
+                (1.-4.*z+3.*z*z)*slope[i] +
+                6.*z*(1.-z)*Hdata[i+1]/l +
+                z*(3.*z-2.)*slope[i+1];
+        return h;
+    }
 
     return CComplex(0);
 }
@@ -502,17 +585,17 @@ CComplex CMMaterialProp::GetH(const CComplex x) const
     if(b>Bdata[BHpoints-1])
         return p*(Hdata[BHpoints-1] + slope[BHpoints-1]*(b-Bdata[BHpoints-1]));
 
-    for(i=0;i<BHpoints-1;i++)
-        if((b>=Bdata[i]) && (b<=Bdata[i+1])){
-            l=Bdata[i+1]-Bdata[i];
-            z=(b-Bdata[i])/l;
-            z2=z*z;
-            h=(1.-3.*z2+2.*z2*z)*Hdata[i] +
-                    z*(1.-2.*z+z2)*l*slope[i] +
-                    z2*(3.-2.*z)*Hdata[i+1] +
-                    z2*(z-1.)*l*slope[i+1];
-            return p*h;
-        }
+    i=FindSegment(b);
+    if(i>=0){
+        l=Bdata[i+1]-Bdata[i];
+        z=(b-Bdata[i])/l;
+        z2=z*z;
+        h=(1.-3.*z2+2.*z2*z)*Hdata[i] +
+                z*(1.-2.*z+z2)*l*slope[i] +
+                z2*(3.-2.*z)*Hdata[i+1] +
+                z2*(z-1.)*l*slope[i+1];
+        return p*h;
+    }
 
     return 0;
 }
@@ -874,18 +957,18 @@ CComplex CMSolverMaterialProp::GetH(double B)
     if(b>Bdata[BHpoints-1])
         return (Hdata[BHpoints-1] + slope[BHpoints-1]*(b-Bdata[BHpoints-1]));
 
-    for(i=0; i<BHpoints-1; i++)
-        if((b>=Bdata[i]) && (b<=Bdata[i+1]))
-        {
-            l=(Bdata[i+1]-Bdata[i]);
-            z=(b-Bdata[i])/l;
-            z2=z*z;
-            h=(1.-3.*z2+2.*z2*z)*Hdata[i] +
-              z*(1.-2.*z+z2)*l*slope[i] +
-              z2*(3.-2.*z)*Hdata[i+1] +
-              z2*(z-1.)*l*slope[i+1];
-            return h;
-        }
+    i=FindSegment(b);
+    if(i>=0)
+    {
+        l=(Bdata[i+1]-Bdata[i]);
+        z=(b-Bdata[i])/l;
+        z2=z*z;
+        h=(1.-3.*z2+2.*z2*z)*Hdata[i] +
+          z*(1.-2.*z+z2)*l*slope[i] +
+          z2*(3.-2.*z)*Hdata[i+1] +
+          z2*(z-1.)*l*slope[i+1];
+        return h;
+    }
 
     return CComplex(0);
 }
@@ -1029,24 +1112,30 @@ void CMSolverMaterialProp::GetBHProps(double B, CComplex &v, CComplex &dv)
         return;
     }
 
-    for(i=0; i<BHpoints-1; i++)
-        if((b>=Bdata[i]) && (b<=Bdata[i+1]))
-        {
-            l=(Bdata[i+1]-Bdata[i]);
-            z=(b-Bdata[i])/l;
-            z2=z*z;
-            h=(1.-3.*z2+2.*z2*z)*Hdata[i] +
-              z*(1.-2.*z+z2)*l*slope[i] +
-              z2*(3.-2.*z)*Hdata[i+1] +
-              z2*(z-1.)*l*slope[i+1];
-            dh=6.*z*(z-1.)*Hdata[i]/l +
-               (1.-4.*z+3.*z*z)*slope[i] +
-               6.*z*(1.-z)*Hdata[i+1]/l +
-               z*(3.*z-2.)*slope[i+1];
-            v=h/b;
-            dv=0.5*(dh/(b*b) - h/(b*b*b));
-            return;
-        }
+    i=FindSegment(b);
+    if(i>=0)
+    {
+        l=(Bdata[i+1]-Bdata[i]);
+        z=(b-Bdata[i])/l;
+        z2=z*z;
+        h=(1.-3.*z2+2.*z2*z)*Hdata[i] +
+          z*(1.-2.*z+z2)*l*slope[i] +
+          z2*(3.-2.*z)*Hdata[i+1] +
+          z2*(z-1.)*l*slope[i+1];
+        dh=6.*z*(z-1.)*Hdata[i]/l +
+           (1.-4.*z+3.*z*z)*slope[i] +
+           6.*z*(1.-z)*Hdata[i+1]/l +
+           z*(3.*z-2.)*slope[i+1];
+        v=h/b;
+        dv=0.5*(dh/(b*b) - h/(b*b*b));
+        return;
+    }
+}
+
+void CMSolverMaterialProp::GetBHProps(int n, const double *B, double *v, double *dv)
+{
+    for(int k=0; k<n; k++)
+        GetBHProps(B[k],v[k],dv[k]);
 }
 
 // this can't be immediately merged with femm::CMaterialProp,
@@ -1354,6 +1443,7 @@ CHMaterialProp::CHMaterialProp()
     , Kt(0)
     , qv(0)
     , npts(0)
+    , KTemperatures()
 {
 }
 
@@ -1376,24 +1466,42 @@ CHMaterialProp::CHMaterialProp( const CHMaterialProp & other)
         // copy the thermal conductivity data points.
         Kn[i] = other.Kn[i];
     }
+    KTemperatures = other.KTemperatures;
 }
 
 CComplex CHMaterialProp::GetK(double t) const
+{
+    double dKdT;
+    return GetK(t, dKdT);
+}
+
+CComplex CHMaterialProp::GetK(double t, double &dKdT) const
 {
     int i,j;
 
     // Kx returned as real part;
     // Ky returned as imag part
+    dKdT=0;
 
     if (npts==0) return (Kx+I*Ky);
     if (npts==1) return (Im(Kn[0])*(1+I));
     if (t<=Re(Kn[0])) return (Im(Kn[0])*(1+I));
     if (t>=Re(Kn[npts-1])) return (Im(Kn[npts-1])*(1+I));
 
+    if (static_cast<int>(KTemperatures.size())==npts)
+    {
+        // the first segment that ends at or above t is the one the linear search below finds
+        j=static_cast<int>(std::lower_bound(KTemperatures.begin()+1, KTemperatures.end(), t) - KTemperatures.begin());
+        i=j-1;
+        dKdT=Im(Kn[j]-Kn[i])/Re(Kn[j]-Kn[i]);
+        return (1+I)*(Im(Kn[i])+Im(Kn[j]-Kn[i])*Re(t-Kn[i])/Re(Kn[j]-Kn[i]));
+    }
+
     for(i=0,j=1;j<npts;i++,j++)
     {
         if((t>=Re(Kn[i])) && (t<=Re(Kn[j])))
         {
+            dKdT=Im(Kn[j]-Kn[i])/Re(Kn[j]-Kn[i]);
             return (1+I)*(Im(Kn[i])+Im(Kn[j]-Kn[i])*Re(t-Kn[i])/Re(Kn[j]-Kn[i]));
         }
     }
@@ -1401,6 +1509,17 @@ CComplex CHMaterialProp::GetK(double t) const
     return (Kx+I*Ky);
 }
 
+void CHMaterialProp::BuildKTable()
+{
+    KTemperatures.clear();
+    for (int i=1; i<npts; i++)
+        if (!(Re(Kn[i])>=Re(Kn[i-1])))
+            return;
+    KTemperatures.resize(npts);
+    for (int i=0; i<npts; i++)
+        KTemperatures[i] = Re(Kn[i]);
+}
+
 CHMaterialProp CHMaterialProp::fromStream(std::istream &input, std::ostream &err, PropertyParseMode mode)
 {
     CHMaterialProp prop;
@@ -1465,6 +1584,7 @@ CHMaterialProp CHMaterialProp::fromStream(std::istream &input, std::ostream &err
                         input >> prop.Kn[i].re >> prop.Kn[i].im;
                     }
                 }
+                prop.BuildKTable();
                 continue;
             }
             if( token != "<endblock>")
@@ -86,6 +86,13 @@ public:
     virtual void clearSlopes();
     virtual void GetSlopes(double omega=0.);
     virtual CComplex LaminatedBH(double w, int i);
+    /**
+     * @brief Find the segment i of the BH curve with Bdata[i] <= b <= Bdata[i+1].
+     * If b is on the boundary of two segments, the lower one is returned,
+     * i.e. the result is the same as for a linear search from the start of the curve.
+     * @return the segment, or -1 if b is not within the curve.
+     */
+    int FindSegment(double b) const;
 
     double GetH(const double b) const;
     CComplex GetH(const CComplex b) const;            // ``raw'' results
@@ -112,6 +119,14 @@ public:
     std::vector<CComplex> Hdata;        // entries in B-H curve;
     std::vector<CComplex> slope;        // slopes used in interpolation
     // of BHdata
+    /**
+     * @brief Lookup table for FindSegment(), built by GetSlopes().
+     * Entry k is the first segment whose end point falls into bucket k or later,
+     * where bucket k holds the flux densities b with (int)(b*SegmentScale)==k.
+     * Empty if the curve is not sorted by B; FindSegment() then searches linearly.
+     */
+    std::vector<int> SegmentTable;
+    double SegmentScale;    // number of buckets per Tesla
     int    LamType;         // flag that tells how block is laminated;
     //  0 = not laminated or laminated in plane;
     //  1 = laminated in the x-direction;
@@ -145,6 +160,11 @@ public:
      * @param out
      */
     virtual void toStream( std::ostream &out ) const override;
+protected:
+    /**
+     * @brief Build the SegmentTable for the current Bdata.
+     */
+    void BuildSegmentTable();
 private:
 
 };
@@ -178,6 +198,13 @@ public:
     CComplex Get_v(double B);
     void GetBHProps(double B, CComplex &v, CComplex &dv);
     void GetBHProps(double B, double &v, double &dv);
+    /**
+     * @brief GetBHProps() for \p n flux densities at once, for magnetostatic problems.
+     * @param B flux densities
+     * @param v receives the reluctivities
+     * @param dv receives the derivatives of the reluctivities with respect to B^2
+     */
+    void GetBHProps(int n, const double *B, double *v, double *dv);
     /**
      * @brief Get the incremental permeability of a nonlinear material for use in incremental permeability formulation about DC offset.
      * @param B
@@ -233,6 +260,11 @@ public:
     int npts;			// number of points in the nonlinear conductivity curve
     CComplex Kn[128];   // here, I'm being _very_ lazy by defining a fixed-length buffer for the
                         // thermal conductivity data points.
+    /**
+     * @brief Temperatures of the Kn curve, for a binary search in GetK(); built by BuildKTable().
+     * Empty if the curve is not sorted by temperature; GetK() then searches linearly.
+     */
+    std::vector<double> KTemperatures;
 
     // Methods
 public:
@@ -241,6 +273,18 @@ public:
     virtual ~CHMaterialProp();
     CHMaterialProp( const CHMaterialProp & );
     CComplex GetK(double t) const;
+    /**
+     * @brief Get the thermal conductivity and its derivative with respect to the temperature.
+     * Nonlinear conductivities are isotropic, so \p dKdT is the derivative of both parts of the result.
+     * @param t temperature
+     * @param dKdT derivative of the conductivity; 0 for linear materials and outside of the Kn curve
+     * @return the conductivity (Kx as real part, Ky as imaginary part)
+     */
+    CComplex GetK(double t, double &dKdT) const;
+    /**
+     * @brief Build KTemperatures for the current Kn curve.
+     */
+    void BuildKTable();
 
     /**
      * @brief fromStream constructs a CHMaterialProp from an input stream (usually an input file stream)
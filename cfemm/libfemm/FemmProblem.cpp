@@ -112,6 +112,27 @@ void femm::FemmProblem::writeProblemDescription(std::ostream &output) const
         output << "[ACSolver]" << "  =  " << ACSolver <<"\n";
     }
 
+    // only written if they differ from the default, to stay compatible with FEMM
+    if (Preconditioner != 0)
+    {
+        output.width(12);
+        output << "[Preconditioner]" << "  =  " << Preconditioner <<"\n";
+        output.width(12);
+        output << "[ICFill]" << "  =  " << ICFill <<"\n";
+        output.width(12);
+        output << "[ICDropTol]" << "  =  " << ICDropTol <<"\n";
+    }
+    if (LinearSolver != 0)
+    {
+        output.width(12);
+        output << "[LinearSolver]" << "  =  " << LinearSolver <<"\n";
+    }
+    if (!SolverBackend.empty())
+    {
+        output.width(12);
+        output << "[SolverBackend]" << "  = \"" << SolverBackend << "\"\n";
+    }
+
 
     output.width(12);
     output << "[PrevSoln]" << "  = \"" << previousSolutionFile << "\"\n";
@@ -119,6 +140,27 @@ void femm::FemmProblem::writeProblemDescription(std::ostream &output) const
     output.width(12);
     output << "[PrevType]" << "  =  " << PrevType << "\n";
 
+    if (filetype == FileType::HeatFlowFile && TimeSteps > 0)
+    {
+        output.width(12);
+        output << "[TimeSteps]" << "  =  " << TimeSteps << "\n";
+        output.width(12);
+        output << "[TimeScheme]" << "  =  " << TimeScheme << "\n";
+        output.width(12);
+        output << "[TimeTolerance]" << "  =  " << TimeTolerance << "\n";
+        output.width(12);
+        output << "[OutputInterval]" << "  =  " << OutputInterval << "\n";
+        output.width(12);
+        output << "[TimeSeries]" << "  =  " << TimeSeries << "\n";
+        output.width(12);
+        output << "[InitialTemperature]" << "  =  " << InitialTemperature << "\n";
+    }
+    if (filetype == FileType::ElectrostaticsFile && ComputeCapacitance)
+    {
+        output.width(12);
+        output << "[ComputeCapacitance]" << "  =  1\n";
+    }
+
     std::string commentString (comment);
     // escape line-breaks
     size_t pos = commentString.find('\n');
@@ -2438,7 +2480,19 @@ femm::FemmProblem::FemmProblem(FileType ftype)
     , extRi(0)
     , comment()
     , ACSolver(0)
+    , Preconditioner(0)
+    , ICFill(0)
+    , ICDropTol(0)
+    , LinearSolver(0)
+    , SolverBackend()
     , dT(0)
+    , TimeSteps(0)
+    , TimeScheme(0)
+    , TimeTolerance(0)
+    , OutputInterval(0)
+    , TimeSeries(0)
+    , InitialTemperature(0)
+    , ComputeCapacitance(false)
     , previousSolutionFile()
     , PrevType(0)
     , DoForceMaxMeshArea(false)
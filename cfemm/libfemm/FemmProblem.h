@@ -509,7 +509,19 @@ public: // data members
     std::string comment; ///< \brief Problem description
 
     int ACSolver; ///< \brief .succ. approcimation or .Newton is possible
+    int Preconditioner; ///< \brief Property introduced by xfemm: preconditioner for the conjugate gradient solver (0: SSOR, 1: incomplete Cholesky, 2: algebraic multigrid)
+    int ICFill; ///< \brief Property introduced by xfemm: fill level of the incomplete Cholesky preconditioner
+    double ICDropTol; ///< \brief Property introduced by xfemm: drop tolerance of the incomplete Cholesky preconditioner
+    int LinearSolver; ///< \brief Property introduced by xfemm: solution method for the linear systems (0: iterative, 1: sparse direct)
+    std::string SolverBackend; ///< \brief Property introduced by xfemm: name of the linear solver backend (empty: default) \verbatim[SolverBackend]\endverbatim
     double dT; ///< \brief delta T used by hsolver \verbatim[dT]\endverbatim
+    int TimeSteps; ///< \brief Property introduced by xfemm: number of time steps solved by hsolver in one run (0: a single step) \verbatim[TimeSteps]\endverbatim
+    int TimeScheme; ///< \brief Property introduced by xfemm: time integration scheme of hsolver (0: backward Euler, 1: BDF2, 2: Crank-Nicolson) \verbatim[TimeScheme]\endverbatim
+    double TimeTolerance; ///< \brief Property introduced by xfemm: local error per time step for adaptive steps (0: fixed steps) \verbatim[TimeTolerance]\endverbatim
+    int OutputInterval; ///< \brief Property introduced by xfemm: hsolver writes every OutputInterval-th time step (0: only the last) \verbatim[OutputInterval]\endverbatim
+    int TimeSeries; ///< \brief Property introduced by xfemm: write the time steps to one time series file instead of one solution file each \verbatim[TimeSeries]\endverbatim
+    double InitialTemperature; ///< \brief Property introduced by xfemm: initial temperature of the time stepping if there is no previous solution \verbatim[InitialTemperature]\endverbatim
+    bool ComputeCapacitance; ///< \brief Property introduced by xfemm: esolver also computes the capacitance matrix of the fixed-voltage conductors \verbatim[ComputeCapacitance]\endverbatim
     std::string previousSolutionFile; ///y \brief   name of a previous solution file for hsolver and fsolver incremental permeability \verbatim[prevsoln]\endverbatim
     int	PrevType; ///< \brief Previous solution type. 0 == None, 1 == Incremental, 2 == Frozen
 
@@ -102,6 +102,7 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
 
     bool success = true;
     bool readSolutionData = false;
+    std::streamoff binarySolutionOffset = -1;
     while (input.good() && success)
     {
         if (input.eof())
@@ -237,6 +238,44 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
             continue;
         }
 
+        // Preconditioner for the conjugate gradient solver
+        if( token == "[preconditioner]")
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, problem->Preconditioner, err);
+            continue;
+        }
+
+        if( token == "[icfill]")
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, problem->ICFill, err);
+            continue;
+        }
+
+        if( token == "[icdroptol]")
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, problem->ICDropTol, err);
+            continue;
+        }
+
+        // Solution method for the linear systems
+        if( token == "[linearsolver]")
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, problem->LinearSolver, err);
+            continue;
+        }
+
+        // Linear solver backend
+        if( token == "[solverbackend]")
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseString(lineStream, &(problem->SolverBackend), err);
+            continue;
+        }
+
 		// Previous solution type
 		if( token == "[prevtype]" )
         {
@@ -592,6 +631,13 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
             break;
         }
 
+        if (token == "[binarysolution]")
+        {
+            readSolutionData = true;
+            binarySolutionOffset = input.tellg();
+            break;
+        }
+
         // fall-through; token was not used
         if (!handleToken(token, lineStream, err))
         {
@@ -614,6 +660,13 @@ ParserResult FemmReader<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLa
 
     if (readSolutionData && success)
     {
+        if (solutionReader && binarySolutionOffset>=0)
+        {
+            CSolutionFile solution;
+            if (!solution.open(file, binarySolutionOffset, err))
+                return F_FILE_MALFORMED;
+            return solutionReader->parseBinarySolution(solution,err);
+        }
         if (solutionReader)
             return solutionReader->parseSolution(input,err);
         else
@@ -729,6 +782,42 @@ bool HeatFlowReader::handleToken(const string &token, istream &input, ostream &e
         parseValue(input, problem->dT, err);
         return true;
     }
+    if( token == "[timesteps]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, problem->TimeSteps, err);
+        return true;
+    }
+    if( token == "[timescheme]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, problem->TimeScheme, err);
+        return true;
+    }
+    if( token == "[timetolerance]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, problem->TimeTolerance, err);
+        return true;
+    }
+    if( token == "[outputinterval]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, problem->OutputInterval, err);
+        return true;
+    }
+    if( token == "[timeseries]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, problem->TimeSeries, err);
+        return true;
+    }
+    if( token == "[initialtemperature]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, problem->InitialTemperature, err);
+        return true;
+    }
     if( token == "[frequency]")
     {
         err << "Warning: [frequency] is not an allowed parameter for heat flow problems!\n";
@@ -756,3 +845,14 @@ ElectrostaticsReader::ElectrostaticsReader(std::shared_ptr<FemmProblem> problem,
     : FemmReader_type(problem,r,errorpipe)
 {
 }
+
+bool ElectrostaticsReader::handleToken(const string &token, istream &input, ostream &err)
+{
+    if( token == "[computecapacitance]" )
+    {
+        expectChar(input, '=', err);
+        parseValue(input, problem->ComputeCapacitance, err);
+        return true;
+    }
+    return false;
+}
@@ -19,6 +19,7 @@
 #define FEMMREADER_H
 
 #include "FemmProblem.h"
+#include "solutionfile.h"
 
 #include <iostream>
 #include <string>
@@ -34,6 +35,11 @@ enum ParserResult { F_FILE_OK, F_FILE_UNKNOWN_TYPE, F_FILE_NOT_OPENED, F_FILE_MA
 class SolutionReader {
 public:
     virtual ParserResult parseSolution( std::istream &input, std::ostream &err = std::cerr ) = 0;
+    /**
+     * @brief parseBinarySolution is called instead of parseSolution() if the file contains a binary solution.
+     * @param solution the mapped container of the solution file, see CSolutionFileWriter
+     */
+    virtual ParserResult parseBinarySolution( const CSolutionFile &solution, std::ostream &err = std::cerr ) = 0;
 protected:
     virtual ~SolutionReader(){}
 };
@@ -172,6 +178,8 @@ class ElectrostaticsReader : public FemmReader<
 public:
     ElectrostaticsReader(std::shared_ptr<FemmProblem> problem, std::ostream &errorpipe);
     ElectrostaticsReader(std::shared_ptr<FemmProblem> problem, SolutionReader *r, std::ostream &errorpipe);
+protected:
+    bool handleToken(const std::string &token, std::istream &input, std::ostream &err) override;
 };
 } //namespace
 
@@ -0,0 +1,537 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "amg.h"
+
+#include <algorithm>
+#include <cmath>
+
+// coarsening stops at this number of unknowns; the coarsest level is solved directly
+#define MAXCOARSE 300
+#define MAXLEVELS 20
+// strength of connection threshold on the finest level; halved on each coarser level
+#define THETA 0.08
+
+CAMGPreconditioner::CAMGPreconditioner()
+    : PatternVersion(-1)
+    , Levels()
+    , Coarse()
+    , CoarseWork()
+{
+}
+
+void CAMGPreconditioner::Clear()
+{
+    Levels.clear();
+    UpperToFull[0].clear();
+    UpperToFull[1].clear();
+    Coarse.clear();
+    CoarseWork.clear();
+    PatternVersion = -1;
+}
+
+double CAMGPreconditioner::Complexity() const
+{
+    if (Levels.empty())
+        return 0;
+    double nnz = 0;
+    for (const Level &lvl: Levels)
+        nnz += lvl.A.value.size();
+    return nnz / Levels[0].A.value.size();
+}
+
+bool CAMGPreconditioner::Setup(int n, const int *rowStart, const int *colIndex, const double *value)
+{
+    Clear();
+
+    // finest level: expand the upper triangle to a full matrix
+    Levels.emplace_back();
+    CSRMatrix &A = Levels[0].A;
+    A.rows = n;
+    A.cols = n;
+    A.rowStart.assign(n+1,0);
+    for (int i=0; i<n; i++)
+    {
+        A.rowStart[i+1]++;
+        for (int e=rowStart[i]+1; e<rowStart[i+1]; e++)
+        {
+            A.rowStart[i+1]++;
+            A.rowStart[colIndex[e]+1]++;
+        }
+    }
+    for (int i=0; i<n; i++)
+        A.rowStart[i+1] += A.rowStart[i];
+    A.colIndex.resize(A.rowStart[n]);
+    A.value.resize(A.rowStart[n]);
+    UpperToFull[0].resize(rowStart[n]);
+    UpperToFull[1].resize(rowStart[n]);
+
+    // the lower triangle of row i comes from rows j<i, so filling the rows in order keeps them sorted
+    std::vector<int> fill(A.rowStart.begin(), A.rowStart.end()-1);
+    for (int i=0; i<n; i++)
+    {
+        for (int e=rowStart[i]; e<rowStart[i+1]; e++)
+        {
+            int j = colIndex[e];
+            UpperToFull[0][e] = fill[i];
+            A.colIndex[fill[i]++] = j;
+            if (j!=i)
+            {
+                UpperToFull[1][e] = fill[j];
+                A.colIndex[fill[j]++] = i;
+            } else {
+                UpperToFull[1][e] = UpperToFull[0][e];
+            }
+        }
+    }
+    for (int e=0; e<rowStart[n]; e++)
+    {
+        A.value[UpperToFull[0][e]] = value[e];
+        A.value[UpperToFull[1][e]] = value[e];
+    }
+    FindDiagonal(Levels[0]);
+
+    // coarsen
+    double theta = THETA;
+    while (Levels.back().A.rows > MAXCOARSE && (int)Levels.size() < MAXLEVELS)
+    {
+        Level &fine = Levels.back();
+        const int nf = fine.A.rows;
+
+        std::vector<int> agg;
+        int nc = Aggregate(fine.A, fine.diag, theta, agg);
+        if (nc==0 || nc > 0.8*nf)
+            break; // coarsening stalls
+
+        // tentative prolongator: piecewise constant on each aggregate, normalized columns
+        std::vector<int> aggsize(nc,0);
+        for (int i=0; i<nf; i++)
+            if (agg[i]>=0) aggsize[agg[i]]++;
+        CSRMatrix T;
+        T.rows = nf;
+        T.cols = nc;
+        T.rowStart.resize(nf+1);
+        for (int i=0; i<nf; i++)
+        {
+            T.rowStart[i] = static_cast<int>(T.colIndex.size());
+            if (agg[i]>=0)
+            {
+                T.colIndex.push_back(agg[i]);
+                T.value.push_back(1./sqrt(static_cast<double>(aggsize[agg[i]])));
+            }
+        }
+        T.rowStart[nf] = static_cast<int>(T.colIndex.size());
+
+        // smoothed prolongator: P = (I - omega D^-1 A) T
+        double omega = 4./3./SpectralRadius(fine.A, fine.diag);
+        CSRMatrix AT;
+        Multiply(fine.A, T, AT);
+        CSRMatrix &P = fine.P;
+        P.rows = nf;
+        P.cols = nc;
+        P.rowStart.resize(nf+1);
+        P.colIndex.clear();
+        P.value.clear();
+        std::vector<double> row(nc,0.);
+        std::vector<int> mark(nc,-1);
+        for (int i=0; i<nf; i++)
+        {
+            P.rowStart[i] = static_cast<int>(P.colIndex.size());
+            const double s = omega/fine.A.value[fine.diag[i]];
+            std::vector<int> cols;
+            for (int e=T.rowStart[i]; e<T.rowStart[i+1]; e++)
+            {
+                int c = T.colIndex[e];
+                if (mark[c]!=i) { mark[c]=i; row[c]=0; cols.push_back(c); }
+                row[c] += T.value[e];
+            }
+            for (int e=AT.rowStart[i]; e<AT.rowStart[i+1]; e++)
+            {
+                int c = AT.colIndex[e];
+                if (mark[c]!=i) { mark[c]=i; row[c]=0; cols.push_back(c); }
+                row[c] -= s*AT.value[e];
+            }
+            std::sort(cols.begin(), cols.end());
+            for (int c: cols)
+            {
+                if (row[c]!=0)
+                {
+                    P.colIndex.push_back(c);
+                    P.value.push_back(row[c]);
+                }
+            }
+        }
+        P.rowStart[nf] = static_cast<int>(P.colIndex.size());
+
+        // Galerkin coarse operator
+        Transpose(P, fine.R);
+        Multiply(fine.A, P, fine.AP);
+        Levels.emplace_back();
+        Level &coarse = Levels.back();
+        Level &f = Levels[Levels.size()-2]; // emplace_back may have moved the fine level
+        Multiply(f.R, f.AP, coarse.A);
+        FindDiagonal(coarse);
+
+        theta *= 0.5;
+    }
+
+    for (Level &lvl: Levels)
+    {
+        lvl.x.assign(lvl.A.rows,0.);
+        lvl.b.assign(lvl.A.rows,0.);
+        lvl.r.assign(lvl.A.rows,0.);
+    }
+
+    if (!FactorCoarse())
+    {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+bool CAMGPreconditioner::Refresh(const double *value)
+{
+    if (Levels.empty())
+        return false;
+
+    CSRMatrix &A = Levels[0].A;
+    for (int e=0; e<(int)UpperToFull[0].size(); e++)
+    {
+        A.value[UpperToFull[0][e]] = value[e];
+        A.value[UpperToFull[1][e]] = value[e];
+    }
+    for (int l=0; l+1<(int)Levels.size(); l++)
+    {
+        MultiplyNumeric(Levels[l].A, Levels[l].P, Levels[l].AP);
+        MultiplyNumeric(Levels[l].R, Levels[l].AP, Levels[l+1].A);
+    }
+    return FactorCoarse();
+}
+
+void CAMGPreconditioner::Solve(const double *X, double *Y)
+{
+    Level &fine = Levels[0];
+    std::copy(X, X+fine.A.rows, fine.b.begin());
+    Cycle(0);
+    std::copy(fine.x.begin(), fine.x.end(), Y);
+}
+
+void CAMGPreconditioner::Cycle(int l)
+{
+    Level &lvl = Levels[l];
+    const CSRMatrix &A = lvl.A;
+    const int n = A.rows;
+    const int *rs = A.rowStart.data();
+    const int *col = A.colIndex.data();
+    const double *val = A.value.data();
+    double *x = lvl.x.data();
+    const double *b = lvl.b.data();
+    int i,e;
+    double s;
+
+    if (l+1 == (int)Levels.size())
+    {
+        // coarsest level: forward and backward substitution with the dense factor
+        const double *L = Coarse.data();
+        double *y = CoarseWork.data();
+        for (i=0; i<n; i++)
+        {
+            s = b[i];
+            for (e=0; e<i; e++) s -= L[i*n+e]*y[e];
+            y[i] = (L[i*n+i]!=0) ? s/L[i*n+i] : 0;
+        }
+        for (i=n-1; i>=0; i--)
+        {
+            s = y[i];
+            for (e=i+1; e<n; e++) s -= L[e*n+i]*x[e];
+            x[i] = (L[i*n+i]!=0) ? s/L[i*n+i] : 0;
+        }
+        return;
+    }
+
+    // pre-smoothing: forward Gauss-Seidel, starting from zero
+    for (i=0; i<n; i++)
+    {
+        s = b[i];
+        for (e=rs[i]; e<rs[i+1]; e++)
+            if (col[e]<i) s -= val[e]*x[col[e]];
+        x[i] = s/val[lvl.diag[i]];
+    }
+
+    // residual and restriction
+    double *r = lvl.r.data();
+    for (i=0; i<n; i++)
+    {
+        s = b[i];
+        for (e=rs[i]; e<rs[i+1]; e++)
+            s -= val[e]*x[col[e]];
+        r[i] = s;
+    }
+    Level &next = Levels[l+1];
+    for (i=0; i<lvl.R.rows; i++)
+    {
+        s = 0;
+        for (e=lvl.R.rowStart[i]; e<lvl.R.rowStart[i+1]; e++)
+            s += lvl.R.value[e]*r[lvl.R.colIndex[e]];
+        next.b[i] = s;
+    }
+
+    Cycle(l+1);
+
+    // prolongation
+    for (i=0; i<n; i++)
+    {
+        s = 0;
+        for (e=lvl.P.rowStart[i]; e<lvl.P.rowStart[i+1]; e++)
+            s += lvl.P.value[e]*next.x[lvl.P.colIndex[e]];
+        x[i] += s;
+    }
+
+    // post-smoothing: backward Gauss-Seidel
+    for (i=n-1; i>=0; i--)
+    {
+        s = b[i];
+        for (e=rs[i]; e<rs[i+1]; e++)
+            if (col[e]!=i) s -= val[e]*x[col[e]];
+        x[i] = s/val[lvl.diag[i]];
+    }
+}
+
+void CAMGPreconditioner::FindDiagonal(Level &lvl)
+{
+    const CSRMatrix &A = lvl.A;
+    lvl.diag.assign(A.rows,-1);
+    for (int i=0; i<A.rows; i++)
+        for (int e=A.rowStart[i]; e<A.rowStart[i+1]; e++)
+            if (A.colIndex[e]==i) lvl.diag[i] = e;
+}
+
+int CAMGPreconditioner::Aggregate(const CSRMatrix &A, const std::vector<int> &diag, double theta, std::vector<int> &agg) const
+{
+    const int n = A.rows;
+    agg.assign(n,-1);
+    int nagg = 0;
+
+    // strong connections: |a_ij| >= theta*sqrt(|a_ii*a_jj|)
+    auto strong = [&](int i, int e) {
+        int j = A.colIndex[e];
+        return j!=i && fabs(A.value[e]) >= theta*sqrt(fabs(A.value[diag[i]]*A.value[diag[j]])) && A.value[e]!=0;
+    };
+
+    // phase 1: aggregates of nodes whose strong neighbours are all free
+    for (int i=0; i<n; i++)
+    {
+        if (agg[i]>=0) continue;
+        bool free = true;
+        bool connected = false;
+        for (int e=A.rowStart[i]; e<A.rowStart[i+1] && free; e++)
+        {
+            if (strong(i,e))
+            {
+                connected = true;
+                if (agg[A.colIndex[e]]>=0) free = false;
+            }
+        }
+        if (!free || !connected) continue;
+        agg[i] = nagg;
+        for (int e=A.rowStart[i]; e<A.rowStart[i+1]; e++)
+            if (strong(i,e)) agg[A.colIndex[e]] = nagg;
+        nagg++;
+    }
+
+    // phase 2: attach remaining nodes to the aggregate of their strongest neighbour
+    std::vector<int> agg1(agg);
+    for (int i=0; i<n; i++)
+    {
+        if (agg1[i]>=0) continue;
+        double best = 0;
+        for (int e=A.rowStart[i]; e<A.rowStart[i+1]; e++)
+        {
+            if (strong(i,e) && agg1[A.colIndex[e]]>=0 && fabs(A.value[e])>best)
+            {
+                best = fabs(A.value[e]);
+                agg[i] = agg1[A.colIndex[e]];
+            }
+        }
+    }
+
+    // phase 3: group what is left with its free strong neighbours.
+    // Nodes without strong connections (e.g. fixed values) are not aggregated at all; the smoother takes care of them.
+    for (int i=0; i<n; i++)
+    {
+        if (agg[i]>=0) continue;
+        bool connected = false;
+        for (int e=A.rowStart[i]; e<A.rowStart[i+1]; e++)
+        {
+            if (strong(i,e))
+            {
+                connected = true;
+                if (agg[A.colIndex[e]]<0) agg[A.colIndex[e]] = nagg;
+            }
+        }
+        if (connected)
+            agg[i] = nagg++;
+    }
+
+    return nagg;
+}
+
+double CAMGPreconditioner::SpectralRadius(const CSRMatrix &A, const std::vector<int> &diag) const
+{
+    // a few power iterations on D^-1 A
+    const int n = A.rows;
+    std::vector<double> v(n), w(n);
+    for (int i=0; i<n; i++)
+        v[i] = 0.5 + ((i*7919)%1000)/1000.;
+
+    double rho = 1;
+    for (int k=0; k<15; k++)
+    {
+        double nv = 0, nw = 0;
+        for (int i=0; i<n; i++)
+        {
+            double s = 0;
+            for (int e=A.rowStart[i]; e<A.rowStart[i+1]; e++)
+                s += A.value[e]*v[A.colIndex[e]];
+            w[i] = s/A.value[diag[i]];
+            nv += v[i]*v[i];
+            nw += w[i]*w[i];
+        }
+        if (nv==0 || nw==0) break;
+        rho = sqrt(nw/nv);
+        for (int i=0; i<n; i++)
+            v[i] = w[i]/sqrt(nw);
+    }
+    return rho;
+}
+
+bool CAMGPreconditioner::FactorCoarse()
+{
+    const CSRMatrix &A = Levels.back().A;
+    const int n = A.rows;
+    Coarse.assign(n*n,0.);
+    CoarseWork.assign(n,0.);
+    double *L = Coarse.data();
+
+    double scale = 0;
+    for (int i=0; i<n; i++)
+    {
+        for (int e=A.rowStart[i]; e<A.rowStart[i+1]; e++)
+        {
+            if (A.colIndex[e]<=i)
+                L[i*n+A.colIndex[e]] = A.value[e];
+            if (A.colIndex[e]==i)
+                scale = std::max(scale, fabs(A.value[e]));
+        }
+    }
+
+    // dense Cholesky factorization (lower triangle, in place).
+    // Pivots that vanish (e.g. a floating potential) are skipped, which yields a pseudo-inverse.
+    for (int j=0; j<n; j++)
+    {
+        double d = L[j*n+j];
+        for (int k=0; k<j; k++) d -= L[j*n+k]*L[j*n+k];
+        if (!(d > 1e-12*scale))
+        {
+            if (d < -1e-8*scale)
+                return false; // not positive definite
+            for (int i=j; i<n; i++) L[i*n+j] = 0;
+            continue;
+        }
+        d = sqrt(d);
+        L[j*n+j] = d;
+        for (int i=j+1; i<n; i++)
+        {
+            double s = L[i*n+j];
+            for (int k=0; k<j; k++) s -= L[i*n+k]*L[j*n+k];
+            L[i*n+j] = s/d;
+        }
+    }
+    return true;
+}
+
+void CAMGPreconditioner::Multiply(const CSRMatrix &A, const CSRMatrix &B, CSRMatrix &C)
+{
+    C.rows = A.rows;
+    C.cols = B.cols;
+    C.rowStart.assign(A.rows+1,0);
+    C.colIndex.clear();
+    std::vector<int> mark(B.cols,-1);
+    for (int i=0; i<A.rows; i++)
+    {
+        int start = static_cast<int>(C.colIndex.size());
+        C.rowStart[i] = start;
+        for (int e=A.rowStart[i]; e<A.rowStart[i+1]; e++)
+        {
+            int k = A.colIndex[e];
+            for (int f=B.rowStart[k]; f<B.rowStart[k+1]; f++)
+            {
+                int j = B.colIndex[f];
+                if (mark[j]!=i)
+                {
+                    mark[j] = i;
+                    C.colIndex.push_back(j);
+                }
+            }
+        }
+        std::sort(C.colIndex.begin()+start, C.colIndex.end());
+    }
+    C.rowStart[A.rows] = static_cast<int>(C.colIndex.size());
+    C.value.assign(C.colIndex.size(),0.);
+    MultiplyNumeric(A,B,C);
+}
+
+void CAMGPreconditioner::MultiplyNumeric(const CSRMatrix &A, const CSRMatrix &B, CSRMatrix &C)
+{
+    std::vector<double> row(B.cols,0.);
+    for (int i=0; i<A.rows; i++)
+    {
+        for (int e=A.rowStart[i]; e<A.rowStart[i+1]; e++)
+        {
+            const int k = A.colIndex[e];
+            const double a = A.value[e];
+            for (int f=B.rowStart[k]; f<B.rowStart[k+1]; f++)
+                row[B.colIndex[f]] += a*B.value[f];
+        }
+        for (int e=C.rowStart[i]; e<C.rowStart[i+1]; e++)
+        {
+            C.value[e] = row[C.colIndex[e]];
+            row[C.colIndex[e]] = 0;
+        }
+    }
+}
+
+void CAMGPreconditioner::Transpose(const CSRMatrix &A, CSRMatrix &T)
+{
+    T.rows = A.cols;
+    T.cols = A.rows;
+    T.rowStart.assign(A.cols+1,0);
+    for (int e=0; e<A.rowStart[A.rows]; e++)
+        T.rowStart[A.colIndex[e]+1]++;
+    for (int i=0; i<A.cols; i++)
+        T.rowStart[i+1] += T.rowStart[i];
+    T.colIndex.resize(A.rowStart[A.rows]);
+    T.value.resize(A.rowStart[A.rows]);
+    std::vector<int> fill(T.rowStart.begin(), T.rowStart.end()-1);
+    for (int i=0; i<A.rows; i++)
+    {
+        for (int e=A.rowStart[i]; e<A.rowStart[i+1]; e++)
+        {
+            int p = fill[A.colIndex[e]]++;
+            T.colIndex[p] = i;
+            T.value[p] = A.value[e];
+        }
+    }
+}
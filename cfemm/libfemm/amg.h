@@ -0,0 +1,117 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef AMG_H
+#define AMG_H
+
+#include <vector>
+
+/**
+ * @brief The CAMGPreconditioner class is a smoothed aggregation algebraic multigrid preconditioner.
+ *
+ * Setup() builds the multigrid hierarchy:
+ *  - unknowns are grouped into aggregates of strongly coupled neighbours,
+ *  - the piecewise constant tentative prolongator is smoothed by one damped Jacobi step,
+ *  - the coarse operators are formed by the Galerkin product P^T A P.
+ *
+ * The aggregates and prolongators only depend on the sparsity pattern and on the matrix values at setup time.
+ * If only the matrix values change (e.g. during a Newton iteration), Refresh() recomputes
+ * the coarse operators for the new values while keeping the prolongators.
+ *
+ * Solve() applies one symmetric V-cycle with a symmetric Gauss-Seidel smoother
+ * and a direct solver on the coarsest level, so the preconditioner is suitable for conjugate gradients.
+ */
+class CAMGPreconditioner
+{
+public:
+    CAMGPreconditioner();
+
+    /**
+     * @brief Build the hierarchy for a symmetric matrix.
+     *
+     * The matrix is given by its upper triangle in compressed row storage,
+     * where the diagonal element is the first entry of each row (see CBigCSRLinProb).
+     *
+     * @param n dimension of the matrix
+     * @param rowStart index of the first entry of each row (n+1 entries)
+     * @param colIndex column of each entry
+     * @param value value of each entry
+     * @return \c true on success
+     */
+    bool Setup(int n, const int *rowStart, const int *colIndex, const double *value);
+    /**
+     * @brief Update the hierarchy for new matrix values.
+     * The matrix must have the same sparsity pattern as in the last call to Setup().
+     * @param value value of each entry
+     * @return \c true on success
+     */
+    bool Refresh(const double *value);
+    /**
+     * @brief Apply one V-cycle: Y ~ A^-1 X
+     */
+    void Solve(const double *X, double *Y);
+    /**
+     * @brief Discard the hierarchy.
+     */
+    void Clear();
+
+    bool Valid() const { return !Levels.empty(); }
+    int NumLevels() const { return static_cast<int>(Levels.size()); }
+    /**
+     * @brief The operator complexity, i.e. the number of entries in all levels relative to the finest level.
+     */
+    double Complexity() const;
+
+    int PatternVersion; ///< version of the sparsity pattern the hierarchy was built for; maintained by the owner
+
+private:
+    /// general sparse matrix in compressed row storage
+    struct CSRMatrix
+    {
+        int rows;
+        int cols;
+        std::vector<int> rowStart;
+        std::vector<int> colIndex;
+        std::vector<double> value;
+    };
+
+    struct Level
+    {
+        CSRMatrix A;  ///< operator on this level (both triangles)
+        CSRMatrix P;  ///< prolongator to this level from the next coarser level
+        CSRMatrix R;  ///< restriction (transpose of P)
+        CSRMatrix AP; ///< A*P, kept to refresh the coarse operator
+        std::vector<int> diag; ///< index of the diagonal entry of each row of A
+        std::vector<double> x; ///< solution on this level
+        std::vector<double> b; ///< right hand side on this level
+        std::vector<double> r; ///< residual on this level
+    };
+
+    void Cycle(int l);
+    void FindDiagonal(Level &lvl);
+    int Aggregate(const CSRMatrix &A, const std::vector<int> &diag, double theta, std::vector<int> &agg) const;
+    double SpectralRadius(const CSRMatrix &A, const std::vector<int> &diag) const;
+    bool FactorCoarse();
+
+    static void Multiply(const CSRMatrix &A, const CSRMatrix &B, CSRMatrix &C);
+    static void MultiplyNumeric(const CSRMatrix &A, const CSRMatrix &B, CSRMatrix &C);
+    static void Transpose(const CSRMatrix &A, CSRMatrix &T);
+
+    std::vector<Level> Levels;
+    std::vector<int> UpperToFull[2]; ///< position of each upper triangle entry (and of its mirror) in the finest level
+    std::vector<double> Coarse;      ///< dense Cholesky factor of the coarsest operator
+    std::vector<double> CoarseWork;
+};
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ * The source code in this file extends the material code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "bhcache.h"
+
+#include "CMaterialProp.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <tuple>
+#include <typeinfo>
+
+namespace {
+const char *const CACHE_FILE_HEADER = "xfemm-bhcurve-cache 1";
+
+void writeVector(std::ostream &out, const std::vector<double> &v)
+{
+    out << v.size();
+    for (double x : v)
+        out << " " << x;
+    out << "\n";
+}
+
+bool readVector(std::istream &in, std::vector<double> &v)
+{
+    size_t n;
+    if (!(in >> n))
+        return false;
+    v.resize(n);
+    for (size_t i=0; i<n; i++)
+        if (!(in >> v[i]))
+            return false;
+    return true;
+}
+} // namespace
+
+using namespace femm;
+
+CBHCurveCache &CBHCurveCache::global()
+{
+    static CBHCurveCache cache;
+    return cache;
+}
+
+CBHCurveCache::CBHCurveCache(size_t maxCurves)
+    : Curves()
+    , Limit(maxCurves)
+    , UseCounter(0)
+    , Mutex()
+{
+}
+
+bool CBHCurveCache::Key::operator<(const CBHCurveCache::Key &other) const
+{
+    return std::tie(kind, omega, thetaHn, lamType, lamFill, lamD, cduct, B, H)
+            < std::tie(other.kind, other.omega, other.thetaHn, other.lamType, other.lamFill, other.lamD, other.cduct, other.B, other.H);
+}
+
+CBHCurveCache::Key CBHCurveCache::makeKey(const CMMaterialProp &prop, const std::vector<double> &B, const std::vector<double> &H, double omega)
+{
+    Key key;
+    key.kind = typeid(prop).name();
+    key.omega = omega;
+    key.thetaHn = prop.Theta_hn;
+    key.lamType = prop.LamType;
+    key.lamFill = prop.LamFill;
+    key.lamD = prop.Lam_d;
+    key.cduct = prop.Cduct;
+    key.B = B;
+    key.H = H;
+    return key;
+}
+
+bool CBHCurveCache::Lookup(CMMaterialProp &prop, double omega)
+{
+    std::vector<double> h(2*prop.Hdata.size());
+    for (size_t i=0; i<prop.Hdata.size(); i++)
+    {
+        h[2*i] = prop.Hdata[i].re;
+        h[2*i+1] = prop.Hdata[i].im;
+    }
+    const Key key = makeKey(prop, prop.Bdata, h, omega);
+
+    std::lock_guard<std::mutex> lock(Mutex);
+    auto it = Curves.find(key);
+    if (it == Curves.end())
+        return false;
+
+    Curve &curve = it->second;
+    curve.lastUse = ++UseCounter;
+    const size_t n = curve.B.size();
+    prop.Bdata = curve.B;
+    prop.Hdata.resize(n);
+    prop.slope.resize(n);
+    for (size_t i=0; i<n; i++)
+    {
+        prop.Hdata[i] = CComplex(curve.H[2*i], curve.H[2*i+1]);
+        prop.slope[i] = CComplex(curve.slope[2*i], curve.slope[2*i+1]);
+    }
+    if (omega!=0)
+        prop.MuMax = curve.muMax;
+    return true;
+}
+
+void CBHCurveCache::Store(const std::vector<double> &B, const std::vector<double> &H, const CMMaterialProp &prop, double omega)
+{
+    Curve curve;
+    curve.B = prop.Bdata;
+    const size_t n = prop.Bdata.size();
+    curve.H.resize(2*n);
+    curve.slope.resize(2*n);
+    for (size_t i=0; i<n; i++)
+    {
+        curve.H[2*i] = prop.Hdata[i].re;
+        curve.H[2*i+1] = prop.Hdata[i].im;
+        curve.slope[2*i] = prop.slope[i].re;
+        curve.slope[2*i+1] = prop.slope[i].im;
+    }
+    curve.muMax = (omega!=0) ? prop.MuMax : 0;
+
+    std::lock_guard<std::mutex> lock(Mutex);
+    curve.lastUse = ++UseCounter;
+    Curves[makeKey(prop, B, H, omega)] = curve;
+    evict();
+}
+
+void CBHCurveCache::evict()
+{
+    if (Limit==0)
+        return;
+    while (Curves.size() > Limit)
+    {
+        auto oldest = Curves.begin();
+        for (auto it = Curves.begin(); it != Curves.end(); ++it)
+        {
+            if (it->second.lastUse < oldest->second.lastUse)
+                oldest = it;
+        }
+        Curves.erase(oldest);
+    }
+}
+
+void CBHCurveCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    Curves.clear();
+}
+
+int CBHCurveCache::Size() const
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    return static_cast<int>(Curves.size());
+}
+
+size_t CBHCurveCache::MaxCurves() const
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    return Limit;
+}
+
+void CBHCurveCache::SetMaxCurves(size_t maxCurves)
+{
+    std::lock_guard<std::mutex> lock(Mutex);
+    Limit = maxCurves;
+    evict();
+}
+
+bool CBHCurveCache::Save(const std::string &fileName) const
+{
+    std::ofstream out(fileName);
+    if (!out)
+        return false;
+    out.precision(std::numeric_limits<double>::max_digits10);
+
+    std::lock_guard<std::mutex> lock(Mutex);
+    // keep the order of use, so that Load() restores it
+    std::vector<std::map<Key,Curve>::const_iterator> entries;
+    for (auto it = Curves.begin(); it != Curves.end(); ++it)
+        entries.push_back(it);
+    std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+        return a->second.lastUse < b->second.lastUse;
+    });
+
+    out << CACHE_FILE_HEADER << "\n" << Curves.size() << "\n";
+    for (const auto &entry : entries)
+    {
+        const Key &key = entry->first;
+        const Curve &curve = entry->second;
+        out << key.kind << " " << key.omega << " " << key.thetaHn << " " << key.lamType
+            << " " << key.lamFill << " " << key.lamD << " " << key.cduct << "\n";
+        writeVector(out, key.B);
+        writeVector(out, key.H);
+        writeVector(out, curve.B);
+        writeVector(out, curve.H);
+        writeVector(out, curve.slope);
+        out << curve.muMax << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+bool CBHCurveCache::Load(const std::string &fileName)
+{
+    std::ifstream in(fileName);
+    std::string header;
+    if (!std::getline(in, header) || header != CACHE_FILE_HEADER)
+        return false;
+
+    size_t count;
+    if (!(in >> count))
+        return false;
+    std::vector<std::pair<Key,Curve>> curves;
+    for (size_t i=0; i<count; i++)
+    {
+        Key key;
+        Curve curve;
+        if (!(in >> key.kind >> key.omega >> key.thetaHn >> key.lamType >> key.lamFill >> key.lamD >> key.cduct))
+            return false;
+        if (!readVector(in, key.B) || !readVector(in, key.H)
+                || !readVector(in, curve.B) || !readVector(in, curve.H) || !readVector(in, curve.slope))
+            return false;
+        if (!(in >> curve.muMax))
+            return false;
+        // the curves must be consistent, since Lookup() does not check them
+        if (key.H.size() != 2*key.B.size() || curve.H.size() != 2*curve.B.size() || curve.slope.size() != curve.H.size())
+            return false;
+        curves.emplace_back(key, curve);
+    }
+
+    // the loaded curves count as used now, in the order of the file
+    std::lock_guard<std::mutex> lock(Mutex);
+    for (auto &entry : curves)
+    {
+        entry.second.lastUse = ++UseCounter;
+        Curves[entry.first] = entry.second;
+    }
+    evict();
+    return true;
+}
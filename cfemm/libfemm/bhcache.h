@@ -0,0 +1,124 @@
+/*
+ * The source code in this file extends the material code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef FEMM_BHCACHE_H
+#define FEMM_BHCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace femm {
+class CMMaterialProp;
+
+/**
+ * @brief The CBHCurveCache class keeps the BH curves processed by CMMaterialProp::GetSlopes().
+ *
+ * For harmonic problems, GetSlopes() derives an effective complex BH curve from the DC curve,
+ * and for conductive laminations it solves a 1-D eddy current problem for each point of the curve.
+ * In a frequency sweep, the same materials are processed at the same frequencies over and over,
+ * so the processed curves are kept, keyed by everything they depend on:
+ * the DC curve, the frequency, the hysteresis angle and the lamination parameters.
+ *
+ * The cache lives as long as the process (e.g. one femmcli session),
+ * and can be saved to and loaded from a file.
+ * When it holds more than MaxCurves() curves, the least recently used curves are removed.
+ */
+class CBHCurveCache
+{
+public:
+    /// the cache used by CMMaterialProp::GetSlopes()
+    static CBHCurveCache &global();
+
+    /// the default size limit of the cache, in curves
+    static constexpr size_t DefaultMaxCurves = 1000;
+
+    /**
+     * @brief Construct a BH curve cache.
+     * @param maxCurves the size limit, or 0 for no limit
+     */
+    explicit CBHCurveCache(size_t maxCurves = DefaultMaxCurves);
+
+    /**
+     * @brief Replace the BH curve of \p prop by the processed curve for \p omega, if it is cached.
+     * Sets Bdata, Hdata and slope, and for harmonic problems MuMax.
+     * @return \c true on success; \p prop is unchanged otherwise.
+     */
+    bool Lookup(CMMaterialProp &prop, double omega);
+    /**
+     * @brief Remember the processed curve of \p prop.
+     * @param B the DC curve (B values) that was processed
+     * @param H the DC curve (H values) that was processed
+     * @param prop the material, after GetSlopes(omega)
+     */
+    void Store(const std::vector<double> &B, const std::vector<double> &H, const CMMaterialProp &prop, double omega);
+
+    void Clear();
+    int Size() const;
+
+    size_t MaxCurves() const;
+    /// Set the size limit (0 for no limit), and remove the least recently used curves that exceed it.
+    void SetMaxCurves(size_t maxCurves);
+
+    /**
+     * @brief Write all cached curves to a text file, the least recently used first.
+     * @return \c false if the file could not be written.
+     */
+    bool Save(const std::string &fileName) const;
+    /**
+     * @brief Add the curves from a file written by Save().
+     * @return \c false if the file could not be read; nothing is added in that case.
+     */
+    bool Load(const std::string &fileName);
+
+private:
+    struct Key
+    {
+        std::string kind; ///< material class, since the lamination model is virtual
+        double omega;
+        double thetaHn;
+        int lamType;
+        double lamFill;
+        double lamD;
+        double cduct;
+        std::vector<double> B; ///< DC curve
+        std::vector<double> H; ///< DC curve, real and imaginary parts interleaved
+
+        bool operator<(const Key &other) const;
+    };
+    struct Curve
+    {
+        std::vector<double> B;     ///< processed curve
+        std::vector<double> H;     ///< processed curve, real and imaginary parts interleaved
+        std::vector<double> slope; ///< real and imaginary parts interleaved
+        double muMax;
+        uint64_t lastUse;          ///< value of UseCounter when the curve was last stored or looked up
+    };
+
+    static Key makeKey(const CMMaterialProp &prop, const std::vector<double> &B, const std::vector<double> &H, double omega);
+    /// remove the least recently used curves until the size limit is met; the caller holds the Mutex
+    void evict();
+
+    std::map<Key,Curve> Curves;
+    size_t Limit;
+    uint64_t UseCounter;
+    mutable std::mutex Mutex;
+};
+
+} // namespace femm
+
+#endif
@@ -0,0 +1,713 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "ccsrspars.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <utility>
+
+#ifdef DEBUG_CCSRSPARS
+#define debug std::cerr << __func__ << "(): "
+#else
+#define debug while(false) std::cerr
+#endif
+
+using std::swap;
+
+CBigComplexCSRLinProb::CBigComplexCSRLinProb()
+    : CBigComplexLinProb()
+    , RowStart()
+    , ColIndex()
+    , NumFillIns(0)
+    , PatternVersion(0)
+    , Direct()
+    , Schedule()
+    , EliminatePeriodicity(true)
+    , PBC()
+    , Reduced()
+    , ReducedPatternVersion(-1)
+{
+}
+
+CBigComplexCSRLinProb::~CBigComplexCSRLinProb()
+{
+}
+
+int CBigComplexCSRLinProb::Create(int d, int bw, int nodes)
+{
+    bdw=bw;
+    NumNodes=nodes;
+    CreateVectors(d);
+
+    // start out with a diagonal matrix
+    RowStart.resize(d+1);
+    ColIndex.resize(d);
+    for (int i=0; i<d; i++)
+    {
+        RowStart[i] = i;
+        ColIndex[i] = i;
+    }
+    RowStart[d] = d;
+    ValueRe[0].assign(d,0.);
+    ValueIm[0].assign(d,0.);
+    for (int k=1; k<4; k++)
+    {
+        ValueRe[k].clear();
+        ValueIm[k].clear();
+    }
+    bNewton=false;
+    NumFillIns = 0;
+    PatternVersion++;
+    PBC.Clear();
+    for (int k=0; k<4; k++)
+    {
+        SavedRe[k].clear();
+        SavedIm[k].clear();
+    }
+    SavedB.clear();
+
+    return 1;
+}
+
+bool CBigComplexCSRLinProb::SetPattern(CSparsityPattern &pattern)
+{
+    if (pattern.Size() != n)
+        return false;
+
+    RowStart.resize(n+1);
+    ColIndex.clear();
+    for (int i=0; i<n; i++)
+    {
+        RowStart[i] = static_cast<int>(ColIndex.size());
+        const std::vector<int> &row = pattern.Row(i);
+        // only keep the upper triangle; the row is sorted, so the diagonal comes first
+        for (auto it = std::lower_bound(row.begin(),row.end(),i); it!=row.end(); ++it)
+            ColIndex.push_back(*it);
+    }
+    RowStart[n] = static_cast<int>(ColIndex.size());
+
+    int nmat = (bNewton) ? 4 : 1;
+    for (int k=0; k<nmat; k++)
+    {
+        ValueRe[k].assign(ColIndex.size(),0.);
+        ValueIm[k].assign(ColIndex.size(),0.);
+    }
+    NumFillIns = 0;
+    PatternVersion++;
+    for (int k=0; k<4; k++)
+    {
+        SavedRe[k].clear();
+        SavedIm[k].clear();
+    }
+    SavedB.clear();
+
+    return true;
+}
+
+int CBigComplexCSRLinProb::Slot(int p, int q) const
+{
+    if (q<p)
+        swap(p,q);
+
+    const int *first = ColIndex.data() + RowStart[p];
+    const int *last = ColIndex.data() + RowStart[p+1];
+    const int *e = std::lower_bound(first, last, q);
+    if (e==last || *e!=q)
+        return -1;
+    return static_cast<int>(e - ColIndex.data());
+}
+
+int CBigComplexCSRLinProb::Insert(int p, int q)
+{
+    if (q<p)
+        swap(p,q);
+
+    auto first = ColIndex.begin() + RowStart[p];
+    auto last = ColIndex.begin() + RowStart[p+1];
+    int pos = static_cast<int>(std::lower_bound(first, last, q) - ColIndex.begin());
+
+    ColIndex.insert(ColIndex.begin()+pos, q);
+    int nmat = (bNewton) ? 4 : 1;
+    for (int k=0; k<nmat; k++)
+    {
+        ValueRe[k].insert(ValueRe[k].begin()+pos, 0.);
+        ValueIm[k].insert(ValueIm[k].begin()+pos, 0.);
+    }
+    for (int k=0; k<4; k++)
+    {
+        if (!SavedRe[k].empty())
+        {
+            SavedRe[k].insert(SavedRe[k].begin()+pos, 0.);
+            SavedIm[k].insert(SavedIm[k].begin()+pos, 0.);
+        }
+    }
+    for (int i=p+1; i<=n; i++)
+        RowStart[i]++;
+    NumFillIns++;
+    PatternVersion++;
+
+    return pos;
+}
+
+void CBigComplexCSRLinProb::CreateNewtonMatrices()
+{
+    if (bNewton)
+        return;
+    bNewton=true;
+    for (int h=1; h<4; h++)
+    {
+        ValueRe[h].assign(ColIndex.size(),0.);
+        ValueIm[h].assign(ColIndex.size(),0.);
+    }
+}
+
+void CBigComplexCSRLinProb::Put(CComplex v, int p, int q, int k)
+{
+    if(q<p)
+    {
+        swap(p,q);
+        if (k==1) v=conj(v);	// hermitian matrix
+        if (k==3) v=-conj(v);	// antihermitian matrix
+    }
+    if (k<0 || k>3)
+        k=0;
+
+    // allocate space for auxilliary matrices if they are actually needed
+    if ((k>0) && (bNewton==false))
+    {
+        CreateNewtonMatrices();
+    }
+
+    int e = Slot(p,q);
+    if (e<0)
+        e = Insert(p,q);
+    ValueRe[k][e] = v.re;
+    ValueIm[k][e] = v.im;
+}
+
+CComplex CBigComplexCSRLinProb::Get(int p, int q, int k)
+{
+    if (k<0 || k>3)
+        k=0;
+    if (k>0 && bNewton==false)
+        return CComplex(0,0);
+
+    int e = Slot(p,q);
+    // if there is no slot for the entry, it must be zero...
+    if (e<0)
+        return CComplex(0,0);
+
+    CComplex v(ValueRe[k][e],ValueIm[k][e]);
+    if (q<p)
+    {
+        if (k==1) return conj(v);	// case where matrix is hermitian...
+        if (k==3) return -conj(v);	// case where matrix is anti-hermitian...
+    }
+    return v;
+}
+
+void CBigComplexCSRLinProb::AddTo(CComplex v, int p, int q)
+{
+    int e = Slot(p,q);
+    if (e<0)
+        e = Insert(p,q);
+    ValueRe[0][e] += v.re;
+    ValueIm[0][e] += v.im;
+}
+
+void CBigComplexCSRLinProb::SymMult(int k, double fr, double fi, double tr, double ti, const CComplex *X, CComplex *Y) const
+{
+    int i,e,c;
+    double xr,xi,yr,yi,er,ei;
+    const int *rs = RowStart.data();
+    const int *col = ColIndex.data();
+    const double *ar = ValueRe[k].data();
+    const double *ai = ValueIm[k].data();
+
+    // the arithmetic is done in the same order as in CComplex,
+    // so that the results match those of CBigComplexLinProb
+    for(i=0; i<n; i++)
+    {
+        xr=X[i].re;
+        xi=X[i].im;
+
+        e=rs[i];
+        er=fr*ar[e];
+        ei=fi*ai[e];
+        yr=Y[i].re + (er*xr - ei*xi);
+        yi=Y[i].im + (er*xi + ei*xr);
+
+        for(e=rs[i]+1; e<rs[i+1]; e++)
+        {
+            c=col[e];
+            er=fr*ar[e];
+            ei=fi*ai[e];
+            yr+=er*X[c].re - ei*X[c].im;
+            yi+=er*X[c].im + ei*X[c].re;
+
+            er=tr*ar[e];
+            ei=ti*ai[e];
+            Y[c].re+=er*xr - ei*xi;
+            Y[c].im+=er*xi + ei*xr;
+        }
+        Y[i].re=yr;
+        Y[i].im=yi;
+    }
+}
+
+void CBigComplexCSRLinProb::MultA(CComplex *X, CComplex *Y, int k)
+{
+    // force the program to give the plain matrix multiply
+    // if auxilliary matrices have not been built
+    if ((!bNewton) && (k!=0)) k=0;
+
+    // the full multiply just combines the multiplies with the individual matrices
+    if ((k==-1) || (k==-2))
+    {
+        CBigComplexLinProb::MultA(X,Y,k);
+        return;
+    }
+    if (k<0 || k>3) k=0;
+
+    for(int i=0; i<n; i++) Y[i]=0;
+
+    switch (k)
+    {
+    case 1:
+        SymMult(k, 1., 1., 1., -1., X, Y); // hermitian
+        break;
+    case 3:
+        SymMult(k, 1., 1., -1., 1., X, Y); // antihermitian
+        break;
+    default:
+        SymMult(k, 1., 1., 1., 1., X, Y); // complex-symmetric
+        break;
+    }
+}
+
+void CBigComplexCSRLinProb::MultConjA(CComplex *X, CComplex *Y, int k)
+{
+    if ((k!=0) && (!bNewton)) k=0;
+    if (k<0 || k>3) k=0;
+
+    for(int i=0; i<n; i++) Y[i]=0;
+
+    switch (k)
+    {
+    case 1:
+        SymMult(k, 1., -1., 1., 1., X, Y); // hermitian
+        break;
+    case 3:
+        SymMult(k, 1., -1., -1., -1., X, Y); // antihermitian
+        break;
+    default:
+        SymMult(k, 1., -1., 1., -1., X, Y); // complex-symmetric
+        break;
+    }
+}
+
+void CBigComplexCSRLinProb::MultPC(CComplex *X, CComplex *Y)
+{
+    // SSOR preconditioner, see CBigComplexLinProb::MultPC
+    int i,e,c;
+    double yr,yi;
+    CComplex cc;
+    const int *rs = RowStart.data();
+    const int *col = ColIndex.data();
+    const double *ar = ValueRe[0].data();
+    const double *ai = ValueIm[0].data();
+
+    cc= Lambda*(2.-Lambda);
+
+    int nthreads = 1;
+    if (femm::useThreads(n))
+    {
+        UpdateSchedule();
+        nthreads = Schedule.SweepThreads(femm::numThreads());
+    }
+
+    if (nthreads>1)
+    {
+        const int *ls = Schedule.LowerStart.data();
+        const int *lcol = Schedule.LowerCol.data();
+        const int *lslot = Schedule.LowerSlot.data();
+        const int *fs = Schedule.ForwardStart.data();
+        const int *frows = Schedule.ForwardRows.data();
+        const int *bs = Schedule.BackwardStart.data();
+        const int *brows = Schedule.BackwardRows.data();
+        const int nfwd = Schedule.NumForwardLevels();
+        const int nbwd = Schedule.NumBackwardLevels();
+
+        // same operations as the serial sweeps below, but the rows of each level are processed concurrently
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+        {
+            // invert Lower Triangle;
+            for(int l=0; l<nfwd; l++)
+            {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for(int k=fs[l]; k<fs[l+1]; k++)
+                {
+                    int r=frows[k];
+                    CComplex y=X[r]*cc;
+                    for(int j=ls[r]; j<ls[r+1]; j++)
+                    {
+                        int s=lslot[j];
+                        const CComplex &x=Y[lcol[j]];
+                        y.re -= (ar[s]*x.re - ai[s]*x.im) * Lambda;
+                        y.im -= (ar[s]*x.im + ai[s]*x.re) * Lambda;
+                    }
+                    y/=CComplex(ar[rs[r]],ai[rs[r]]);
+                    Y[r]=y;
+                }
+            }
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for(int r=0; r<n; r++) Y[r]*=CComplex(ar[rs[r]],ai[rs[r]]);
+
+            // invert Upper Triangle
+            for(int l=0; l<nbwd; l++)
+            {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for(int k=bs[l]; k<bs[l+1]; k++)
+                {
+                    int r=brows[k];
+                    double y_re=Y[r].re;
+                    double y_im=Y[r].im;
+                    for(int j=rs[r]+1; j<rs[r+1]; j++)
+                    {
+                        const CComplex &x=Y[col[j]];
+                        y_re -= (ar[j]*x.re - ai[j]*x.im) * Lambda;
+                        y_im -= (ar[j]*x.im + ai[j]*x.re) * Lambda;
+                    }
+                    Y[r].re=y_re;
+                    Y[r].im=y_im;
+                    Y[r]/=CComplex(ar[rs[r]],ai[rs[r]]);
+                }
+            }
+        }
+        return;
+    }
+
+    for(i=0; i<n; i++) Y[i]=X[i]*cc;
+
+    // invert Lower Triangle;
+    for(i=0; i<n; i++)
+    {
+        Y[i]/= CComplex(ar[rs[i]],ai[rs[i]]);
+        yr=Y[i].re;
+        yi=Y[i].im;
+        for(e=rs[i]+1; e<rs[i+1]; e++)
+        {
+            c=col[e];
+            Y[c].re -= (ar[e]*yr - ai[e]*yi) * Lambda;
+            Y[c].im -= (ar[e]*yi + ai[e]*yr) * Lambda;
+        }
+    }
+
+    for(i=0; i<n; i++) Y[i]*=CComplex(ar[rs[i]],ai[rs[i]]);
+
+    // invert Upper Triangle
+    for(i=n-1; i>=0; i--)
+    {
+        yr=Y[i].re;
+        yi=Y[i].im;
+        for(e=rs[i]+1; e<rs[i+1]; e++)
+        {
+            c=col[e];
+            yr -= (ar[e]*Y[c].re - ai[e]*Y[c].im) * Lambda;
+            yi -= (ar[e]*Y[c].im + ai[e]*Y[c].re) * Lambda;
+        }
+        Y[i].re=yr;
+        Y[i].im=yi;
+        Y[i]/= CComplex(ar[rs[i]],ai[rs[i]]);
+    }
+}
+
+void CBigComplexCSRLinProb::UpdateSchedule()
+{
+    if (Schedule.PatternVersion == PatternVersion)
+        return;
+    Schedule.Build(n, RowStart.data(), ColIndex.data());
+    Schedule.PatternVersion = PatternVersion;
+}
+
+void CBigComplexCSRLinProb::Wipe()
+{
+    for(int i=0; i<n; i++) b[i]=0;
+
+    int nmat = (bNewton) ? 4 : 1;
+    for (int k=0; k<nmat; k++)
+    {
+        std::fill(ValueRe[k].begin(), ValueRe[k].end(), 0.);
+        std::fill(ValueIm[k].begin(), ValueIm[k].end(), 0.);
+    }
+    PBC.Clear();
+}
+
+void CBigComplexCSRLinProb::SaveAssembly()
+{
+    int nmat = (bNewton) ? 4 : 1;
+    for (int k=0; k<4; k++)
+    {
+        if (k<nmat)
+        {
+            SavedRe[k] = ValueRe[k];
+            SavedIm[k] = ValueIm[k];
+        } else {
+            SavedRe[k].clear();
+            SavedIm[k].clear();
+        }
+    }
+    SavedB.assign(b,b+n);
+}
+
+void CBigComplexCSRLinProb::RestoreAssembly()
+{
+    if (SavedRe[0].size() != ValueRe[0].size())
+    {
+        Wipe();
+        return;
+    }
+
+    int nmat = (bNewton) ? 4 : 1;
+    for (int k=0; k<nmat; k++)
+    {
+        // the auxiliary matrices may have been allocated after the copy was made
+        if (SavedRe[k].size() == ValueRe[k].size())
+        {
+            std::copy(SavedRe[k].begin(), SavedRe[k].end(), ValueRe[k].begin());
+            std::copy(SavedIm[k].begin(), SavedIm[k].end(), ValueIm[k].begin());
+        } else {
+            std::fill(ValueRe[k].begin(), ValueRe[k].end(), 0.);
+            std::fill(ValueIm[k].begin(), ValueIm[k].end(), 0.);
+        }
+    }
+    std::copy(SavedB.begin(), SavedB.end(), b);
+    PBC.Clear();
+}
+
+void CBigComplexCSRLinProb::EliminateEntry(int k, int e, bool mirrored, CComplex x)
+{
+    CComplex z(ValueRe[0][e],ValueIm[0][e]);
+    if (z!=0)
+    {
+        b[k]-=(z*x);
+        ValueRe[0][e] = 0.;
+        ValueIm[0][e] = 0.;
+    }
+
+    if (bNewton)
+    {
+        // the mirrored entries of the hermitian and antihermitian matrices are conjugated
+        z = CComplex(ValueRe[1][e], mirrored ? -ValueIm[1][e] : ValueIm[1][e]);
+        if (z!=0)
+        {
+            b[k]=b[k]-(z*x);
+            ValueRe[1][e] = 0.;
+            ValueIm[1][e] = 0.;
+        }
+
+        z = CComplex(ValueRe[2][e],ValueIm[2][e]);
+        if (z!=0)
+        {
+            b[k]=b[k]-(z*conj(x));
+            ValueRe[2][e] = 0.;
+            ValueIm[2][e] = 0.;
+        }
+
+        z = mirrored ? CComplex(-ValueRe[3][e],ValueIm[3][e]) : CComplex(ValueRe[3][e],ValueIm[3][e]);
+        if (z!=0)
+        {
+            b[k]=b[k]-(z*conj(x));
+            ValueRe[3][e] = 0.;
+            ValueIm[3][e] = 0.;
+        }
+    }
+}
+
+void CBigComplexCSRLinProb::SetValue(int i, CComplex x)
+{
+    UpdateSchedule();
+
+    // column i above the diagonal
+    for (int t=Schedule.LowerStart[i]; t<Schedule.LowerStart[i+1]; t++)
+        EliminateEntry(Schedule.LowerCol[t], Schedule.LowerSlot[t], false, x);
+    // column i below the diagonal, i.e. row i
+    for (int e=RowStart[i]+1; e<RowStart[i+1]; e++)
+        EliminateEntry(ColIndex[e], e, true, x);
+
+    // the diagonal of the plain matrix is kept, those of the auxiliary matrices are cleared
+    const int d = RowStart[i];
+    if (bNewton)
+    {
+        for (int k=1; k<4; k++)
+        {
+            ValueRe[k][d] = 0.;
+            ValueIm[k][d] = 0.;
+        }
+    }
+    b[i]=CComplex(ValueRe[0][d],ValueIm[0][d])*x;
+}
+
+void CBigComplexCSRLinProb::Periodicity(int i, int j)
+{
+    if (EliminatePeriodicity)
+        PBC.Add(i,j,1);
+    else
+        CBigComplexLinProb::Periodicity(i,j);
+}
+
+void CBigComplexCSRLinProb::AntiPeriodicity(int i, int j)
+{
+    if (EliminatePeriodicity)
+        PBC.Add(i,j,-1);
+    else
+        CBigComplexLinProb::AntiPeriodicity(i,j);
+}
+
+bool CBigComplexCSRLinProb::UpdateReduced()
+{
+    if (PBC.Empty())
+        return false;
+
+    if (PBC.Build(n) || !Reduced || ReducedPatternVersion != PatternVersion)
+    {
+        int nodes = 0;
+        for (int m : PBC.Masters)
+            if (m<NumNodes) nodes++;
+
+        CSparsityPattern pattern;
+        PBC.BuildPattern(n, RowStart.data(), ColIndex.data(), pattern);
+        Reduced.reset(new CBigComplexCSRLinProb());
+        Reduced->Create(PBC.NumReduced, 0, nodes);
+        Reduced->SetPattern(pattern);
+        PBC.MapEntries(n, RowStart.data(), ColIndex.data(), Reduced->RowStart.data(), Reduced->ColIndex.data());
+        ReducedPatternVersion = PatternVersion;
+    }
+
+    Reduced->Precision = Precision;
+    Reduced->Lambda = Lambda;
+    Reduced->LinearSolver = LinearSolver;
+    if (bNewton && !Reduced->bNewton)
+    {
+        Reduced->bNewton = true;
+        for (int k=1; k<4; k++)
+        {
+            Reduced->ValueRe[k].assign(Reduced->ColIndex.size(),0.);
+            Reduced->ValueIm[k].assign(Reduced->ColIndex.size(),0.);
+        }
+    }
+
+    // reduced matrices S^T A S; the mirrored entry of (re,im) is (tr*re,ti*im)
+    Reduced->Wipe();
+    const double tr[4] = { 1., 1., 1., -1. };
+    const double ti[4] = { 1., -1., 1., 1. };
+    const int nnz = RowStart[n];
+    const int nmat = (bNewton) ? 4 : 1;
+    for (int k=0; k<nmat; k++)
+    {
+        double *rre = Reduced->ValueRe[k].data();
+        double *rim = Reduced->ValueIm[k].data();
+        for (int e=0; e<nnz; e++)
+        {
+            int kind = PBC.Kind[e];
+            double re = ValueRe[k][e];
+            double im = ValueIm[k][e];
+            if (kind<0)
+            {
+                kind = -kind;
+                re = -re;
+                im = -im;
+            }
+            if (kind == CPeriodicElimination::ENTRY_MIRRORED)
+            {
+                re *= tr[k];
+                im *= ti[k];
+            } else if (kind == CPeriodicElimination::ENTRY_MERGED) {
+                re *= 1.+tr[k];
+                im *= 1.+ti[k];
+            }
+            rre[PBC.Slot[e]] += re;
+            rim[PBC.Slot[e]] += im;
+        }
+    }
+    return true;
+}
+
+int CBigComplexCSRLinProb::Solve(int flag)
+{
+    if (!UpdateReduced())
+        return CBigComplexLinProb::Solve(flag);
+
+    PBC.Restrict(b, Reduced->b);
+    if (flag)
+        PBC.Inject(V, Reduced->V);
+    int ok = Reduced->Solve(flag);
+    Iterations = Reduced->Iterations;
+    PBC.Prolong(Reduced->V, V);
+    return ok;
+}
+
+int CBigComplexCSRLinProb::DirectSolve()
+{
+    if (!Direct.Analyzed() || Direct.S.PatternVersion != PatternVersion)
+    {
+        if (!Direct.Analyze(n, RowStart.data(), ColIndex.data()))
+            return 0;
+        Direct.S.PatternVersion = PatternVersion;
+    }
+
+    bool ok;
+    if (bNewton)
+    {
+        const double *re[4] = { ValueRe[0].data(), ValueRe[1].data(), ValueRe[2].data(), ValueRe[3].data() };
+        const double *im[4] = { ValueIm[0].data(), ValueIm[1].data(), ValueIm[2].data(), ValueIm[3].data() };
+        ok = Direct.FactorGeneral(re, im);
+    } else {
+        ok = Direct.FactorSymmetric(ValueRe[0].data(), ValueIm[0].data());
+        if (!ok)
+        {
+            // a pivot vanished; the block factorization also mixes real and imaginary parts
+            debug << "LDL^T factorization failed, trying block LDU\n";
+            const double *re[4] = { ValueRe[0].data(), NULL, NULL, NULL };
+            const double *im[4] = { ValueIm[0].data(), NULL, NULL, NULL };
+            ok = Direct.FactorGeneral(re, im);
+        }
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Sparse factorization failed\n");
+        return 0;
+    }
+    if (Direct.Reused)
+        debug << "Reusing " << (Direct.IsSymmetric() ? "LDL^T" : "block LDU") << " factor\n";
+    else
+        debug << "Sparse " << (Direct.IsSymmetric() ? "LDL^T" : "block LDU") << " factor: "
+              << Direct.NumSupernodes() << " supernodes, " << Direct.NumEntries()
+              << " entries (matrix: " << ColIndex.size() << ")\n";
+
+    Direct.Solve(b,V);
+    return 1;
+}
@@ -0,0 +1,128 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef CCSRSPARS_H
+#define CCSRSPARS_H
+
+#include "femmcomplex.h"
+#include "cdirect.h"
+#include "cspars.h"
+#include "csrspars.h"
+#include "periodic.h"
+
+#include <memory>
+#include <vector>
+
+/**
+ * @brief The CBigComplexCSRLinProb class stores the matrices of a CBigComplexLinProb in compressed row storage.
+ *
+ * The plain matrix \c M and the auxiliary matrices of the Newton-Raphson algorithm
+ * (hermitian \c Mh, complex-symmetric \c Ms, and antihermitian \c Ma)
+ * all have the same structure, so they share a single set of row pointers and column indices.
+ * Only the values are stored separately for each matrix, split into real and imaginary parts.
+ * The values of the auxiliary matrices are only allocated once the first entry is put into one of them.
+ *
+ * Like CBigComplexLinProb, only the upper triangle (including the main diagonal) is stored,
+ * and the diagonal element is always the first entry of each row.
+ * See CBigCSRLinProb for the symbolic and numeric assembly phases.
+ *
+ * For large matrices, the SSOR preconditioner is distributed over femm::numThreads() threads
+ * with the same level scheduled sweeps as in CBigCSRLinProb.
+ *
+ * With \c LinearSolver set to SOLVER_DIRECT, the system is solved by a sparse L D L^T factorization,
+ * or by a block L D U factorization for Newton-Raphson iterations (see CComplexDirectSolver).
+ * The ordering is only recomputed when the sparsity pattern changes,
+ * and the factor is reused as long as the matrix values stay the same.
+ *
+ * Periodic and antiperiodic constraints are eliminated when solving, as in CBigCSRLinProb.
+ * The auxiliary matrices are reduced in the same way, taking into account that the mirrored entries
+ * of the hermitian and antihermitian matrices are conjugated.
+ *
+ * CBigComplexCSRLinProb can be used in place of a CBigComplexLinProb.
+ */
+class CBigComplexCSRLinProb : public CBigComplexLinProb
+{
+public:
+    CBigComplexCSRLinProb();
+    ~CBigComplexCSRLinProb();
+
+    int Create(int d, int bw, int nodes) override;
+    /**
+     * @brief Allocate the matrix storage from a sparsity pattern.
+     * All matrix entries are reset to zero.
+     * @param pattern a pattern with the same dimension as the matrix
+     * @return \c true on success, \c false if the dimensions do not match.
+     */
+    bool SetPattern(CSparsityPattern &pattern) override;
+
+    void Put(CComplex v, int p, int q, int k=0) override;
+    void CreateNewtonMatrices() override;
+    CComplex Get(int p, int q, int k=0) override;
+    void AddTo(CComplex v, int p, int q) override;
+    void MultA(CComplex *X, CComplex *Y, int k=0) override;
+    void MultConjA(CComplex *X, CComplex *Y, int k=0) override;
+    void MultPC(CComplex *X, CComplex *Y) override;
+    void Wipe() override;
+    /**
+     * @brief Keep a copy of the values and the right hand side, see CBigCSRLinProb::SaveAssembly().
+     */
+    void SaveAssembly() override;
+    void RestoreAssembly() override;
+    int DirectSolve() override;
+    int Solve(int flag) override;
+    /**
+     * @brief Fix unknown \p i to \p x, like CBigComplexLinProb::SetValue().
+     * Only the entries of column \p i are visited, using the transposed index of \c Schedule.
+     */
+    void SetValue(int i, CComplex x) override;
+    void Periodicity(int i, int j) override;
+    void AntiPeriodicity(int i, int j) override;
+
+    /**
+     * @brief Find the storage index of entry (p,q).
+     * @return the index into the value arrays, or -1 if (p,q) is not part of the pattern.
+     */
+    int Slot(int p, int q) const;
+
+    std::vector<int> RowStart; ///< index of the first entry of each row in ColIndex; has n+1 entries
+    std::vector<int> ColIndex; ///< column of each entry
+    std::vector<double> ValueRe[4]; ///< real part of each entry of M, Mh, Ms, and Ma (in the numbering of the \c k argument of Put())
+    std::vector<double> ValueIm[4]; ///< imaginary part of each entry of M, Mh, Ms, and Ma
+    int NumFillIns; ///< number of entries that had to be inserted outside of the pattern
+    int PatternVersion; ///< incremented whenever the sparsity pattern changes
+    CComplexDirectSolver Direct; ///< sparse factorization, if the direct solver is used
+    CLevelSchedule Schedule; ///< transposed index (see SetValue()) and level schedule, if multithreading is used
+    /**
+     * @brief Eliminate periodic and antiperiodic constraints when solving (default),
+     * instead of averaging the rows and columns of the matrices like CBigComplexLinProb.
+     */
+    bool EliminatePeriodicity;
+    CPeriodicElimination PBC; ///< constraints recorded since the last call to Wipe()
+
+private:
+    int Insert(int p, int q);
+    void UpdateSchedule();
+    bool UpdateReduced();
+    /// SetValue() for the entry (k,i) in slot \p e; \p mirrored if the slot stores (i,k)
+    void EliminateEntry(int k, int e, bool mirrored, CComplex x);
+
+    std::vector<double> SavedRe[4]; ///< copy of ValueRe made by SaveAssembly()
+    std::vector<double> SavedIm[4]; ///< copy of ValueIm made by SaveAssembly()
+    std::unique_ptr<CBigComplexCSRLinProb> Reduced; ///< system without the slave unknowns
+    int ReducedPatternVersion; ///< PatternVersion the reduced system was built for
+    /// Y += A*X for the values of matrix \p k; a stored entry (re,im) is used as (fr*re,fi*im) and its mirror as (tr*re,ti*im)
+    void SymMult(int k, double fr, double fi, double tr, double ti, const CComplex *X, CComplex *Y) const;
+};
+
+#endif
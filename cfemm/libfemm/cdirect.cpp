@@ -0,0 +1,525 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "cdirect.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// relative size below which a pivot is considered to vanish
+#define PIVOTTOL 1e-13
+
+// 2x2 real blocks are stored row by row: (a[0] a[1]; a[2] a[3])
+
+// c -= a*b
+static inline void BlockSubMul(double *c, const double *a, const double *b)
+{
+    c[0] -= a[0]*b[0] + a[1]*b[2];
+    c[1] -= a[0]*b[1] + a[1]*b[3];
+    c[2] -= a[2]*b[0] + a[3]*b[2];
+    c[3] -= a[2]*b[1] + a[3]*b[3];
+}
+
+// c = a*b
+static inline void BlockMul(double *c, const double *a, const double *b)
+{
+    c[0] = a[0]*b[0] + a[1]*b[2];
+    c[1] = a[0]*b[1] + a[1]*b[3];
+    c[2] = a[2]*b[0] + a[3]*b[2];
+    c[3] = a[2]*b[1] + a[3]*b[3];
+}
+
+// x -= a*y
+static inline void BlockSubMulVec(double *x, const double *a, const double *y)
+{
+    x[0] -= a[0]*y[0] + a[1]*y[1];
+    x[1] -= a[2]*y[0] + a[3]*y[1];
+}
+
+// real 2x2 block of the operator X -> c*X + s*conj(X)
+static inline void MakeBlock(double *blk, double cr, double ci, double sr, double si)
+{
+    blk[0] = cr+sr;
+    blk[1] = -ci+si;
+    blk[2] = ci+si;
+    blk[3] = cr-sr;
+}
+
+CComplexDirectSolver::CComplexDirectSolver()
+    : S()
+    , Reused(false)
+    , Mode(NONE)
+{
+}
+
+void CComplexDirectSolver::Clear()
+{
+    S.Clear();
+    LValue.clear();
+    UValue.clear();
+    FactoredValue.clear();
+    Work.clear();
+    Mode = NONE;
+    Reused = false;
+}
+
+bool CComplexDirectSolver::Analyze(int n, const int *rowStart, const int *colIndex)
+{
+    Clear();
+    return S.Analyze(n, rowStart, colIndex);
+}
+
+bool CComplexDirectSolver::SameValues(FactorMode mode, const std::vector<double> &values)
+{
+    Reused = (Mode==mode && FactoredValue.size()==values.size()
+              && std::memcmp(FactoredValue.data(), values.data(), values.size()*sizeof(double))==0);
+    return Reused;
+}
+
+bool CComplexDirectSolver::FactorSymmetric(const double *re, const double *im)
+{
+    const int nnz = static_cast<int>(S.ValueIndex.size());
+    std::vector<double> values(re, re+nnz);
+    values.insert(values.end(), im, im+nnz);
+    if (SameValues(SYMMETRIC, values))
+        return true;
+    Mode = NONE;
+
+    const int ns = S.NumSupernodes();
+    LValue.assign(2*S.SnValueStart[ns],0.);
+    UValue.clear();
+
+    std::vector<int> map(S.N);
+    std::vector<int> head(ns,-1);
+    std::vector<int> link(ns,-1);
+    std::vector<int> nextrow(ns,0);
+    std::vector<double> T;
+
+    double scale = 0;
+    for (int j=0; j<S.N; j++)
+    {
+        int e = S.ColStart[j]; // the diagonal comes first in each column
+        int v = S.ValueIndex[e];
+        scale = std::max(scale, sqrt(re[v]*re[v]+im[v]*im[v]));
+    }
+
+    for (int s=0; s<ns; s++)
+    {
+        const int f = S.SnFirst[s];
+        const int l = S.SnFirst[s+1];
+        const int nc = l-f;
+        const int m = S.SnRowStart[s+1]-S.SnRowStart[s];
+        const int *rows = S.SnRows.data() + S.SnRowStart[s];
+        double *Ls = LValue.data() + 2*S.SnValueStart[s];
+
+        for (int r=0; r<m; r++)
+            map[rows[r]] = r;
+
+        // columns of A
+        for (int j=f; j<l; j++)
+        {
+            for (int e=S.ColStart[j]; e<S.ColStart[j+1]; e++)
+            {
+                double *a = Ls + 2*(static_cast<size_t>(j-f)*m + map[S.RowIndex[e]]);
+                a[0] += re[S.ValueIndex[e]];
+                a[1] += im[S.ValueIndex[e]];
+            }
+        }
+
+        // updates from descendants: A(r,c) -= sum_k L(r,k) d_k L(c,k)
+        int d = head[s];
+        while (d>=0)
+        {
+            const int dnext = link[d];
+            const int md = S.SnRowStart[d+1]-S.SnRowStart[d];
+            const int ncd = S.SnFirst[d+1]-S.SnFirst[d];
+            const int *rowsd = S.SnRows.data() + S.SnRowStart[d];
+            const double *Ld = LValue.data() + 2*S.SnValueStart[d];
+            const int p = nextrow[d];
+            int q = p;
+            while (q<md && rowsd[q]<l) q++;
+
+            for (int c=p; c<q; c++)
+            {
+                double *Lsc = Ls + 2*static_cast<size_t>(rowsd[c]-f)*m;
+                for (int k=0; k<ncd; k++)
+                {
+                    const double *Ldk = Ld + 2*static_cast<size_t>(k)*md;
+                    // g = d_k * L(c,k)
+                    const double gr = Ldk[2*k]*Ldk[2*c] - Ldk[2*k+1]*Ldk[2*c+1];
+                    const double gi = Ldk[2*k]*Ldk[2*c+1] + Ldk[2*k+1]*Ldk[2*c];
+                    if (gr==0 && gi==0) continue;
+                    for (int r=c; r<md; r++)
+                    {
+                        double *a = Lsc + 2*map[rowsd[r]];
+                        a[0] -= Ldk[2*r]*gr - Ldk[2*r+1]*gi;
+                        a[1] -= Ldk[2*r]*gi + Ldk[2*r+1]*gr;
+                    }
+                }
+            }
+
+            nextrow[d] = q;
+            if (q<md)
+            {
+                const int t = S.ColSn[rowsd[q]];
+                link[d] = head[t];
+                head[t] = d;
+            }
+            d = dnext;
+        }
+
+        // dense L D L^T factorization of the supernode
+        T.resize(2*m);
+        for (int j=0; j<nc; j++)
+        {
+            double *Lj = Ls + 2*static_cast<size_t>(j)*m;
+            const double dr = Lj[2*j];
+            const double di = Lj[2*j+1];
+            const double dd = dr*dr + di*di;
+            if (!(sqrt(dd) > PIVOTTOL*scale))
+                return false;
+            const double ir = dr/dd;
+            const double ii = -di/dd;
+            for (int r=j+1; r<m; r++)
+            {
+                T[2*r] = Lj[2*r];
+                T[2*r+1] = Lj[2*r+1];
+                Lj[2*r] = T[2*r]*ir - T[2*r+1]*ii;
+                Lj[2*r+1] = T[2*r]*ii + T[2*r+1]*ir;
+            }
+            for (int jj=j+1; jj<nc; jj++)
+            {
+                double *Ljj = Ls + 2*static_cast<size_t>(jj)*m;
+                const double tr = T[2*jj];
+                const double ti = T[2*jj+1];
+                for (int r=jj; r<m; r++)
+                {
+                    Ljj[2*r] -= Lj[2*r]*tr - Lj[2*r+1]*ti;
+                    Ljj[2*r+1] -= Lj[2*r]*ti + Lj[2*r+1]*tr;
+                }
+            }
+        }
+
+        if (nc<m)
+        {
+            nextrow[s] = nc;
+            const int t = S.ColSn[rows[nc]];
+            link[s] = head[t];
+            head[t] = s;
+        }
+    }
+
+    FactoredValue.swap(values);
+    Mode = SYMMETRIC;
+    return true;
+}
+
+bool CComplexDirectSolver::FactorGeneral(const double *const re[4], const double *const im[4])
+{
+    const int nnz = static_cast<int>(S.ValueIndex.size());
+    std::vector<double> values;
+    for (int k=0; k<4; k++)
+    {
+        if (re[k]==NULL) continue;
+        values.insert(values.end(), re[k], re[k]+nnz);
+        values.insert(values.end(), im[k], im[k]+nnz);
+    }
+    if (SameValues(GENERAL, values))
+        return true;
+    Mode = NONE;
+
+    const int ns = S.NumSupernodes();
+    LValue.assign(4*S.SnValueStart[ns],0.);
+    UValue.assign(4*S.SnValueStart[ns],0.);
+
+    std::vector<int> map(S.N);
+    std::vector<int> head(ns,-1);
+    std::vector<int> link(ns,-1);
+    std::vector<int> nextrow(ns,0);
+    std::vector<int> pos;
+    std::vector<double> TL, TU;
+
+    // complex entry of the matrix (M + Mh + Ma) and of Ms
+    // in the direction of the stored upper triangle entry v, or mirrored
+    auto entry = [&](int v, bool mirrored, double &cr, double &ci, double &sr, double &si) {
+        cr = re[0][v];
+        ci = im[0][v];
+        sr = si = 0;
+        if (re[1]!=NULL)
+        {
+            // hermitian part
+            cr += re[1][v];
+            ci += mirrored ? -im[1][v] : im[1][v];
+        }
+        if (re[2]!=NULL)
+        {
+            sr = re[2][v];
+            si = im[2][v];
+        }
+        if (re[3]!=NULL)
+        {
+            // antihermitian part
+            cr += mirrored ? -re[3][v] : re[3][v];
+            ci += im[3][v];
+        }
+    };
+
+    double scale = 0;
+    for (int j=0; j<S.N; j++)
+    {
+        double cr,ci,sr,si,blk[4];
+        entry(S.ValueIndex[S.ColStart[j]], false, cr, ci, sr, si);
+        MakeBlock(blk, cr, ci, sr, si);
+        scale = std::max(scale, fabs(blk[0]*blk[3]-blk[1]*blk[2]));
+    }
+
+    for (int s=0; s<ns; s++)
+    {
+        const int f = S.SnFirst[s];
+        const int l = S.SnFirst[s+1];
+        const int nc = l-f;
+        const int m = S.SnRowStart[s+1]-S.SnRowStart[s];
+        const int *rows = S.SnRows.data() + S.SnRowStart[s];
+        double *Ls = LValue.data() + 4*S.SnValueStart[s];
+        double *Ws = UValue.data() + 4*S.SnValueStart[s];
+
+        for (int r=0; r<m; r++)
+            map[rows[r]] = r;
+
+        // columns of A: L part gets A(r,c), W part gets A(c,r)
+        for (int j=f; j<l; j++)
+        {
+            for (int e=S.ColStart[j]; e<S.ColStart[j+1]; e++)
+            {
+                const size_t idx = 4*(static_cast<size_t>(j-f)*m + map[S.RowIndex[e]]);
+                const int v = S.ValueIndex[e];
+                const bool mirrored = S.Mirrored[e]!=0;
+                double cr,ci,sr,si,blk[4];
+                entry(v, mirrored, cr, ci, sr, si);
+                MakeBlock(blk, cr, ci, sr, si);
+                for (int h=0; h<4; h++) Ls[idx+h] += blk[h];
+                if (S.RowIndex[e]!=j)
+                {
+                    entry(v, !mirrored, cr, ci, sr, si);
+                    MakeBlock(blk, cr, ci, sr, si);
+                    for (int h=0; h<4; h++) Ws[idx+h] += blk[h];
+                }
+            }
+        }
+
+        // updates from descendants:
+        //   A(r,c) -= sum_k L(r,k) D_k U(k,c)   and   A(c,r) -= sum_k L(c,k) D_k U(k,r)
+        int d = head[s];
+        while (d>=0)
+        {
+            const int dnext = link[d];
+            const int md = S.SnRowStart[d+1]-S.SnRowStart[d];
+            const int ncd = S.SnFirst[d+1]-S.SnFirst[d];
+            const int *rowsd = S.SnRows.data() + S.SnRowStart[d];
+            const double *Ld = LValue.data() + 4*S.SnValueStart[d];
+            const double *Wd = UValue.data() + 4*S.SnValueStart[d];
+            const int p = nextrow[d];
+            int q = p;
+            while (q<md && rowsd[q]<l) q++;
+
+            pos.resize(md);
+            for (int r=p; r<md; r++)
+                pos[r] = 4*map[rowsd[r]];
+
+            for (int c=p; c<q; c++)
+            {
+                const size_t col = 4*static_cast<size_t>(rowsd[c]-f)*m;
+                for (int k=0; k<ncd; k++)
+                {
+                    const double *Ldk = Ld + 4*static_cast<size_t>(k)*md;
+                    const double *Wdk = Wd + 4*static_cast<size_t>(k)*md;
+                    const double *Dk = Ldk + 4*k;
+                    double G[4], H[4];
+                    BlockMul(G, Dk, Wdk+4*c); // D_k U(k,c)
+                    BlockMul(H, Ldk+4*c, Dk); // L(c,k) D_k
+                    BlockSubMul(Ls + col + pos[c], Ldk+4*c, G);
+                    for (int r=c+1; r<md; r++)
+                    {
+                        BlockSubMul(Ls + col + pos[r], Ldk+4*r, G);
+                        BlockSubMul(Ws + col + pos[r], H, Wdk+4*r);
+                    }
+                }
+            }
+
+            nextrow[d] = q;
+            if (q<md)
+            {
+                const int t = S.ColSn[rowsd[q]];
+                link[d] = head[t];
+                head[t] = d;
+            }
+            d = dnext;
+        }
+
+        // dense block L D U factorization of the supernode
+        TL.resize(4*m);
+        TU.resize(4*m);
+        for (int j=0; j<nc; j++)
+        {
+            double *Lj = Ls + 4*static_cast<size_t>(j)*m;
+            double *Wj = Ws + 4*static_cast<size_t>(j)*m;
+            const double *D = Lj + 4*j;
+            const double det = D[0]*D[3]-D[1]*D[2];
+            if (!(fabs(det) > PIVOTTOL*scale))
+                return false;
+            const double Dinv[4] = { D[3]/det, -D[1]/det, -D[2]/det, D[0]/det };
+            for (int r=j+1; r<m; r++)
+            {
+                for (int h=0; h<4; h++)
+                {
+                    TL[4*r+h] = Lj[4*r+h];
+                    TU[4*r+h] = Wj[4*r+h];
+                }
+                BlockMul(Lj+4*r, TL.data()+4*r, Dinv); // L(r,j) = A(r,j) D^-1
+                BlockMul(Wj+4*r, Dinv, TU.data()+4*r); // U(j,r) = D^-1 A(j,r)
+            }
+            for (int jj=j+1; jj<nc; jj++)
+            {
+                double *Ljj = Ls + 4*static_cast<size_t>(jj)*m;
+                double *Wjj = Ws + 4*static_cast<size_t>(jj)*m;
+                BlockSubMul(Ljj+4*jj, Lj+4*jj, TU.data()+4*jj);
+                for (int r=jj+1; r<m; r++)
+                {
+                    BlockSubMul(Ljj+4*r, Lj+4*r, TU.data()+4*jj);
+                    BlockSubMul(Wjj+4*r, TL.data()+4*jj, Wj+4*r);
+                }
+            }
+        }
+
+        if (nc<m)
+        {
+            nextrow[s] = nc;
+            const int t = S.ColSn[rows[nc]];
+            link[s] = head[t];
+            head[t] = s;
+        }
+    }
+
+    FactoredValue.swap(values);
+    Mode = GENERAL;
+    return true;
+}
+
+void CComplexDirectSolver::Solve(const CComplex *X, CComplex *Y)
+{
+    const int ns = S.NumSupernodes();
+    Work.resize(2*S.N);
+    double *x = Work.data();
+    for (int k=0; k<S.N; k++)
+    {
+        x[2*k] = X[S.Perm[k]].re;
+        x[2*k+1] = X[S.Perm[k]].im;
+    }
+
+    if (Mode==SYMMETRIC)
+    {
+        // solve L y = x
+        for (int s=0; s<ns; s++)
+        {
+            const int f = S.SnFirst[s];
+            const int nc = S.SnFirst[s+1]-f;
+            const int m = S.SnRowStart[s+1]-S.SnRowStart[s];
+            const int *rows = S.SnRows.data() + S.SnRowStart[s];
+            const double *Ls = LValue.data() + 2*S.SnValueStart[s];
+            for (int j=0; j<nc; j++)
+            {
+                const double *Lj = Ls + 2*static_cast<size_t>(j)*m;
+                const double yr = x[2*(f+j)];
+                const double yi = x[2*(f+j)+1];
+                for (int r=j+1; r<m; r++)
+                {
+                    x[2*rows[r]] -= Lj[2*r]*yr - Lj[2*r+1]*yi;
+                    x[2*rows[r]+1] -= Lj[2*r]*yi + Lj[2*r+1]*yr;
+                }
+                // divide by the pivot
+                const double dr = Lj[2*j];
+                const double di = Lj[2*j+1];
+                const double dd = dr*dr + di*di;
+                x[2*(f+j)] = (yr*dr + yi*di)/dd;
+                x[2*(f+j)+1] = (yi*dr - yr*di)/dd;
+            }
+        }
+
+        // solve L^T x = y
+        for (int s=ns-1; s>=0; s--)
+        {
+            const int f = S.SnFirst[s];
+            const int nc = S.SnFirst[s+1]-f;
+            const int m = S.SnRowStart[s+1]-S.SnRowStart[s];
+            const int *rows = S.SnRows.data() + S.SnRowStart[s];
+            const double *Ls = LValue.data() + 2*S.SnValueStart[s];
+            for (int j=nc-1; j>=0; j--)
+            {
+                const double *Lj = Ls + 2*static_cast<size_t>(j)*m;
+                double tr = x[2*(f+j)];
+                double ti = x[2*(f+j)+1];
+                for (int r=j+1; r<m; r++)
+                {
+                    tr -= Lj[2*r]*x[2*rows[r]] - Lj[2*r+1]*x[2*rows[r]+1];
+                    ti -= Lj[2*r]*x[2*rows[r]+1] + Lj[2*r+1]*x[2*rows[r]];
+                }
+                x[2*(f+j)] = tr;
+                x[2*(f+j)+1] = ti;
+            }
+        }
+    } else {
+        // solve L y = x, then D z = y
+        for (int s=0; s<ns; s++)
+        {
+            const int f = S.SnFirst[s];
+            const int nc = S.SnFirst[s+1]-f;
+            const int m = S.SnRowStart[s+1]-S.SnRowStart[s];
+            const int *rows = S.SnRows.data() + S.SnRowStart[s];
+            const double *Ls = LValue.data() + 4*S.SnValueStart[s];
+            for (int j=0; j<nc; j++)
+            {
+                const double *Lj = Ls + 4*static_cast<size_t>(j)*m;
+                double *y = x + 2*(f+j);
+                for (int r=j+1; r<m; r++)
+                    BlockSubMulVec(x+2*rows[r], Lj+4*r, y);
+                const double *D = Lj + 4*j;
+                const double det = D[0]*D[3]-D[1]*D[2];
+                const double y0 = y[0];
+                y[0] = (D[3]*y0 - D[1]*y[1])/det;
+                y[1] = (D[0]*y[1] - D[2]*y0)/det;
+            }
+        }
+
+        // solve U x = z
+        for (int s=ns-1; s>=0; s--)
+        {
+            const int f = S.SnFirst[s];
+            const int nc = S.SnFirst[s+1]-f;
+            const int m = S.SnRowStart[s+1]-S.SnRowStart[s];
+            const int *rows = S.SnRows.data() + S.SnRowStart[s];
+            const double *Ws = UValue.data() + 4*S.SnValueStart[s];
+            for (int j=nc-1; j>=0; j--)
+            {
+                const double *Wj = Ws + 4*static_cast<size_t>(j)*m;
+                double *y = x + 2*(f+j);
+                for (int r=j+1; r<m; r++)
+                    BlockSubMulVec(y, Wj+4*r, x+2*rows[r]);
+            }
+        }
+    }
+
+    for (int k=0; k<S.N; k++)
+        Y[S.Perm[k]] = CComplex(x[2*k], x[2*k+1]);
+}
@@ -0,0 +1,93 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef CDIRECT_H
+#define CDIRECT_H
+
+#include "femmcomplex.h"
+#include "spchol.h"
+
+#include <vector>
+
+/**
+ * @brief The CComplexDirectSolver class is a supernodal sparse direct solver for the systems of CBigComplexCSRLinProb.
+ *
+ * Two factorizations are available, both without pivoting and based on the symbolic
+ * factorization of CSupernodalStructure:
+ *  - FactorSymmetric(): complex-symmetric A = L D L^T, for the plain time-harmonic problem.
+ *  - FactorGeneral(): block L D U factorization with real 2x2 blocks for the
+ *    Newton-Raphson system  (M + Mh + Ma) X + Ms conj(X) = b, which is not complex-linear.
+ *    Each complex unknown is split into its real and imaginary part.
+ *    It can also be used for a complex-symmetric matrix if the L D L^T factorization breaks down.
+ *
+ * Like CSparseCholesky, the factor is kept if the matrix values did not change,
+ * so that solves for additional right hand sides only cost a forward and a back substitution.
+ */
+class CComplexDirectSolver
+{
+public:
+    CComplexDirectSolver();
+
+    /**
+     * @brief Compute ordering and symbolic factorization, see CSupernodalStructure::Analyze().
+     */
+    bool Analyze(int n, const int *rowStart, const int *colIndex);
+    /**
+     * @brief Compute the L D L^T factorization of a complex-symmetric matrix.
+     * @param re real part of each entry of the upper triangle
+     * @param im imaginary part of each entry of the upper triangle
+     * @return \c true on success, \c false if a pivot vanishes
+     */
+    bool FactorSymmetric(const double *re, const double *im);
+    /**
+     * @brief Compute the block L D U factorization of the Newton-Raphson system.
+     *
+     * The matrices are given by their upper triangle, in the same order as in CBigComplexCSRLinProb:
+     * 0: complex-symmetric M, 1: hermitian Mh, 2: complex-symmetric Ms, 3: antihermitian Ma.
+     * Matrices 1 to 3 may be \c NULL.
+     *
+     * @return \c true on success, \c false if a pivot block is singular
+     */
+    bool FactorGeneral(const double *const re[4], const double *const im[4]);
+    /**
+     * @brief Compute Y = A^-1 X using the current factor.
+     */
+    void Solve(const CComplex *X, CComplex *Y);
+    /**
+     * @brief Discard ordering and factor.
+     */
+    void Clear();
+
+    bool Analyzed() const { return S.Valid(); }
+    bool Valid() const { return Mode != NONE; }
+    bool IsSymmetric() const { return Mode == SYMMETRIC; }
+    int NumSupernodes() const { return S.NumSupernodes(); }
+    size_t NumEntries() const { return S.NumEntries(); }
+
+    CSupernodalStructure S; ///< symbolic factorization
+    bool Reused;            ///< \c true if the last factorization found the same values and kept the factor
+
+private:
+    enum FactorMode { NONE, SYMMETRIC, GENERAL };
+
+    bool SameValues(FactorMode mode, const std::vector<double> &values);
+
+    FactorMode Mode;
+    std::vector<double> LValue; ///< L and D; 2 doubles per entry (symmetric) or 4 per 2x2 block (general)
+    std::vector<double> UValue; ///< U, stored by columns of U^T; only used by the general factorization
+    std::vector<double> FactoredValue; ///< matrix values of the current factor
+    std::vector<double> Work;
+};
+
+#endif
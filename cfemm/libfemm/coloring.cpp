@@ -0,0 +1,84 @@
+/*
+ * The source code in this file extends the solver code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "coloring.h"
+
+constexpr int CElementColoring::MIN_PARALLEL_ELEMENTS;
+constexpr int CElementColoring::MAX_COLORS;
+
+CElementColoring::CElementColoring()
+    : Elements()
+    , ColorStart(1,0)
+    , NodeColors()
+    , Added()
+    , Color()
+{
+}
+
+void CElementColoring::Create(int numNodes)
+{
+    NodeColors.assign(numNodes,0);
+    Added.clear();
+    Color.clear();
+    Elements.clear();
+    ColorStart.assign(1,0);
+}
+
+void CElementColoring::Add(int el, const int *n, bool serial)
+{
+    int color = -1;
+    if (!serial)
+    {
+        const std::uint64_t used = NodeColors[n[0]] | NodeColors[n[1]] | NodeColors[n[2]];
+        for (int c=0; c<MAX_COLORS; c++)
+        {
+            if (!(used & (std::uint64_t(1)<<c)))
+            {
+                color = c;
+                break;
+            }
+        }
+        if (color>=0)
+        {
+            for (int j=0; j<3; j++)
+                NodeColors[n[j]] |= std::uint64_t(1)<<color;
+        }
+    }
+    Added.push_back(el);
+    Color.push_back(color);
+}
+
+void CElementColoring::Finish()
+{
+    int numColors = 0;
+    for (int c: Color)
+        if (c+1>numColors)
+            numColors = c+1;
+
+    // counting sort by color; the serial elements go last
+    ColorStart.assign(numColors+2,0);
+    for (int c: Color)
+        ColorStart[(c<0) ? numColors+1 : c+1]++;
+    for (int c=0; c<=numColors; c++)
+        ColorStart[c+1] += ColorStart[c];
+
+    Elements.resize(Added.size());
+    std::vector<int> pos(ColorStart.begin(), ColorStart.end()-1);
+    for (std::size_t k=0; k<Added.size(); k++)
+    {
+        const int c = (Color[k]<0) ? numColors : Color[k];
+        Elements[pos[c]++] = Added[k];
+    }
+    ColorStart.pop_back();
+}
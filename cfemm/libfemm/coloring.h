@@ -0,0 +1,100 @@
+/*
+ * The source code in this file extends the solver code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef COLORING_H
+#define COLORING_H
+
+#include "parallel.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief The CElementColoring class splits the elements of a triangle mesh into colors,
+ * so that no two elements of the same color share a node.
+ *
+ * The elements of one color can be assembled concurrently:
+ * their matrix entries and right hand side entries lie in the rows of different nodes,
+ * so AddTo() never modifies the same entry or row from two threads.
+ * This requires that all entries are already part of the sparsity pattern
+ * (see FEASolver::BuildSparsityPattern()), since CBigCSRLinProb can not insert entries concurrently.
+ *
+ * Elements that also couple to unknowns shared by many elements (e.g. conductors or circuits)
+ * are not colored, but processed by a single thread after all colors.
+ *
+ * Colors are assigned greedily in the order in which the elements are added,
+ * and the colors are always processed in the same order.
+ * Each matrix entry therefore receives its contributions in the same order for any number of threads,
+ * i.e. the assembled system is bitwise reproducible.
+ */
+class CElementColoring
+{
+public:
+    CElementColoring();
+
+    /**
+     * @brief Forget all elements.
+     * @param numNodes number of mesh nodes
+     */
+    void Create(int numNodes);
+    /**
+     * @brief Assign element \p el to the first color that none of its neighbours has.
+     * @param el element number, passed to the function given to ForEach()
+     * @param n the three nodes of the element
+     * @param serial \c true if the element couples to shared unknowns and must not be processed concurrently
+     */
+    void Add(int el, const int *n, bool serial=false);
+    /**
+     * @brief Sort the elements by color. Call after the last Add().
+     */
+    void Finish();
+
+    int NumColors() const { return static_cast<int>(ColorStart.size())-1; }
+
+    /**
+     * @brief Call \p f(el) for each element.
+     * The elements of each color are distributed over femm::numThreads() threads if there are enough of them,
+     * the serial elements are processed last, in the order they were added.
+     */
+    template <class F> void ForEach(F f) const
+    {
+        for (int c=0; c<NumColors(); c++)
+        {
+            const int first = ColorStart[c];
+            const int last = ColorStart[c+1];
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(femm::numThreads()) if(femm::numThreads()>1 && last-first>=MIN_PARALLEL_ELEMENTS)
+#endif
+            for (int k=first; k<last; k++)
+                f(Elements[k]);
+        }
+        for (int k=ColorStart.back(); k<static_cast<int>(Elements.size()); k++)
+            f(Elements[k]);
+    }
+
+    /// colors with fewer elements are processed by a single thread
+    static constexpr int MIN_PARALLEL_ELEMENTS = 256;
+    /// maximum number of colors; elements that do not fit are processed serially
+    static constexpr int MAX_COLORS = 64;
+
+    std::vector<int> Elements;   ///< elements sorted by color, followed by the serial elements
+    std::vector<int> ColorStart; ///< index of the first element of each color in Elements; the last entry is the start of the serial elements
+
+private:
+    std::vector<std::uint64_t> NodeColors; ///< bit c is set if an element of color c uses the node
+    std::vector<int> Added; ///< elements in the order of Add()
+    std::vector<int> Color; ///< color of each added element; -1 for serial elements
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include <cstdlib>
 #include "femmcomplex.h"
 #include "cspars.h"
+#include "spars.h"
 
 #define MAXITER 1000000
 #define KLUDGE
@@ -40,8 +41,15 @@ CComplexEntry::CComplexEntry()
 CBigComplexLinProb::CBigComplexLinProb()
 {
     n=0;
+    M=NULL;
+    Mh=NULL;
+    Ma=NULL;
+    Ms=NULL;
+    bNewton=false;
     // Best guess for relaxation parameter
     Lambda = 1.5;
+    LinearSolver = SOLVER_ITERATIVE;
+    Iterations = 0;
 }
 
 CBigComplexLinProb::~CBigComplexLinProb()
@@ -60,6 +68,8 @@ CBigComplexLinProb::~CBigComplexLinProb()
     free(uu);
     free(vv);
 
+    if (M==NULL) return;
+
     for(i=0; i<n; i++)
     {
         ui=M[i];
@@ -73,7 +83,7 @@ CBigComplexLinProb::~CBigComplexLinProb()
     }
     free(M);
 
-    if (bNewton)
+    if (bNewton && Mh!=NULL)
     {
         for(i=0; i<n; i++)
         {
@@ -116,12 +126,8 @@ CBigComplexLinProb::~CBigComplexLinProb()
     }
 }
 
-int CBigComplexLinProb::Create(int d, int bw, int nodes)
+void CBigComplexLinProb::CreateVectors(int d)
 {
-    int i;
-
-    bdw=bw;
-    NumNodes=nodes;
     b=(CComplex *)calloc(d,sizeof(CComplex));
     V=(CComplex *)calloc(d,sizeof(CComplex));
     P=(CComplex *)calloc(d,sizeof(CComplex));
@@ -131,6 +137,15 @@ int CBigComplexLinProb::Create(int d, int bw, int nodes)
     uu=(CComplex *)calloc(d,sizeof(CComplex));
     vv=(CComplex *)calloc(d,sizeof(CComplex));
     n=d;
+}
+
+int CBigComplexLinProb::Create(int d, int bw, int nodes)
+{
+    int i;
+
+    bdw=bw;
+    NumNodes=nodes;
+    CreateVectors(d);
 
     M=(CComplexEntry **)calloc(d,sizeof(CComplexEntry *));
     for(i=0; i<d; i++)
@@ -144,6 +159,41 @@ int CBigComplexLinProb::Create(int d, int bw, int nodes)
     return 1;
 }
 
+bool CBigComplexLinProb::SetPattern(CSparsityPattern &)
+{
+    // entries are created on demand by Put() and AddTo()
+    return true;
+}
+
+void CBigComplexLinProb::CreateNewtonMatrices()
+{
+    int i;
+
+    if (bNewton) return;
+    bNewton=true;
+
+    Mh=(CComplexEntry **)calloc(n,sizeof(CComplexEntry *));
+    for(i=0; i<n; i++)
+    {
+        Mh[i] = new CComplexEntry;
+        Mh[i]->c = i;
+    }
+
+    Ma=(CComplexEntry **)calloc(n,sizeof(CComplexEntry *));
+    for(i=0; i<n; i++)
+    {
+        Ma[i] = new CComplexEntry;
+        Ma[i]->c = i;
+    }
+
+    Ms=(CComplexEntry **)calloc(n,sizeof(CComplexEntry *));
+    for(i=0; i<n; i++)
+    {
+        Ms[i] = new CComplexEntry;
+        Ms[i]->c = i;
+    }
+}
+
 void CBigComplexLinProb::Put(CComplex v, int p, int q, int k)
 {
     CComplexEntry *e,*l = NULL;
@@ -161,28 +211,7 @@ void CBigComplexLinProb::Put(CComplex v, int p, int q, int k)
     // allocate space for auxilliary matrices if they are actually needed
     if ((k>0) && (bNewton==false))
     {
-        bNewton=true;
-
-        Mh=(CComplexEntry **)calloc(n,sizeof(CComplexEntry *));
-        for(i=0; i<n; i++)
-        {
-            Mh[i] = new CComplexEntry;
-            Mh[i]->c = i;
-        }
-
-        Ma=(CComplexEntry **)calloc(n,sizeof(CComplexEntry *));
-        for(i=0; i<n; i++)
-        {
-            Ma[i] = new CComplexEntry;
-            Ma[i]->c = i;
-        }
-
-        Ms=(CComplexEntry **)calloc(n,sizeof(CComplexEntry *));
-        for(i=0; i<n; i++)
-        {
-            Ms[i] = new CComplexEntry;
-            Ms[i]->c = i;
-        }
+        CreateNewtonMatrices();
     }
 
     switch(k)
@@ -394,7 +423,7 @@ void CBigComplexLinProb::MultConjA(CComplex *X, CComplex *Y, int k)
             Y[i]+=(e->x.Conj()*X[e->c]);
             if (k==1)
                 Y[e->c]+=(e->x*X[i]);   // case in which the matrix is hermitian
-            if (k==3)
+            else if (k==3)
                 Y[e->c]+=(-e->x*X[i]);   // case in which the matrix is antihermitian
             else
                 Y[e->c]+=(e->x.Conj()*X[i]); // case in which the matrix is complex-symmetric
@@ -589,6 +618,45 @@ void CBigComplexLinProb::Wipe()
     }
 }
 
+void CBigComplexLinProb::SaveAssembly()
+{
+    // numbering of the k argument of Put()
+    CComplexEntry **mat[4] = {M, Mh, Ms, Ma};
+    int nmat = (bNewton) ? 4 : 1;
+
+    SavedMat.clear();
+    SavedRow.clear();
+    SavedCol.clear();
+    SavedValue.clear();
+    for(int k=0; k<nmat; k++)
+    {
+        for(int i=0; i<n; i++)
+        {
+            for(CComplexEntry *e=mat[k][i]; e!=NULL; e=e->next)
+            {
+                if (e->x!=0)
+                {
+                    SavedMat.push_back(k);
+                    SavedRow.push_back(i);
+                    SavedCol.push_back(e->c);
+                    SavedValue.push_back(e->x);
+                }
+            }
+        }
+    }
+    SavedB.assign(b,b+n);
+}
+
+void CBigComplexLinProb::RestoreAssembly()
+{
+    Wipe();
+    for(std::size_t k=0; k<SavedValue.size(); k++)
+        Put(SavedValue[k],SavedRow[k],SavedCol[k],SavedMat[k]);
+    for(int i=0; i<n && i<static_cast<int>(SavedB.size()); i++)
+        b[i]=SavedB[i];
+}
+
+
 void CBigComplexLinProb::AntiPeriodicity(int i, int j)
 {
     int k,fst,lst,h;
@@ -767,7 +835,7 @@ int CBigComplexLinProb::PCGSQStart()
     CComplex res,res_new,del,rho,pAp;
 
     // quick check for most obvious sign of singularity;
-    for(i=0; i<n; i++) if((M[i]->x.re==0) && (M[i]->x.im==0))
+    for(i=0; i<n; i++) if(Get(i,i)==0)
         {
             fprintf(stderr,"singular flag tripped.");
             return 0;
@@ -874,6 +942,7 @@ int CBigComplexLinProb::PBCGSolve(int flag)
         for(i=0; i<n; i++) P[i]=Z[i]+(rho*P[i]);
 
         er=nrm(R)/normb;
+        Iterations++;
 
         // report progress
         prg2=(int) (20.*log10(er)/(log10(Precision)));
@@ -949,6 +1018,7 @@ int CBigComplexLinProb::BiCGSTAB(int flag)
             R[j]=Z[j]-om*t[j];
         }
         rho2 = rho1;
+        Iterations++;
         er=nrm(R)/normb;
 
         // display progress to the user
@@ -1078,3 +1148,20 @@ int CBigComplexLinProb::PBCGSolveMod(int flag)
     // call the complex-symmetric solver
     return PBCGSolve(2);
 }
+
+int CBigComplexLinProb::Solve(int flag)
+{
+    Iterations = 0;
+    if (LinearSolver == SOLVER_DIRECT)
+    {
+        if (DirectSolve())
+            return 1;
+        printf("Direct solver not available, using iterative solver instead\n");
+    }
+    return PBCGSolveMod(flag);
+}
+
+int CBigComplexLinProb::DirectSolve()
+{
+    return 0;
+}
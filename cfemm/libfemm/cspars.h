@@ -22,6 +22,10 @@
 #ifndef CSPARS_H
 #define CSPARS_H
 
+#include <vector>
+
+class CSparsityPattern;
+
 class CComplexEntry
 {
 public:
@@ -59,24 +63,48 @@ public:
     int NumNodes;
     double Precision;
     double Lambda;			// relaxation factor;
+    int LinearSolver;		///< solution method used by Solve(), see LinearSolverType
+    int Iterations;			///< number of iterations taken by the last call to Solve(); 0 for direct solves
 
     // member functions
 
     CBigComplexLinProb();				// constructor
-    ~CBigComplexLinProb();				// destructor
-    int Create(int d, int bw, int nodes);	// initialize the problem
-    void Put(CComplex v, int p, int q, int k=0); // use to create/set entries in the matrix
-    CComplex Get(int p, int q, int k=0);
-    void AddTo(CComplex v, int p, int q);
-    void MultA(CComplex *X, CComplex *Y, int k=0);
-    void MultConjA(CComplex *X, CComplex *Y, int k=0);
+    virtual ~CBigComplexLinProb();		// destructor
+    virtual int Create(int d, int bw, int nodes);	// initialize the problem
+    /**
+     * @brief Prepare the matrix storage for the given sparsity pattern.
+     * The default implementation creates entries on demand and ignores the pattern.
+     * @return \c false if the pattern does not fit the matrix.
+     */
+    virtual bool SetPattern(CSparsityPattern &pattern);
+    virtual void Put(CComplex v, int p, int q, int k=0); // use to create/set entries in the matrix
+    /**
+     * @brief Allocate the auxiliary matrices Mh, Ms, and Ma of the Newton-Raphson algorithm and set \c bNewton.
+     * Put() calls this on demand; it must be called beforehand if the matrices are filled by several threads at once.
+     */
+    virtual void CreateNewtonMatrices();
+    virtual CComplex Get(int p, int q, int k=0);
+    virtual void AddTo(CComplex v, int p, int q);
+    virtual void MultA(CComplex *X, CComplex *Y, int k=0);
+    virtual void MultConjA(CComplex *X, CComplex *Y, int k=0);
     CComplex Dot(CComplex *x, CComplex *y);
     CComplex ConjDot(CComplex *x, CComplex *y);
-    void SetValue(int i, CComplex x);
-    void Periodicity(int i, int j);
-    void AntiPeriodicity(int i, int j);
-    void Wipe();
-    void MultPC(CComplex *X, CComplex *Y);
+    virtual void SetValue(int i, CComplex x);
+    virtual void Periodicity(int i, int j);
+    virtual void AntiPeriodicity(int i, int j);
+    virtual void Wipe();
+    /**
+     * @brief Keep a copy of the matrices and the right hand side.
+     * Used by nonlinear solvers to keep the contributions that stay the same in each iteration.
+     * @see RestoreAssembly()
+     */
+    virtual void SaveAssembly();
+    /**
+     * @brief Replace the matrices and the right hand side by the copy made by SaveAssembly().
+     * Like Wipe(), this starts a new assembly, but with the saved contributions already in place.
+     */
+    virtual void RestoreAssembly();
+    virtual void MultPC(CComplex *X, CComplex *Y);
     void MultAPPA(CComplex *X, CComplex *Y);
 
 
@@ -87,10 +115,28 @@ public:
     int PBCGSolve(int flag);
     int BiCGSTAB(int flag);
     int KludgeSolve(int flag);
+    /**
+     * @brief Solve the system with the method selected by \c LinearSolver.
+     * If the direct solver is not available or fails, PBCGSolveMod() is used instead.
+     */
+    virtual int Solve(int flag);
+    /**
+     * @brief Solve the system with a sparse direct solver.
+     * The default implementation does not support direct solving and returns 0.
+     */
+    virtual int DirectSolve();
 
 //		CFknDlg *TheView;
 
-private:
+protected:
+    void CreateVectors(int d);	// allocate the vectors, but not the matrix
+
+    // copy made by SaveAssembly(); the default implementation stores each matrix entry as (matrix, row, column, value)
+    std::vector<int> SavedMat;
+    std::vector<int> SavedRow;
+    std::vector<int> SavedCol;
+    std::vector<CComplex> SavedValue;
+    std::vector<CComplex> SavedB;
 
 };
 
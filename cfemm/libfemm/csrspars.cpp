@@ -0,0 +1,750 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "csrspars.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+#ifdef DEBUG_CSRSPARS
+#define debug std::cerr << __func__ << "(): "
+#else
+#define debug while(false) std::cerr
+#endif
+
+using std::swap;
+
+CSparsityPattern::CSparsityPattern()
+    : Adj()
+{
+}
+
+CSparsityPattern::CSparsityPattern(int d)
+    : Adj()
+{
+    Create(d);
+}
+
+void CSparsityPattern::Create(int d)
+{
+    Adj.clear();
+    Adj.resize(d);
+    for (int i=0; i<d; i++)
+        Adj[i].push_back(i);
+}
+
+void CSparsityPattern::AddEntry(int p, int q)
+{
+    if (p<0 || q<0 || p==q)
+        return;
+    Adj[p].push_back(q);
+    Adj[q].push_back(p);
+}
+
+void CSparsityPattern::AddClique(const int *dofs, int count)
+{
+    for (int j=0; j<count; j++)
+        for (int k=j+1; k<count; k++)
+            AddEntry(dofs[j],dofs[k]);
+}
+
+void CSparsityPattern::Couple(int i, int j)
+{
+    if (i<0 || j<0 || i==j)
+        return;
+    // the constraint itself couples i and j (the Newton matrices of CBigComplexLinProb get an entry there)
+    AddEntry(i,j);
+    CompressRow(i);
+    CompressRow(j);
+
+    std::vector<int> neighbours;
+    std::set_union(Adj[i].begin(), Adj[i].end(),
+                   Adj[j].begin(), Adj[j].end(),
+                   std::back_inserter(neighbours));
+    for (int k : neighbours)
+    {
+        if (k!=i && k!=j)
+        {
+            AddEntry(k,i);
+            AddEntry(k,j);
+        }
+    }
+}
+
+void CSparsityPattern::Compress()
+{
+    for (int i=0; i<Size(); i++)
+        CompressRow(i);
+}
+
+const std::vector<int> &CSparsityPattern::Row(int row)
+{
+    CompressRow(row);
+    return Adj[row];
+}
+
+void CSparsityPattern::CompressRow(int row)
+{
+    std::vector<int> &r = Adj[row];
+    std::sort(r.begin(), r.end());
+    r.erase(std::unique(r.begin(), r.end()), r.end());
+}
+
+
+CBigCSRLinProb::CBigCSRLinProb()
+    : CBigLinProb()
+    , RowStart()
+    , ColIndex()
+    , Value()
+    , NumFillIns(0)
+    , PatternVersion(0)
+    , IC()
+    , AMG()
+    , Chol()
+    , Schedule()
+    , EliminatePeriodicity(true)
+    , PBC()
+    , Reduced()
+    , ReducedPatternVersion(-1)
+{
+}
+
+CBigCSRLinProb::~CBigCSRLinProb()
+{
+}
+
+int CBigCSRLinProb::Create(int d, int bw)
+{
+    bdw=bw;
+    CreateVectors(d);
+
+    // start out with a diagonal matrix
+    RowStart.resize(d+1);
+    ColIndex.resize(d);
+    Value.assign(d,0.);
+    for (int i=0; i<d; i++)
+    {
+        RowStart[i] = i;
+        ColIndex[i] = i;
+    }
+    RowStart[d] = d;
+    NumFillIns = 0;
+    PatternVersion++;
+    IC.Clear();
+    PBC.Clear();
+    SavedValue.clear();
+    SavedB.clear();
+
+    return 1;
+}
+
+bool CBigCSRLinProb::SetPattern(CSparsityPattern &pattern)
+{
+    if (pattern.Size() != n)
+        return false;
+
+    RowStart.resize(n+1);
+    ColIndex.clear();
+    for (int i=0; i<n; i++)
+    {
+        RowStart[i] = static_cast<int>(ColIndex.size());
+        const std::vector<int> &row = pattern.Row(i);
+        // only keep the upper triangle; the row is sorted, so the diagonal comes first
+        for (auto it = std::lower_bound(row.begin(),row.end(),i); it!=row.end(); ++it)
+            ColIndex.push_back(*it);
+    }
+    RowStart[n] = static_cast<int>(ColIndex.size());
+    Value.assign(ColIndex.size(),0.);
+    NumFillIns = 0;
+    PatternVersion++;
+    IC.Clear();
+    SavedValue.clear();
+    SavedB.clear();
+
+    return true;
+}
+
+int CBigCSRLinProb::Slot(int p, int q) const
+{
+    if (q<p)
+        swap(p,q);
+
+    const int *first = ColIndex.data() + RowStart[p];
+    const int *last = ColIndex.data() + RowStart[p+1];
+    const int *e = std::lower_bound(first, last, q);
+    if (e==last || *e!=q)
+        return -1;
+    return static_cast<int>(e - ColIndex.data());
+}
+
+int CBigCSRLinProb::Insert(int p, int q)
+{
+    if (q<p)
+        swap(p,q);
+
+    auto first = ColIndex.begin() + RowStart[p];
+    auto last = ColIndex.begin() + RowStart[p+1];
+    int pos = static_cast<int>(std::lower_bound(first, last, q) - ColIndex.begin());
+
+    ColIndex.insert(ColIndex.begin()+pos, q);
+    Value.insert(Value.begin()+pos, 0.);
+    if (!SavedValue.empty())
+        SavedValue.insert(SavedValue.begin()+pos, 0.);
+    for (int i=p+1; i<=n; i++)
+        RowStart[i]++;
+    NumFillIns++;
+    PatternVersion++;
+
+    return pos;
+}
+
+void CBigCSRLinProb::Put(double v, int p, int q)
+{
+    int e = Slot(p,q);
+    if (e<0)
+        e = Insert(p,q);
+    Value[e] = v;
+}
+
+double CBigCSRLinProb::Get(int p, int q)
+{
+    int e = Slot(p,q);
+    if (e<0)
+        return 0;
+    return Value[e];
+}
+
+void CBigCSRLinProb::AddTo(double v, int p, int q)
+{
+    int e = Slot(p,q);
+    if (e<0)
+        e = Insert(p,q);
+    Value[e] += v;
+}
+
+void CBigCSRLinProb::MultA(double *X, double *Y)
+{
+    int i,e,c;
+    const int *rs = RowStart.data();
+    const int *col = ColIndex.data();
+    const double *val = Value.data();
+
+    if (femm::useThreads(n))
+    {
+        UpdateSchedule();
+        const int *ls = Schedule.LowerStart.data();
+        const int *lcol = Schedule.LowerCol.data();
+        const int *lslot = Schedule.LowerSlot.data();
+
+        // sum up in the same order as the serial product below
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(femm::numThreads())
+#endif
+        for(int r=0; r<n; r++)
+        {
+            double y=0;
+            for(int k=ls[r]; k<ls[r+1]; k++)
+                y+=val[lslot[k]]*X[lcol[k]];
+            y+=val[rs[r]]*X[r];
+            for(int k=rs[r]+1; k<rs[r+1]; k++)
+                y+=val[k]*X[col[k]];
+            Y[r]=y;
+        }
+        return;
+    }
+
+    for(i=0; i<n; i++) Y[i]=0;
+
+    for(i=0; i<n; i++)
+    {
+        Y[i]+=val[rs[i]]*X[i];
+        for(e=rs[i]+1; e<rs[i+1]; e++)
+        {
+            c=col[e];
+            Y[i]+=val[e]*X[c];
+            Y[c]+=val[e]*X[i];
+        }
+    }
+}
+
+void CBigCSRLinProb::UpdateSchedule()
+{
+    if (Schedule.PatternVersion == PatternVersion)
+        return;
+    Schedule.Build(n, RowStart.data(), ColIndex.data());
+    Schedule.PatternVersion = PatternVersion;
+}
+
+void CBigCSRLinProb::InitPC()
+{
+    if (ReusePC &&
+            ((Preconditioner == PRECOND_ICHOL && IC.Valid())
+             || (Preconditioner == PRECOND_AMG && AMG.Valid() && AMG.PatternVersion == PatternVersion)))
+    {
+        debug << "Reusing preconditioner\n";
+        return;
+    }
+
+    IC.Clear();
+    if (Preconditioner == PRECOND_AMG)
+    {
+        // the hierarchy only depends on the pattern; for new values just refresh the coarse operators
+        if (AMG.Valid() && AMG.PatternVersion == PatternVersion && AMG.Refresh(Value.data()))
+            return;
+        if (AMG.Setup(n, RowStart.data(), ColIndex.data(), Value.data()))
+        {
+            AMG.PatternVersion = PatternVersion;
+            debug << "AMG preconditioner: " << AMG.NumLevels() << " levels, operator complexity "
+                  << AMG.Complexity() << "\n";
+        } else {
+            fprintf(stderr, "AMG setup failed, using SSOR instead\n");
+        }
+        return;
+    }
+    AMG.Clear();
+    if (Preconditioner != PRECOND_ICHOL)
+        return;
+
+    if (IC.Factor(n, RowStart.data(), ColIndex.data(), Value.data(), ICFill, ICDropTol))
+    {
+        debug << "IC(" << ICFill << ") preconditioner: " << IC.NumEntries() << " entries (matrix: "
+              << ColIndex.size() << "), diagonal shift " << IC.Shift << "\n";
+    } else {
+        fprintf(stderr, "IC(%i) factorization failed, using SSOR instead\n", ICFill);
+    }
+}
+
+void CBigCSRLinProb::MultPC(const double *X, double *Y)
+{
+    if (IC.Valid())
+    {
+        IC.Solve(X,Y);
+        return;
+    }
+    if (AMG.Valid())
+    {
+        AMG.Solve(X,Y);
+        return;
+    }
+
+    // SSOR preconditioner, see CBigLinProb::MultPC
+    int i,e;
+    double c;
+    const int *rs = RowStart.data();
+    const int *col = ColIndex.data();
+    const double *val = Value.data();
+
+    c= Lambda*(2.-Lambda);
+
+    int nthreads = 1;
+    if (femm::useThreads(n))
+    {
+        UpdateSchedule();
+        nthreads = Schedule.SweepThreads(femm::numThreads());
+    }
+
+    if (nthreads>1)
+    {
+        const int *ls = Schedule.LowerStart.data();
+        const int *lcol = Schedule.LowerCol.data();
+        const int *lslot = Schedule.LowerSlot.data();
+        const int *fs = Schedule.ForwardStart.data();
+        const int *frows = Schedule.ForwardRows.data();
+        const int *bs = Schedule.BackwardStart.data();
+        const int *brows = Schedule.BackwardRows.data();
+        const int nfwd = Schedule.NumForwardLevels();
+        const int nbwd = Schedule.NumBackwardLevels();
+
+        // same operations as the serial sweeps below, but the rows of each level are processed concurrently
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+        {
+            // invert Lower Triangle;
+            for(int l=0; l<nfwd; l++)
+            {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for(int k=fs[l]; k<fs[l+1]; k++)
+                {
+                    int r=frows[k];
+                    double y=X[r]*c;
+                    for(int j=ls[r]; j<ls[r+1]; j++)
+                        y -= val[lslot[j]] * Y[lcol[j]] * Lambda;
+                    Y[r]=y/val[rs[r]];
+                }
+            }
+
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for(int r=0; r<n; r++) Y[r]*=val[rs[r]];
+
+            // invert Upper Triangle
+            for(int l=0; l<nbwd; l++)
+            {
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+                for(int k=bs[l]; k<bs[l+1]; k++)
+                {
+                    int r=brows[k];
+                    double y=Y[r];
+                    for(int j=rs[r]+1; j<rs[r+1]; j++)
+                        y -= val[j] * Y[col[j]] * Lambda;
+                    Y[r]=y/val[rs[r]];
+                }
+            }
+        }
+        return;
+    }
+
+    for(i=0; i<n; i++) Y[i]=X[i]*c;
+
+    // invert Lower Triangle;
+    for(i=0; i<n; i++)
+    {
+        Y[i]/= val[rs[i]];
+        for(e=rs[i]+1; e<rs[i+1]; e++)
+            Y[col[e]] -= val[e] * Y[i] * Lambda;
+    }
+
+    for(i=0; i<n; i++) Y[i]*=val[rs[i]];
+
+    // invert Upper Triangle
+    for(i=n-1; i>=0; i--)
+    {
+        for(e=rs[i]+1; e<rs[i+1]; e++)
+            Y[i] -= val[e] * Y[col[e]] * Lambda;
+        Y[i]/= val[rs[i]];
+    }
+}
+
+void CBigCSRLinProb::MultABlock(int k, const double *X, double *Y)
+{
+    const int *rs = RowStart.data();
+    const int *col = ColIndex.data();
+    const double *val = Value.data();
+
+    if (femm::useThreads(n))
+    {
+        UpdateSchedule();
+        const int *ls = Schedule.LowerStart.data();
+        const int *lcol = Schedule.LowerCol.data();
+        const int *lslot = Schedule.LowerSlot.data();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(femm::numThreads())
+#endif
+        for(int r=0; r<n; r++)
+        {
+            double *y = Y + static_cast<size_t>(r)*k;
+            const double *x = X + static_cast<size_t>(r)*k;
+            for(int j=0; j<k; j++) y[j]=0;
+            for(int e=ls[r]; e<ls[r+1]; e++)
+            {
+                const double v = val[lslot[e]];
+                const double *xc = X + static_cast<size_t>(lcol[e])*k;
+                for(int j=0; j<k; j++) y[j]+=v*xc[j];
+            }
+            for(int j=0; j<k; j++) y[j]+=val[rs[r]]*x[j];
+            for(int e=rs[r]+1; e<rs[r+1]; e++)
+            {
+                const double v = val[e];
+                const double *xc = X + static_cast<size_t>(col[e])*k;
+                for(int j=0; j<k; j++) y[j]+=v*xc[j];
+            }
+        }
+        return;
+    }
+
+    std::fill(Y, Y+static_cast<size_t>(n)*k, 0.);
+    for(int i=0; i<n; i++)
+    {
+        double *yi = Y + static_cast<size_t>(i)*k;
+        const double *xi = X + static_cast<size_t>(i)*k;
+        for(int j=0; j<k; j++) yi[j]+=val[rs[i]]*xi[j];
+        for(int e=rs[i]+1; e<rs[i+1]; e++)
+        {
+            const double v = val[e];
+            double *yc = Y + static_cast<size_t>(col[e])*k;
+            const double *xc = X + static_cast<size_t>(col[e])*k;
+            for(int j=0; j<k; j++)
+            {
+                yi[j]+=v*xc[j];
+                yc[j]+=v*xi[j];
+            }
+        }
+    }
+}
+
+void CBigCSRLinProb::MultPCBlock(int k, const double *X, double *Y)
+{
+    if (IC.Valid() || AMG.Valid())
+    {
+        CBigLinProb::MultPCBlock(k,X,Y);
+        return;
+    }
+
+    // SSOR preconditioner, see MultPC
+    const int *rs = RowStart.data();
+    const int *col = ColIndex.data();
+    const double *val = Value.data();
+    const size_t nk = static_cast<size_t>(n)*k;
+
+    double c= Lambda*(2.-Lambda);
+    for(size_t e=0; e<nk; e++) Y[e]=X[e]*c;
+
+    // invert Lower Triangle;
+    for(int i=0; i<n; i++)
+    {
+        double *yi = Y + static_cast<size_t>(i)*k;
+        for(int j=0; j<k; j++) yi[j]/= val[rs[i]];
+        for(int e=rs[i]+1; e<rs[i+1]; e++)
+        {
+            const double v = val[e];
+            double *yc = Y + static_cast<size_t>(col[e])*k;
+            for(int j=0; j<k; j++) yc[j] -= v * yi[j] * Lambda;
+        }
+    }
+
+    for(int i=0; i<n; i++)
+        for(int j=0; j<k; j++) Y[static_cast<size_t>(i)*k+j]*=val[rs[i]];
+
+    // invert Upper Triangle
+    for(int i=n-1; i>=0; i--)
+    {
+        double *yi = Y + static_cast<size_t>(i)*k;
+        for(int e=rs[i]+1; e<rs[i+1]; e++)
+        {
+            const double v = val[e];
+            const double *yc = Y + static_cast<size_t>(col[e])*k;
+            for(int j=0; j<k; j++) yi[j] -= v * yc[j] * Lambda;
+        }
+        for(int j=0; j<k; j++) yi[j]/= val[rs[i]];
+    }
+}
+
+bool CBigCSRLinProb::DirectSolve()
+{
+    if (!Chol.Analyzed() || Chol.S.PatternVersion != PatternVersion)
+    {
+        if (!Chol.Analyze(n, RowStart.data(), ColIndex.data()))
+            return false;
+        Chol.S.PatternVersion = PatternVersion;
+    }
+    else if (ReusePC && Chol.Valid())
+    {
+        debug << "Reusing Cholesky factor of an earlier matrix\n";
+        MultA(V,R);
+        for (int i=0; i<n; i++)
+            R[i] = b[i]-R[i];
+        Chol.Solve(R,Z);
+        for (int i=0; i<n; i++)
+            V[i] += Z[i];
+        return true;
+    }
+
+    if (!Chol.Factor(Value.data()))
+    {
+        fprintf(stderr, "Cholesky factorization failed\n");
+        return false;
+    }
+    if (Chol.Reused)
+        debug << "Reusing Cholesky factor\n";
+    else
+        debug << "Sparse Cholesky factor: " << Chol.NumSupernodes() << " supernodes, " << Chol.NumEntries()
+              << " entries (matrix: " << ColIndex.size() << ")\n";
+
+    Chol.Solve(b,V);
+    return true;
+}
+
+void CBigCSRLinProb::Wipe()
+{
+    for(int i=0; i<n; i++) b[i]=0.;
+    std::fill(Value.begin(), Value.end(), 0.);
+    PBC.Clear();
+}
+
+void CBigCSRLinProb::SaveAssembly()
+{
+    SavedValue = Value;
+    SavedB.assign(b,b+n);
+}
+
+void CBigCSRLinProb::RestoreAssembly()
+{
+    if (SavedValue.size() != Value.size())
+    {
+        Wipe();
+        return;
+    }
+    std::copy(SavedValue.begin(), SavedValue.end(), Value.begin());
+    std::copy(SavedB.begin(), SavedB.end(), b);
+    PBC.Clear();
+}
+
+void CBigCSRLinProb::SetValue(int i, double x)
+{
+    UpdateSchedule();
+
+    // column i above the diagonal
+    for (int t=Schedule.LowerStart[i]; t<Schedule.LowerStart[i+1]; t++)
+    {
+        const int e = Schedule.LowerSlot[t];
+        if (Value[e]!=0)
+        {
+            b[Schedule.LowerCol[t]] -= Value[e]*x;
+            Value[e] = 0.;
+        }
+    }
+    // column i below the diagonal, i.e. row i
+    for (int e=RowStart[i]+1; e<RowStart[i+1]; e++)
+    {
+        if (Value[e]!=0)
+        {
+            b[ColIndex[e]] -= Value[e]*x;
+            Value[e] = 0.;
+        }
+    }
+    b[i] = Value[RowStart[i]]*x;
+}
+
+void CBigCSRLinProb::Periodicity(int i, int j)
+{
+    if (EliminatePeriodicity)
+        PBC.Add(i,j,1);
+    else
+        CBigLinProb::Periodicity(i,j);
+}
+
+void CBigCSRLinProb::AntiPeriodicity(int i, int j)
+{
+    if (EliminatePeriodicity)
+        PBC.Add(i,j,-1);
+    else
+        CBigLinProb::AntiPeriodicity(i,j);
+}
+
+bool CBigCSRLinProb::UpdateReduced()
+{
+    if (PBC.Empty())
+        return false;
+
+    if (PBC.Build(n) || !Reduced || ReducedPatternVersion != PatternVersion)
+    {
+        CSparsityPattern pattern;
+        PBC.BuildPattern(n, RowStart.data(), ColIndex.data(), pattern);
+        Reduced.reset(new CBigCSRLinProb());
+        Reduced->Create(PBC.NumReduced, 0);
+        Reduced->SetPattern(pattern);
+        PBC.MapEntries(n, RowStart.data(), ColIndex.data(), Reduced->RowStart.data(), Reduced->ColIndex.data());
+        ReducedPatternVersion = PatternVersion;
+    }
+
+    Reduced->Precision = Precision;
+    Reduced->Lambda = Lambda;
+    Reduced->Preconditioner = Preconditioner;
+    Reduced->ICFill = ICFill;
+    Reduced->ICDropTol = ICDropTol;
+    Reduced->LinearSolver = LinearSolver;
+    Reduced->ForcingTerm = ForcingTerm;
+    Reduced->ReusePC = ReusePC;
+
+    // reduced matrix S^T A S
+    Reduced->Wipe();
+    double *rv = Reduced->Value.data();
+    const int nnz = RowStart[n];
+    for (int e=0; e<nnz; e++)
+    {
+        int kind = PBC.Kind[e];
+        double v = Value[e];
+        if (kind<0)
+        {
+            kind = -kind;
+            v = -v;
+        }
+        if (kind == CPeriodicElimination::ENTRY_MERGED)
+            v *= 2.;
+        rv[PBC.Slot[e]] += v;
+    }
+    return true;
+}
+
+bool CBigCSRLinProb::Solve(int flag)
+{
+    if (!UpdateReduced())
+        return CBigLinProb::Solve(flag);
+
+    PBC.Restrict(b, Reduced->b);
+    if (flag)
+        PBC.Inject(V, Reduced->V);
+    bool ok = Reduced->Solve(flag);
+    Iterations = Reduced->Iterations;
+    PBC.Prolong(Reduced->V, V);
+    return ok;
+}
+
+double CBigCSRLinProb::ResidualNorm()
+{
+    if (!UpdateReduced())
+        return CBigLinProb::ResidualNorm();
+
+    // S^T (b - A S y) of the reduced system
+    PBC.Restrict(b, Reduced->b);
+    PBC.Inject(V, Reduced->V);
+    return Reduced->ResidualNorm();
+}
+
+bool CBigCSRLinProb::SolveBlock(int nrhs, double *const *B, double *const *X, int flag)
+{
+    if (!UpdateReduced())
+        return CBigLinProb::SolveBlock(nrhs, B, X, flag);
+
+    const int nr = PBC.NumReduced;
+    std::vector<double> rb(static_cast<size_t>(nr)*nrhs), rx(static_cast<size_t>(nr)*nrhs, 0.);
+    std::vector<double *> RB(nrhs), RX(nrhs);
+    for (int j=0; j<nrhs; j++)
+    {
+        RB[j] = rb.data() + static_cast<size_t>(j)*nr;
+        RX[j] = rx.data() + static_cast<size_t>(j)*nr;
+        PBC.Restrict(B[j], RB[j]);
+        if (flag)
+            PBC.Inject(X[j], RX[j]);
+    }
+    bool ok = Reduced->SolveBlock(nrhs, RB.data(), RX.data(), flag);
+    Iterations = Reduced->Iterations;
+    for (int j=0; j<nrhs; j++)
+        PBC.Prolong(RX[j], X[j]);
+    return ok;
+}
+
+void CBigCSRLinProb::ComputeBandwidth()
+{
+    int k,bw,maxbw;
+
+    for(maxbw=0,k=0; k<n; k++)
+    {
+        bw=ColIndex[RowStart[k+1]-1] - k;
+        if (bw>maxbw) maxbw=bw;
+    }
+
+    printf("Assumed Bandwidth = %i\nActual Bandwidth = %i", bdw, maxbw);
+}
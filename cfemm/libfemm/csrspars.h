@@ -0,0 +1,206 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef CSRSPARS_H
+#define CSRSPARS_H
+
+#include "amg.h"
+#include "ichol.h"
+#include "levelsched.h"
+#include "periodic.h"
+#include "spars.h"
+#include "spchol.h"
+
+#include <memory>
+#include <vector>
+
+/**
+ * @brief The CSparsityPattern class collects the structure of a symmetric sparse matrix.
+ *
+ * The pattern is built once from the mesh connectivity (the "symbolic" assembly phase),
+ * and is then used to allocate the compressed row storage of a CBigCSRLinProb.
+ * Entries are always stored symmetrically, and the main diagonal is always part of the pattern.
+ */
+class CSparsityPattern
+{
+public:
+    CSparsityPattern();
+    explicit CSparsityPattern(int d);
+
+    /**
+     * @brief Reset the pattern to a diagonal pattern of dimension \p d.
+     */
+    void Create(int d);
+    /**
+     * @brief Add a structural nonzero at (p,q) and (q,p).
+     * Negative indices are ignored.
+     */
+    void AddEntry(int p, int q);
+    /**
+     * @brief Couple all unknowns in \p dofs with each other, as a finite element does.
+     * Negative indices are ignored.
+     */
+    void AddClique(const int *dofs, int count);
+    /**
+     * @brief Add the fill-in caused by a (anti-)periodic constraint between \p i and \p j.
+     * Every unknown that is coupled to either \p i or \p j is afterwards coupled to both,
+     * and \p i and \p j are coupled with each other.
+     * This corresponds to the entries created by CBigLinProb::Periodicity() and CBigLinProb::AntiPeriodicity(),
+     * and their counterparts in CBigComplexLinProb.
+     */
+    void Couple(int i, int j);
+    /**
+     * @brief Sort and remove duplicate entries.
+     * Called implicitly by users of the pattern; calling it explicitly is only needed to reduce memory usage.
+     */
+    void Compress();
+
+    int Size() const { return static_cast<int>(Adj.size()); }
+    /**
+     * @brief Access the (compressed) list of columns coupled to \p row, including \p row itself.
+     */
+    const std::vector<int> &Row(int row);
+
+private:
+    void CompressRow(int row);
+
+    std::vector< std::vector<int> > Adj; ///< column indices for each row (full symmetric storage)
+};
+
+/**
+ * @brief The CBigCSRLinProb class stores the matrix of a CBigLinProb in compressed row storage.
+ *
+ * Like CBigLinProb, only the upper triangle (including the main diagonal) of the symmetric matrix is stored.
+ * The diagonal element is always the first entry of each row.
+ *
+ * Usage is split into two phases:
+ *  1. symbolic phase: SetPattern() allocates the storage for all entries, using a pattern
+ *     derived from the mesh connectivity (see FEASolver::BuildSparsityPattern()).
+ *  2. numeric phase: the element matrices are scattered into the preallocated slots using AddTo() or Put(),
+ *     which just locates the entry within the (short, contiguous) row.
+ *
+ * Entries that are not part of the pattern are still accepted, but are expensive to insert.
+ * Their number is tracked in \c NumFillIns.
+ *
+ * Besides the SSOR preconditioner of CBigLinProb, CBigCSRLinProb also supports
+ * an incomplete Cholesky and an algebraic multigrid preconditioner (see \c Preconditioner).
+ * The multigrid hierarchy is only rebuilt when the sparsity pattern changes;
+ * for new matrix values (e.g. in a nonlinear iteration) only the coarse operators are recomputed.
+ *
+ * For large matrices, MultA() and the SSOR preconditioner are distributed over femm::numThreads() threads.
+ * Each thread computes whole rows, gathering the lower triangle through a transposed index
+ * of the upper triangle storage, and the SSOR sweeps proceed level by level (see CLevelSchedule).
+ * The result is the same as for the serial computation.
+ *
+ * For several right hand sides (see SolveBlock()), MultABlock() and the SSOR sweeps of MultPCBlock()
+ * read each matrix entry only once for all vectors of the block.
+ *
+ * Instead of conjugate gradients, the system can also be solved by a sparse Cholesky factorization
+ * (see \c LinearSolver). The ordering is only recomputed when the sparsity pattern changes,
+ * and the factor is reused as long as the matrix values stay the same.
+ *
+ * Periodic and antiperiodic constraints are not applied to the matrix, but only recorded by Periodicity()
+ * and AntiPeriodicity() (see \c EliminatePeriodicity). Solve() then eliminates the slave unknowns
+ * in a single sweep over the matrix, solves the reduced system with the same settings,
+ * and reconstructs the slave values (see CPeriodicElimination).
+ * The reduced system is kept, so that its preconditioner or factorization can be reused.
+ *
+ * With \c ReusePC set, the incomplete Cholesky factor or the multigrid hierarchy of an earlier matrix
+ * is used to precondition the current one, and a direct solve corrects the current \c V
+ * with the Cholesky factor of an earlier matrix instead of factoring the current one (see DirectSolve()).
+ *
+ * CBigCSRLinProb can be used in place of a CBigLinProb.
+ */
+class CBigCSRLinProb : public CBigLinProb
+{
+public:
+    CBigCSRLinProb();
+    ~CBigCSRLinProb();
+
+    int Create(int d, int bw) override;
+    /**
+     * @brief Allocate the matrix storage from a sparsity pattern.
+     * All matrix entries are reset to zero.
+     * @param pattern a pattern with the same dimension as the matrix
+     * @return \c true on success, \c false if the dimensions do not match.
+     */
+    bool SetPattern(CSparsityPattern &pattern) override;
+
+    void Put(double v, int p, int q) override;
+    double Get(int p, int q) override;
+    void AddTo(double v, int p, int q) override;
+    void MultA(double *X, double *Y) override;
+    void MultPC(const double *X, double *Y) override;
+    void MultABlock(int k, const double *X, double *Y) override;
+    void MultPCBlock(int k, const double *X, double *Y) override;
+    void InitPC() override;
+    void Wipe() override;
+    /**
+     * @brief Keep a copy of the values and the right hand side.
+     * The copy follows entries that are inserted later on, and is discarded when the pattern is replaced.
+     */
+    void SaveAssembly() override;
+    void RestoreAssembly() override;
+    void ComputeBandwidth() override;
+    /**
+     * @brief Solve the system with the sparse Cholesky factorization.
+     * With \c ReusePC set and a factor of an earlier matrix with the same pattern available,
+     * \c V is taken as the current iterate and corrected by one step V += F^-1 (b-A*V),
+     * where F is the earlier matrix.
+     */
+    bool DirectSolve() override;
+    double ResidualNorm() override;
+    bool Solve(int flag) override;
+    bool SolveBlock(int nrhs, double *const *B, double *const *X, int flag) override;
+    /**
+     * @brief Fix unknown \p i to \p x, like CBigLinProb::SetValue().
+     * Only the entries of column \p i are visited, using the transposed index of \c Schedule,
+     * instead of searching all rows within the bandwidth.
+     */
+    void SetValue(int i, double x) override;
+    void Periodicity(int i, int j) override;
+    void AntiPeriodicity(int i, int j) override;
+
+    /**
+     * @brief Find the storage index of entry (p,q).
+     * @return the index into \c Value, or -1 if (p,q) is not part of the pattern.
+     */
+    int Slot(int p, int q) const;
+
+    std::vector<int> RowStart; ///< index of the first entry of each row in ColIndex/Value; has n+1 entries
+    std::vector<int> ColIndex; ///< column of each entry
+    std::vector<double> Value; ///< value of each entry
+    int NumFillIns; ///< number of entries that had to be inserted outside of the pattern
+    int PatternVersion; ///< incremented whenever the sparsity pattern changes
+    CIncompleteCholesky IC; ///< incomplete Cholesky factor, if the IC preconditioner is used
+    CAMGPreconditioner AMG; ///< multigrid hierarchy, if the AMG preconditioner is used
+    CSparseCholesky Chol; ///< sparse Cholesky factor, if the direct solver is used
+    CLevelSchedule Schedule; ///< transposed index (see SetValue()) and level schedule, if multithreading is used
+    /**
+     * @brief Eliminate periodic and antiperiodic constraints when solving (default),
+     * instead of averaging the rows and columns of the matrix like CBigLinProb.
+     */
+    bool EliminatePeriodicity;
+    CPeriodicElimination PBC; ///< constraints recorded since the last call to Wipe()
+
+private:
+    int Insert(int p, int q);
+    void UpdateSchedule();
+    bool UpdateReduced();
+
+    std::unique_ptr<CBigCSRLinProb> Reduced; ///< system without the slave unknowns
+    int ReducedPatternVersion; ///< PatternVersion the reduced system was built for
+};
+
+#endif
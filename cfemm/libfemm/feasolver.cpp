@@ -30,8 +30,10 @@
 
 #include "femmcomplex.h"
 #include "spars.h"
+#include "cspars.h"
 #include "fparse.h"
 #include "feasolver.h"
+#include "solverbackend.h"
 #include "stringTools.h"
 
 #include <assert.h>
@@ -78,6 +80,11 @@ FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshEleme
     , extRi(0.0)
     , comment()
     , ACSolver(0)
+    , Preconditioner(PRECOND_SSOR)
+    , ICFill(0)
+    , ICDropTol(0)
+    , LinearSolver(SOLVER_ITERATIVE)
+    , SolverBackend()
     , DoForceMaxMeshArea(false)
     , DoSmartMesh(true)
     , bMultiplyDefinedLabels(false)
@@ -95,6 +102,8 @@ FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshEleme
     , pbclist()
     , PathName()
     , PrevType(0)
+    , meshData()
+    , binarySolutionFile(false)
     , nodeproplist()
     , lineproplist()
     , blockproplist()
@@ -145,6 +154,11 @@ void FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
     extRi = 0.0;
     comment.clear();
     ACSolver = 0;
+    Preconditioner = PRECOND_SSOR;
+    ICFill = 0;
+    ICDropTol = 0;
+    LinearSolver = SOLVER_ITERATIVE;
+    SolverBackend.clear();
     DoForceMaxMeshArea = false;
     DoSmartMesh = true;
     bMultiplyDefinedLabels = false;
@@ -339,6 +353,44 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
             continue;
         }
 
+        // Preconditioner for the conjugate gradient solver
+        if( token == "[preconditioner]")
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, Preconditioner, err);
+            continue;
+        }
+
+        if( token == "[icfill]")
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, ICFill, err);
+            continue;
+        }
+
+        if( token == "[icdroptol]")
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, ICDropTol, err);
+            continue;
+        }
+
+        // Solution method for the linear systems
+        if( token == "[linearsolver]")
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseValue(lineStream, LinearSolver, err);
+            continue;
+        }
+
+        // Linear solver backend
+        if( token == "[solverbackend]")
+        {
+            success &= expectChar(lineStream, '=', err);
+            success &= parseString(lineStream, &SolverBackend, err);
+            continue;
+        }
+
 		// Previous solution type
 		if( token == "[prevtype]" )
         {
@@ -574,6 +626,107 @@ bool FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,Mesh
     return false;
 }
 
+template< class PointPropT
+          , class BoundaryPropT
+          , class BlockPropT
+          , class CircuitPropT
+          , class BlockLabelT
+          , class MeshElementT
+          >
+std::unique_ptr<CBigLinProb> FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
+::createLinProb() const
+{
+    std::unique_ptr<CBigLinProb> L = femm::createLinProb(SolverBackend);
+    if (!L)
+    {
+        std::string msg = "Linear solver backend \"" + SolverBackend + "\" is not available for this problem\n";
+        WarnMessage(msg.c_str());
+        return L;
+    }
+    L->Precision = Precision;
+    L->Preconditioner = Preconditioner;
+    L->ICFill = ICFill;
+    L->ICDropTol = ICDropTol;
+    L->LinearSolver = LinearSolver;
+    return L;
+}
+
+template< class PointPropT
+          , class BoundaryPropT
+          , class BlockPropT
+          , class CircuitPropT
+          , class BlockLabelT
+          , class MeshElementT
+          >
+std::unique_ptr<CBigComplexLinProb> FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
+::createComplexLinProb() const
+{
+    std::unique_ptr<CBigComplexLinProb> L = femm::createComplexLinProb(SolverBackend);
+    if (!L)
+    {
+        std::string msg = "Linear solver backend \"" + SolverBackend + "\" is not available for this problem\n";
+        WarnMessage(msg.c_str());
+        return L;
+    }
+    L->Precision = Precision;
+    L->LinearSolver = LinearSolver;
+    return L;
+}
+
+template< class PointPropT
+          , class BoundaryPropT
+          , class BlockPropT
+          , class CircuitPropT
+          , class BlockLabelT
+          , class MeshElementT
+          >
+void FEASolver<PointPropT,BoundaryPropT,BlockPropT,CircuitPropT,BlockLabelT,MeshElementT>
+::BuildSparsityPattern(CSparsityPattern &pattern, const std::vector<int> &dofmap, const std::vector<int> &elementdof) const
+{
+    // air gap elements couple 10 nodes each (see the air gap element assembly in Static2D)
+    for (const auto &age: agelist)
+    {
+        const int N = age.totalArcElements;
+        for (int k=0; k<N; k++)
+        {
+            const int km = (k-1<0) ? N-1 : k-1;
+            const int kp = (k+2>N) ? 1 : k+2;
+            const int nn[10] = {
+                age.quadNode[km].n0, age.quadNode[k].n0, age.quadNode[k].n1, age.quadNode[k+1].n1, age.quadNode[kp].n1,
+                age.quadNode[km].n2, age.quadNode[k].n2, age.quadNode[k].n3, age.quadNode[k+1].n3, age.quadNode[kp].n3
+            };
+            pattern.AddClique(nn,10);
+        }
+    }
+
+    for (int i=0; i<(int)meshele.size(); i++)
+    {
+        const auto &el = meshele[i];
+        int ne[3];
+        for (int j=0; j<3; j++)
+        {
+            ne[j] = el.p[j];
+            if (!dofmap.empty() && dofmap[el.p[j]]!=el.p[j])
+            {
+                ne[j] = dofmap[el.p[j]];
+                pattern.AddEntry(el.p[j],ne[j]);
+            }
+        }
+        pattern.AddClique(ne,3);
+        if (!elementdof.empty() && elementdof[i]>=0)
+        {
+            for (int j=0; j<3; j++)
+                pattern.AddEntry(ne[j],elementdof[i]);
+        }
+    }
+
+    // the fill-in depends on the order in which the constraints are applied
+    for (const auto &pbc: pbclist)
+    {
+        pattern.Couple(pbc.x,pbc.y);
+    }
+}
+
 template< class PointPropT
           , class BoundaryPropT
           , class BlockPropT
@@ -35,14 +35,21 @@
 #include "femmenums.h"
 #include "fparse.h"
 #include "spars.h"
+#include "csrspars.h"
 #include "CAirGapElement.h"
 #include "CBoundaryProp.h"
 #include "CCommonPoint.h"
 #include "CNode.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
+class CBigComplexLinProb;
+namespace femm {
+class CMeshData;
+}
+
 #ifndef _WIN32
 #define _strnicmp strncasecmp
 #ifndef SNPRINTF
@@ -104,6 +111,11 @@ public:
     std::string comment; ///< \brief Problem description
 
     int		ACSolver;
+    int     Preconditioner; ///< \brief preconditioner for the conjugate gradient solver, see PCGPreconditioner \verbatim[preconditioner]\endverbatim
+    int     ICFill;         ///< \brief fill level k of the IC(k) preconditioner \verbatim[icfill]\endverbatim
+    double  ICDropTol;      ///< \brief drop tolerance of the IC(k) preconditioner \verbatim[icdroptol]\endverbatim
+    int     LinearSolver;   ///< \brief solution method for the linear systems, see LinearSolverType \verbatim[linearsolver]\endverbatim
+    std::string SolverBackend; ///< \brief name of the linear solver backend, see solverbackend.h; empty for the default \verbatim[solverbackend]\endverbatim
     bool    DoForceMaxMeshArea;
     bool    DoSmartMesh;
     bool    bMultiplyDefinedLabels;
@@ -132,6 +144,16 @@ public:
 
     int PrevType; ///< \brief flag indicating type of previous solution, 0 for None, 1 for Incremental or 2 for Frozen \verbatim[prevtype]\endverbatim
     std::string previousSolutionFile; ///< \brief name of a previous solution file for hsolver and fsolver incremental permeability \verbatim[prevsoln]\endverbatim
+    /**
+     * @brief The mesh, as handed over by the mesher (see fmesher::FMesher::meshData).
+     * If set, LoadMesh() and Cuthill() use it instead of reading the mesh files.
+     */
+    std::shared_ptr<const femm::CMeshData> meshData;
+    /**
+     * @brief Write the solution file in the binary format (see femm::CSolutionFileWriter) instead of the text format.
+     * The postprocessors read both formats.
+     */
+    bool binarySolutionFile;
 
     std::vector< PointPropT > nodeproplist;
     std::vector< BoundaryPropT > lineproplist;
@@ -162,6 +184,37 @@ public:
     int Cuthill(bool deleteFiles=true);
     int SortElements();
 
+    /**
+     * @brief Build the sparsity pattern of the system matrix from the mesh connectivity.
+     *
+     * This is the symbolic assembly phase for a CBigCSRLinProb:
+     * the pattern contains the couplings of all elements in \c meshele and of all air gap elements,
+     * plus the fill-in caused by the periodic and antiperiodic boundary conditions in \c pbclist.
+     *
+     * @param pattern a pattern with (at least) one row per unknown
+     * @param dofmap optional mapping from node number to unknown.
+     * If a node is mapped to a different unknown (e.g. a conductor), the element couplings are added to the mapped unknown,
+     * and the node itself is coupled to its mapped unknown.
+     * @param elementdof optional additional unknown per element (e.g. the circuit of its block label), or -1.
+     * The additional unknown is coupled to all nodes of the element.
+     */
+    void BuildSparsityPattern(CSparsityPattern &pattern
+                              , const std::vector<int> &dofmap = std::vector<int>()
+                              , const std::vector<int> &elementdof = std::vector<int>()
+                              ) const;
+
+    /**
+     * @brief Create the real linear system with the backend selected by \c SolverBackend.
+     * The solver settings (precision, preconditioner, linear solver) are copied to the linear system.
+     * @return the linear system, or \c nullptr (with a warning) if the backend is unknown or does not support real problems.
+     */
+    std::unique_ptr<CBigLinProb> createLinProb() const;
+    /**
+     * @brief Create the complex linear system with the backend selected by \c SolverBackend.
+     * @return the linear system, or \c nullptr (with a warning) if the backend is unknown or does not support complex problems.
+     */
+    std::unique_ptr<CBigComplexLinProb> createComplexLinProb() const;
+
     // pointer to function to call when issuing warning messages
     int (*WarnMessage)(const char*, ...);
     int (*PrintMessage)(const char*, ...);
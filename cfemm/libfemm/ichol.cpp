@@ -0,0 +1,203 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "ichol.h"
+
+#include <algorithm>
+#include <cmath>
+
+// number of attempts with increasing diagonal shift
+#define MAXSHIFTS 10
+
+CIncompleteCholesky::CIncompleteCholesky()
+    : Shift(0)
+    , RowStart()
+    , ColIndex()
+    , Value()
+{
+}
+
+bool CIncompleteCholesky::Factor(int n, const int *rowStart, const int *colIndex, const double *value, int fill, double droptol)
+{
+    double alpha = 0;
+    for (int attempt=0; attempt<MAXSHIFTS; attempt++)
+    {
+        if (TryFactor(n, rowStart, colIndex, value, fill, droptol, alpha))
+        {
+            Shift = alpha;
+            return true;
+        }
+        alpha = (alpha==0) ? 1e-3 : 4*alpha;
+    }
+    Clear();
+    return false;
+}
+
+bool CIncompleteCholesky::TryFactor(int n, const int *rowStart, const int *colIndex, const double *value, int fill, double droptol, double alpha)
+{
+    // The factor is computed row by row (up-looking).
+    // Row i of U needs the entries u_ki of all rows k<i that are nonzero in column i.
+    // To find them without column storage, each finished row k is kept in a linked list
+    // for the column of its next unused entry (first[k]).
+    std::vector<int> head(n,-1);  // first row in the list for each column
+    std::vector<int> link(n,-1);  // next row in the same list
+    std::vector<int> first(n,-1); // next unused entry of each row
+    std::vector<int> level;       // fill level of each entry of U
+
+    std::vector<double> w(n,0.);  // work row
+    std::vector<int> wlev(n,-1);  // fill level of each entry in the work row; -1 if not present
+    std::vector<int> wcol;        // columns present in the work row
+
+    RowStart.assign(1,0);
+    ColIndex.clear();
+    Value.clear();
+    ColIndex.reserve(rowStart[n]);
+    Value.reserve(rowStart[n]);
+    level.reserve(rowStart[n]);
+
+    for (int i=0; i<n; i++)
+    {
+        // scatter row i of A
+        wcol.clear();
+        for (int e=rowStart[i]; e<rowStart[i+1]; e++)
+        {
+            int j = colIndex[e];
+            w[j] = value[e];
+            wlev[j] = 0;
+            wcol.push_back(j);
+        }
+        w[i] *= (1.+alpha);
+
+        // a_ij = sum_k u_ki*u_kj + u_ii*u_ij
+        int k = head[i];
+        while (k>=0)
+        {
+            int knext = link[k];
+            int e = first[k];
+            double uki = Value[e];
+            int lki = level[e];
+
+            w[i] -= uki*uki;
+            for (int f=e+1; f<RowStart[k+1]; f++)
+            {
+                int j = ColIndex[f];
+                int lev = lki + level[f] + 1;
+                if (wlev[j]<0)
+                {
+                    if (lev>fill) continue;
+                    w[j] = 0;
+                    wlev[j] = lev;
+                    wcol.push_back(j);
+                } else if (lev<wlev[j]) {
+                    wlev[j] = lev;
+                }
+                w[j] -= uki*Value[f];
+            }
+
+            // move row k to the list of its next column
+            if (e+1 < RowStart[k+1])
+            {
+                first[k] = e+1;
+                int j = ColIndex[e+1];
+                link[k] = head[j];
+                head[j] = k;
+            }
+            k = knext;
+        }
+
+        if (!(w[i]>0))
+        {
+            // breakdown; clean up the work row
+            for (int j: wcol)
+            {
+                w[j] = 0;
+                wlev[j] = -1;
+            }
+            return false;
+        }
+
+        // gather row i of U
+        std::sort(wcol.begin(), wcol.end());
+        double d = sqrt(w[i]);
+        double aii = fabs(value[rowStart[i]]);
+        ColIndex.push_back(i);
+        Value.push_back(d);
+        level.push_back(0);
+        for (int j: wcol)
+        {
+            if (j!=i)
+            {
+                bool drop = (wlev[j]>0 && fabs(w[j]) < droptol*sqrt(aii*fabs(value[rowStart[j]])));
+                if (!drop)
+                {
+                    ColIndex.push_back(j);
+                    Value.push_back(w[j]/d);
+                    level.push_back(wlev[j]);
+                }
+            }
+            w[j] = 0;
+            wlev[j] = -1;
+        }
+        RowStart.push_back(static_cast<int>(ColIndex.size()));
+
+        // add row i to the list of its first off-diagonal column
+        if (RowStart[i]+1 < RowStart[i+1])
+        {
+            first[i] = RowStart[i]+1;
+            int j = ColIndex[first[i]];
+            link[i] = head[j];
+            head[j] = i;
+        }
+    }
+
+    return true;
+}
+
+void CIncompleteCholesky::Solve(const double *X, double *Y) const
+{
+    int i,e;
+    double y;
+    const int n = static_cast<int>(RowStart.size())-1;
+    const int *rs = RowStart.data();
+    const int *col = ColIndex.data();
+    const double *val = Value.data();
+
+    for(i=0; i<n; i++) Y[i]=X[i];
+
+    // solve U^T z = x
+    for(i=0; i<n; i++)
+    {
+        Y[i]/= val[rs[i]];
+        y=Y[i];
+        for(e=rs[i]+1; e<rs[i+1]; e++)
+            Y[col[e]] -= val[e]*y;
+    }
+
+    // solve U y = z
+    for(i=n-1; i>=0; i--)
+    {
+        y=Y[i];
+        for(e=rs[i]+1; e<rs[i+1]; e++)
+            y -= val[e]*Y[col[e]];
+        Y[i] = y/val[rs[i]];
+    }
+}
+
+void CIncompleteCholesky::Clear()
+{
+    RowStart.clear();
+    ColIndex.clear();
+    Value.clear();
+    Shift = 0;
+}
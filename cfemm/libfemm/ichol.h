@@ -0,0 +1,73 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef ICHOL_H
+#define ICHOL_H
+
+#include <vector>
+
+/**
+ * @brief The CIncompleteCholesky class computes an incomplete Cholesky factorization A ~ U^T U.
+ *
+ * The factor is computed with a level-of-fill strategy (IC(k)):
+ * a fill-in entry gets the level lev(i,k)+lev(k,j)+1, and entries with a level above the fill level are discarded.
+ * IC(0) keeps exactly the pattern of the matrix.
+ * Additionally, fill-in entries (but never entries of the original pattern)
+ * are dropped if they are small compared to the diagonal, i.e. if |a_ij| < droptol*sqrt(|a_ii*a_jj|).
+ *
+ * If the factorization breaks down (non-positive pivot), it is retried with a growing diagonal shift.
+ */
+class CIncompleteCholesky
+{
+public:
+    CIncompleteCholesky();
+
+    /**
+     * @brief Factor a symmetric matrix.
+     *
+     * The matrix is given by its upper triangle in compressed row storage,
+     * where the diagonal element is the first entry of each row (see CBigCSRLinProb).
+     *
+     * @param n dimension of the matrix
+     * @param rowStart index of the first entry of each row (n+1 entries)
+     * @param colIndex column of each entry
+     * @param value value of each entry
+     * @param fill fill level k of IC(k)
+     * @param droptol drop tolerance for fill-in entries
+     * @return \c true on success, \c false if no factorization could be computed.
+     */
+    bool Factor(int n, const int *rowStart, const int *colIndex, const double *value, int fill, double droptol);
+    /**
+     * @brief Compute Y = (U^T U)^-1 X.
+     */
+    void Solve(const double *X, double *Y) const;
+    /**
+     * @brief Discard the factor.
+     */
+    void Clear();
+
+    bool Valid() const { return !RowStart.empty(); }
+    int NumEntries() const { return static_cast<int>(ColIndex.size()); }
+
+    double Shift; ///< relative diagonal shift that was needed to compute the factor
+
+private:
+    bool TryFactor(int n, const int *rowStart, const int *colIndex, const double *value, int fill, double droptol, double alpha);
+
+    std::vector<int> RowStart; ///< index of the first entry of each row of U; has n+1 entries
+    std::vector<int> ColIndex; ///< column of each entry of U; the diagonal comes first
+    std::vector<double> Value; ///< value of each entry of U
+};
+
+#endif
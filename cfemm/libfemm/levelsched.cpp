@@ -0,0 +1,108 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "levelsched.h"
+
+#include <algorithm>
+
+CLevelSchedule::CLevelSchedule()
+    : LowerStart()
+    , LowerCol()
+    , LowerSlot()
+    , ForwardStart()
+    , ForwardRows()
+    , BackwardStart()
+    , BackwardRows()
+    , PatternVersion(-1)
+{
+}
+
+void CLevelSchedule::Build(int n, const int *rowStart, const int *colIndex)
+{
+    // transposed index
+    LowerStart.assign(n+1,0);
+    for (int e=0; e<rowStart[n]; e++)
+        LowerStart[colIndex[e]+1]++;
+    // the diagonal entries are not part of the lower triangle
+    for (int i=0; i<n; i++)
+        LowerStart[i+1] += LowerStart[i] - 1;
+
+    LowerCol.resize(LowerStart[n]);
+    LowerSlot.resize(LowerStart[n]);
+    std::vector<int> next(LowerStart.begin(), LowerStart.end()-1);
+    for (int i=0; i<n; i++)
+    {
+        for (int e=rowStart[i]+1; e<rowStart[i+1]; e++)
+        {
+            int k = next[colIndex[e]]++;
+            LowerCol[k] = i;
+            LowerSlot[k] = e;
+        }
+    }
+
+    // forward sweep: row c depends on all rows i<c with an entry (i,c)
+    std::vector<int> level(n,0);
+    for (int i=0; i<n; i++)
+        for (int e=rowStart[i]+1; e<rowStart[i+1]; e++)
+            level[colIndex[e]] = std::max(level[colIndex[e]], level[i]+1);
+    Sort(level, ForwardStart, ForwardRows);
+
+    // backward sweep: row i depends on all rows c>i with an entry (i,c)
+    for (int i=n-1; i>=0; i--)
+    {
+        level[i] = 0;
+        for (int e=rowStart[i]+1; e<rowStart[i+1]; e++)
+            level[i] = std::max(level[i], level[colIndex[e]]+1);
+    }
+    Sort(level, BackwardStart, BackwardRows);
+}
+
+void CLevelSchedule::Sort(const std::vector<int> &level, std::vector<int> &start, std::vector<int> &rows)
+{
+    int nlevels = 0;
+    for (int l : level)
+        nlevels = std::max(nlevels, l+1);
+
+    start.assign(nlevels+1,0);
+    for (int l : level)
+        start[l+1]++;
+    for (int l=0; l<nlevels; l++)
+        start[l+1] += start[l];
+
+    rows.resize(level.size());
+    std::vector<int> next(start.begin(), start.end()-1);
+    for (int i=0; i<static_cast<int>(level.size()); i++)
+        rows[next[level[i]]++] = i;
+}
+
+int CLevelSchedule::SweepThreads(int maxThreads) const
+{
+    int nlevels = std::max(NumForwardLevels(), NumBackwardLevels());
+    if (nlevels<1)
+        return 1;
+    int rowsPerLevel = static_cast<int>(ForwardRows.size()) / nlevels;
+    return std::max(1, std::min(maxThreads, rowsPerLevel/MIN_ROWS_PER_THREAD));
+}
+
+void CLevelSchedule::Clear()
+{
+    LowerStart.clear();
+    LowerCol.clear();
+    LowerSlot.clear();
+    ForwardStart.clear();
+    ForwardRows.clear();
+    BackwardStart.clear();
+    BackwardRows.clear();
+    PatternVersion = -1;
+}
@@ -0,0 +1,77 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef LEVELSCHED_H
+#define LEVELSCHED_H
+
+#include <vector>
+
+/**
+ * @brief The CLevelSchedule class prepares a symmetric matrix in upper triangle storage for multithreaded sweeps.
+ *
+ * The matrix is given by its upper triangle in compressed row storage,
+ * where the diagonal element is the first entry of each row (see CBigCSRLinProb).
+ *
+ * Build() computes
+ *  - a transposed index of the upper triangle, i.e. the lower triangle by rows,
+ *    so that each row of a matrix-vector product or of a forward sweep can be computed on its own;
+ *  - level schedules for the forward (lower triangle) and backward (upper triangle) sweeps.
+ *    The rows within one level only depend on rows of earlier levels,
+ *    so each level can be distributed over several threads.
+ *
+ * The sweeps keep the original order of the unknowns, so the result is exactly the same as for a serial sweep.
+ * All data only depends on the sparsity pattern.
+ */
+class CLevelSchedule
+{
+public:
+    CLevelSchedule();
+
+    /**
+     * @brief Compute the transposed index and the level schedules.
+     * @param n dimension of the matrix
+     * @param rowStart index of the first entry of each row (n+1 entries)
+     * @param colIndex column of each entry
+     */
+    void Build(int n, const int *rowStart, const int *colIndex);
+    void Clear();
+
+    int NumForwardLevels() const { return static_cast<int>(ForwardStart.size())-1; }
+    int NumBackwardLevels() const { return static_cast<int>(BackwardStart.size())-1; }
+    /**
+     * @brief The number of threads worth using for the sweeps.
+     * Each thread should get at least \c MIN_ROWS_PER_THREAD rows per level on average,
+     * since all threads synchronize after each level.
+     * @param maxThreads upper limit, usually femm::numThreads()
+     */
+    int SweepThreads(int maxThreads) const;
+
+    static constexpr int MIN_ROWS_PER_THREAD = 32;
+
+    std::vector<int> LowerStart; ///< index of the first lower triangle entry of each row in LowerCol/LowerSlot; has n+1 entries
+    std::vector<int> LowerCol;   ///< column of each lower triangle entry, ascending within each row
+    std::vector<int> LowerSlot;  ///< index of each lower triangle entry in the upper triangle storage
+
+    std::vector<int> ForwardStart;  ///< index of the first row of each level in ForwardRows
+    std::vector<int> ForwardRows;   ///< rows of the forward sweep, by level
+    std::vector<int> BackwardStart; ///< index of the first row of each level in BackwardRows
+    std::vector<int> BackwardRows;  ///< rows of the backward sweep, by level
+
+    int PatternVersion; ///< version of the sparsity pattern the schedule was built for; maintained by the owner
+
+private:
+    static void Sort(const std::vector<int> &level, std::vector<int> &start, std::vector<int> &rows);
+};
+
+#endif
@@ -0,0 +1,408 @@
+/*
+ * The source code in this file extends the mesh handling code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "meshcache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char EntryMagic[8] = {'X','F','E','M','M','M','S','H'};
+const uint32_t EntryVersion = 1;
+/// entries are stored in the byte order of the host; other hosts see a cache miss
+const uint32_t ByteOrderMark = 0x01020304;
+/// temporary files older than this are left over from processes that died while storing an entry
+const std::chrono::hours StaleTempFileAge(1);
+
+/// 64 bit FNV-1a hash
+uint64_t hashKey(const std::string &key)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : key)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+class EntryWriter
+{
+public:
+    template<class T>
+    void put(T value)
+    {
+        data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void putBytes(const char *s, size_t n)
+    {
+        data.append(s, n);
+    }
+    void putString(const std::string &s)
+    {
+        put<uint64_t>(s.size());
+        data.append(s);
+    }
+
+    std::string data;
+};
+
+class EntryReader
+{
+public:
+    EntryReader(const char *begin, const char *end)
+        : pos(begin)
+        , end(end)
+    {}
+
+    template<class T>
+    bool get(T &value)
+    {
+        if (static_cast<size_t>(end-pos) < sizeof(T))
+            return false;
+        memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+    bool getString(std::string &s)
+    {
+        uint64_t n;
+        if (!get(n) || static_cast<uint64_t>(end-pos) < n)
+            return false;
+        s.assign(pos, n);
+        pos += n;
+        return true;
+    }
+    /// read a record count, and check that the file can hold that many records of (at least) \p recordSize bytes
+    bool getCount(size_t &count, size_t recordSize)
+    {
+        uint64_t n;
+        if (!get(n) || n > static_cast<uint64_t>(end-pos)/recordSize)
+            return false;
+        count = n;
+        return true;
+    }
+    bool atEnd() const { return pos==end; }
+
+private:
+    const char *pos;
+    const char *end;
+};
+
+bool readWholeFile(const std::string &fileName, std::vector<char> &buffer)
+{
+    FILE *fp = fopen(fileName.c_str(), "rb");
+    if (fp==NULL)
+        return false;
+    bool ok = false;
+    if (fseek(fp,0,SEEK_END)==0)
+    {
+        long size = ftell(fp);
+        if (size>=0 && fseek(fp,0,SEEK_SET)==0)
+        {
+            buffer.resize(size);
+            ok = fread(buffer.data(),1,buffer.size(),fp)==buffer.size();
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+bool validNode(int n, size_t numNodes)
+{
+    return n>=0 && static_cast<size_t>(n)<numNodes;
+}
+
+} // namespace
+
+using namespace femm;
+
+CMeshCache::CMeshCache(const std::string &directory, uint64_t maxBytes)
+    : cacheDir(directory)
+    , sizeLimit(maxBytes)
+{
+    std::error_code ec;
+    fs::create_directories(cacheDir, ec);
+}
+
+std::string CMeshCache::entryFile(const std::string &key) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(hashKey(key)));
+    return (fs::path(cacheDir) / name).string();
+}
+
+std::shared_ptr<CMeshData> CMeshCache::load(const std::string &key) const
+{
+    const std::string fileName = entryFile(key);
+    std::vector<char> buffer;
+    if (!readWholeFile(fileName, buffer))
+        return nullptr;
+
+    EntryReader in(buffer.data(), buffer.data()+buffer.size());
+    char magic[sizeof(EntryMagic)];
+    uint32_t version, bom;
+    std::string entryKey;
+    if (!in.get(magic) || memcmp(magic,EntryMagic,sizeof(magic))!=0
+            || !in.get(version) || version!=EntryVersion
+            || !in.get(bom) || bom!=ByteOrderMark
+            || !in.getString(entryKey) || entryKey!=key)
+        return nullptr;
+
+    auto mesh = std::make_shared<CMeshData>();
+    size_t count;
+    bool ok = in.getCount(count, 2*sizeof(double)+sizeof(int32_t));
+    mesh->nodes.resize(ok ? count : 0);
+    for (CMeshData::Node &node : mesh->nodes)
+        ok = ok && in.get(node.x) && in.get(node.y) && in.get(node.marker);
+    ok = ok && in.getCount(count, 3*sizeof(int32_t));
+    mesh->edges.resize(ok ? count : 0);
+    for (CMeshData::Edge &edge : mesh->edges)
+        ok = ok && in.get(edge.n0) && in.get(edge.n1) && in.get(edge.marker);
+    ok = ok && in.getCount(count, 4*sizeof(int32_t));
+    mesh->elements.resize(ok ? count : 0);
+    for (CMeshData::Element &elm : mesh->elements)
+        ok = ok && in.get(elm.p[0]) && in.get(elm.p[1]) && in.get(elm.p[2]) && in.get(elm.label);
+    ok = ok && in.getCount(count, 3*sizeof(int32_t));
+    mesh->pbcs.resize(ok ? count : 0);
+    for (CCommonPoint &pbc : mesh->pbcs)
+        ok = ok && in.get(pbc.x) && in.get(pbc.y) && in.get(pbc.t);
+    ok = ok && in.getCount(count, sizeof(uint64_t));
+    mesh->ages.resize(ok ? count : 0);
+    for (femmsolver::CAirGapElement &age : mesh->ages)
+    {
+        ok = ok && in.getString(age.BdryName)
+                && in.get(age.BdryFormat) && in.get(age.totalArcElements) && in.get(age.totalArcLength)
+                && in.get(age.ri) && in.get(age.ro)
+                && in.get(age.InnerAngle) && in.get(age.OuterAngle)
+                && in.get(age.InnerShift) && in.get(age.OuterShift)
+                && in.get(age.agc.re) && in.get(age.agc.im)
+                && in.getCount(count, 4*sizeof(int32_t)+4*sizeof(double));
+        age.quadNode.resize(ok ? count : 0);
+        for (CQuadPoint &qp : age.quadNode)
+        {
+            ok = ok && in.get(qp.n0) && in.get(qp.n1) && in.get(qp.n2) && in.get(qp.n3)
+                    && in.get(qp.w0) && in.get(qp.w1) && in.get(qp.w2) && in.get(qp.w3);
+        }
+    }
+    ok = ok && in.getCount(count, sizeof(int32_t));
+    mesh->numbering.resize(ok ? count : 0);
+    for (int &n : mesh->numbering)
+        ok = ok && in.get(n);
+    ok = ok && in.get(mesh->bandWidth) && in.atEnd();
+    if (!ok)
+        return nullptr;
+
+    // the solvers use the node numbers as indices
+    const size_t numNodes = mesh->nodes.size();
+    for (const CMeshData::Element &elm : mesh->elements)
+    {
+        if (!validNode(elm.p[0],numNodes) || !validNode(elm.p[1],numNodes) || !validNode(elm.p[2],numNodes))
+            return nullptr;
+    }
+    for (const CMeshData::Edge &edge : mesh->edges)
+    {
+        if (!validNode(edge.n0,numNodes) || !validNode(edge.n1,numNodes))
+            return nullptr;
+    }
+    for (const CCommonPoint &pbc : mesh->pbcs)
+    {
+        if (!validNode(pbc.x,numNodes) || !validNode(pbc.y,numNodes))
+            return nullptr;
+    }
+    for (const femmsolver::CAirGapElement &age : mesh->ages)
+    {
+        if (age.totalArcElements<0 || static_cast<size_t>(age.totalArcElements)>=age.quadNode.size())
+            return nullptr;
+        for (const CQuadPoint &qp : age.quadNode)
+        {
+            if (!validNode(qp.n0,numNodes) || !validNode(qp.n1,numNodes)
+                    || !validNode(qp.n2,numNodes) || !validNode(qp.n3,numNodes))
+                return nullptr;
+        }
+    }
+    if (!mesh->numbering.empty() && mesh->numbering.size()!=numNodes)
+        return nullptr;
+    for (int n : mesh->numbering)
+    {
+        if (!validNode(n,numNodes))
+            return nullptr;
+    }
+
+    // mark the entry as recently used
+    std::error_code ec;
+    fs::last_write_time(fileName, fs::file_time_type::clock::now(), ec);
+    return mesh;
+}
+
+bool CMeshCache::store(const std::string &key, const CMeshData &mesh)
+{
+    EntryWriter out;
+    out.putBytes(EntryMagic, sizeof(EntryMagic));
+    out.put(EntryVersion);
+    out.put(ByteOrderMark);
+    out.putString(key);
+    out.put<uint64_t>(mesh.nodes.size());
+    for (const CMeshData::Node &node : mesh.nodes)
+    {
+        out.put(node.x);
+        out.put(node.y);
+        out.put<int32_t>(node.marker);
+    }
+    out.put<uint64_t>(mesh.edges.size());
+    for (const CMeshData::Edge &edge : mesh.edges)
+    {
+        out.put<int32_t>(edge.n0);
+        out.put<int32_t>(edge.n1);
+        out.put<int32_t>(edge.marker);
+    }
+    out.put<uint64_t>(mesh.elements.size());
+    for (const CMeshData::Element &elm : mesh.elements)
+    {
+        out.put<int32_t>(elm.p[0]);
+        out.put<int32_t>(elm.p[1]);
+        out.put<int32_t>(elm.p[2]);
+        out.put<int32_t>(elm.label);
+    }
+    out.put<uint64_t>(mesh.pbcs.size());
+    for (const CCommonPoint &pbc : mesh.pbcs)
+    {
+        out.put<int32_t>(pbc.x);
+        out.put<int32_t>(pbc.y);
+        out.put<int32_t>(pbc.t);
+    }
+    out.put<uint64_t>(mesh.ages.size());
+    for (const femmsolver::CAirGapElement &age : mesh.ages)
+    {
+        out.putString(age.BdryName);
+        out.put<int32_t>(age.BdryFormat);
+        out.put<int32_t>(age.totalArcElements);
+        out.put(age.totalArcLength);
+        out.put(age.ri);
+        out.put(age.ro);
+        out.put(age.InnerAngle);
+        out.put(age.OuterAngle);
+        out.put(age.InnerShift);
+        out.put(age.OuterShift);
+        out.put(age.agc.re);
+        out.put(age.agc.im);
+        out.put<uint64_t>(age.quadNode.size());
+        for (const CQuadPoint &qp : age.quadNode)
+        {
+            out.put<int32_t>(qp.n0);
+            out.put<int32_t>(qp.n1);
+            out.put<int32_t>(qp.n2);
+            out.put<int32_t>(qp.n3);
+            out.put(qp.w0);
+            out.put(qp.w1);
+            out.put(qp.w2);
+            out.put(qp.w3);
+        }
+    }
+    out.put<uint64_t>(mesh.numbering.size());
+    for (int n : mesh.numbering)
+        out.put<int32_t>(n);
+    out.put<int32_t>(mesh.bandWidth);
+
+    // write to a file of our own, and move the complete entry into place
+    static std::atomic<unsigned> counter(0);
+    const std::string fileName = entryFile(key);
+    const std::string tmpName = fileName + "." + std::to_string(getpid()) + "." + std::to_string(counter++) + ".tmp";
+    FILE *fp = fopen(tmpName.c_str(), "wb");
+    if (fp==NULL)
+        return false;
+    bool ok = fwrite(out.data.data(),1,out.data.size(),fp)==out.data.size();
+    ok = fclose(fp)==0 && ok;
+    std::error_code ec;
+    if (ok)
+    {
+        // if another process stored the same entry in the meantime, it is replaced by an identical one
+        fs::rename(tmpName, fileName, ec);
+        ok = !ec;
+    }
+    if (!ok)
+    {
+        fs::remove(tmpName, ec);
+        return false;
+    }
+
+    if (sizeLimit>0)
+        evict();
+    return true;
+}
+
+void CMeshCache::evict()
+{
+    struct Entry
+    {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type lastUse;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    const fs::file_time_type now = fs::file_time_type::clock::now();
+
+    std::error_code ec;
+    for (fs::directory_iterator it(cacheDir, ec), end; !ec && it!=end; it.increment(ec))
+    {
+        const fs::path &path = it->path();
+        std::error_code entryEc;
+        const fs::file_time_type lastUse = fs::last_write_time(path, entryEc);
+        if (entryEc)
+            continue; // removed by another process
+        if (path.extension()==".tmp")
+        {
+            if (now-lastUse > StaleTempFileAge)
+                fs::remove(path, entryEc);
+            continue;
+        }
+        if (path.extension()!=".mesh")
+            continue;
+        const uint64_t size = fs::file_size(path, entryEc);
+        if (entryEc)
+            continue;
+        entries.push_back(Entry{path, size, lastUse});
+        total += size;
+    }
+    if (total<=sizeLimit)
+        return;
+
+    // another process may remove the same entries at the same time, which is harmless
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.lastUse < b.lastUse;
+    });
+    for (const Entry &entry : entries)
+    {
+        if (total<=sizeLimit)
+            break;
+        fs::remove(entry.path, ec);
+        total -= entry.size;
+    }
+}
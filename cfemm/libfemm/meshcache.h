@@ -0,0 +1,74 @@
+/*
+ * The source code in this file extends the mesh handling code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef FEMM_MESHCACHE_H
+#define FEMM_MESHCACHE_H
+
+#include "meshdata.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace femm {
+
+/**
+ * @brief The CMeshCache class keeps triangulations in a directory, keyed by the input of the mesher.
+ *
+ * In a parameter sweep, often only material properties, circuit currents or the frequency change between runs,
+ * and the same geometry is meshed over and over.
+ * The key describes everything the mesher reads (see fmesher::FMesher::meshCacheKey()),
+ * and the cache stores the resulting CMeshData, including its Cuthill-McKee numbering.
+ *
+ * Each entry is a binary file named after the hash of its key.
+ * The file also contains the key itself, so that a hash collision is just a cache miss.
+ * Entries are written to a temporary file and then renamed, so that several processes can share the directory:
+ * a process either sees a complete entry or none.
+ * When the entries exceed the size limit, the least recently used entries are removed.
+ */
+class CMeshCache
+{
+public:
+    /**
+     * @brief Construct a mesh cache.
+     * @param directory the cache directory; it is created, if necessary
+     * @param maxBytes the size limit of all entries, or 0 for no limit
+     */
+    CMeshCache(const std::string &directory, uint64_t maxBytes);
+
+    /**
+     * @brief Load the triangulation stored for \p key.
+     * @return the triangulation, or \c nullptr if there is no (valid) entry for \p key.
+     */
+    std::shared_ptr<CMeshData> load(const std::string &key) const;
+    /**
+     * @brief Store a triangulation for \p key, and remove old entries if the cache exceeds its size limit.
+     * @return \c false if the entry could not be written.
+     */
+    bool store(const std::string &key, const CMeshData &mesh);
+
+    const std::string &directory() const { return cacheDir; }
+    uint64_t maxBytes() const { return sizeLimit; }
+
+private:
+    std::string entryFile(const std::string &key) const;
+    void evict();
+
+    std::string cacheDir;
+    uint64_t sizeLimit;
+};
+
+} // namespace femm
+
+#endif
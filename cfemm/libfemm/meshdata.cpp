@@ -0,0 +1,759 @@
+/*
+ * The source code in this file extends the mesh handling code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "meshdata.h"
+
+#include "parallel.h"
+#include "textwriter.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/// files larger than this are parsed in parallel chunks
+const size_t PARALLEL_PARSE_BYTES = 1<<20;
+
+bool isBlank(char c)
+{
+    return c==' ' || c=='\t' || c=='\r' || c=='\v' || c=='\f';
+}
+
+/**
+ * @brief The Line class splits one line of a mesh file into numbers.
+ * A \c # starts a comment that extends to the end of the line.
+ */
+class Line
+{
+public:
+    Line(const char *begin, const char *end)
+        : pos(begin)
+        , end(end)
+    {}
+
+    /// \c true, if the line contains no (more) tokens
+    bool atEnd()
+    {
+        skipBlanks();
+        return pos==end;
+    }
+
+    template<class T>
+    bool next(T &value)
+    {
+        skipBlanks();
+        std::from_chars_result result = std::from_chars(pos,end,value);
+        if (result.ec!=std::errc() || (result.ptr!=end && !isBlank(*result.ptr) && *result.ptr!='#'))
+            return false;
+        pos = result.ptr;
+        return true;
+    }
+
+    /// skip a token, e.g. the record number
+    bool skip()
+    {
+        if (atEnd())
+            return false;
+        while (pos!=end && !isBlank(*pos) && *pos!='#')
+            pos++;
+        return true;
+    }
+
+private:
+    void skipBlanks()
+    {
+        while (pos!=end && isBlank(*pos))
+            pos++;
+        if (pos!=end && *pos=='#')
+            pos = end;
+    }
+
+    const char *pos;
+    const char *end;
+};
+
+/**
+ * @brief Get the next line.
+ * @param pos start of the line; advanced to the start of the following line
+ * @return the end of the line (excluding the newline)
+ */
+const char *nextLine(const char *&pos, const char *end)
+{
+    const char *eol = static_cast<const char*>(memchr(pos,'\n',end-pos));
+    if (!eol)
+        eol = end;
+    pos = (eol==end) ? end : eol+1;
+    return eol;
+}
+
+/**
+ * @brief Get the next line that is neither blank nor a comment.
+ * @return \c false at the end of the buffer
+ */
+bool nextRecordLine(const char *&pos, const char *end, Line &line)
+{
+    while (pos!=end)
+    {
+        const char *begin = pos;
+        const char *eol = nextLine(pos,end);
+        line = Line(begin,eol);
+        if (!line.atEnd())
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Parse the number of records from the header line of a mesh file.
+ * @param pos is advanced past the header
+ */
+bool parseCount(const char *&pos, const char *end, int &count)
+{
+    Line line(pos,pos);
+    return nextRecordLine(pos,end,line) && line.next(count) && count>=0;
+}
+
+/**
+ * @brief Parse the records of a mesh file, one record per line.
+ *
+ * Large files are split into chunks at line boundaries.
+ * A first pass counts the records of each chunk, so that each chunk knows the number of its first record,
+ * and a second pass parses the chunks independently.
+ * @param records is resized to \p count records
+ * @param parse parses a record from a line
+ * @return \c false, if a record is malformed or the file ends before \p count records
+ */
+template<class Record, class Parse>
+bool parseRecords(const char *begin, const char *end, std::vector<Record> &records, size_t count, Parse parse)
+{
+    records.resize(count);
+
+    int chunks = 1;
+    if (static_cast<size_t>(end-begin) >= PARALLEL_PARSE_BYTES && count>0)
+        chunks = femm::numThreads();
+    std::vector<const char*> chunkBegin(chunks+1);
+    chunkBegin[0] = begin;
+    chunkBegin[chunks] = end;
+    for (int c=1; c<chunks; c++)
+    {
+        const char *pos = begin + (end-begin)/chunks*c;
+        if (pos<chunkBegin[c-1])
+            pos = chunkBegin[c-1];
+        nextLine(pos,end);
+        chunkBegin[c] = pos;
+    }
+
+    // number of the first record of each chunk
+    std::vector<size_t> first(chunks+1,0);
+    if (chunks>1)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(chunks)
+#endif
+        for (int c=0; c<chunks; c++)
+        {
+            const char *pos = chunkBegin[c];
+            Line line(pos,pos);
+            size_t n = 0;
+            while (nextRecordLine(pos,chunkBegin[c+1],line))
+                n++;
+            first[c+1] = n;
+        }
+        for (int c=0; c<chunks; c++)
+            first[c+1] += first[c];
+        if (first[chunks]<count)
+            return false;
+    }
+
+    std::vector<char> ok(chunks,1);
+    std::vector<size_t> parsed(chunks,0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(chunks) if(chunks>1)
+#endif
+    for (int c=0; c<chunks; c++)
+    {
+        const char *pos = chunkBegin[c];
+        Line line(pos,pos);
+        size_t i = first[c];
+        while (i<count && nextRecordLine(pos,chunkBegin[c+1],line))
+        {
+            if (!parse(line,records[i]))
+            {
+                ok[c] = 0;
+                break;
+            }
+            i++;
+        }
+        parsed[c] = i-first[c];
+    }
+
+    size_t total = 0;
+    for (int c=0; c<chunks; c++)
+    {
+        if (!ok[c])
+            return false;
+        total += parsed[c];
+    }
+    return total==count;
+}
+
+/// Read the rest of a file into a buffer.
+bool readFile(FILE *fp, std::vector<char> &buffer)
+{
+    buffer.clear();
+    long pos = ftell(fp);
+    if (pos>=0 && fseek(fp,0,SEEK_END)==0)
+    {
+        long size = ftell(fp);
+        if (size>=pos && fseek(fp,pos,SEEK_SET)==0)
+        {
+            buffer.resize(size-pos);
+            buffer.resize(fread(buffer.data(),1,buffer.size(),fp));
+        }
+    }
+    // not seekable, or the file grew in between
+    char chunk[65536];
+    size_t n;
+    while ((n=fread(chunk,1,sizeof(chunk),fp)) > 0)
+        buffer.insert(buffer.end(),chunk,chunk+n);
+    return !ferror(fp);
+}
+
+/**
+ * @brief The FileContents class holds the contents of a file.
+ * On POSIX systems, the file is memory-mapped; elsewhere, it is read into a buffer.
+ */
+class FileContents
+{
+public:
+    FileContents()
+        : mapping(nullptr)
+        , mappingSize(0)
+        , buffer()
+    {}
+    ~FileContents()
+    {
+#ifndef _WIN32
+        if (mapping)
+            munmap(mapping, mappingSize);
+#endif
+    }
+    FileContents(const FileContents &) = delete;
+    FileContents &operator=(const FileContents &) = delete;
+
+    bool open(const std::string &fileName)
+    {
+#ifndef _WIN32
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd<0)
+            return false;
+        struct stat st;
+        if (fstat(fd,&st)!=0)
+        {
+            ::close(fd);
+            return false;
+        }
+        if (st.st_size>0)
+        {
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            // the whole file is parsed anyway, so map it at once instead of page by page
+            flags |= MAP_POPULATE;
+#endif
+            void *m = mmap(nullptr, st.st_size, PROT_READ, flags, fd, 0);
+            if (m!=MAP_FAILED)
+            {
+                mapping = m;
+                mappingSize = st.st_size;
+            }
+        }
+        ::close(fd);
+        if (mapping || st.st_size==0)
+            return true;
+#endif
+        FILE *fp = fopen(fileName.c_str(),"rb");
+        if (fp==NULL)
+            return false;
+        bool ok = readFile(fp,buffer);
+        fclose(fp);
+        return ok;
+    }
+
+    const char *begin() const
+    {
+        return mapping ? static_cast<const char*>(mapping) : buffer.data();
+    }
+    const char *end() const
+    {
+        return mapping ? begin()+mappingSize : buffer.data()+buffer.size();
+    }
+
+private:
+    void *mapping;
+    size_t mappingSize;
+    std::vector<char> buffer;
+};
+
+bool validNode(int n, size_t numNodes)
+{
+    return n>=0 && static_cast<size_t>(n)<numNodes;
+}
+
+} // namespace
+
+using namespace femm;
+
+void CMeshData::clear()
+{
+    nodes.clear();
+    edges.clear();
+    elements.clear();
+    pbcs.clear();
+    ages.clear();
+    numbering.clear();
+    bandWidth = 0;
+}
+
+void CMeshData::computeNumbering()
+{
+    bandWidth = cuthillMcKee((int)nodes.size(), edges, numbering);
+}
+
+int CMeshData::cuthillMcKee(int numNodes, const std::vector<Edge> &edges, std::vector<int> &newnum)
+{
+    newnum.assign(numNodes,-1);
+    if (numNodes==0)
+        return 1;
+    const long k = (long)edges.size();
+
+    // with first pass, figure out how many connections there are for each node;
+    // the connections of node i are ocon[first[i]] ... ocon[first[i]+numcon[i]-1]
+    std::vector<int> numcon(numNodes,0);
+    for (const Edge &edge : edges)
+    {
+        numcon[edge.n0]++;
+        numcon[edge.n1]++;
+    }
+    std::vector<long> first(numNodes,0);
+    for (int i=1; i<numNodes; i++)
+        first[i] = first[i-1]+numcon[i-1];
+
+    // on second pass, store connections;
+    std::vector<int> ocon(2*k);
+    std::vector<int> nxtnum(numNodes,0);
+    for (const Edge &edge : edges)
+    {
+        ocon[first[edge.n0]+nxtnum[edge.n0]++] = edge.n1;
+        ocon[first[edge.n1]+nxtnum[edge.n1]++] = edge.n0;
+    }
+
+    // sort connections in order of increasing connectivity;
+    for (int n0=0; n0<numNodes; n0++)
+    {
+        int *con = ocon.data()+first[n0];
+        for (int i=1; i<numcon[n0]; i++)
+            for (int j=1; j<numcon[n0]; j++)
+                if (numcon[con[j]]<numcon[con[j-1]])
+                    std::swap(con[j],con[j-1]);
+    }
+
+    // search for a node to start with;
+    long j=numcon[0];
+    int n0=0;
+    for (long i=1; i<numNodes; i++)
+    {
+        if (numcon[i]<j)
+        {
+            j=numcon[i];
+            n0=i;
+        }
+        // break out if j==2, because this is the best we can do
+        // (as in FEMM, this skips to the number of edges, which is normally beyond the last node)
+        if (j==2) i=k;
+    }
+
+    // do renumbering algorithm;
+    for (int i=0; i<numNodes; i++) nxtnum[i]=-1;
+    newnum[n0]=0;
+    int n=1;
+    nxtnum[0]=n0;
+
+    do
+    {
+        // renumber in order of increasing number of connections;
+        const int *con = ocon.data()+first[n0];
+        for (int i=0; i<numcon[n0]; i++)
+        {
+            if (newnum[con[i]]<0)
+            {
+                newnum[con[i]]=n;
+                nxtnum[n]=con[i];
+                n++;
+            }
+        }
+
+        // need to catch case in which problem is multiply
+        // connected and still renumber right.
+        if (nxtnum[newnum[n0]+1]<0)
+        {
+            // first, get a node that hasn't been visited yet;
+            for (int i=0; i<numNodes; i++)
+                if (newnum[i]<0)
+                {
+                    j=numcon[i];
+                    n0=i;
+                    break;
+                }
+
+            // now, get a new starting node;
+            for (int i=0; i<numNodes; i++)
+            {
+                if ((newnum[i]<0) && (numcon[i]<j))
+                {
+                    j=numcon[i];
+                    n0=i;
+                }
+                if (j==2) break;
+            }
+
+            // now, set things to restart;
+            newnum[n0]=n;
+            nxtnum[n]=n0;
+            n++;
+        }
+        else n0=nxtnum[newnum[n0]+1];
+    }
+    while (n<numNodes);
+
+    // find new bandwidth;
+    int newwide=0;
+    for (n0=0; n0<numNodes; n0++)
+    {
+        const int *con = ocon.data()+first[n0];
+        for (int i=0; i<numcon[n0]; i++)
+            newwide = std::max(newwide, std::abs(newnum[n0]-newnum[con[i]]));
+    }
+
+    return newwide+1;
+}
+
+LoadMeshErr CMeshData::readFiles(const std::string &baseName)
+{
+    clear();
+
+    if (!readNodes(baseName+".node"))
+        return BADNODEFILE;
+    if (!readPbcs(baseName+".pbc"))
+        return BADPBCFILE;
+    if (!readElements(baseName+".ele"))
+        return BADELEMENTFILE;
+    if (!readEdges(baseName+".edge"))
+        return BADEDGEFILE;
+
+    // the solvers use the node numbers as indices
+    const size_t numNodes = nodes.size();
+    for (const CCommonPoint &pbc : pbcs)
+    {
+        if (!validNode(pbc.x,numNodes) || !validNode(pbc.y,numNodes))
+            return BADPBCFILE;
+    }
+    for (const femmsolver::CAirGapElement &age : ages)
+    {
+        for (const femm::CQuadPoint &qp : age.quadNode)
+        {
+            if (!validNode(qp.n0,numNodes) || !validNode(qp.n1,numNodes)
+                    || !validNode(qp.n2,numNodes) || !validNode(qp.n3,numNodes))
+                return BADPBCFILE;
+        }
+    }
+    for (const Element &elm : elements)
+    {
+        if (!validNode(elm.p[0],numNodes) || !validNode(elm.p[1],numNodes) || !validNode(elm.p[2],numNodes))
+            return BADELEMENTFILE;
+    }
+    for (const Edge &edge : edges)
+    {
+        if (!validNode(edge.n0,numNodes) || !validNode(edge.n1,numNodes))
+            return BADEDGEFILE;
+    }
+
+    return NOERROR;
+}
+
+bool CMeshData::readNodes(const std::string &fileName)
+{
+    FileContents contents;
+    return contents.open(fileName) && parseNodes(contents.begin(),contents.end());
+}
+
+bool CMeshData::readEdges(const std::string &fileName)
+{
+    FileContents contents;
+    return contents.open(fileName) && parseEdges(contents.begin(),contents.end());
+}
+
+bool CMeshData::readElements(const std::string &fileName)
+{
+    FileContents contents;
+    return contents.open(fileName) && parseElements(contents.begin(),contents.end());
+}
+
+bool CMeshData::readPbcs(const std::string &fileName)
+{
+    FileContents contents;
+    return contents.open(fileName) && parsePbcs(contents.begin(),contents.end());
+}
+
+bool CMeshData::readNodes(FILE *fp)
+{
+    std::vector<char> buffer;
+    return readFile(fp,buffer) && parseNodes(buffer.data(),buffer.data()+buffer.size());
+}
+
+bool CMeshData::readEdges(FILE *fp)
+{
+    std::vector<char> buffer;
+    return readFile(fp,buffer) && parseEdges(buffer.data(),buffer.data()+buffer.size());
+}
+
+bool CMeshData::readElements(FILE *fp)
+{
+    std::vector<char> buffer;
+    return readFile(fp,buffer) && parseElements(buffer.data(),buffer.data()+buffer.size());
+}
+
+bool CMeshData::readPbcs(FILE *fp)
+{
+    std::vector<char> buffer;
+    return readFile(fp,buffer) && parsePbcs(buffer.data(),buffer.data()+buffer.size());
+}
+
+bool CMeshData::parseNodes(const char *begin, const char *end)
+{
+    // <# of vertices> <dimension (must be 2)> <# of attributes> <# of boundary markers (0 or 1)>
+    // Only the number of vertices is used, since older mesh files do not fill in the rest correctly.
+    int count;
+    if (!parseCount(begin,end,count))
+        return false;
+
+    // <vertex #> <x> <y> <boundary marker>
+    return parseRecords(begin,end,nodes,count,[](Line &line, Node &node) {
+        node.marker = 0;
+        return line.skip()
+                && line.next(node.x) && line.next(node.y)
+                && (line.atEnd() || line.next(node.marker));
+    });
+}
+
+bool CMeshData::parseEdges(const char *begin, const char *end)
+{
+    // <# of edges> <# of boundary markers (0 or 1)>
+    int count;
+    if (!parseCount(begin,end,count))
+        return false;
+
+    // <edge #> <endpoint> <endpoint> <boundary marker>
+    return parseRecords(begin,end,edges,count,[](Line &line, Edge &edge) {
+        edge.marker = 0;
+        return line.skip()
+                && line.next(edge.n0) && line.next(edge.n1)
+                && (line.atEnd() || line.next(edge.marker));
+    });
+}
+
+bool CMeshData::parseElements(const char *begin, const char *end)
+{
+    // <# of triangles> <nodes per triangle> <# of attributes>
+    int count;
+    if (!parseCount(begin,end,count))
+        return false;
+
+    // <triangle #> <node> <node> <node> <regional attribute>
+    return parseRecords(begin,end,elements,count,[](Line &line, Element &elm) {
+        // triangle writes the attribute as a floating point value
+        double label = 0;
+        bool ok = line.skip()
+                && line.next(elm.p[0]) && line.next(elm.p[1]) && line.next(elm.p[2])
+                && (line.atEnd() || line.next(label));
+        elm.label = (int) label;
+        return ok;
+    });
+}
+
+bool CMeshData::parsePbcs(const char *begin, const char *end)
+{
+    int count;
+    if (!parseCount(begin,end,count))
+        return false;
+
+    // <pbc #> <node> <node> <0: periodic, 1: antiperiodic>
+    pbcs.clear();
+    ages.clear();
+    pbcs.reserve(count);
+    Line line(begin,begin);
+    for (int i=0; i<count; i++)
+    {
+        CCommonPoint pbc;
+        if (!nextRecordLine(begin,end,line)
+                || !line.skip() || !line.next(pbc.x) || !line.next(pbc.y) || !line.next(pbc.t))
+            return false;
+        pbcs.push_back(pbc);
+    }
+
+    // read in air gap element info;
+    // older mesh files end after the periodic boundary conditions
+    if (!nextRecordLine(begin,end,line))
+        return true;
+    if (!line.next(count) || count<0)
+        return false;
+    ages.resize(count);
+    for (femmsolver::CAirGapElement &age : ages)
+    {
+        // the name line is kept verbatim
+        if (begin==end)
+            return false;
+        const char *nameBegin = begin;
+        nextLine(begin,end);
+        age.BdryName = std::string(nameBegin,begin);
+
+        if (!nextRecordLine(begin,end,line)
+                || !line.next(age.BdryFormat)
+                || !line.next(age.InnerAngle)
+                || !line.next(age.OuterAngle)
+                || !line.next(age.ri)
+                || !line.next(age.ro)
+                || !line.next(age.totalArcLength)
+                || !line.next(age.agc.re)
+                || !line.next(age.agc.im)
+                || !line.next(age.totalArcElements)
+                || !line.next(age.InnerShift)
+                || !line.next(age.OuterShift)
+                || age.totalArcElements<0)
+            return false;
+
+        age.quadNode.resize(age.totalArcElements+1);
+        for (femm::CQuadPoint &qp : age.quadNode)
+        {
+            if (!nextRecordLine(begin,end,line)
+                    || !line.next(qp.n0) || !line.next(qp.w0)
+                    || !line.next(qp.n1) || !line.next(qp.w1)
+                    || !line.next(qp.n2) || !line.next(qp.w2)
+                    || !line.next(qp.n3) || !line.next(qp.w3))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool CMeshData::writeFiles(const std::string &baseName) const
+{
+    FILE *fp;
+    bool ok = true;
+    auto finish = [&ok](FILE *file, CTextWriter &out) {
+        ok = out.flush() && ok;
+        ok = fclose(file)==0 && ok;
+    };
+
+    // <# of vertices> <dimension (must be 2)> <# of attributes> <# of boundary markers (0 or 1)>
+    if ((fp=fopen((baseName+".node").c_str(),"wt"))==NULL)
+        return false;
+    {
+        CTextWriter out(fp);
+        out << (int)nodes.size() << "\t2\t0\t1\n";
+        out.writeRecords((int)nodes.size(), [this](CTextWriter &w, int i) {
+            w << i << '\t' << nodes[i].x << '\t' << nodes[i].y << '\t' << nodes[i].marker << '\n';
+        });
+        finish(fp,out);
+    }
+
+    // <# of edges> <# of boundary markers (0 or 1)>
+    if ((fp=fopen((baseName+".edge").c_str(),"wt"))==NULL)
+        return false;
+    {
+        CTextWriter out(fp);
+        out << (int)edges.size() << "\t1\n";
+        out.writeRecords((int)edges.size(), [this](CTextWriter &w, int i) {
+            w << i << '\t' << edges[i].n0 << '\t' << edges[i].n1 << '\t' << edges[i].marker << '\n';
+        });
+        finish(fp,out);
+    }
+
+    // <# of triangles> <nodes per triangle> <# of attributes>
+    if ((fp=fopen((baseName+".ele").c_str(),"wt"))==NULL)
+        return false;
+    {
+        CTextWriter out(fp);
+        out << (int)elements.size() << "\t3\t1\n";
+        out.writeRecords((int)elements.size(), [this](CTextWriter &w, int i) {
+            const Element &elm = elements[i];
+            w << i << '\t' << elm.p[0] << '\t' << elm.p[1] << '\t' << elm.p[2] << '\t' << elm.label << "\t\n";
+        });
+        finish(fp,out);
+    }
+
+    // a list of linked nodes, followed by the air gap elements
+    if ((fp=fopen((baseName+".pbc").c_str(),"wt"))==NULL)
+        return false;
+    {
+        CTextWriter out(fp);
+        out << (int)pbcs.size() << '\n';
+        for (int i=0; i<(int)pbcs.size(); i++)
+            out << i << "    " << pbcs[i].x << "    " << pbcs[i].y << "    " << pbcs[i].t << '\n';
+        // the trivial file of a nonperiodic triangulation ends here
+        if (!pbcs.empty() || !ages.empty())
+        {
+            out << (int)ages.size() << '\n';
+            for (const femmsolver::CAirGapElement &age : ages)
+            {
+                out << age.BdryName;
+                out << age.BdryFormat << ' ' << age.InnerAngle << ' ' << age.OuterAngle << ' '
+                    << age.ri << ' ' << age.ro << ' ' << age.totalArcLength << ' '
+                    << age.agc.re << ' ' << age.agc.im << ' ' << age.totalArcElements << ' '
+                    << age.InnerShift << ' ' << age.OuterShift << '\n';
+                // the weights round-trip exactly (FEMM writes them with %g),
+                // so that a solver reading the file sees the same mesh as one that gets it in memory
+                for (const femm::CQuadPoint &qp : age.quadNode)
+                {
+                    out << qp.n0 << ' ' << qp.w0 << ' '
+                        << qp.n1 << ' ' << qp.w1 << ' '
+                        << qp.n2 << ' ' << qp.w2 << ' '
+                        << qp.n3 << ' ' << qp.w3 << '\n';
+                }
+            }
+        }
+        finish(fp,out);
+    }
+
+    return ok;
+}
+
+void CMeshData::removeFiles(const std::string &baseName, bool includeEdgeFile)
+{
+    remove((baseName+".ele").c_str());
+    remove((baseName+".node").c_str());
+    remove((baseName+".pbc").c_str());
+    remove((baseName+".poly").c_str());
+    if (includeEdgeFile)
+        remove((baseName+".edge").c_str());
+}
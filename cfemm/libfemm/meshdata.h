@@ -0,0 +1,145 @@
+/*
+ * The source code in this file extends the mesh handling code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef FEMM_MESHDATA_H
+#define FEMM_MESHDATA_H
+
+#include "feasolver.h"
+#include "CAirGapElement.h"
+#include "CCommonPoint.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief The CMeshData class holds a triangulation as the mesher writes it to the mesh files.
+ *
+ * The mesher writes the files \c .node, \c .edge, \c .ele and \c .pbc, and the solvers read them back.
+ * CMeshData contains the same data in the same numbering, including the raw markers of triangle,
+ * so that the mesher can hand its triangulation directly to a solver (see FEASolver::meshData).
+ * The solvers interpret the markers exactly as if they had been read from the files.
+ */
+class CMeshData
+{
+public:
+    struct Node
+    {
+        double x;
+        double y;
+        int marker; ///< point marker, in the same encoding as in the \c .node file
+    };
+    struct Edge
+    {
+        int n0;
+        int n1;
+        int marker; ///< segment marker, in the same encoding as in the \c .edge file
+    };
+    struct Element
+    {
+        int p[3];
+        int label; ///< regional attribute: number of the block label + 1, or 0 if the region has no label
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Edge> edges;
+    std::vector<Element> elements;
+    std::vector<CCommonPoint> pbcs; ///< periodic (t=0) and antiperiodic (t=1) node pairs
+    /**
+     * @brief The air gap elements.
+     * As in the solvers, BdryName holds the verbatim name line of the \c .pbc file,
+     * i.e. the quoted name followed by a newline.
+     */
+    std::vector<femmsolver::CAirGapElement> ages;
+    /**
+     * @brief The Cuthill-McKee numbering of the nodes, as computed by computeNumbering().
+     * \c numbering[i] is the new number of node \c i.
+     * If it is set, FEASolver::Cuthill() applies it instead of computing the numbering again.
+     */
+    std::vector<int> numbering;
+    int bandWidth = 0; ///< the bandwidth of the node connectivity in \c numbering
+
+    void clear();
+
+    /**
+     * @brief Compute the Cuthill-McKee numbering of the nodes and store it in numbering and bandWidth.
+     * This allows to keep the numbering with the mesh, e.g. in the CMeshCache.
+     */
+    void computeNumbering();
+    /**
+     * @brief Renumber the nodes using the Cuthill-McKee algorithm as described in Hoole.
+     * @param numNodes the number of nodes
+     * @param edges the connectivity of the nodes
+     * @param newnum is set to the new number of each node
+     * @return the bandwidth in the new numbering
+     */
+    static int cuthillMcKee(int numNodes, const std::vector<Edge> &edges, std::vector<int> &newnum);
+
+    /**
+     * @brief Read the mesh files.
+     * Besides the syntax of each file, the node numbers of elements, edges and periodic boundary conditions are validated.
+     * @param baseName the name of the problem file without extension
+     * @return \c NOERROR on success, or the error of the first file that could not be read or is malformed.
+     */
+    LoadMeshErr readFiles(const std::string &baseName);
+    /**
+     * @brief Read a \c .node file.
+     * On POSIX systems, the file is memory-mapped, so that it is parsed straight from the page cache.
+     * The remaining read functions work alike, for the \c .edge, \c .ele and \c .pbc files.
+     * @param fileName the full file name, including the extension
+     * @return \c false, if the file can not be read or is malformed.
+     */
+    bool readNodes(const std::string &fileName);
+    bool readEdges(const std::string &fileName);
+    bool readElements(const std::string &fileName);
+    bool readPbcs(const std::string &fileName);
+    /**
+     * @brief Read the contents of a \c .node file from the current position of \p fp up to its end.
+     */
+    bool readNodes(FILE *fp);
+    bool readEdges(FILE *fp);
+    bool readElements(FILE *fp);
+    bool readPbcs(FILE *fp);
+    /**
+     * @brief Parse the contents of a \c .node file held in memory.
+     *
+     * The parser accepts the file format of triangle: blank lines and \c # comments are skipped,
+     * and anything after the number of records given in the header is ignored.
+     * Numbers are parsed with \c std::from_chars, i.e. independent of the locale.
+     * Large files are split into chunks at line boundaries, and the chunks are parsed by femm::numThreads() threads.
+     */
+    bool parseNodes(const char *begin, const char *end);
+    bool parseEdges(const char *begin, const char *end);
+    bool parseElements(const char *begin, const char *end);
+    bool parsePbcs(const char *begin, const char *end);
+    /**
+     * @brief Write the mesh files, as readFiles() and the solvers expect them.
+     * @param baseName the name of the problem file without extension
+     * @return \c false, if a file could not be written.
+     */
+    bool writeFiles(const std::string &baseName) const;
+
+    /**
+     * @brief Remove the mesh files.
+     * The \c .poly file is removed as well, since it belongs to the same triangulation.
+     * @param includeEdgeFile if \c false, the \c .edge file is kept (e.g. for FEASolver::Cuthill())
+     */
+    static void removeFiles(const std::string &baseName, bool includeEdgeFile=true);
+};
+
+} // namespace femm
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * The source code in this file extends the solution handling code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef FEMM_MSOLUTION_H
+#define FEMM_MSOLUTION_H
+
+#include "femmcomplex.h"
+#include "CAirGapElement.h"
+#include "CCommonPoint.h"
+
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief The CMSolution class holds the solution of a magnetics problem,
+ * as FSolver writes it to the \c [Solution] section of the \c .ans file.
+ *
+ * It allows the solver to hand its results directly to the postprocessor (see FPProc::LoadSolution()).
+ * All values are the ones that would be written to the file, e.g. node coordinates are in the length units of the problem.
+ */
+class CMSolution
+{
+public:
+    struct Node
+    {
+        double x;
+        double y;
+        CComplex A; ///< vector potential; the imaginary part is 0 for static problems
+        int marker; ///< boundary marker
+    };
+    struct Element
+    {
+        int p[3];
+        int lbl;     ///< block label
+        double Jprev; ///< current density of the previous solution (incremental problems only)
+    };
+    /// circuit info of a block label
+    struct Circuit
+    {
+        int Case;       ///< 0: voltage gradient, 1: current density
+        CComplex value; ///< voltage gradient or current density
+    };
+
+    std::vector<Node> nodes;
+    std::vector<double> Aprev; ///< vector potential of the previous solution (incremental problems only)
+    std::vector<Element> elements;
+    std::vector<Circuit> circuits;
+    std::vector<CCommonPoint> pbcs;
+    /**
+     * @brief The air gap elements.
+     * As in the solver, BdryName holds the quoted name followed by a newline,
+     * and the radii are in the length units of the problem.
+     */
+    std::vector<femmsolver::CAirGapElement> ages;
+};
+
+} // namespace femm
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "parallel.h"
+
+#include <cstddef>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+/// thread count requested by setNumThreads(); 0 means automatic
+int RequestedThreads = 0;
+}
+
+void femm::setNumThreads(int n)
+{
+    RequestedThreads = (n<0) ? 0 : n;
+}
+
+int femm::numThreads()
+{
+#ifdef _OPENMP
+    if (RequestedThreads>0)
+        return RequestedThreads;
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+bool femm::useThreads(int n)
+{
+    return n>=PARALLEL_MIN_SIZE && numThreads()>1;
+}
+
+double femm::dot(int n, const double *X, const double *Y)
+{
+    const int nb = (n+PARALLEL_BLOCK-1)/PARALLEL_BLOCK;
+    if (nb<=1)
+    {
+        double z=0;
+        for (int i=0; i<n; i++) z+=X[i]*Y[i];
+        return z;
+    }
+
+    std::vector<double> partial(nb);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(numThreads()) if(useThreads(n))
+#endif
+    for (int k=0; k<nb; k++)
+    {
+        const int last = (k==nb-1) ? n : (k+1)*PARALLEL_BLOCK;
+        double z=0;
+        for (int i=k*PARALLEL_BLOCK; i<last; i++) z+=X[i]*Y[i];
+        partial[k]=z;
+    }
+
+    // sum up in a fixed order, independent of the number of threads
+    double z=0;
+    for (int k=0; k<nb; k++) z+=partial[k];
+    return z;
+}
+
+void femm::axpy2(int n, double a, const double *P, const double *U, double *V, double *R)
+{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(numThreads()) if(useThreads(n))
+#endif
+    for (int i=0; i<n; i++)
+    {
+        V[i]+=a*P[i];
+        R[i]-=a*U[i];
+    }
+}
+
+void femm::xpby(int n, const double *Z, double b, double *P)
+{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(numThreads()) if(useThreads(n))
+#endif
+    for (int i=0; i<n; i++)
+        P[i]=Z[i]+b*P[i];
+}
+
+void femm::dotBlock(int n, int k, const double *X, const double *Y, double *d)
+{
+    const int nb = (n+PARALLEL_BLOCK-1)/PARALLEL_BLOCK;
+    std::vector<double> partial(static_cast<size_t>(nb)*k, 0.);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(numThreads()) if(useThreads(n))
+#endif
+    for (int blk=0; blk<nb; blk++)
+    {
+        const int last = (blk==nb-1) ? n : (blk+1)*PARALLEL_BLOCK;
+        double *z = partial.data() + static_cast<size_t>(blk)*k;
+        for (int i=blk*PARALLEL_BLOCK; i<last; i++)
+            for (int j=0; j<k; j++)
+                z[j]+=X[static_cast<size_t>(i)*k+j]*Y[static_cast<size_t>(i)*k+j];
+    }
+
+    // sum up in a fixed order, independent of the number of threads
+    for (int j=0; j<k; j++) d[j]=0;
+    for (int blk=0; blk<nb; blk++)
+        for (int j=0; j<k; j++)
+            d[j]+=partial[static_cast<size_t>(blk)*k+j];
+}
+
+void femm::axpy2Block(int n, int k, const double *a, const double *P, const double *U, double *V, double *R)
+{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(numThreads()) if(useThreads(n))
+#endif
+    for (int i=0; i<n; i++)
+    {
+        const size_t row = static_cast<size_t>(i)*k;
+        for (int j=0; j<k; j++)
+        {
+            V[row+j]+=a[j]*P[row+j];
+            R[row+j]-=a[j]*U[row+j];
+        }
+    }
+}
+
+void femm::xpbyBlock(int n, int k, const double *Z, const double *b, double *P)
+{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(numThreads()) if(useThreads(n))
+#endif
+    for (int i=0; i<n; i++)
+    {
+        const size_t row = static_cast<size_t>(i)*k;
+        for (int j=0; j<k; j++)
+            P[row+j]=Z[row+j]+b[j]*P[row+j];
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef FEMM_PARALLEL_H
+#define FEMM_PARALLEL_H
+
+/**
+ * @file parallel.h
+ * Thread count setting and multithreaded vector kernels for the Krylov solvers.
+ *
+ * Threading uses OpenMP if the library was built with it; otherwise all kernels run serially.
+ * Reductions are done over fixed blocks of \c PARALLEL_BLOCK entries and summed up in order,
+ * so that results do not depend on the number of threads.
+ * For vectors shorter than one block, the kernels give exactly the same result as a plain loop.
+ */
+namespace femm {
+
+/// number of vector entries per block of a reduction
+constexpr int PARALLEL_BLOCK = 4096;
+/// vectors shorter than this are always processed by a single thread
+constexpr int PARALLEL_MIN_SIZE = 2*PARALLEL_BLOCK;
+
+/**
+ * @brief Set the number of threads used by the linear solvers.
+ * @param n number of threads; 0 selects the OpenMP default (e.g. from \c OMP_NUM_THREADS)
+ */
+void setNumThreads(int n);
+/**
+ * @brief The number of threads used by the linear solvers.
+ * Always 1 if the library was built without OpenMP.
+ */
+int numThreads();
+/**
+ * @brief Whether a loop over \p n entries should be distributed over several threads.
+ */
+bool useThreads(int n);
+
+/**
+ * @brief Deterministic dot product of X and Y.
+ */
+double dot(int n, const double *X, const double *Y);
+/**
+ * @brief Fused conjugate gradient update  V += a*P,  R -= a*U.
+ */
+void axpy2(int n, double a, const double *P, const double *U, double *V, double *R);
+/**
+ * @brief Search direction update  P = Z + b*P.
+ */
+void xpby(int n, const double *Z, double b, double *P);
+
+/**
+ * @name Kernels for blocks of vectors.
+ * A block of \p k vectors of length \p n is stored interleaved, i.e. entry i of vector j is at [i*k+j].
+ * @{
+ */
+/**
+ * @brief Deterministic dot products of the columns of X and Y; d receives \p k values.
+ */
+void dotBlock(int n, int k, const double *X, const double *Y, double *d);
+/**
+ * @brief Fused conjugate gradient update  V += a*P,  R -= a*U, with one factor a[j] per column.
+ */
+void axpy2Block(int n, int k, const double *a, const double *P, const double *U, double *V, double *R);
+/**
+ * @brief Search direction update  P = Z + b*P, with one factor b[j] per column.
+ */
+void xpbyBlock(int n, int k, const double *Z, const double *b, double *P);
+/** @} */
+
+} // namespace femm
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "periodic.h"
+
+#include "csrspars.h"
+
+#include <algorithm>
+
+CPeriodicElimination::CPeriodicElimination()
+    : NumReduced(0)
+    , Map()
+    , Sign()
+    , Masters()
+    , Slot()
+    , Kind()
+    , Pairs()
+    , Parent()
+    , RelSign()
+{
+}
+
+void CPeriodicElimination::Clear()
+{
+    Pairs.clear();
+}
+
+void CPeriodicElimination::Add(int i, int j, int sign)
+{
+    Pairs.push_back({i, j, (sign<0) ? -1 : 1});
+}
+
+int CPeriodicElimination::Find(int i, int &sign)
+{
+    // find the root and the sign of i relative to it
+    int root = i;
+    sign = 1;
+    while (Parent[root]!=root)
+    {
+        sign *= RelSign[root];
+        root = Parent[root];
+    }
+
+    // path compression
+    int s = sign;
+    while (Parent[i]!=root && Parent[i]!=i)
+    {
+        int next = Parent[i];
+        int ns = s*RelSign[i];
+        Parent[i] = root;
+        RelSign[i] = s;
+        i = next;
+        s = ns;
+    }
+    return root;
+}
+
+bool CPeriodicElimination::Build(int n)
+{
+    Parent.resize(n);
+    RelSign.assign(n,1);
+    for (int i=0; i<n; i++)
+        Parent[i] = i;
+
+    for (const Constraint &p : Pairs)
+    {
+        int si,sj;
+        int ri = Find(p.i,si);
+        int rj = Find(p.j,sj);
+        if (ri==rj)
+            continue;
+        // V[j] = sign*V[i]  =>  V[rj] = sign*si*sj*V[ri]; the smaller root stays the root
+        if (ri<rj)
+        {
+            Parent[rj] = ri;
+            RelSign[rj] = p.sign*si*sj;
+        } else {
+            Parent[ri] = rj;
+            RelSign[ri] = p.sign*si*sj;
+        }
+    }
+
+    std::vector<int> map(n), sign(n);
+    Masters.clear();
+    for (int i=0; i<n; i++)
+    {
+        int s;
+        int root = Find(i,s);
+        if (root==i)
+        {
+            map[i] = static_cast<int>(Masters.size());
+            Masters.push_back(i);
+        } else {
+            // roots are the smallest unknown of their group, so they are already numbered
+            map[i] = map[root];
+        }
+        sign[i] = s;
+    }
+    NumReduced = static_cast<int>(Masters.size());
+
+    bool changed = (map!=Map) || (sign!=Sign);
+    Map.swap(map);
+    Sign.swap(sign);
+    return changed;
+}
+
+void CPeriodicElimination::BuildPattern(int n, const int *rowStart, const int *colIndex, CSparsityPattern &pattern) const
+{
+    pattern.Create(NumReduced);
+    for (int i=0; i<n; i++)
+        for (int e=rowStart[i]+1; e<rowStart[i+1]; e++)
+            pattern.AddEntry(Map[i], Map[colIndex[e]]);
+}
+
+void CPeriodicElimination::MapEntries(int n, const int *rowStart, const int *colIndex, const int *redRowStart, const int *redColIndex)
+{
+    Slot.resize(rowStart[n]);
+    Kind.resize(rowStart[n]);
+    for (int i=0; i<n; i++)
+    {
+        for (int e=rowStart[i]; e<rowStart[i+1]; e++)
+        {
+            const int c = colIndex[e];
+            int p = Map[i];
+            int q = Map[c];
+            int kind = ENTRY_DIRECT;
+            if (p==q && i!=c)
+                kind = ENTRY_MERGED;
+            else if (q<p)
+            {
+                std::swap(p,q);
+                kind = ENTRY_MIRRORED;
+            }
+            const int *first = redColIndex + redRowStart[p];
+            const int *last = redColIndex + redRowStart[p+1];
+            Slot[e] = static_cast<int>(std::lower_bound(first, last, q) - redColIndex);
+            Kind[e] = static_cast<signed char>(kind*Sign[i]*Sign[c]);
+        }
+    }
+}
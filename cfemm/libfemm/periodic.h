@@ -0,0 +1,137 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef PERIODIC_H
+#define PERIODIC_H
+
+#include <vector>
+
+class CSparsityPattern;
+
+/**
+ * @brief The CPeriodicElimination class eliminates periodic and antiperiodic constraints from a symmetric system.
+ *
+ * A periodic constraint between unknowns i and j demands V[j]=V[i], an antiperiodic one V[j]=-V[i].
+ * Constraints that share unknowns (e.g. corners that are periodic in two directions) are merged into
+ * groups, and the smallest unknown of each group becomes its master.
+ * All other unknowns are slaves with V[slave] = Sign[slave]*V[master].
+ *
+ * With the matrix S that maps the reduced unknowns to all unknowns, the reduced system is
+ *   (S^T A S) y = S^T b,  V = S y.
+ * This is the system that CBigLinProb::Periodicity() and CBigLinProb::AntiPeriodicity() solve implicitly
+ * by averaging the rows and columns of the constrained unknowns, but it is built in a single sweep over the matrix,
+ * and it is smaller and better conditioned.
+ * The reduced unknowns keep the order of their masters.
+ *
+ * If the constraints contradict each other (a closed chain of constraints with an odd number of antiperiodic ones),
+ * the constraint that closes the chain is ignored.
+ */
+class CPeriodicElimination
+{
+public:
+    CPeriodicElimination();
+
+    /**
+     * @brief Forget all constraints, e.g. before the matrix is assembled again.
+     * The mapping of the last call to Build() is kept, so that Build() can detect whether it changed.
+     */
+    void Clear();
+    /**
+     * @brief Add the constraint V[j] = sign*V[i].
+     * @param sign 1 for periodic, -1 for antiperiodic constraints
+     */
+    void Add(int i, int j, int sign);
+    bool Empty() const { return Pairs.empty(); }
+
+    /**
+     * @brief Compute the master of each unknown.
+     * @param n number of unknowns
+     * @return \c true if the mapping differs from the one of the previous call.
+     */
+    bool Build(int n);
+
+    /**
+     * @brief Compute the pattern of the reduced matrix from the pattern of an upper triangle matrix in compressed row storage.
+     * @param pattern receives the pattern, with \c NumReduced rows
+     */
+    void BuildPattern(int n, const int *rowStart, const int *colIndex, CSparsityPattern &pattern) const;
+    /**
+     * @brief Find the storage slot of each matrix entry within the reduced matrix.
+     * Both matrices use upper triangle compressed row storage.
+     * The results are stored in \c Slot and \c Kind.
+     */
+    void MapEntries(int n, const int *rowStart, const int *colIndex, const int *redRowStart, const int *redColIndex);
+
+    /**
+     * @brief Reduced right hand side y = S^T x; \p y has \c NumReduced entries and is overwritten.
+     */
+    template <class T> void Restrict(const T *x, T *y) const
+    {
+        for (int r=0; r<NumReduced; r++)
+            y[r] = 0.;
+        for (int i=0; i<static_cast<int>(Map.size()); i++)
+        {
+            if (Sign[i]>0)
+                y[Map[i]] += x[i];
+            else
+                y[Map[i]] -= x[i];
+        }
+    }
+    /**
+     * @brief Values of the masters, e.g. for an initial guess of the reduced system.
+     */
+    template <class T> void Inject(const T *x, T *y) const
+    {
+        for (int r=0; r<NumReduced; r++)
+            y[r] = x[Masters[r]];
+    }
+    /**
+     * @brief Solution x = S y of all unknowns from the reduced solution \p y.
+     */
+    template <class T> void Prolong(const T *y, T *x) const
+    {
+        for (int i=0; i<static_cast<int>(Map.size()); i++)
+            x[i] = (Sign[i]>0) ? y[Map[i]] : 0.-y[Map[i]];
+    }
+
+    /// how a matrix entry (i,c), i<=c, is added to its slot; negative values mean that the entry changes its sign
+    enum EntryKind
+    {
+        ENTRY_DIRECT = 1,   ///< added as (Map[i],Map[c])
+        ENTRY_MIRRORED = 2, ///< added as (Map[c],Map[i]), i.e. as the mirrored entry of the symmetric/hermitian matrix
+        ENTRY_MERGED = 3    ///< i and c have the same master: the entry and its mirror are both added to the diagonal
+    };
+
+    int NumReduced; ///< number of reduced unknowns
+    std::vector<int> Map;     ///< reduced unknown of each unknown
+    std::vector<int> Sign;    ///< sign of each unknown relative to its master (1 or -1)
+    std::vector<int> Masters; ///< master (original unknown) of each reduced unknown
+    std::vector<int> Slot;         ///< slot of each matrix entry in the reduced matrix, see MapEntries()
+    std::vector<signed char> Kind; ///< EntryKind of each matrix entry, times its sign
+
+private:
+    struct Constraint
+    {
+        int i;
+        int j;
+        int sign;
+    };
+    int Find(int i, int &sign);
+
+    std::vector<Constraint> Pairs;
+    std::vector<int> Parent;  ///< union-find forest used by Build()
+    std::vector<int> RelSign; ///< sign relative to the parent
+};
+
+#endif
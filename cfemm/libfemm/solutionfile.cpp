@@ -0,0 +1,326 @@
+/*
+ * The source code in this file extends the solution handling code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "solutionfile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char MAGIC[8] = {'X','F','E','M','M','S','O','L'};
+const uint32_t VERSION = 1;
+/// reads as 0x01020304 on a host with the same byte order as the writer
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct ContainerHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint32_t sectionCount;
+    uint32_t reserved;
+};
+
+struct SectionEntry
+{
+    uint32_t type;
+    uint32_t recordSize;
+    uint64_t offset; ///< relative to the start of the container
+    uint64_t count;
+};
+
+static_assert(sizeof(ContainerHeader) == 24, "unexpected padding in ContainerHeader");
+static_assert(sizeof(SectionEntry) == 24, "unexpected padding in SectionEntry");
+static_assert(sizeof(femm::SolutionNode) == 24, "unexpected padding in SolutionNode");
+static_assert(sizeof(femm::SolutionElement) == 16, "unexpected padding in SolutionElement");
+static_assert(sizeof(femm::SolutionComplex) == 16, "unexpected padding in SolutionComplex");
+static_assert(sizeof(femm::SolutionCircuit) == 24, "unexpected padding in SolutionCircuit");
+static_assert(sizeof(femm::SolutionPBC) == 12, "unexpected padding in SolutionPBC");
+static_assert(sizeof(femm::SolutionAirGapElement) == 96, "unexpected padding in SolutionAirGapElement");
+static_assert(sizeof(femm::SolutionQuadPoint) == 48, "unexpected padding in SolutionQuadPoint");
+
+bool hostIsLittleEndian()
+{
+    const uint32_t one = 1;
+    return *reinterpret_cast<const unsigned char*>(&one) == 1;
+}
+
+uint64_t align8(uint64_t offset)
+{
+    return (offset+7) & ~uint64_t(7);
+}
+
+bool writePadding(FILE *fp, uint64_t &pos)
+{
+    static const char zeros[8] = {0,0,0,0,0,0,0,0};
+    const uint64_t n = align8(pos)-pos;
+    pos += n;
+    return fwrite(zeros,1,n,fp) == n;
+}
+} // namespace
+
+using namespace femm;
+
+const char *const CSolutionFile::Tag = "[BinarySolution]";
+
+bool CSolutionFile::hostByteOrderSupported()
+{
+    return hostIsLittleEndian();
+}
+
+void CSolutionFileWriter::addSection(SolutionSection type, const void *data, uint64_t count, uint32_t recordSize)
+{
+    sections.push_back(Section{type, data, count, recordSize});
+}
+
+bool CSolutionFileWriter::write(const std::string &fileName, const std::string &problemFile) const
+{
+    if (!hostIsLittleEndian())
+    {
+        printf("Binary solution files can only be written on little-endian hosts\n");
+        return false;
+    }
+
+    FILE *fz = fopen(problemFile.c_str(),"rb");
+    if (fz==NULL)
+    {
+        printf("Couldn't open %s\n",problemFile.c_str());
+        return false;
+    }
+    FILE *fp = fopen(fileName.c_str(),"wb");
+    if (fp==NULL)
+    {
+        printf("Couldn't write to %s\n",fileName.c_str());
+        fclose(fz);
+        return false;
+    }
+
+    // echo the problem file
+    bool ok = true;
+    uint64_t pos = 0;
+    char c[4096];
+    char last = '\n';
+    size_t n;
+    while ((n=fread(c,1,sizeof(c),fz)) > 0)
+    {
+        ok = ok && fwrite(c,1,n,fp) == n;
+        pos += n;
+        last = c[n-1];
+    }
+    fclose(fz);
+    // the problem file does not necessarily end with a newline
+    if (last!='\n')
+    {
+        ok = ok && fputc('\n',fp) != EOF;
+        pos++;
+    }
+    ok = ok && fprintf(fp,"%s\n",CSolutionFile::Tag) > 0;
+    pos += strlen(CSolutionFile::Tag)+1;
+    ok = ok && writePadding(fp,pos);
+
+    // header and section table
+    ContainerHeader header;
+    memcpy(header.magic,MAGIC,sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.sectionCount = static_cast<uint32_t>(sections.size());
+    header.reserved = 0;
+    ok = ok && fwrite(&header,sizeof(header),1,fp) == 1;
+
+    uint64_t offset = sizeof(ContainerHeader) + sections.size()*sizeof(SectionEntry);
+    for (const Section &section : sections)
+    {
+        SectionEntry entry;
+        entry.type = static_cast<uint32_t>(section.type);
+        entry.recordSize = section.recordSize;
+        entry.offset = offset;
+        entry.count = section.count;
+        ok = ok && fwrite(&entry,sizeof(entry),1,fp) == 1;
+        offset = align8(offset + section.count*section.recordSize);
+    }
+
+    // section data
+    offset = sizeof(ContainerHeader) + sections.size()*sizeof(SectionEntry);
+    for (const Section &section : sections)
+    {
+        const uint64_t size = section.count*section.recordSize;
+        if (size>0)
+            ok = ok && fwrite(section.data,1,size,fp) == size;
+        offset += size;
+        ok = ok && writePadding(fp,offset);
+    }
+
+    if (fclose(fp)!=0)
+        ok = false;
+    if (!ok)
+        printf("Couldn't write to %s\n",fileName.c_str());
+    return ok;
+}
+
+CSolutionFile::CSolutionFile()
+    : container(nullptr)
+    , containerSize(0)
+    , mapping(nullptr)
+    , mappingSize(0)
+    , buffer()
+{
+}
+
+CSolutionFile::~CSolutionFile()
+{
+    close();
+}
+
+bool CSolutionFile::open(const std::string &fileName, uint64_t offset, std::ostream &err)
+{
+    close();
+    if (!hostIsLittleEndian())
+    {
+        err << "Binary solution files can only be read on little-endian hosts\n";
+        return false;
+    }
+    offset = align8(offset);
+
+#ifndef _WIN32
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd<0)
+    {
+        err << "Couldn't read from file " << fileName << "\n";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd,&st)!=0 || static_cast<uint64_t>(st.st_size) < offset+sizeof(ContainerHeader))
+    {
+        ::close(fd);
+        err << "Binary solution in " << fileName << " is truncated\n";
+        return false;
+    }
+    void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (m==MAP_FAILED)
+    {
+        err << "Couldn't map file " << fileName << "\n";
+        return false;
+    }
+    mapping = m;
+    mappingSize = st.st_size;
+    container = static_cast<const char*>(m) + offset;
+    containerSize = st.st_size - offset;
+#else
+    std::ifstream input(fileName, std::ios::binary);
+    input.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(input.tellg());
+    if (!input || fileSize < offset+sizeof(ContainerHeader))
+    {
+        err << "Binary solution in " << fileName << " is truncated\n";
+        return false;
+    }
+    buffer.resize(fileSize-offset);
+    input.seekg(offset);
+    if (!input.read(buffer.data(), buffer.size()))
+    {
+        err << "Couldn't read from file " << fileName << "\n";
+        close();
+        return false;
+    }
+    container = buffer.data();
+    containerSize = buffer.size();
+#endif
+
+    // validate header and section table, so that sectionData() can rely on them
+    const ContainerHeader *header = reinterpret_cast<const ContainerHeader*>(container);
+    std::string problem;
+    if (memcmp(header->magic,MAGIC,sizeof(MAGIC))!=0)
+        problem = "is not a binary solution";
+    else if (header->byteOrderMark!=BYTE_ORDER_MARK)
+        problem = "has the wrong byte order";
+    else if (header->version!=VERSION)
+        problem = "has the unsupported format version " + std::to_string(header->version);
+    else if (containerSize < sizeof(ContainerHeader) + uint64_t(header->sectionCount)*sizeof(SectionEntry))
+        problem = "is truncated";
+    else
+    {
+        const SectionEntry *entries = reinterpret_cast<const SectionEntry*>(header+1);
+        for (uint32_t i=0; i<header->sectionCount && problem.empty(); i++)
+        {
+            const SectionEntry &entry = entries[i];
+            if (entry.offset%8!=0 || entry.offset>containerSize
+                    || (entry.recordSize>0 && entry.count > (containerSize-entry.offset)/entry.recordSize))
+                problem = "is truncated";
+        }
+    }
+    if (!problem.empty())
+    {
+        err << "Binary solution in " << fileName << " " << problem << "\n";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void CSolutionFile::close()
+{
+#ifndef _WIN32
+    if (mapping)
+        munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    buffer.clear();
+    buffer.shrink_to_fit();
+    container = nullptr;
+    containerSize = 0;
+}
+
+bool CSolutionFile::hasSection(SolutionSection type) const
+{
+    if (!container)
+        return false;
+    const ContainerHeader *header = reinterpret_cast<const ContainerHeader*>(container);
+    const SectionEntry *entries = reinterpret_cast<const SectionEntry*>(header+1);
+    for (uint32_t i=0; i<header->sectionCount; i++)
+    {
+        if (entries[i].type == static_cast<uint32_t>(type))
+            return true;
+    }
+    return false;
+}
+
+const void *CSolutionFile::sectionData(SolutionSection type, uint32_t recordSize, size_t &count) const
+{
+    count = 0;
+    if (!container)
+        return nullptr;
+    const ContainerHeader *header = reinterpret_cast<const ContainerHeader*>(container);
+    const SectionEntry *entries = reinterpret_cast<const SectionEntry*>(header+1);
+    for (uint32_t i=0; i<header->sectionCount; i++)
+    {
+        const SectionEntry &entry = entries[i];
+        if (entry.type != static_cast<uint32_t>(type))
+            continue;
+        if (entry.recordSize != recordSize)
+            return nullptr;
+        count = static_cast<size_t>(entry.count);
+        return container + entry.offset;
+    }
+    return nullptr;
+}
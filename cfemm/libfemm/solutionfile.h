@@ -0,0 +1,217 @@
+/*
+ * The source code in this file extends the solution handling code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef FEMM_SOLUTIONFILE_H
+#define FEMM_SOLUTIONFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief The section types of a binary solution file.
+ *
+ * Each section is an array of fixed-size records.
+ * Values are stored as the solvers write them to text solution files,
+ * e.g. node coordinates are in the length units of the problem.
+ */
+enum class SolutionSection : uint32_t
+{
+    Nodes = 1,              ///< SolutionNode per mesh node
+    Elements = 2,           ///< SolutionElement per mesh element
+    Potentials = 3,         ///< double per mesh node: vector potential (static magnetics), temperature or voltage
+    ComplexPotentials = 4,  ///< SolutionComplex per mesh node: vector potential of harmonic magnetics problems
+    PreviousPotentials = 5, ///< double per mesh node: vector potential of the previous solution (incremental problems)
+    PreviousCurrentDensities = 6, ///< double per mesh element: current density of the previous solution (incremental problems)
+    Circuits = 7,           ///< SolutionCircuit per block label (magnetics) or per conductor (heat flow, electrostatics)
+    PeriodicBCs = 8,        ///< SolutionPBC per periodic or antiperiodic node pair
+    AirGapElements = 9,     ///< SolutionAirGapElement per air gap element
+    AirGapQuadPoints = 10,  ///< SolutionQuadPoint per quadrature point, for all air gap elements
+    AirGapNames = 11,       ///< char: the names of all air gap elements, see SolutionAirGapElement
+    CapacitanceConductors = 12, ///< int32_t per conductor of the capacitance matrix: its index in the conductor list (electrostatics)
+    Capacitance = 13        ///< double per entry of the capacitance matrix, by rows (electrostatics)
+};
+
+struct SolutionNode
+{
+    double x;
+    double y;
+    int32_t marker;   ///< boundary marker (magnetics), or conductor (heat flow, electrostatics)
+    int32_t reserved;
+};
+
+struct SolutionElement
+{
+    int32_t p[3];
+    int32_t lbl;
+};
+
+struct SolutionComplex
+{
+    double re;
+    double im;
+};
+
+struct SolutionCircuit
+{
+    int32_t Case;     ///< magnetics: 0 for a voltage gradient, 1 for a current density; unused otherwise
+    int32_t reserved;
+    /**
+     * @brief The circuit values.
+     * Magnetics: voltage gradient or current density (real and imaginary part).
+     * Heat flow and electrostatics: temperature or voltage, and heat flux or charge of the conductor.
+     */
+    double value[2];
+};
+
+struct SolutionPBC
+{
+    int32_t x;
+    int32_t y;
+    int32_t t;  ///< 0 for periodic, 1 for antiperiodic
+};
+
+struct SolutionAirGapElement
+{
+    int32_t BdryFormat;
+    int32_t totalArcElements;
+    int32_t firstQuadPoint; ///< index of the first of totalArcElements+1 records in the AirGapQuadPoints section
+    int32_t nameOffset;     ///< offset of the name in the AirGapNames section
+    int32_t nameLength;     ///< length of the name; the name is the verbatim name line, i.e. quoted and followed by a newline
+    int32_t reserved;
+    double InnerAngle;
+    double OuterAngle;
+    double ri; ///< inner radius, in the length units of the problem
+    double ro; ///< outer radius, in the length units of the problem
+    double totalArcLength;
+    SolutionComplex agc;
+    double InnerShift;
+    double OuterShift;
+};
+
+struct SolutionQuadPoint
+{
+    int32_t n[4];
+    double w[4];
+};
+
+/**
+ * @brief The CSolutionFileWriter class writes a binary solution file.
+ *
+ * A binary solution file starts like a text solution file: the problem file is echoed verbatim.
+ * Instead of the \c [Solution] section, it continues with a line \c [BinarySolution],
+ * and the binary container starts at the next file offset that is a multiple of 8:
+ *  - the header: the magic "XFEMMSOL", the format version, a byte order mark and the number of sections
+ *  - the section table: type, record size, offset (relative to the container) and record count of each section
+ *  - the sections, each at an offset that is a multiple of 8
+ *
+ * All values are little-endian.
+ * Since the records are stored in memory layout, the postprocessors can map the file and use the sections directly (see CSolutionFile).
+ */
+class CSolutionFileWriter
+{
+public:
+    /**
+     * @brief Add a section.
+     * @param data the records; they are not copied, and must remain valid until write() is called.
+     */
+    void addSection(SolutionSection type, const void *data, uint64_t count, uint32_t recordSize);
+    template<class T>
+    void addSection(SolutionSection type, const std::vector<T> &records)
+    {
+        addSection(type, records.data(), records.size(), sizeof(T));
+    }
+
+    /**
+     * @brief Write the solution file.
+     * @param fileName the solution file
+     * @param problemFile the problem file, which is echoed at the start of the solution file
+     * @return \c false if a file could not be read or written, or if the host is not little-endian.
+     */
+    bool write(const std::string &fileName, const std::string &problemFile) const;
+
+private:
+    struct Section
+    {
+        SolutionSection type;
+        const void *data;
+        uint64_t count;
+        uint32_t recordSize;
+    };
+    std::vector<Section> sections;
+};
+
+/**
+ * @brief The CSolutionFile class maps the binary container of a solution file written by CSolutionFileWriter.
+ *
+ * On POSIX systems, the file is memory-mapped, so that opening it costs (almost) nothing,
+ * and the sections are read straight from the page cache.
+ * Elsewhere, the container is read into memory at once.
+ */
+class CSolutionFile
+{
+public:
+    CSolutionFile();
+    ~CSolutionFile();
+    CSolutionFile(const CSolutionFile &) = delete;
+    CSolutionFile &operator=(const CSolutionFile &) = delete;
+
+    /**
+     * @brief Map the binary container of a solution file.
+     * @param fileName the solution file
+     * @param offset the file offset right after the \c [BinarySolution] line
+     * @param err output stream for error messages
+     * @return \c false if the file can not be mapped or its container is invalid.
+     */
+    bool open(const std::string &fileName, uint64_t offset, std::ostream &err);
+    void close();
+
+    /**
+     * @brief The records of a section.
+     * @param count is set to the number of records, or 0 if the section is missing.
+     * @return the records, or \c nullptr if the file has no such section (or its records are not of type \p T).
+     */
+    template<class T>
+    const T *section(SolutionSection type, size_t &count) const
+    {
+        return static_cast<const T*>(sectionData(type, sizeof(T), count));
+    }
+    bool hasSection(SolutionSection type) const;
+
+    /// The tag that replaces the \c [Solution] tag in binary solution files.
+    static const char *const Tag;
+    /**
+     * @brief Check whether this host can write and read binary solution files.
+     * The records are stored in little-endian memory layout and used in place,
+     * so big-endian hosts have to stick to text solution files.
+     */
+    static bool hostByteOrderSupported();
+
+private:
+    const void *sectionData(SolutionSection type, uint32_t recordSize, size_t &count) const;
+
+    const char *container;
+    uint64_t containerSize;
+    void *mapping;
+    size_t mappingSize;
+    std::vector<char> buffer;
+};
+
+} // namespace femm
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "solverbackend.h"
+
+#include "femmcomplex.h"
+#include "spars.h"
+#include "cspars.h"
+#include "csrspars.h"
+#include "ccsrspars.h"
+
+#include <deque>
+
+namespace {
+
+std::deque<femm::LinearSolverBackend> &backends()
+{
+    // a deque keeps pointers from findLinearSolverBackend() valid when backends are added
+    static std::deque<femm::LinearSolverBackend> registry {
+        {
+            "csr",
+            "compressed row storage; supports IC/AMG preconditioners and direct solvers",
+            [] { return new CBigCSRLinProb(); },
+            [] { return new CBigComplexCSRLinProb(); }
+        },
+        {
+            "legacy",
+            "linked list storage with SSOR preconditioned iterative solvers, as in FEMM 4.2",
+            [] { return new CBigLinProb(); },
+            [] { return new CBigComplexLinProb(); }
+        }
+    };
+    return registry;
+}
+
+} // namespace
+
+bool femm::registerLinearSolverBackend(const LinearSolverBackend &backend)
+{
+    if (backend.name.empty() || findLinearSolverBackend(backend.name))
+        return false;
+    backends().push_back(backend);
+    return true;
+}
+
+const femm::LinearSolverBackend *femm::findLinearSolverBackend(const std::string &name)
+{
+    const std::string &key = name.empty() ? std::string(DEFAULT_LINEAR_SOLVER_BACKEND) : name;
+    for (const auto &backend : backends())
+    {
+        if (backend.name == key)
+            return &backend;
+    }
+    return nullptr;
+}
+
+std::vector<std::string> femm::linearSolverBackendNames()
+{
+    std::vector<std::string> names;
+    for (const auto &backend : backends())
+        names.push_back(backend.name);
+    return names;
+}
+
+std::unique_ptr<CBigLinProb> femm::createLinProb(const std::string &name)
+{
+    const LinearSolverBackend *backend = findLinearSolverBackend(name);
+    if (!backend || !backend->createReal)
+        return nullptr;
+    return std::unique_ptr<CBigLinProb>(backend->createReal());
+}
+
+std::unique_ptr<CBigComplexLinProb> femm::createComplexLinProb(const std::string &name)
+{
+    const LinearSolverBackend *backend = findLinearSolverBackend(name);
+    if (!backend || !backend->createComplex)
+        return nullptr;
+    return std::unique_ptr<CBigComplexLinProb>(backend->createComplex());
+}
@@ -0,0 +1,84 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef FEMM_SOLVERBACKEND_H
+#define FEMM_SOLVERBACKEND_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CBigLinProb;
+class CBigComplexLinProb;
+
+/**
+ * @file solverbackend.h
+ * Registry of linear solver backends.
+ *
+ * A backend provides the linear system objects used by the solvers.
+ * CBigLinProb and CBigComplexLinProb define the interface every backend implements:
+ *  - assembly: Create(), SetPattern(), Put(), AddTo(), Get()
+ *  - constraints: SetValue() for fixed values, Periodicity() and AntiPeriodicity()
+ *  - solving: Solve(), using the method selected by \c LinearSolver
+ *  - statistics: \c Iterations
+ *
+ * The solvers look up the backend by the name given in the problem file (\c [SolverBackend]);
+ * an empty name selects the default backend.
+ */
+namespace femm {
+
+/// name of the backend used if a problem does not select one
+constexpr const char *DEFAULT_LINEAR_SOLVER_BACKEND = "csr";
+
+struct LinearSolverBackend
+{
+    std::string name;        ///< name used in problem files
+    std::string description; ///< short description for the user
+    /// create a real linear system; may be empty if the backend only supports complex problems
+    std::function<CBigLinProb*()> createReal;
+    /// create a complex linear system; may be empty if the backend only supports real problems
+    std::function<CBigComplexLinProb*()> createComplex;
+};
+
+/**
+ * @brief Add a backend to the registry.
+ * @return \c false if a backend with the same name already exists.
+ */
+bool registerLinearSolverBackend(const LinearSolverBackend &backend);
+/**
+ * @brief Look up a backend by name.
+ * @param name backend name; an empty name selects the default backend
+ * @return the backend, or \c nullptr if there is no backend with that name.
+ */
+const LinearSolverBackend *findLinearSolverBackend(const std::string &name);
+/**
+ * @brief The names of all registered backends, in order of registration.
+ */
+std::vector<std::string> linearSolverBackendNames();
+
+/**
+ * @brief Create a real linear system with the named backend.
+ * @return the linear system, or \c nullptr if the backend does not exist or does not support real problems.
+ */
+std::unique_ptr<CBigLinProb> createLinProb(const std::string &name);
+/**
+ * @brief Create a complex linear system with the named backend.
+ * @return the linear system, or \c nullptr if the backend does not exist or does not support complex problems.
+ */
+std::unique_ptr<CBigComplexLinProb> createComplexLinProb(const std::string &name);
+
+} // namespace femm
+
+#endif
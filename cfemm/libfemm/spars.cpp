@@ -20,12 +20,21 @@
 */
 
 #include "femmcomplex.h"
+#include "parallel.h"
 #include "spars.h"
 
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <iostream>
 #include <utility>
+#include <vector>
+
+#ifdef DEBUG_SPARS
+#define debug std::cerr << __func__ << "(): "
+#else
+#define debug while(false) std::cerr
+#endif
 
 using std::swap;
 
@@ -42,8 +51,16 @@ CEntry::CEntry()
 CBigLinProb::CBigLinProb()
 {
     n=0;
+    M=NULL;
     // Best guess for relaxation parameter
     Lambda = 1.5;
+    Preconditioner = PRECOND_SSOR;
+    ICFill = 0;
+    ICDropTol = 0;
+    Iterations = 0;
+    LinearSolver = SOLVER_ITERATIVE;
+    ForcingTerm = 0;
+    ReusePC = false;
 }
 
 CBigLinProb::~CBigLinProb()
@@ -59,49 +76,64 @@ CBigLinProb::~CBigLinProb()
     free(V);
     free(U);
     free(Z);
+    free(Q);
 
-    for(i=0; i<n; i++)
+    // derived classes may use their own matrix storage
+    if (M!=NULL)
     {
-        ui=M[i];
-        do
+        for(i=0; i<n; i++)
         {
-            uo=ui;
-            ui=uo->next;
-            delete uo;
+            ui=M[i];
+            do
+            {
+                uo=ui;
+                ui=uo->next;
+                delete uo;
+            }
+            while(ui!=NULL);
         }
-        while(ui!=NULL);
-    }
 
-    free(M);
-    free(Q);
+        free(M);
+    }
     n = 0;
 }
 
-int CBigLinProb::Create(int d, int bw)
+void CBigLinProb::CreateVectors(int d)
 {
-    int i;
-
-    bdw=bw;
     b=(double *)calloc(d,sizeof(double));
     V=(double *)calloc(d,sizeof(double));
     P=(double *)calloc(d,sizeof(double));
     R=(double *)calloc(d,sizeof(double));
     U=(double *)calloc(d,sizeof(double));
     Z=(double *)calloc(d,sizeof(double));
+    Q = (int *)  calloc(d,sizeof(int));
+    n=d;
+}
+
+int CBigLinProb::Create(int d, int bw)
+{
+    int i;
+
+    bdw=bw;
+    CreateVectors(d);
 
     M=(CEntry **)calloc(d,sizeof(CEntry *));
-    n=d;
 
     for(i=0; i<d; i++)
     {
         M[i] = new CEntry;
         M[i]->c = i;
     }
-    Q = (int *)  calloc(d,sizeof(int));
 
     return 1;
 }
 
+bool CBigLinProb::SetPattern(CSparsityPattern &)
+{
+    // entries are created on demand by Put() and AddTo()
+    return true;
+}
+
 void CBigLinProb::Put(double v, int p, int q)
 {
     CEntry *e,*l = NULL;
@@ -186,12 +218,14 @@ void CBigLinProb::MultA(double *X, double *Y)
 
 double CBigLinProb::Dot(double *X, double *Y)
 {
-    int i;
-    double z;
-
-    for(i=0,z=0; i<n; i++) z+=X[i]*Y[i];
+    return femm::dot(n,X,Y);
+}
 
-    return z;
+double CBigLinProb::ResidualNorm()
+{
+    MultA(V,R);
+    for(int i=0; i<n; i++) R[i]=b[i]-R[i];
+    return sqrt(Dot(R,R));
 }
 
 void CBigLinProb::MultPC(const double *X, double *Y)
@@ -238,11 +272,11 @@ void CBigLinProb::MultPC(const double *X, double *Y)
 bool CBigLinProb::PCGSolve(int flag)
 {
     int i;
-    double res,res_o,res_new;
+    double res,res_i,res_o,res_new;
     double er,del,rho,pAp;
 
     // quick check for most obvious sign of singularity;
-    for(i=0; i<n; i++) if(M[i]->x==0)
+    for(i=0; i<n; i++) if(Get(i,i)==0)
         {
             fprintf(stderr,"singular flag tripped at %i of %i\n", i,n);
             return 0;
@@ -252,6 +286,8 @@ bool CBigLinProb::PCGSolve(int flag)
 //	TheView->SetDlgItemText(IDC_FRAME1,"Conjugate Gradient Solver");
 //	TheView->m_prog1.SetPos(0);
     printf("Conjugate Gradient Solver\n");
+    Iterations=0;
+    InitPC();
 
     // residual with V=0
     MultPC(b,Z);
@@ -269,6 +305,7 @@ bool CBigLinProb::PCGSolve(int flag)
     MultPC(R,Z);
     for(i=0; i<n; i++) P[i]=Z[i];
     res=Dot(Z,R);
+    res_i=res;
 
     // do iteration;
     do
@@ -278,14 +315,8 @@ bool CBigLinProb::PCGSolve(int flag)
         pAp=Dot(P,U);
         del=res/pAp;
 
-        for(i=0; i<n; i++)
-        {
-            // step ii)
-            V[i]+=(del*P[i]);
-
-            // step iii)
-            R[i]-=(del*U[i]);
-        }
+        // step ii) and iii)
+        femm::axpy2(n,del,P,U,V,R);
 
         // step iv)
         MultPC(R,Z);
@@ -294,10 +325,11 @@ bool CBigLinProb::PCGSolve(int flag)
         res=res_new;
 
         // step v)
-        for(i=0; i<n; i++) P[i]=Z[i]+(rho*P[i]);
+        femm::xpby(n,Z,rho,P);
 
         // have we converged yet?
         er=sqrt(res/res_o);
+        Iterations++;
 //        prg2=(int) (20.*log10(er)/(log10(Precision)));
 //        if(prg2>prg1)
 //        {
@@ -310,11 +342,189 @@ bool CBigLinProb::PCGSolve(int flag)
 //        }
 
     }
-    while(er>Precision);
+    while((er>Precision) && !((ForcingTerm>0) && (res<=ForcingTerm*ForcingTerm*res_i)));
+    debug << "Converged after " << Iterations << " iterations\n";
+
+    return true;
+}
+
+void CBigLinProb::InitPC()
+{
+    // SSOR does not need any setup
+}
+
+bool CBigLinProb::Solve(int flag)
+{
+    Iterations = 0;
+    if (LinearSolver == SOLVER_DIRECT)
+    {
+        if (DirectSolve())
+            return true;
+        printf("Direct solver not available, using conjugate gradients instead\n");
+    }
+    return PCGSolve(flag);
+}
+
+bool CBigLinProb::DirectSolve()
+{
+    return false;
+}
+
+bool CBigLinProb::SolveBlock(int nrhs, double *const *B, double *const *X, int flag)
+{
+    if (LinearSolver == SOLVER_DIRECT)
+    {
+        // DirectSolve() works on b and V; the factor of the first column is reused for the others
+        double *b0=b;
+        double *V0=V;
+        bool ok=true;
+        for(int j=0; j<nrhs && ok; j++)
+        {
+            b=B[j];
+            V=X[j];
+            ok=DirectSolve();
+        }
+        b=b0;
+        V=V0;
+        if (ok)
+            return true;
+        printf("Direct solver not available, using conjugate gradients instead\n");
+    }
+    return BlockPCGSolve(nrhs,B,X,flag);
+}
+
+bool CBigLinProb::BlockPCGSolve(int nrhs, double *const *B, double *const *X, int flag)
+{
+    int i,j,k;
+
+    // quick check for most obvious sign of singularity;
+    for(i=0; i<n; i++) if(Get(i,i)==0)
+        {
+            fprintf(stderr,"singular flag tripped at %i of %i\n", i,n);
+            return false;
+        }
+
+    printf("Conjugate Gradient Solver (%i right hand sides)\n",nrhs);
+    Iterations=0;
+    InitPC();
+
+    // the active columns are stored interleaved: entry i of column j is at [i*k+j]
+    k=nrhs;
+    std::vector<int> cols(k);
+    std::vector<double> Vb(static_cast<size_t>(n)*k), Rb(Vb.size()), Pb(Vb.size()), Ub(Vb.size()), Zb(Vb.size());
+    std::vector<double> res(k), res_o(k), res_new(k), pAp(k), coef(k);
+    for(j=0; j<k; j++)
+    {
+        cols[j]=j;
+        for(i=0; i<n; i++)
+        {
+            Rb[static_cast<size_t>(i)*k+j]=B[j][i];
+            Vb[static_cast<size_t>(i)*k+j]=(flag==0) ? 0. : X[j][i];
+        }
+    }
+
+    // residual with V=0
+    MultPCBlock(k,Rb.data(),Zb.data());
+    femm::dotBlock(n,k,Zb.data(),Rb.data(),res_o.data());
+
+    // form residual;
+    MultABlock(k,Vb.data(),Ub.data());
+    for(size_t e=0; e<Rb.size(); e++) Rb[e]-=Ub[e];
+
+    // form initial search direction;
+    MultPCBlock(k,Rb.data(),Zb.data());
+    Pb=Zb;
+    femm::dotBlock(n,k,Zb.data(),Rb.data(),res.data());
+
+    // remove the columns that are not flagged in keep from an interleaved block
+    std::vector<char> keep(k);
+    auto compact = [&](std::vector<double> &A, int kold, int knew)
+    {
+        size_t to=0;
+        for(size_t from=0; from<A.size(); from++)
+            if (keep[from%kold]) A[to++]=A[from];
+        A.resize(static_cast<size_t>(n)*knew);
+    };
+
+    for(;;)
+    {
+        // store and remove converged columns
+        int kk=0;
+        for(j=0; j<k; j++)
+        {
+            keep[j] = (res_o[j]!=0) && (Iterations==0 || sqrt(res[j]/res_o[j])>Precision);
+            if (!keep[j])
+            {
+                for(i=0; i<n; i++)
+                    X[cols[j]][i] = (res_o[j]==0) ? 0. : Vb[static_cast<size_t>(i)*k+j];
+                continue;
+            }
+            cols[kk]=cols[j];
+            res[kk]=res[j];
+            res_o[kk]=res_o[j];
+            kk++;
+        }
+        if (kk<k)
+        {
+            compact(Vb,k,kk);
+            compact(Rb,k,kk);
+            compact(Pb,k,kk);
+            compact(Zb,k,kk);
+            Ub.resize(Vb.size());
+            k=kk;
+        }
+        if (k==0)
+            break;
+
+        // step i)
+        MultABlock(k,Pb.data(),Ub.data());
+        femm::dotBlock(n,k,Pb.data(),Ub.data(),pAp.data());
+        for(j=0; j<k; j++) coef[j]=res[j]/pAp[j];
+
+        // step ii) and iii)
+        femm::axpy2Block(n,k,coef.data(),Pb.data(),Ub.data(),Vb.data(),Rb.data());
+
+        // step iv)
+        MultPCBlock(k,Rb.data(),Zb.data());
+        femm::dotBlock(n,k,Zb.data(),Rb.data(),res_new.data());
+        for(j=0; j<k; j++)
+        {
+            coef[j]=res_new[j]/res[j];
+            res[j]=res_new[j];
+        }
+
+        // step v)
+        femm::xpbyBlock(n,k,Zb.data(),coef.data(),Pb.data());
+
+        Iterations++;
+    }
+    debug << "Converged after " << Iterations << " iterations\n";
 
     return true;
 }
 
+void CBigLinProb::MultABlock(int k, const double *X, double *Y)
+{
+    std::vector<double> x(n), y(n);
+    for(int j=0; j<k; j++)
+    {
+        for(int i=0; i<n; i++) x[i]=X[static_cast<size_t>(i)*k+j];
+        MultA(x.data(),y.data());
+        for(int i=0; i<n; i++) Y[static_cast<size_t>(i)*k+j]=y[i];
+    }
+}
+
+void CBigLinProb::MultPCBlock(int k, const double *X, double *Y)
+{
+    std::vector<double> x(n), y(n);
+    for(int j=0; j<k; j++)
+    {
+        for(int i=0; i<n; i++) x[i]=X[static_cast<size_t>(i)*k+j];
+        MultPC(x.data(),y.data());
+        for(int i=0; i<n; i++) Y[static_cast<size_t>(i)*k+j]=y[i];
+    }
+}
+
 void CBigLinProb::SetValue(int i, double x)
 {
     int k,fst,lst;
@@ -363,6 +573,35 @@ void CBigLinProb::Wipe()
     }
 }
 
+void CBigLinProb::SaveAssembly()
+{
+    SavedRow.clear();
+    SavedCol.clear();
+    SavedValue.clear();
+    for(int i=0; i<n; i++)
+    {
+        for(CEntry *e=M[i]; e!=NULL; e=e->next)
+        {
+            if (e->x!=0)
+            {
+                SavedRow.push_back(i);
+                SavedCol.push_back(e->c);
+                SavedValue.push_back(e->x);
+            }
+        }
+    }
+    SavedB.assign(b,b+n);
+}
+
+void CBigLinProb::RestoreAssembly()
+{
+    Wipe();
+    for(std::size_t k=0; k<SavedValue.size(); k++)
+        Put(SavedValue[k],SavedRow[k],SavedCol[k]);
+    for(int i=0; i<n && i<static_cast<int>(SavedB.size()); i++)
+        b[i]=SavedB[i];
+}
+
 void CBigLinProb::AntiPeriodicity(int i, int j)
 {
     int k,fst,lst;
@@ -22,6 +22,25 @@
 #ifndef SPARS_H
 #define SPARS_H
 
+#include <vector>
+
+/// preconditioners for CBigLinProb::PCGSolve()
+enum PCGPreconditioner
+{
+    PRECOND_SSOR = 0, ///< symmetric successive over-relaxation
+    PRECOND_ICHOL = 1, ///< incomplete Cholesky factorization IC(k); needs a CBigCSRLinProb
+    PRECOND_AMG = 2 ///< smoothed aggregation algebraic multigrid; needs a CBigCSRLinProb
+};
+
+/// methods for solving a CBigLinProb or CBigComplexLinProb, see CBigLinProb::Solve() and CBigComplexLinProb::Solve()
+enum LinearSolverType
+{
+    SOLVER_ITERATIVE = 0, ///< preconditioned conjugate gradients (real) or biconjugate gradients (complex)
+    SOLVER_DIRECT = 1     ///< sparse direct factorization (Cholesky, or L D L^T / L D U for complex problems); needs compressed row storage
+};
+
+class CSparsityPattern;
+
 class CEntry
 {
 public:
@@ -52,6 +71,23 @@ public:
     int bdw;				// Optional matrix bandwidth parameter;
     double Precision;		// error tolerance for solution
     double Lambda;			// relaxation factor;
+    int Preconditioner;		///< preconditioner used by PCGSolve(), see PCGPreconditioner
+    int ICFill;				///< fill level k of the IC(k) preconditioner
+    double ICDropTol;		///< drop tolerance for the fill-in of the IC(k) preconditioner
+    int Iterations;			///< number of iterations taken by the last call to PCGSolve() or Solve(); 0 for direct solves
+    int LinearSolver;		///< solution method used by Solve(), see LinearSolverType
+    /**
+     * @brief Relative tolerance of an inexact Newton step; 0 (default) to disable.
+     * If positive, PCGSolve() also stops as soon as the residual dropped by this factor
+     * compared to the residual of the initial guess, even if \c Precision is not reached yet.
+     */
+    double ForcingTerm;
+    /**
+     * @brief Reuse the preconditioner or the direct factorization of an earlier matrix (modified Newton).
+     * Only backends that need a setup for the preconditioner or a factorization (CBigCSRLinProb) make use of it.
+     * Reset to \c false (default) to set them up for the current matrix again.
+     */
+    bool ReusePC;
 
     int *Q; ///< Used by esolver and hsolver.
 
@@ -60,25 +96,108 @@ public:
     // constructor
     CBigLinProb();
     // destructor
-    ~CBigLinProb();
+    virtual ~CBigLinProb();
     virtual int Create(int d, int bw);	// initialize the problem
-    void Put(double v, int p, int q);
+    /**
+     * @brief Prepare the matrix storage for the given sparsity pattern.
+     * Called after Create() and before assembly.
+     * The default implementation creates entries on demand and ignores the pattern.
+     * @return \c false if the pattern does not fit the matrix.
+     */
+    virtual bool SetPattern(CSparsityPattern &pattern);
+    virtual void Put(double v, int p, int q);
     // use to create/set entries in the matrix
-    double Get(int p, int q);
+    virtual double Get(int p, int q);
     bool PCGSolve(int flag);	// flag==true if guess for V present;
-    void MultPC(const double *X, double *Y);
-    void AddTo(double v, int p, int q);
-    void MultA(double *X, double *Y);
-    void SetValue(int i, double x);
-    void Periodicity(int i, int j);
-    void AntiPeriodicity(int i, int j);
-    void Wipe();
+    /**
+     * @brief Solve the system with the method selected by \c LinearSolver.
+     * If the direct solver is not available or fails, PCGSolve() is used instead.
+     * @param flag \c true if V contains an initial guess (only used by PCGSolve())
+     */
+    virtual bool Solve(int flag);
+    /**
+     * @brief Solve the system with a sparse direct solver.
+     * The default implementation does not support direct solving and returns \c false.
+     */
+    virtual bool DirectSolve();
+    /**
+     * @brief Solve the system for several right hand sides at once.
+     *
+     * With \c LinearSolver set to SOLVER_DIRECT, the matrix is factored once and the factor is used for all columns.
+     * Otherwise BlockPCGSolve() is used.
+     * The vectors \c b and \c V are not used.
+     * @param nrhs number of right hand sides
+     * @param B right hand sides: \p nrhs vectors of length n
+     * @param X solutions: \p nrhs vectors of length n
+     * @param flag \c true if X contains an initial guess (only used by BlockPCGSolve())
+     */
+    virtual bool SolveBlock(int nrhs, double *const *B, double *const *X, int flag);
+    /**
+     * @brief Preconditioned conjugate gradients for several right hand sides.
+     *
+     * Each right hand side has its own conjugate gradient recurrence, with the same convergence
+     * criterion as PCGSolve(), but the matrix-vector products and the preconditioner are applied
+     * to all columns in a single sweep over the matrix (see MultABlock() and MultPCBlock()).
+     * Converged columns are removed from the block.
+     * @see SolveBlock()
+     */
+    bool BlockPCGSolve(int nrhs, double *const *B, double *const *X, int flag);
+    virtual void MultPC(const double *X, double *Y);
+    /**
+     * @brief Set up the preconditioner for the current matrix.
+     * Called by PCGSolve() once before the iteration starts.
+     */
+    virtual void InitPC();
+    virtual void AddTo(double v, int p, int q);
+    virtual void MultA(double *X, double *Y);
+    /**
+     * @brief Y = A*X for a block of \p k vectors, stored interleaved (entry i of vector j is at [i*k+j]).
+     * The default implementation calls MultA() for each vector.
+     */
+    virtual void MultABlock(int k, const double *X, double *Y);
+    /**
+     * @brief Apply the preconditioner to a block of \p k interleaved vectors, see MultABlock().
+     * The default implementation calls MultPC() for each vector.
+     */
+    virtual void MultPCBlock(int k, const double *X, double *Y);
+    virtual void SetValue(int i, double x);
+    virtual void Periodicity(int i, int j);
+    virtual void AntiPeriodicity(int i, int j);
+    virtual void Wipe();
+    /**
+     * @brief Keep a copy of the matrix and the right hand side.
+     * Used by nonlinear solvers to keep the contributions that stay the same in each iteration.
+     * @see RestoreAssembly()
+     */
+    virtual void SaveAssembly();
+    /**
+     * @brief Replace the matrix and the right hand side by the copy made by SaveAssembly().
+     * Like Wipe(), this starts a new assembly, but with the saved contributions already in place.
+     */
+    virtual void RestoreAssembly();
     double Dot(double *X, double *Y);
-    void ComputeBandwidth();
+    /**
+     * @brief Norm of the residual b-A*V of the assembled system, including all constraints.
+     * A nonlinear solver uses it to measure the progress of its iteration.
+     * The vector \c R is used as temporary storage.
+     */
+    virtual double ResidualNorm();
+    virtual void ComputeBandwidth();
 
 //		CFknDlg *TheView;
 
-private:
+protected:
+    /**
+     * @brief Allocate the solution, work and RHS vectors for a problem of dimension \p d.
+     * Used by Create() of this class and derived classes that provide their own matrix storage.
+     */
+    void CreateVectors(int d);
+
+    // copy made by SaveAssembly(); the default implementation stores each matrix entry as (row, column, value)
+    std::vector<int> SavedRow;
+    std::vector<int> SavedCol;
+    std::vector<double> SavedValue;
+    std::vector<double> SavedB;
 
 };
 
@@ -0,0 +1,585 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "spchol.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+CSupernodalStructure::CSupernodalStructure()
+    : N(0)
+    , PatternVersion(-1)
+{
+}
+
+void CSupernodalStructure::Clear()
+{
+    N = 0;
+    Perm.clear();
+    ColStart.clear();
+    RowIndex.clear();
+    ValueIndex.clear();
+    Mirrored.clear();
+    SnFirst.clear();
+    SnRowStart.clear();
+    SnRows.clear();
+    SnValueStart.clear();
+    ColSn.clear();
+    PatternVersion = -1;
+}
+
+size_t CSupernodalStructure::NumEntries() const
+{
+    size_t nnz = 0;
+    for (int s=0; s<NumSupernodes(); s++)
+    {
+        size_t nc = SnFirst[s+1]-SnFirst[s];
+        size_t m = SnRowStart[s+1]-SnRowStart[s];
+        nnz += nc*m - nc*(nc-1)/2;
+    }
+    return nnz;
+}
+
+void CSupernodalStructure::Order(const int *rowStart, const int *colIndex)
+{
+    // Approximate minimum degree ordering on the quotient graph:
+    // eliminated variables become "elements" that stand for the clique they create,
+    // so the graph never grows. The degree of a variable i adjacent to the new element p is estimated by
+    //   |A_i| + |L_p \ i| + sum over other elements e of |L_e \ L_p|
+    // (see Amestoy, Davis and Duff, An approximate minimum degree ordering algorithm, 1996).
+    const int n = N;
+    std::vector< std::vector<int> > adjV(n); // variables adjacent to each variable
+    std::vector< std::vector<int> > adjE(n); // elements adjacent to each variable
+    std::vector< std::vector<int> > Le(n);   // variables of each element
+    for (int i=0; i<n; i++)
+    {
+        for (int e=rowStart[i]; e<rowStart[i+1]; e++)
+        {
+            int j = colIndex[e];
+            if (j!=i)
+            {
+                adjV[i].push_back(j);
+                adjV[j].push_back(i);
+            }
+        }
+    }
+
+    // degree lists
+    std::vector<int> degree(n), head(n,-1), next(n,-1), prev(n,-1);
+    auto insert = [&](int i, int d) {
+        degree[i] = d;
+        prev[i] = -1;
+        next[i] = head[d];
+        if (head[d]>=0) prev[head[d]] = i;
+        head[d] = i;
+    };
+    auto remove = [&](int i) {
+        if (prev[i]>=0) next[prev[i]] = next[i];
+        else head[degree[i]] = next[i];
+        if (next[i]>=0) prev[next[i]] = prev[i];
+    };
+    for (int i=n-1; i>=0; i--)
+        insert(i, std::min(static_cast<int>(adjV[i].size()), n-1));
+
+    enum { VARIABLE, ELEMENT, ABSORBED };
+    std::vector<char> state(n,VARIABLE);
+    std::vector<int> mark(n,-1);  // stamp: member of the current element
+    std::vector<int> w(n), wstamp(n,-1);
+
+    Perm.resize(n);
+    int mindeg = 0;
+    for (int k=0; k<n; k++)
+    {
+        while (head[mindeg]<0) mindeg++;
+        const int p = head[mindeg];
+        remove(p);
+        state[p] = ELEMENT;
+        Perm[k] = p;
+
+        // the new element: all variables reachable from p
+        std::vector<int> &Lp = Le[p];
+        Lp.clear();
+        mark[p] = k;
+        for (int e: adjE[p])
+        {
+            if (state[e]!=ELEMENT) continue;
+            for (int v: Le[e])
+            {
+                if (state[v]==VARIABLE && mark[v]!=k)
+                {
+                    mark[v] = k;
+                    Lp.push_back(v);
+                }
+            }
+            state[e] = ABSORBED;
+            std::vector<int>().swap(Le[e]);
+        }
+        for (int v: adjV[p])
+        {
+            if (state[v]==VARIABLE && mark[v]!=k)
+            {
+                mark[v] = k;
+                Lp.push_back(v);
+            }
+        }
+        std::vector<int>().swap(adjV[p]);
+        std::vector<int>().swap(adjE[p]);
+
+        for (int i: Lp)
+            remove(i);
+
+        // |L_e \ L_p| for all elements adjacent to L_p
+        for (int i: Lp)
+        {
+            for (int e: adjE[i])
+            {
+                if (state[e]!=ELEMENT) continue;
+                if (wstamp[e]!=k)
+                {
+                    wstamp[e] = k;
+                    w[e] = static_cast<int>(Le[e].size());
+                }
+                w[e]--;
+            }
+        }
+
+        // update the variables of the new element
+        const int nlp = static_cast<int>(Lp.size());
+        for (int i: Lp)
+        {
+            int d = nlp-1;
+            std::vector<int> &E = adjE[i];
+            size_t o = 0;
+            for (int e: E)
+            {
+                if (state[e]!=ELEMENT) continue;
+                if (wstamp[e]==k && w[e]==0)
+                {
+                    // L_e is a subset of L_p: absorb e into p
+                    state[e] = ABSORBED;
+                    std::vector<int>().swap(Le[e]);
+                    continue;
+                }
+                E[o++] = e;
+                d += (wstamp[e]==k) ? w[e] : static_cast<int>(Le[e].size());
+            }
+            E.resize(o);
+            E.push_back(p);
+
+            // variables in L_p are now reached through p
+            std::vector<int> &A = adjV[i];
+            o = 0;
+            for (int v: A)
+            {
+                if (state[v]==VARIABLE && mark[v]!=k)
+                {
+                    A[o++] = v;
+                    d++;
+                }
+            }
+            A.resize(o);
+
+            d = std::min(d, degree[i]+nlp);
+            d = std::min(d, n-k-2);
+            d = std::max(d, 0);
+            insert(i,d);
+            mindeg = std::min(mindeg,d);
+        }
+    }
+}
+
+bool CSupernodalStructure::Analyze(int n, const int *rowStart, const int *colIndex)
+{
+    Clear();
+    N = n;
+    if (n<=0)
+        return false;
+
+    Order(rowStart, colIndex);
+
+    std::vector<int> iperm(n);
+    for (int k=0; k<n; k++) iperm[Perm[k]] = k;
+
+    // pattern of the permuted matrix, by rows of the lower triangle
+    std::vector<int> lrs(n+1,0), lcol(rowStart[n]);
+    for (int i=0; i<n; i++)
+        for (int e=rowStart[i]+1; e<rowStart[i+1]; e++)
+            lrs[std::max(iperm[i],iperm[colIndex[e]])+1]++;
+    for (int i=0; i<n; i++) lrs[i+1] += lrs[i];
+    {
+        std::vector<int> fill(lrs.begin(), lrs.end()-1);
+        for (int i=0; i<n; i++)
+            for (int e=rowStart[i]+1; e<rowStart[i+1]; e++)
+            {
+                int a = iperm[i], b = iperm[colIndex[e]];
+                lcol[fill[std::max(a,b)]++] = std::min(a,b);
+            }
+    }
+
+    // elimination tree (with path compression through ancestor)
+    std::vector<int> parent(n,-1), ancestor(n,-1);
+    for (int k=0; k<n; k++)
+    {
+        for (int e=lrs[k]; e<lrs[k+1]; e++)
+        {
+            int i = lcol[e];
+            while (i!=-1 && i<k)
+            {
+                int inext = ancestor[i];
+                ancestor[i] = k;
+                if (inext==-1) parent[i] = k;
+                i = inext;
+            }
+        }
+    }
+
+    // postorder the tree, so that the columns of each supernode are contiguous
+    std::vector<int> child(n,-1), sibling(n,-1), post;
+    post.reserve(n);
+    for (int j=n-1; j>=0; j--)
+    {
+        if (parent[j]>=0)
+        {
+            sibling[j] = child[parent[j]];
+            child[parent[j]] = j;
+        }
+    }
+    {
+        std::vector<int> stack;
+        for (int j=0; j<n; j++)
+        {
+            if (parent[j]!=-1) continue;
+            stack.push_back(j);
+            while (!stack.empty())
+            {
+                int t = stack.back();
+                if (child[t]>=0)
+                {
+                    int c = child[t];
+                    child[t] = sibling[c];
+                    stack.push_back(c);
+                } else {
+                    post.push_back(t);
+                    stack.pop_back();
+                }
+            }
+        }
+    }
+    {
+        std::vector<int> newperm(n), ipost(n);
+        for (int k=0; k<n; k++)
+        {
+            newperm[k] = Perm[post[k]];
+            ipost[post[k]] = k;
+        }
+        Perm.swap(newperm);
+        std::vector<int> newparent(n,-1);
+        for (int k=0; k<n; k++)
+            if (parent[post[k]]>=0) newparent[k] = ipost[parent[post[k]]];
+        parent.swap(newparent);
+        for (int k=0; k<n; k++) iperm[Perm[k]] = k;
+    }
+
+    // lower triangle of the permuted matrix: rows (for the symbolic phase) and columns (for the numeric phase)
+    std::fill(lrs.begin(), lrs.end(), 0);
+    ColStart.assign(n+1,0);
+    for (int i=0; i<n; i++)
+    {
+        for (int e=rowStart[i]; e<rowStart[i+1]; e++)
+        {
+            int a = iperm[i], b = iperm[colIndex[e]];
+            ColStart[std::min(a,b)+1]++;
+            if (a!=b) lrs[std::max(a,b)+1]++;
+        }
+    }
+    for (int i=0; i<n; i++)
+    {
+        ColStart[i+1] += ColStart[i];
+        lrs[i+1] += lrs[i];
+    }
+    RowIndex.resize(rowStart[n]);
+    ValueIndex.resize(rowStart[n]);
+    Mirrored.resize(rowStart[n]);
+    {
+        std::vector<int> cfill(ColStart.begin(), ColStart.end()-1);
+        std::vector<int> rfill(lrs.begin(), lrs.end()-1);
+        for (int i=0; i<n; i++)
+        {
+            for (int e=rowStart[i]; e<rowStart[i+1]; e++)
+            {
+                int a = iperm[i], b = iperm[colIndex[e]];
+                int c = std::min(a,b), r = std::max(a,b);
+                RowIndex[cfill[c]] = r;
+                Mirrored[cfill[c]] = (r!=a);
+                ValueIndex[cfill[c]++] = e;
+                if (a!=b) lcol[rfill[r]++] = c;
+            }
+        }
+    }
+
+    // column counts: the nonzeros of row k of L are the nodes of the
+    // subtree of the elimination tree spanned by the nonzeros of row k of A
+    std::vector<int> count(n,0), stamp(n,-1);
+    for (int k=0; k<n; k++)
+    {
+        stamp[k] = k;
+        for (int e=lrs[k]; e<lrs[k+1]; e++)
+        {
+            for (int i=lcol[e]; stamp[i]!=k; i=parent[i])
+            {
+                count[i]++;
+                stamp[i] = k;
+            }
+        }
+    }
+
+    // supernodes: a column joins the previous one if it is its parent
+    // and has the same structure below the diagonal
+    ColSn.resize(n);
+    SnFirst.clear();
+    for (int j=0; j<n; j++)
+    {
+        if (j==0 || parent[j-1]!=j || count[j-1]!=count[j]+1)
+            SnFirst.push_back(j);
+        ColSn[j] = static_cast<int>(SnFirst.size())-1;
+    }
+    const int ns = static_cast<int>(SnFirst.size());
+    SnFirst.push_back(n);
+
+    SnRowStart.resize(ns+1);
+    SnValueStart.resize(ns+1);
+    SnRowStart[0] = 0;
+    SnValueStart[0] = 0;
+    for (int s=0; s<ns; s++)
+    {
+        int m = count[SnFirst[s]]+1;
+        int nc = SnFirst[s+1]-SnFirst[s];
+        SnRowStart[s+1] = SnRowStart[s] + m;
+        SnValueStart[s+1] = SnValueStart[s] + static_cast<size_t>(m)*nc;
+    }
+
+    // row structure of the supernodes: own columns first, then the rows below in increasing order
+    SnRows.resize(SnRowStart[ns]);
+    std::vector<int> fill(ns);
+    for (int s=0; s<ns; s++)
+    {
+        fill[s] = SnRowStart[s];
+        for (int j=SnFirst[s]; j<SnFirst[s+1]; j++)
+            SnRows[fill[s]++] = j;
+    }
+    std::fill(stamp.begin(), stamp.end(), -1);
+    for (int k=0; k<n; k++)
+    {
+        stamp[k] = k;
+        for (int e=lrs[k]; e<lrs[k+1]; e++)
+        {
+            for (int i=lcol[e]; stamp[i]!=k; i=parent[i])
+            {
+                stamp[i] = k;
+                int s = ColSn[i];
+                if (i==SnFirst[s] && k>=SnFirst[s+1])
+                    SnRows[fill[s]++] = k;
+            }
+        }
+    }
+
+    return true;
+}
+
+CSparseCholesky::CSparseCholesky()
+    : S()
+    , Reused(false)
+    , Factored(false)
+{
+}
+
+void CSparseCholesky::Clear()
+{
+    S.Clear();
+    LValue.clear();
+    FactoredValue.clear();
+    Work.clear();
+    Factored = false;
+    Reused = false;
+}
+
+bool CSparseCholesky::Analyze(int n, const int *rowStart, const int *colIndex)
+{
+    Clear();
+    return S.Analyze(n, rowStart, colIndex);
+}
+
+bool CSparseCholesky::Factor(const double *value)
+{
+    const int nnz = static_cast<int>(S.ValueIndex.size());
+    if (Factored && (int)FactoredValue.size()==nnz
+            && std::memcmp(FactoredValue.data(), value, nnz*sizeof(double))==0)
+    {
+        Reused = true;
+        return true;
+    }
+    Reused = false;
+    Factored = false;
+
+    const int ns = NumSupernodes();
+    LValue.assign(S.SnValueStart[ns],0.);
+
+    std::vector<int> map(S.N);        // position of each row in the current supernode
+    std::vector<int> head(ns,-1);   // descendants that still have to update each supernode
+    std::vector<int> link(ns,-1);
+    std::vector<int> nextrow(ns,0); // first row of each finished supernode that was not used yet
+    std::vector<double> C;
+
+    for (int s=0; s<ns; s++)
+    {
+        const int f = S.SnFirst[s];
+        const int l = S.SnFirst[s+1];
+        const int nc = l-f;
+        const int m = S.SnRowStart[s+1]-S.SnRowStart[s];
+        const int *rows = S.SnRows.data() + S.SnRowStart[s];
+        double *Ls = LValue.data() + S.SnValueStart[s];
+
+        for (int r=0; r<m; r++)
+            map[rows[r]] = r;
+
+        // columns of A
+        for (int j=f; j<l; j++)
+            for (int e=S.ColStart[j]; e<S.ColStart[j+1]; e++)
+                Ls[static_cast<size_t>(j-f)*m + map[S.RowIndex[e]]] += value[S.ValueIndex[e]];
+
+        // updates from all descendants with rows in [f,l)
+        int d = head[s];
+        while (d>=0)
+        {
+            const int dnext = link[d];
+            const int md = S.SnRowStart[d+1]-S.SnRowStart[d];
+            const int ncd = S.SnFirst[d+1]-S.SnFirst[d];
+            const int *rowsd = S.SnRows.data() + S.SnRowStart[d];
+            const double *Ld = LValue.data() + S.SnValueStart[d];
+            const int p = nextrow[d];
+            int q = p;
+            while (q<md && rowsd[q]<l) q++;
+
+            // C = L_d(p:md,:) * L_d(p:q,:)^T, lower part
+            const int mc = md-p;
+            C.assign(static_cast<size_t>(mc)*(q-p),0.);
+            for (int c=0; c<q-p; c++)
+            {
+                double *Cc = C.data() + static_cast<size_t>(c)*mc;
+                for (int k=0; k<ncd; k++)
+                {
+                    const double *Ldk = Ld + static_cast<size_t>(k)*md + p;
+                    const double lck = Ldk[c];
+                    if (lck==0) continue;
+                    for (int r=c; r<mc; r++)
+                        Cc[r] += Ldk[r]*lck;
+                }
+                double *Lsc = Ls + static_cast<size_t>(rowsd[p+c]-f)*m;
+                for (int r=c; r<mc; r++)
+                    Lsc[map[rowsd[p+r]]] -= Cc[r];
+            }
+
+            // move d on to the supernode of its next row
+            nextrow[d] = q;
+            if (q<md)
+            {
+                const int t = S.ColSn[rowsd[q]];
+                link[d] = head[t];
+                head[t] = d;
+            }
+            d = dnext;
+        }
+
+        // dense factorization of the supernode
+        for (int j=0; j<nc; j++)
+        {
+            double *Lj = Ls + static_cast<size_t>(j)*m;
+            if (!(Lj[j]>0))
+                return false; // not positive definite
+            const double djj = sqrt(Lj[j]);
+            Lj[j] = djj;
+            for (int r=j+1; r<m; r++)
+                Lj[r] /= djj;
+            for (int jj=j+1; jj<nc; jj++)
+            {
+                double *Ljj = Ls + static_cast<size_t>(jj)*m;
+                const double lj = Lj[jj];
+                if (lj==0) continue;
+                for (int r=jj; r<m; r++)
+                    Ljj[r] -= Lj[r]*lj;
+            }
+        }
+
+        if (nc<m)
+        {
+            nextrow[s] = nc;
+            const int t = S.ColSn[rows[nc]];
+            link[s] = head[t];
+            head[t] = s;
+        }
+    }
+
+    FactoredValue.assign(value, value+nnz);
+    Factored = true;
+    return true;
+}
+
+void CSparseCholesky::Solve(const double *X, double *Y)
+{
+    const int ns = NumSupernodes();
+    Work.resize(S.N);
+    double *x = Work.data();
+    for (int k=0; k<S.N; k++)
+        x[k] = X[S.Perm[k]];
+
+    // solve L y = x
+    for (int s=0; s<ns; s++)
+    {
+        const int f = S.SnFirst[s];
+        const int nc = S.SnFirst[s+1]-f;
+        const int m = S.SnRowStart[s+1]-S.SnRowStart[s];
+        const int *rows = S.SnRows.data() + S.SnRowStart[s];
+        const double *Ls = LValue.data() + S.SnValueStart[s];
+        for (int j=0; j<nc; j++)
+        {
+            const double *Lj = Ls + static_cast<size_t>(j)*m;
+            x[f+j] /= Lj[j];
+            const double xj = x[f+j];
+            for (int r=j+1; r<m; r++)
+                x[rows[r]] -= Lj[r]*xj;
+        }
+    }
+
+    // solve L^T x = y
+    for (int s=ns-1; s>=0; s--)
+    {
+        const int f = S.SnFirst[s];
+        const int nc = S.SnFirst[s+1]-f;
+        const int m = S.SnRowStart[s+1]-S.SnRowStart[s];
+        const int *rows = S.SnRows.data() + S.SnRowStart[s];
+        const double *Ls = LValue.data() + S.SnValueStart[s];
+        for (int j=nc-1; j>=0; j--)
+        {
+            const double *Lj = Ls + static_cast<size_t>(j)*m;
+            double t = x[f+j];
+            for (int r=j+1; r<m; r++)
+                t -= Lj[r]*x[rows[r]];
+            x[f+j] = t/Lj[j];
+        }
+    }
+
+    for (int k=0; k<S.N; k++)
+        Y[S.Perm[k]] = x[k];
+}
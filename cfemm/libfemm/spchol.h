@@ -0,0 +1,129 @@
+/*
+ * The source code in this file extends the sparse matrix code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef SPCHOL_H
+#define SPCHOL_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief The CSupernodalStructure class holds the symbolic factorization of a symmetric sparse matrix.
+ *
+ * Analyze() computes a fill-reducing (approximate minimum degree) ordering,
+ * postorders the elimination tree and groups columns of the factor with identical structure into supernodes.
+ * The result only depends on the sparsity pattern, and is shared by the numeric factorizations
+ * (CSparseCholesky, and the complex direct solver CComplexDirectSolver).
+ *
+ * The factor of supernode s covers the columns SnFirst[s] to SnFirst[s+1]-1.
+ * Its rows are stored in SnRows (starting with the columns of the supernode itself),
+ * and its entries form a dense column-major block starting at SnValueStart[s] (in units of entries).
+ */
+class CSupernodalStructure
+{
+public:
+    CSupernodalStructure();
+
+    /**
+     * @brief Compute ordering and symbolic factorization.
+     *
+     * The matrix is given by its upper triangle in compressed row storage,
+     * where the diagonal element is the first entry of each row (see CBigCSRLinProb).
+     *
+     * @param n dimension of the matrix
+     * @param rowStart index of the first entry of each row (n+1 entries)
+     * @param colIndex column of each entry
+     * @return \c true on success
+     */
+    bool Analyze(int n, const int *rowStart, const int *colIndex);
+    void Clear();
+
+    bool Valid() const { return !SnFirst.empty(); }
+    int NumSupernodes() const { return static_cast<int>(SnFirst.size())-1; }
+    /**
+     * @brief Number of nonzero entries in the lower triangle of the factor.
+     */
+    size_t NumEntries() const;
+
+    int N;                       ///< dimension of the matrix
+    std::vector<int> Perm;       ///< Perm[k] is the original index of the k-th pivot
+    std::vector<int> ColStart;   ///< lower triangle of the permuted matrix, by column
+    std::vector<int> RowIndex;   ///< row of each entry of the permuted matrix
+    std::vector<int> ValueIndex; ///< position of each entry in the upper triangle storage of the original matrix
+    std::vector<char> Mirrored;  ///< \c true if the entry is the mirror image of the stored upper triangle entry
+
+    std::vector<int> SnFirst;    ///< first column of each supernode; one entry more than supernodes
+    std::vector<int> SnRowStart; ///< index of the first row of each supernode in SnRows
+    std::vector<int> SnRows;     ///< row indices of each supernode; the columns of the supernode come first
+    std::vector<size_t> SnValueStart; ///< start of the dense block of each supernode
+    std::vector<int> ColSn;      ///< supernode of each column
+
+    int PatternVersion; ///< version of the sparsity pattern the analysis was done for; maintained by the owner
+
+private:
+    void Order(const int *rowStart, const int *colIndex);
+};
+
+/**
+ * @brief The CSparseCholesky class is a supernodal sparse direct solver for symmetric positive definite matrices.
+ *
+ * Solving is split into three phases:
+ *  1. Analyze() computes the symbolic factorization (see CSupernodalStructure).
+ *     It only depends on the sparsity pattern.
+ *  2. Factor() computes the numeric factorization P A P^T = L L^T.
+ *     If the matrix values did not change since the last call, the factor is kept.
+ *  3. Solve() only does a forward and a back substitution,
+ *     so solving for additional right hand sides is cheap.
+ */
+class CSparseCholesky
+{
+public:
+    CSparseCholesky();
+
+    /**
+     * @brief Compute ordering and symbolic factorization, see CSupernodalStructure::Analyze().
+     */
+    bool Analyze(int n, const int *rowStart, const int *colIndex);
+    /**
+     * @brief Compute the numeric factorization.
+     * The values must belong to the pattern passed to Analyze().
+     * @param value value of each entry
+     * @return \c true on success, \c false if the matrix is not positive definite.
+     */
+    bool Factor(const double *value);
+    /**
+     * @brief Compute Y = A^-1 X using the current factor.
+     */
+    void Solve(const double *X, double *Y);
+    /**
+     * @brief Discard ordering and factor.
+     */
+    void Clear();
+
+    bool Analyzed() const { return S.Valid(); }
+    bool Valid() const { return Factored; }
+    int NumSupernodes() const { return S.NumSupernodes(); }
+    size_t NumEntries() const { return S.NumEntries(); }
+
+    CSupernodalStructure S; ///< symbolic factorization
+    bool Reused;            ///< \c true if the last call to Factor() found the same values and kept the factor
+
+private:
+    std::vector<double> LValue;  ///< values of L
+    std::vector<double> FactoredValue; ///< matrix values of the current factor
+    std::vector<double> Work;
+    bool Factored;
+};
+
+#endif
@@ -46,7 +46,7 @@ inline void to_lower(std::string &s)
  */
 inline void ltrim(std::string &s) {
     s.erase(s.begin(), std::find_if(s.begin(), s.end(),
-                                    std::not1(std::ptr_fun<int, int>(std::isspace))));
+                                    [](unsigned char c) { return !std::isspace(c); }));
 }
 
 /**
@@ -56,7 +56,7 @@ inline void ltrim(std::string &s) {
  */
 inline void rtrim(std::string &s) {
     s.erase(std::find_if(s.rbegin(), s.rend(),
-                         std::not1(std::ptr_fun<int, int>(std::isspace))).base(), s.end());
+                         [](unsigned char c) { return !std::isspace(c); }).base(), s.end());
 }
 
 /**
@@ -0,0 +1,171 @@
+/*
+ * The source code in this file extends the material code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+// Tests for femm::CBHCurveCache:
+// a cached curve is the same as a computed one (bit for bit), changed lamination parameters or frequencies miss,
+// the Save()/Load() round trip, and the LRU eviction.
+// The cache file is created in the working directory.
+
+#include "bhcache.h"
+#include "CMaterialProp.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using femm::CBHCurveCache;
+using femm::CMSolverMaterialProp;
+
+namespace {
+
+int failed = 0;
+
+void check(const std::string &name, bool ok)
+{
+    if (!ok)
+        failed++;
+    printf("%s %s\n", ok ? "[  ok  ]" : "[FAILED]", name.c_str());
+}
+
+const double PI = 3.141592653589793;
+
+// the BH curve of "1117 Steel"
+const std::vector<double> dcB = { 0, 0.7004, 1.351, 1.624, 1.77, 2, 2.13, 2.25, 2.46 };
+const std::vector<double> dcH = { 0, 238.7325, 795.775, 3183.1, 7957.75, 31831, 79577.5, 159155, 318310 };
+
+/// a laminated material with conductive laminations, i.e. one that needs the 1-D eddy current model
+CMSolverMaterialProp testMaterial(double lamD)
+{
+    CMSolverMaterialProp prop;
+    prop.BlockName = "test";
+    prop.BHpoints = static_cast<int>(dcB.size());
+    prop.Bdata = dcB;
+    prop.Hdata.clear();
+    for (double h : dcH)
+        prop.Hdata.push_back(CComplex(h,0));
+    prop.LamType = 0;
+    prop.LamFill = 0.98;
+    prop.Lam_d = lamD;
+    prop.Cduct = 5;
+    return prop;
+}
+
+/// \c true, if both processed curves are the same, bit for bit
+bool sameCurve(const CMSolverMaterialProp &a, const CMSolverMaterialProp &b)
+{
+    if (a.Bdata.size()!=b.Bdata.size() || a.Hdata.size()!=b.Hdata.size() || a.slope.size()!=b.slope.size())
+        return false;
+    for (size_t i=0; i<a.Bdata.size(); i++)
+    {
+        if (a.Bdata[i]!=b.Bdata[i] || a.Hdata[i].re!=b.Hdata[i].re || a.Hdata[i].im!=b.Hdata[i].im
+                || a.slope[i].re!=b.slope[i].re || a.slope[i].im!=b.slope[i].im)
+            return false;
+    }
+    return a.MuMax==b.MuMax;
+}
+
+/// process the curve of \p prop at frequency \p f, using the global cache
+/// (in place, since the copy constructor of the material does not copy MuMax)
+void process(CMSolverMaterialProp &prop, double f)
+{
+    prop.GetSlopes(2*PI*f);
+}
+
+/// \c true, if the cache has the processed curve of \p prop at frequency \p f
+bool cached(CBHCurveCache &cache, CMSolverMaterialProp prop, double f)
+{
+    return cache.Lookup(prop, 2*PI*f);
+}
+
+} // namespace
+
+int main()
+{
+    CBHCurveCache &cache = CBHCurveCache::global();
+    const std::string file = "bhcache-test.cache";
+
+    // cached and computed curves
+    cache.Clear();
+    CMSolverMaterialProp computed = testMaterial(0.5);
+    process(computed, 50);
+    check("a computed curve is stored", cache.Size()==1);
+    check("the computed curve is processed", !computed.slope.empty() && computed.Bdata!=dcB);
+    CMSolverMaterialProp hit = testMaterial(0.5);
+    process(hit, 50);
+    check("the same material and frequency hit", cache.Size()==1);
+    check("the cached curve is the computed curve, bit for bit", sameCurve(hit, computed));
+
+    CMSolverMaterialProp otherLamination = testMaterial(0.35);
+    process(otherLamination, 50);
+    check("a changed lamination thickness misses", cache.Size()==2 && !sameCurve(otherLamination, computed));
+    CMSolverMaterialProp otherFill = testMaterial(0.5);
+    otherFill.LamFill = 0.95;
+    process(otherFill, 50);
+    check("a changed fill factor misses", cache.Size()==3 && !sameCurve(otherFill, computed));
+    CMSolverMaterialProp otherFrequency = testMaterial(0.5);
+    process(otherFrequency, 60);
+    check("a changed frequency misses", cache.Size()==4 && !sameCurve(otherFrequency, computed));
+
+    // Save() and Load()
+    check("save", cache.Save(file));
+    cache.Clear();
+    check("load", cache.Load(file) && cache.Size()==4);
+    CMSolverMaterialProp loaded = testMaterial(0.5);
+    process(loaded, 50);
+    check("a loaded curve is the computed curve, bit for bit", sameCurve(loaded, computed) && cache.Size()==4);
+    CMSolverMaterialProp loadedLamination = testMaterial(0.35);
+    process(loadedLamination, 50);
+    CMSolverMaterialProp loadedFrequency = testMaterial(0.5);
+    process(loadedFrequency, 60);
+    check("all loaded curves hit",
+          sameCurve(loadedLamination, otherLamination) && sameCurve(loadedFrequency, otherFrequency)
+          && cache.Size()==4);
+    FILE *fp = fopen(file.c_str(), "r+b");
+    if (fp)
+    {
+        // break the header
+        fputs("#", fp);
+        fclose(fp);
+    }
+    cache.Clear();
+    check("a broken file is not loaded", !cache.Load(file) && cache.Size()==0);
+    remove(file.c_str());
+
+    // eviction of the least recently used curves
+    {
+        CBHCurveCache small(2);
+        std::vector<double> dcHc;
+        for (double h : dcH)
+        {
+            dcHc.push_back(h);
+            dcHc.push_back(0);
+        }
+        CMSolverMaterialProp thin = testMaterial(0.25);
+        process(thin, 50);
+        small.Store(dcB, dcHc, computed, 2*PI*50);
+        small.Store(dcB, dcHc, otherLamination, 2*PI*50);
+        check("hit before eviction", cached(small, testMaterial(0.5), 50));
+        small.Store(dcB, dcHc, thin, 2*PI*50);
+        check("the cache keeps to its size limit", small.Size()==2);
+        check("the least recently used curve is evicted", !cached(small, testMaterial(0.35), 50));
+        check("a recently used curve is kept", cached(small, testMaterial(0.5), 50));
+        check("a new curve is kept", cached(small, testMaterial(0.25), 50));
+        small.SetMaxCurves(1);
+        check("a lower limit evicts", small.Size()==1);
+        check("the most recently used curve is kept", cached(small, testMaterial(0.25), 50));
+    }
+
+    cache.Clear();
+    return failed==0 ? 0 : 1;
+}
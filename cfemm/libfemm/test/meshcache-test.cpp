@@ -0,0 +1,236 @@
+/*
+ * The source code in this file extends the mesh handling code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+// Tests for femm::CMeshCache:
+// a hit, a miss on a changed key, the LRU eviction, and the atomic store (temporary file + rename).
+// The cache directory is created in the working directory.
+
+#include "meshcache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+using femm::CMeshCache;
+using femm::CMeshData;
+
+namespace {
+
+int failed = 0;
+
+void check(const std::string &name, bool ok)
+{
+    if (!ok)
+        failed++;
+    printf("%s %s\n", ok ? "[  ok  ]" : "[FAILED]", name.c_str());
+}
+
+/// a small triangulation with all parts of a CMeshData
+CMeshData testMesh(double scale)
+{
+    CMeshData mesh;
+    mesh.nodes = { {0,0,0}, {scale,0,2}, {scale,scale,0}, {0,scale,65538} };
+    mesh.edges = { {0,1,1}, {1,2,0}, {2,3,0}, {3,0,1}, {0,2,0} };
+    mesh.elements = { {{0,1,2},1}, {{0,2,3},2} };
+    femm::CCommonPoint pbc;
+    pbc.x = 1;
+    pbc.y = 3;
+    pbc.t = 1;
+    mesh.pbcs.push_back(pbc);
+    femmsolver::CAirGapElement age;
+    age.BdryName = "\"AGE\"\n";
+    age.BdryFormat = 1;
+    age.totalArcElements = 1;
+    age.totalArcLength = 90;
+    age.ri = 0.5*scale;
+    age.ro = scale;
+    age.agc = CComplex(0.75*scale, 0);
+    femm::CQuadPoint qp;
+    qp.n0 = 0; qp.w0 = 0.1;
+    qp.n1 = 1; qp.w1 = 0.2;
+    qp.n2 = 2; qp.w2 = 0.3;
+    qp.n3 = 3; qp.w3 = 0.4;
+    age.quadNode = { qp, qp };
+    mesh.ages.push_back(age);
+    mesh.computeNumbering();
+    return mesh;
+}
+
+bool sameMesh(const CMeshData &a, const CMeshData &b)
+{
+    if (a.nodes.size()!=b.nodes.size() || a.edges.size()!=b.edges.size()
+            || a.elements.size()!=b.elements.size() || a.pbcs.size()!=b.pbcs.size()
+            || a.ages.size()!=b.ages.size() || a.numbering!=b.numbering || a.bandWidth!=b.bandWidth)
+        return false;
+    for (size_t i=0; i<a.nodes.size(); i++)
+    {
+        if (a.nodes[i].x!=b.nodes[i].x || a.nodes[i].y!=b.nodes[i].y || a.nodes[i].marker!=b.nodes[i].marker)
+            return false;
+    }
+    for (size_t i=0; i<a.edges.size(); i++)
+    {
+        if (a.edges[i].n0!=b.edges[i].n0 || a.edges[i].n1!=b.edges[i].n1 || a.edges[i].marker!=b.edges[i].marker)
+            return false;
+    }
+    for (size_t i=0; i<a.elements.size(); i++)
+    {
+        for (int j=0; j<3; j++)
+        {
+            if (a.elements[i].p[j]!=b.elements[i].p[j])
+                return false;
+        }
+        if (a.elements[i].label!=b.elements[i].label)
+            return false;
+    }
+    for (size_t i=0; i<a.pbcs.size(); i++)
+    {
+        if (a.pbcs[i].x!=b.pbcs[i].x || a.pbcs[i].y!=b.pbcs[i].y || a.pbcs[i].t!=b.pbcs[i].t)
+            return false;
+    }
+    for (size_t i=0; i<a.ages.size(); i++)
+    {
+        const femmsolver::CAirGapElement &x = a.ages[i];
+        const femmsolver::CAirGapElement &y = b.ages[i];
+        if (x.BdryName!=y.BdryName || x.BdryFormat!=y.BdryFormat || x.totalArcElements!=y.totalArcElements
+                || x.totalArcLength!=y.totalArcLength || x.ri!=y.ri || x.ro!=y.ro
+                || x.agc.re!=y.agc.re || x.agc.im!=y.agc.im || x.quadNode.size()!=y.quadNode.size())
+            return false;
+        for (size_t j=0; j<x.quadNode.size(); j++)
+        {
+            const femm::CQuadPoint &p = x.quadNode[j];
+            const femm::CQuadPoint &q = y.quadNode[j];
+            if (p.n0!=q.n0 || p.n1!=q.n1 || p.n2!=q.n2 || p.n3!=q.n3
+                    || p.w0!=q.w0 || p.w1!=q.w1 || p.w2!=q.w2 || p.w3!=q.w3)
+                return false;
+        }
+    }
+    return true;
+}
+
+/// count the files in \p dir with the given extension
+int countFiles(const std::string &dir, const std::string &extension)
+{
+    int n = 0;
+    for (const fs::directory_entry &entry : fs::directory_iterator(dir))
+    {
+        if (entry.path().extension()==extension)
+            n++;
+    }
+    return n;
+}
+
+/// the only entry file in \p dir
+fs::path onlyEntry(const std::string &dir)
+{
+    for (const fs::directory_entry &entry : fs::directory_iterator(dir))
+    {
+        if (entry.path().extension()==".mesh")
+            return entry.path();
+    }
+    return fs::path();
+}
+
+/// set the time of last use of an entry (or temporary file) to \p age in the past
+void makeOlder(const fs::path &file, std::chrono::minutes age)
+{
+    fs::last_write_time(file, fs::file_time_type::clock::now()-age);
+}
+
+} // namespace
+
+int main()
+{
+    const std::string dir = "meshcache-test.dir";
+    fs::remove_all(dir);
+
+    const CMeshData meshA = testMesh(1);
+    const CMeshData meshB = testMesh(2);
+    const CMeshData meshC = testMesh(3);
+
+    // hit and miss
+    {
+        CMeshCache cache(dir, 0);
+        check("directory is created", fs::is_directory(dir));
+        check("miss on an empty cache", cache.load("key A") == nullptr);
+        check("store", cache.store("key A", meshA));
+        std::shared_ptr<CMeshData> loaded = cache.load("key A");
+        check("hit", loaded != nullptr);
+        check("hit returns the stored mesh", loaded && sameMesh(*loaded, meshA));
+        check("miss on a changed key", cache.load("key A ") == nullptr);
+        check("miss on an unknown key", cache.load("key B") == nullptr);
+    }
+
+    // store: the entry is written to a temporary file, and renamed into place
+    {
+        CMeshCache cache(dir, 0);
+        check("one entry file", countFiles(dir, ".mesh") == 1);
+        check("no temporary files are left over", countFiles(dir, ".tmp") == 0);
+
+        // an entry with the key of another one (i.e. a hash collision) is a miss
+        const fs::path entryA = onlyEntry(dir);
+        check("store", cache.store("key B", meshB));
+        fs::path entryB;
+        for (const fs::directory_entry &entry : fs::directory_iterator(dir))
+        {
+            if (entry.path().extension()==".mesh" && entry.path()!=entryA)
+                entryB = entry.path();
+        }
+        fs::copy_file(entryA, entryB, fs::copy_options::overwrite_existing);
+        check("miss on an entry for another key", cache.load("key B") == nullptr);
+
+        // a partially written entry is a miss, not a broken mesh
+        fs::resize_file(entryB, fs::file_size(entryA)/2);
+        check("miss on a truncated entry", cache.load("key A") != nullptr && cache.load("key B") == nullptr);
+        // storing again replaces the broken entry
+        check("store replaces an entry", cache.store("key B", meshB));
+        std::shared_ptr<CMeshData> loaded = cache.load("key B");
+        check("hit after replacing an entry", loaded && sameMesh(*loaded, meshB));
+    }
+
+    // eviction of the least recently used entries
+    {
+        fs::remove_all(dir);
+        CMeshCache unlimited(dir, 0);
+        unlimited.store("key A", meshA);
+        const uint64_t entrySize = fs::file_size(onlyEntry(dir));
+        unlimited.store("key B", meshB);
+
+        // room for two entries and a half
+        CMeshCache cache(dir, entrySize*5/2);
+        for (const fs::directory_entry &entry : fs::directory_iterator(dir))
+            makeOlder(entry.path(), std::chrono::minutes(20));
+        // A is used more recently than B
+        check("hit before eviction", cache.load("key A") != nullptr);
+
+        // a temporary file of a process that is storing an entry right now, and one of a process that died
+        const std::string activeTmp = dir + "/active.tmp";
+        const std::string staleTmp = dir + "/stale.tmp";
+        fclose(fopen(activeTmp.c_str(), "wb"));
+        fclose(fopen(staleTmp.c_str(), "wb"));
+        makeOlder(staleTmp, std::chrono::minutes(120));
+
+        check("store beyond the size limit", cache.store("key C", meshC));
+        check("least recently used entry is evicted", cache.load("key B") == nullptr);
+        check("recently used entry is kept", cache.load("key A") != nullptr);
+        check("new entry is kept", cache.load("key C") != nullptr);
+        check("cache is within its size limit", countFiles(dir, ".mesh") == 2);
+        check("temporary file of another process is kept", fs::exists(activeTmp));
+        check("stale temporary file is removed", !fs::exists(staleTmp));
+    }
+
+    fs::remove_all(dir);
+    return failed==0 ? 0 : 1;
+}
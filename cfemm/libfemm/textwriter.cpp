@@ -0,0 +1,104 @@
+/*
+ * The source code in this file extends the file handling code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "textwriter.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+using namespace femm;
+
+CTextWriter::CTextWriter()
+    : fp(nullptr)
+    , buffer()
+    , failed(false)
+{
+}
+
+CTextWriter::CTextWriter(FILE *fp)
+    : fp(fp)
+    , buffer()
+    , failed(false)
+{
+    buffer.reserve(BlockSize + BlockSize/8);
+}
+
+CTextWriter::~CTextWriter()
+{
+    flush();
+}
+
+CTextWriter &CTextWriter::operator<<(int value)
+{
+    char s[16];
+    std::to_chars_result result = std::to_chars(s, s+sizeof(s), value);
+    append(s, result.ptr-s);
+    return *this;
+}
+
+CTextWriter &CTextWriter::operator<<(double value)
+{
+    char s[32];
+    std::to_chars_result result = std::to_chars(s, s+sizeof(s), value);
+    append(s, result.ptr-s);
+    return *this;
+}
+
+CTextWriter &CTextWriter::operator<<(FixedPrecision value)
+{
+    // at most 48 digits, plus sign, point and exponent
+    char s[64];
+    std::to_chars_result result = std::to_chars(s, s+sizeof(s), value.value, std::chars_format::general, std::min(value.precision,48));
+    append(s, result.ptr-s);
+    return *this;
+}
+
+CTextWriter &CTextWriter::operator<<(char c)
+{
+    append(&c, 1);
+    return *this;
+}
+
+CTextWriter &CTextWriter::operator<<(const char *s)
+{
+    append(s, strlen(s));
+    return *this;
+}
+
+CTextWriter &CTextWriter::operator<<(const std::string &s)
+{
+    append(s.data(), s.size());
+    return *this;
+}
+
+bool CTextWriter::copyFrom(FILE *in)
+{
+    char s[65536];
+    size_t n;
+    while ((n=fread(s,1,sizeof(s),in)) > 0)
+        append(s, n);
+    return !ferror(in);
+}
+
+bool CTextWriter::flush()
+{
+    if (fp && !buffer.empty())
+    {
+        if (fwrite(buffer.data(), 1, buffer.size(), fp) != buffer.size())
+            failed = true;
+        buffer.clear();
+    }
+    return !failed;
+}
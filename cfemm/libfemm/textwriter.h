@@ -0,0 +1,155 @@
+/*
+ * The source code in this file extends the file handling code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#ifndef FEMM_TEXTWRITER_H
+#define FEMM_TEXTWRITER_H
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace femm {
+
+/**
+ * @brief A floating point value that CTextWriter formats like \c printf("%.<precision>g").
+ * @see withPrecision()
+ */
+struct FixedPrecision
+{
+    double value;
+    int precision;
+};
+
+inline FixedPrecision withPrecision(double value, int precision)
+{
+    return FixedPrecision{value, precision};
+}
+
+/**
+ * @brief The CTextWriter class writes text files, like the solution and mesh files, in large blocks.
+ *
+ * Numbers are formatted with \c std::to_chars, i.e. independent of the locale.
+ * A \c double is written in the shortest form that reads back to the same value,
+ * so it replaces \c %.17g without loss: readers get bit-identical values, from fewer bytes.
+ * Where a file has always been written with fewer digits, use withPrecision() to keep its contents.
+ *
+ * The text is collected in memory and handed to the file in blocks of about BlockSize bytes.
+ * Sections with many records can be formatted by several threads, see writeRecords().
+ */
+class CTextWriter
+{
+public:
+    /// the buffered text is written to the file when it exceeds this size
+    static constexpr size_t BlockSize = 1<<20;
+    /// writeRecords() hands this many records to a thread at a time
+    static constexpr int RecordsPerBlock = 8192;
+
+    /**
+     * @brief Construct a writer that collects the text in memory, see text().
+     */
+    CTextWriter();
+    /**
+     * @brief Construct a writer that appends to a file.
+     * The file is not closed by the writer, but all text is flushed to it on destruction.
+     */
+    explicit CTextWriter(FILE *fp);
+    ~CTextWriter();
+    CTextWriter(const CTextWriter &) = delete;
+    CTextWriter &operator=(const CTextWriter &) = delete;
+
+    CTextWriter &operator<<(int value);
+    CTextWriter &operator<<(double value);
+    CTextWriter &operator<<(FixedPrecision value);
+    CTextWriter &operator<<(char c);
+    CTextWriter &operator<<(const char *s);
+    CTextWriter &operator<<(const std::string &s);
+
+    /**
+     * @brief Copy the rest of a file verbatim, e.g. to echo the problem file into a solution file.
+     * @return \c false, if \p in could not be read.
+     */
+    bool copyFrom(FILE *in);
+
+    /**
+     * @brief Write a section of \p n records.
+     *
+     * \p record is called as \c record(writer,i) for each record \c i.
+     * For large sections, blocks of records are formatted into separate buffers by femm::numThreads() threads,
+     * and the buffers are written in order, so the output is the same as for a plain loop.
+     * \p record must therefore not modify shared state.
+     */
+    template<class Record>
+    void writeRecords(int n, Record record);
+
+    /**
+     * @brief Write the buffered text to the file.
+     * @return \c false, if writing to the file failed (now or before).
+     */
+    bool flush();
+    /**
+     * @brief The text of an in-memory writer.
+     */
+    const std::string &text() const { return buffer; }
+
+private:
+    void append(const char *s, size_t n)
+    {
+        buffer.append(s,n);
+        if (fp && buffer.size() >= BlockSize)
+            flush();
+    }
+
+    FILE *fp;
+    std::string buffer;
+    bool failed;
+};
+
+template<class Record>
+void CTextWriter::writeRecords(int n, Record record)
+{
+    const int threads = useThreads(n) ? numThreads() : 1;
+    if (threads<=1)
+    {
+        for (int i=0; i<n; i++)
+            record(*this,i);
+        return;
+    }
+
+    // format one block per thread, then append the blocks in order
+    std::vector<CTextWriter> blocks(threads);
+    for (int first=0; first<n; first+=threads*RecordsPerBlock)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static,1) num_threads(threads)
+#endif
+        for (int b=0; b<threads; b++)
+        {
+            blocks[b].buffer.clear();
+            const int begin = first + b*RecordsPerBlock;
+            const int end = std::min(n, begin+RecordsPerBlock);
+            for (int i=begin; i<end; i++)
+                record(blocks[b],i);
+        }
+        for (const CTextWriter &block : blocks)
+            append(block.buffer.data(), block.buffer.size());
+    }
+}
+
+} // namespace femm
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * The source code in this file extends the solver code of
+ * FEMM by David Meeker <dmeeker@ieee.org>.
+ * For more information on FEMM see http://www.femm.info
+ * This modified version is not endorsed in any way by the original
+ * authors of FEMM.
+ *
+ * License:
+ * This software is subject to the Aladdin Free Public Licence
+ * version 8, November 18, 1999.
+ * The full license text is available in the file LICENSE.txt supplied
+ * along with the source code.
+ */
+
+#include "triangleshapes.h"
+
+#include <cmath>
+
+CTriangleShapes::CTriangleShapes()
+    : X()
+    , Y()
+    , N()
+    , P()
+    , Q()
+    , L2()
+    , Area()
+    , MX()
+    , MY()
+    , MXY()
+{
+}
+
+void CTriangleShapes::Compute()
+{
+    const int n = static_cast<int>(N[0].size());
+    for (int k=0; k<3; k++)
+    {
+        P[k].resize(n);
+        Q[k].resize(n);
+        L2[k].resize(n);
+    }
+    Area.resize(n);
+
+    const double *x = X.data();
+    const double *y = Y.data();
+    const int *n0 = N[0].data();
+    const int *n1 = N[1].data();
+    const int *n2 = N[2].data();
+    double *p0 = P[0].data(), *p1 = P[1].data(), *p2 = P[2].data();
+    double *q0 = Q[0].data(), *q1 = Q[1].data(), *q2 = Q[2].data();
+    double *l0 = L2[0].data(), *l1 = L2[1].data(), *l2 = L2[2].data();
+    double *a = Area.data();
+
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+    for (int i=0; i<n; i++)
+    {
+        const double x0 = x[n0[i]], y0 = y[n0[i]];
+        const double x1 = x[n1[i]], y1 = y[n1[i]];
+        const double x2 = x[n2[i]], y2 = y[n2[i]];
+
+        p0[i] = y1 - y2;
+        p1[i] = y2 - y0;
+        p2[i] = y0 - y1;
+        q0[i] = x2 - x1;
+        q1[i] = x0 - x2;
+        q2[i] = x1 - x0;
+        a[i] = (p0[i]*q1[i] - p1[i]*q0[i]) / 2.;
+
+        // std::sqrt() may set errno, which keeps the loop from being vectorized;
+        // GetSides() takes the square roots for the few elements that need them
+        l0[i] = (x1-x0)*(x1-x0) + (y1-y0)*(y1-y0);
+        l1[i] = (x2-x1)*(x2-x1) + (y2-y1)*(y2-y1);
+        l2[i] = (x0-x2)*(x0-x2) + (y0-y2)*(y0-y2);
+    }
+}
+
+void CTriangleShapes::ComputePlanarMatrices()
+{
+    const int n = NumElements();
+    for (int u=0; u<6; u++)
+    {
+        MX[u].resize(n);
+        MY[u].resize(n);
+        MXY[u].resize(n);
+    }
+
+    const double *p0 = P[0].data(), *p1 = P[1].data(), *p2 = P[2].data();
+    const double *q0 = Q[0].data(), *q1 = Q[1].data(), *q2 = Q[2].data();
+    const double *a = Area.data();
+    double *mx00 = MX[0].data(), *mx01 = MX[1].data(), *mx02 = MX[2].data();
+    double *mx11 = MX[3].data(), *mx12 = MX[4].data(), *mx22 = MX[5].data();
+    double *my00 = MY[0].data(), *my01 = MY[1].data(), *my02 = MY[2].data();
+    double *my11 = MY[3].data(), *my12 = MY[4].data(), *my22 = MY[5].data();
+    double *mxy00 = MXY[0].data(), *mxy01 = MXY[1].data(), *mxy02 = MXY[2].data();
+    double *mxy11 = MXY[3].data(), *mxy12 = MXY[4].data(), *mxy22 = MXY[5].data();
+
+    // the expressions (and their evaluation order) are the ones of the former per-element code
+#ifdef _OPENMP
+#pragma omp simd
+#endif
+    for (int i=0; i<n; i++)
+    {
+        const double K = (-1./(4.*a[i]));
+
+        mx00[i] = K*p0[i]*p0[i];
+        mx01[i] = K*p0[i]*p1[i];
+        mx02[i] = K*p0[i]*p2[i];
+        mx11[i] = K*p1[i]*p1[i];
+        mx12[i] = K*p1[i]*p2[i];
+        mx22[i] = K*p2[i]*p2[i];
+
+        my00[i] = K*q0[i]*q0[i];
+        my01[i] = K*q0[i]*q1[i];
+        my02[i] = K*q0[i]*q2[i];
+        my11[i] = K*q1[i]*q1[i];
+        my12[i] = K*q1[i]*q2[i];
+        my22[i] = K*q2[i]*q2[i];
+
+        mxy00[i] = K*(p0[i]*q0[i] + p0[i]*q0[i]);
+        mxy01[i] = K*(p0[i]*q1[i] + p1[i]*q0[i]);
+        mxy02[i] = K*(p0[i]*q2[i] + p2[i]*q0[i]);
+        mxy11[i] = K*(p1[i]*q1[i] + p1[i]*q1[i]);
+        mxy12[i] = K*(p1[i]*q2[i] + p2[i]*q1[i]);
+        mxy22[i] = K*(p2[i]*q2[i] + p2[i]*q2[i]);
+    }
+}
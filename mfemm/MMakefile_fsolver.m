@@ -63,11 +63,11 @@ function [rules,vars] = MMakefile_fsolver (varargin)
         vars.MEXFLAGS = [vars.MEXFLAGS, ' -v '];
     end
 
-    vars.CXXFLAGS = '${CXXFLAGS} -std=c++11 ';
+    vars.CXXFLAGS = '${CXXFLAGS} -std=c++17 ';
 
     if mfemmdeps.isoctave
-        setenv('CFLAGS','-std=c++11'); %vars.CXXFLAGS = [vars.CXXFLAGS, ' -std=c++11'];
-        setenv('CXXFLAGS','-std=c++11');
+        setenv('CFLAGS','-std=c++17'); %vars.CXXFLAGS = [vars.CXXFLAGS, ' -std=c++17'];
+        setenv('CXXFLAGS','-std=c++17');
         vars.MEXFLAGS = [vars.MEXFLAGS, ' ''-Wl,--no-undefined'' -L/usr/local/lib/octave/5.1.0 -loctinterp -loctave -lstdc++'];
     end
 %     vars.CXXFLAGS = [vars.CXXFLAGS, ' -std=c++14'];
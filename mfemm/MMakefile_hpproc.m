@@ -49,11 +49,11 @@ function [rules,vars] = MMakefile_hpproc (varargin)
         vars.MEXFLAGS = [vars.MEXFLAGS, ' -g'];
     end
 
-    vars.CXXFLAGS = '${CXXFLAGS} -std=c++11 ';
+    vars.CXXFLAGS = '${CXXFLAGS} -std=c++17 ';
 
     if mfemmdeps.isoctave
-        setenv('CFLAGS','-std=c++11'); %vars.CXXFLAGS = [vars.CXXFLAGS, ' -std=c++11'];
-        setenv('CXXFLAGS','-std=c++11');
+        setenv('CFLAGS','-std=c++17'); %vars.CXXFLAGS = [vars.CXXFLAGS, ' -std=c++17'];
+        setenv('CXXFLAGS','-std=c++17');
     end
 
 %     vars.CXXFLAGS = [vars.CXXFLAGS, ' -std=c++14'];
@@ -30,6 +30,23 @@ function libfemm_sources = getlibfemmsources ()
         'PostProcessor.cpp', ...
         'spars.cpp', ...
         'stringTools.cpp', ... 
+        'csrspars.cpp', ...
+        'ccsrspars.cpp', ...
+        'ichol.cpp', ...
+        'amg.cpp', ...
+        'spchol.cpp', ...
+        'cdirect.cpp', ...
+        'parallel.cpp', ...
+        'levelsched.cpp', ...
+        'solverbackend.cpp', ...
+        'periodic.cpp', ...
+        'coloring.cpp', ...
+        'triangleshapes.cpp', ...
+        'bhcache.cpp', ...
+        'meshdata.cpp', ...
+        'solutionfile.cpp', ...
+        'textwriter.cpp', ...
+        'meshcache.cpp', ...
         };
 
 end
\ No newline at end of file